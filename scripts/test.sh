@@ -16522,6 +16522,1945 @@ esac
 N=$((N+1))
 
 
+# the client address is within a permitted network, but a longer prefix in the
+# range file denies it
+NAME=TCP4RANGEFILE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%security%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%range%*|*%listen%*|*%fork%*|*%$NAME%*)
+TEST="$NAME: security of TCP4-L with RANGE-FILE option"
+if ! eval $NUMCOND; then :;
+elif ! feat=$(testfeats tcp ip4) || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tr="$td/test$N.ranges"
+cat >"$tr" <<EOF
+# permit loopback network, but not the client
+127.0.0.0/8
+!127.0.0.1/32
+[::1]/128
+EOF
+newport tcp4 	# provide free port number in $PORT
+testserversec "$N" "$TEST" "$opts" "TCP4-L:$PORT,reuseaddr,fork,retry=1" "" "range-file=$tr" "TCP4:127.0.0.1:$PORT" 4 tcp $PORT 0
+fi ;; # NUMCOND, feats
+esac
+N=$((N+1))
+
+# like TCP4WRAPPERS_ADDR, but with the tables compiled by socat
+NAME=TCP4WRAPPERS_CACHE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%security%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%tcpwrap%*|*%listen%*|*%fork%*|*%$NAME%*)
+TEST="$NAME: security of TCP4-L with TCPWRAP-CACHE option"
+if ! eval $NUMCOND; then :;
+elif ! feat=$(testfeats tcp ip4 libwrap) || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+ha="$td/hosts.allow"
+hd="$td/hosts.deny"
+$ECHO "socat: 127.0.0.0/255.0.0.0 EXCEPT 127.0.0.1" >"$ha"
+$ECHO "ALL: ALL" >"$hd"
+newport tcp4 	# provide free port number in $PORT
+testserversec "$N" "$TEST" "$opts" "TCP4-L:$PORT,reuseaddr,fork,retry=1" "" "tcpwrap-cache,hosts-allow=$ha,hosts-deny=$hd" "TCP4:127.0.0.1:$PORT" 4 tcp $PORT 0
+fi ;; # NUMCOND, feats
+esac
+N=$((N+1))
+
+# option session-table lets one socat process handle all peers of a datagram
+# server; packets of the same peer must reach the same instance of the second
+# address, packets of other peers their own instance
+NAME=UDP4RECVFROM_SESSIONS
+case "$TESTS" in
+*%$N%*|*%functions%*|*%ip4%*|*%udp%*|*%dgram%*|*%session%*|*%$NAME%*)
+TEST="$NAME: UDP4-RECVFROM with session-table"
+# idea: the second address numbers the packets it receives. One client sends
+# two packets and must see the numbers 1 and 2, a second client sends one
+# packet and must see number 1.
+if ! eval $NUMCOND; then :;
+elif ! feat=$(testfeats udp ip4 system) || ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}$feat not available${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+newport udp4; tsp=$PORT
+ts="$LOCALHOST:$tsp"
+da="test$N $(date) $RANDOM"
+CMD1="$TRACE $SOCAT $opts UDP4-RECVFROM:$tsp,reuseaddr,session-table SYSTEM:'n=0; while read l; do n=\$((n+1)); echo \$n \$l; done'"
+CMD2="$TRACE $SOCAT $opts -t 1 - UDP4-SENDTO:$ts"
+printf "test $F_n $TEST... " $N
+$TRACE $SOCAT $opts UDP4-RECVFROM:$tsp,reuseaddr,session-table SYSTEM:'n=0; while read l; do n=$((n+1)); echo $n $l; done' >/dev/null 2>"${te}1" &
+pid1=$!
+waitudp4port $tsp 1
+(echo "$da a"; relsleep 1; echo "$da b") |$CMD2 >"${tf}2" 2>"${te}2"
+rc2=$?
+echo "$da c" |$CMD2 >"${tf}3" 2>"${te}3"
+rc3=$?
+kill $pid1 2>/dev/null; wait
+cat "${tf}2" "${tf}3" >"$tf"
+if [ $rc2 -ne 0 -o $rc3 -ne 0 ]; then
+    $PRINTF "$FAILED: $TRACE $SOCAT:\n"
+    echo "$CMD1 &" >&2
+    cat "${te}1" >&2
+    echo "$CMD2" >&2
+    cat "${te}2" "${te}3" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+elif ! printf "1 $da a\n2 $da b\n1 $da c\n" |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED: $TRACE $SOCAT:\n"
+    echo "$CMD1 &" >&2
+    cat "${te}1" >&2
+    echo "$CMD2" >&2
+    cat "${te}2" "${te}3" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+else
+    $PRINTF "$OK\n"
+    if [ -n "$debug" ]; then cat "${te}1" "${te}2" "${te}3"; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi ;; # NUMCOND, feats
+esac
+N=$((N+1))
+
+# Test option --relays: two address pairs from a file are served by one socat
+# invocation
+NAME=RELAYS_FILE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%fork%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%listen%*|*%relays%*|*%$NAME%*)
+TEST="$NAME: Socat option --relays"
+# Write a relays file with two TCP4-LISTEN/PIPE pairs, start Socat with it,
+# connect to both ports and check the echoed data; the supervising process
+# must terminate successfully when both relays have finished
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN PIPE); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tr="$td/test$N.relays"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+newport tcp4; PORT1=$PORT
+newport tcp4; PORT2=$PORT
+cat >"$tr" <<EOF
+# relays of test $N
+TCP4-LISTEN:$PORT1,reuseaddr	PIPE
+
+TCP4-LISTEN:$PORT2,reuseaddr  PIPE
+EOF
+CMD0="$TRACE $SOCAT $opts --relays=$tr"
+CMD1="$TRACE $SOCAT $opts - TCP4:$LOCALHOST:$PORT1"
+CMD2="$TRACE $SOCAT $opts - TCP4:$LOCALHOST:$PORT2"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waittcp4port $PORT1 1
+waittcp4port $PORT2 1
+echo "$da 1" |$CMD1 >"${tf}1" 2>"${te}1"
+rc1=$?
+echo "$da 2" |$CMD2 >"${tf}2" 2>"${te}2"
+rc2=$?
+wait $pid0
+rc0=$?
+if [ "$rc0" -ne 0 -o "$rc1" -ne 0 -o "$rc2" -ne 0 ]; then
+    $PRINTF "$FAILED (rc0=$rc0, rc1=$rc1, rc2=$rc2)\n"
+    echo "$CMD0 &"
+    cat "${te}0" >&2
+    echo "$CMD1"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! { echo "$da 1"; echo "$da 2"; } |diff - <(cat "${tf}1" "${tf}2") >"$tdiff"; then
+    $PRINTF "$FAILED (diff)\n"
+    echo "$CMD0 &"
+    cat "${te}0" >&2
+    echo "$CMD1"
+    echo "$CMD2"
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; echo "$CMD2"; fi
+    if [ "$DEBUG" ];   then cat "${te}0" "${te}1" "${te}2" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+
+# Test option handover: a second TCP4-LISTEN process takes over the listening
+# socket of a running one
+NAME=TCP4LISTEN_HANDOVER
+case "$TESTS" in
+*%$N%*|*%functions%*|*%fork%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%listen%*|*%unix%*|*%handover%*|*%$NAME%*)
+TEST="$NAME: TCP4-LISTEN option handover"
+# Start a TCP4-LISTEN server with fork and option handover that answers "old",
+# check it; start a second one with the same handover socket that answers
+# "new". The first process must terminate with status 0, and a new client
+# connection must be served by the second process
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN UNIX SYSTEM); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+ts="$td/test$N.sock"
+newport tcp4
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,reuseaddr,fork,handover=$ts SYSTEM:\"echo old\""
+CMD2="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,reuseaddr,fork,handover=$ts SYSTEM:\"echo new\""
+CMD="$TRACE $SOCAT $opts -u TCP4:$LOCALHOST:$PORT -"
+printf "test $F_n $TEST... " $N
+$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,reuseaddr,fork,handover=$ts SYSTEM:"echo old" >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+waitfile "$ts"
+$CMD >"${tf}1" 2>"${te}a"
+$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,reuseaddr,fork,handover=$ts SYSTEM:"echo new" >/dev/null 2>"${te}2" &
+pid2=$!
+i=0; while kill -0 $pid1 2>/dev/null && [ $i -lt 50 ]; do relsleep 1; i=$((i+1)); done
+kill $pid1 2>/dev/null; wait $pid1
+rc1=$?
+$CMD >"${tf}2" 2>"${te}b"
+kill $pid2 2>/dev/null; wait
+if [ "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED (rc1=$rc1)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif [ "$(cat "${tf}1")" != old -o "$(cat "${tf}2")" != new ]; then
+    $PRINTF "$FAILED (wrong output)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD"
+    cat "${te}a" "${tf}1" >&2
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    echo "$CMD"
+    cat "${te}b" "${tf}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD"; echo "$CMD2 &"; echo "$CMD"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}a" "${te}2" "${te}b" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+NAME=TCP4LISTEN_HANDOVER_REJECT
+case "$TESTS" in
+*%$N%*|*%functions%*|*%fork%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%listen%*|*%unix%*|*%handover%*|*%$NAME%*)
+TEST="$NAME: TCP4-LISTEN handover of socket on other port"
+# Start a TCP4-LISTEN server with fork and option handover that answers "old";
+# start a second one with the same handover socket but on another port that
+# answers "new". The second process must not use the passed socket, so the
+# first process must keep serving its port, and the second one its own port
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN UNIX SYSTEM); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+ts="$td/test$N.sock"
+newport tcp4; PORT1=$PORT
+newport tcp4; PORT2=$PORT
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT1,reuseaddr,fork,handover=$ts SYSTEM:\"echo old\""
+CMD2="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT2,reuseaddr,fork,handover=$ts SYSTEM:\"echo new\""
+printf "test $F_n $TEST... " $N
+$TRACE $SOCAT $opts TCP4-LISTEN:$PORT1,reuseaddr,fork,handover=$ts SYSTEM:"echo old" >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT1 1
+waitfile "$ts"
+$TRACE $SOCAT $opts TCP4-LISTEN:$PORT2,reuseaddr,fork,handover=$ts SYSTEM:"echo new" >/dev/null 2>"${te}2" &
+pid2=$!
+waittcp4port $PORT2 1
+$TRACE $SOCAT $opts -u TCP4:$LOCALHOST:$PORT1 - >"${tf}1" 2>"${te}a"
+$TRACE $SOCAT $opts -u TCP4:$LOCALHOST:$PORT2 - >"${tf}2" 2>"${te}b"
+kill -0 $pid1 2>/dev/null; rc1=$?
+kill $pid1 $pid2 2>/dev/null; wait
+if [ "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED (first process terminated)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif [ "$(cat "${tf}1")" != old -o "$(cat "${tf}2")" != new ]; then
+    $PRINTF "$FAILED (wrong output)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    cat "${te}a" "${tf}1" "${te}b" "${tf}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2 &"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+
+# Test option happy-eyeballs: when localhost resolves to ::1 and 127.0.0.1 and
+# only the IPv4 address is listening, connecting with IPv6 preference must
+# succeed via the IPv4 attempt
+NAME=TCP_HAPPY_EYEBALLS
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%ip4%*|*%ip6%*|*%$NAME%*)
+TEST="$NAME: TCP connect with option happy-eyeballs"
+# Start a TCP4-LISTEN server, connect with option -6 and TCP:localhost with
+# happy-eyeballs; the ::1 attempt is refused, the 127.0.0.1 attempt succeeds
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 IP6 TCP LISTEN SYSTEM); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null || ! runsip6 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 or IPv6 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! type getent >/dev/null 2>&1 ||
+	! getent ahostsv6 localhost 2>/dev/null |grep -q '^::1 ' ||
+	! getent ahostsv4 localhost 2>/dev/null |grep -q '^127\.0\.0\.1 '; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}localhost does not resolve to ::1 and 127.0.0.1${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+newport tcp4
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,reuseaddr SYSTEM:\"echo ok\""
+CMD2="$TRACE $SOCAT $opts -6 -u TCP:localhost:$PORT,happy-eyeballs -"
+printf "test $F_n $TEST... " $N
+$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,reuseaddr SYSTEM:"echo ok" >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+$CMD2 >"$tf" 2>"${te}2"
+rc2=$?
+kill $pid1 2>/dev/null; wait
+if [ "$rc2" -ne 0 ]; then
+    $PRINTF "$FAILED (rc2=$rc2)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif [ "$(cat "$tf")" != ok ]; then
+    $PRINTF "$FAILED (wrong output)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "${te}2" "$tf" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+
+# Test option resolve-ttl: in a TCP-LISTEN,fork relay, the second child must
+# take the target addresses from the resolver cache that the first child filled
+NAME=TCP4_RESOLVE_TTL
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%fork%*|*%$NAME%*)
+TEST="$NAME: resolver cache shared by forked children"
+# Start an echo server and a relay to TCP4:localhost with resolve-ttl, send
+# two connections through the relay; both must be echoed, and the relay log
+# must show that the second one used the cached addresses
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN PIPE); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+newport tcp4; PORT1=$PORT
+newport tcp4; PORT2=$PORT
+CMD0="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT1,reuseaddr,fork PIPE"
+CMD1="$TRACE $SOCAT $opts -d -d -d TCP4-LISTEN:$PORT2,reuseaddr,fork TCP4:localhost:$PORT1,resolve-ttl=60"
+CMD2="$TRACE $SOCAT $opts - TCP4:$LOCALHOST:$PORT2"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT1 1
+waittcp4port $PORT2 1
+echo "$da 1" |$CMD2 >"$tf" 2>"${te}2"
+rc2=$?
+echo "$da 2" |$CMD2 >>"$tf" 2>>"${te}2"
+rc2=$((rc2+$?))
+relsleep 1
+kill $pid0 $pid1 2>/dev/null; wait
+if [ "$rc2" -ne 0 ]; then
+    $PRINTF "$FAILED (rc2=$rc2)\n"
+    echo "$CMD0 &"
+    cat "${te}0" >&2
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! printf "$da 1\n$da 2\n" |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED (wrong output)\n"
+    echo "$CMD0 &"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "resolver cache: using addresses of \"localhost:$PORT1\"" "${te}1"; then
+    $PRINTF "$FAILED (cache not used)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1 &"; echo "$CMD2"; fi
+    if [ "$DEBUG" ];   then cat "${te}0" "${te}1" "${te}2" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option resolve-timeout: the name is resolved by a helper process, the
+# connection must work as usual
+NAME=TCP4_RESOLVE_TIMEOUT
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%$NAME%*)
+TEST="$NAME: TCP4 connect with asynchronous name resolution"
+# Start an echo server, connect to localhost with option resolve-timeout; data
+# must be echoed, and the log must show the resolver helper process
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN PIPE); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+newport tcp4
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,reuseaddr PIPE"
+CMD2="$TRACE $SOCAT $opts -d -d -d - TCP4:localhost:$PORT,resolve-timeout=10"
+printf "test $F_n $TEST... " $N
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+echo "$da" |$CMD2 >"$tf" 2>"${te}2"
+rc2=$?
+kill $pid1 2>/dev/null; wait
+if [ "$rc2" -ne 0 ]; then
+    $PRINTF "$FAILED (rc2=$rc2)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! echo "$da" |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED (wrong output)\n"
+    echo "$CMD1 &"
+    echo "$CMD2"
+    cat "${te}2" "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "resolving \"localhost:$PORT\" in process" "${te}2"; then
+    $PRINTF "$FAILED (no resolver process)\n"
+    echo "$CMD2"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option pool: the children of a forking listener take connections to
+# the target from the pool
+NAME=TCP4_POOL
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%fork%*|*%$NAME%*)
+TEST="$NAME: TCP4 connection pool behind forking listener"
+# Start an echo server, and a forking listener that relays to it with option
+# pool=2; send data twice via the listener. Both must be echoed, and the second
+# child must have taken an established connection from the pool
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN PIPE); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions pool) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+newport tcp4; PORT1=$PORT
+newport tcp4; PORT2=$PORT
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT1,reuseaddr,fork PIPE"
+CMD2="$TRACE $SOCAT $opts -d -d TCP4-LISTEN:$PORT2,reuseaddr,fork TCP4:localhost:$PORT1,pool=2"
+CMD3="$TRACE $SOCAT $opts -t 0.5 - TCP4:localhost:$PORT2"
+printf "test $F_n $TEST... " $N
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT1 1
+$CMD2 >/dev/null 2>"${te}2" &
+pid2=$!
+waittcp4port $PORT2 1
+echo "$da" |$CMD3 >"$tf" 2>"${te}3"
+rc3=$?
+relsleep 5
+echo "$da" |$CMD3 >>"$tf" 2>>"${te}3"
+rc3=$((rc3+$?))
+kill $pid2 $pid1 2>/dev/null; wait
+if [ "$rc3" -ne 0 ]; then
+    $PRINTF "$FAILED (rc3=$rc3)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    echo "$CMD3"
+    cat "${te}3" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! { echo "$da"; echo "$da"; } |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED (wrong output)\n"
+    echo "$CMD1 &"
+    echo "$CMD2 &"
+    echo "$CMD3"
+    cat "${te}2" "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "pool: took established connection" "${te}2"; then
+    $PRINTF "$FAILED (pool not used)\n"
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2 &"; echo "$CMD3"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" "${te}3" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test TCP Fast Open options: without a cookie the connection falls back to
+# a normal handshake, with cookie the data is sent in the SYN; both must work
+NAME=TCP4_FASTOPEN
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%$NAME%*)
+TEST="$NAME: TCP4 with options fastopen and fastopen-connect"
+# Start an echo server with option fastopen, and connect to it twice with
+# option fastopen-connect; data must be echoed both times
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN PIPE); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions fastopen fastopen-connect) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+newport tcp4
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT,reuseaddr,fork,fastopen=16 PIPE"
+CMD2="$TRACE $SOCAT $opts -t 0.5 - TCP4:$LOCALHOST:$PORT,fastopen-connect"
+printf "test $F_n $TEST... " $N
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+echo "$da" |$CMD2 >"$tf" 2>"${te}2"
+rc2=$?
+echo "$da" |$CMD2 >>"$tf" 2>>"${te}2"
+rc2=$((rc2+$?))
+kill $pid1 2>/dev/null; wait
+if [ "$rc2" -ne 0 ]; then
+    $PRINTF "$FAILED (rc2=$rc2)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! { echo "$da"; echo "$da"; } |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED (wrong output)\n"
+    echo "$CMD1 &"
+    echo "$CMD2"
+    cat "${te}2" "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option backends: a forking listener distributes connections round robin
+# over two backends, a third one that refuses connections is skipped
+NAME=TCP4_BACKENDS
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%fork%*|*%$NAME%*)
+TEST="$NAME: TCP4 load balancing over backends"
+# Start two servers that answer A and B, and a forking listener that relays to
+# them with option backends, including a port without server. Four clients
+# must all get an answer, both A and B
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN SYSTEM); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions backends balance) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+newport tcp4; PORT1=$PORT
+newport tcp4; PORT2=$PORT
+newport tcp4; PORT3=$PORT	# no server
+newport tcp4; PORT4=$PORT
+CMD1="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT1,$REUSEADDR,fork SYSTEM:'echo A'"
+CMD2="$TRACE $SOCAT $opts TCP4-LISTEN:$PORT2,$REUSEADDR,fork SYSTEM:'echo B'"
+CMD3="$TRACE $SOCAT $opts -d -d TCP4-LISTEN:$PORT4,$REUSEADDR,fork TCP4:$LOCALHOST:$PORT1,backends=$LOCALHOST:$PORT3;$LOCALHOST:$PORT2,balance=round-robin"
+CMD4="$TRACE $SOCAT $opts -t 0.5 - TCP4:$LOCALHOST:$PORT4"
+printf "test $F_n $TEST... " $N
+$TRACE $SOCAT $opts TCP4-LISTEN:$PORT1,$REUSEADDR,fork SYSTEM:'echo A' >/dev/null 2>"${te}1" &
+pid1=$!
+$TRACE $SOCAT $opts TCP4-LISTEN:$PORT2,$REUSEADDR,fork SYSTEM:'echo B' >/dev/null 2>"${te}2" &
+pid2=$!
+waittcp4port $PORT1 1
+waittcp4port $PORT2 1
+$CMD3 >/dev/null 2>"${te}3" &
+pid3=$!
+waittcp4port $PORT4 1
+rc4=0
+for i in 1 2 3 4; do
+    $CMD4 </dev/null >>"$tf" 2>>"${te}4" || rc4=$?
+done
+kill $pid3 $pid2 $pid1 2>/dev/null; wait
+if [ "$rc4" -ne 0 ]; then
+    $PRINTF "$FAILED (rc4=$rc4)\n"
+    echo "$CMD3 &"
+    cat "${te}3" >&2
+    echo "$CMD4"
+    cat "${te}4" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif [ "$(wc -l <"$tf")" -ne 4 ] || ! grep -q A "$tf" || ! grep -q B "$tf"; then
+    $PRINTF "$FAILED (not balanced)\n"
+    echo "$CMD3 &"
+    cat "${te}3" >&2
+    cat "$tf" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2 &"; echo "$CMD3 &"; echo "$CMD4"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" "${te}3" "${te}4" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option openssl-session-cache: the children of a forking listener that
+# connect to the same OpenSSL server resume the session the first one negotiated
+NAME=OPENSSL_SESSION_CACHE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%openssl%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%fork%*|*%$NAME%*)
+TEST="$NAME: OpenSSL client session resumption across forks"
+# Start an OpenSSL echo server, and a forking TCP listener that connects to it
+# with option session-cache. Three clients must get their data echoed, and
+# the listener must log that a session was resumed
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN OPENSSL); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions openssl-session-cache) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+gentestcert testsrv
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+da="test$N $(date) $RANDOM"
+newport tcp4; PORT1=$PORT
+newport tcp4; PORT2=$PORT
+CMD1="$TRACE $SOCAT $opts OPENSSL-LISTEN:$PORT1,pf=ip4,$REUSEADDR,fork,$SOCAT_EGD,cert=testsrv.crt,key=testsrv.key,verify=0 PIPE"
+CMD2="$TRACE $SOCAT $opts -t 0.5 -d -d -d TCP4-LISTEN:$PORT2,$REUSEADDR,fork OPENSSL:$LOCALHOST:$PORT1,pf=ip4,verify=0,session-cache,$SOCAT_EGD"
+CMD3="$TRACE $SOCAT $opts -t 0.5 - TCP4:$LOCALHOST:$PORT2"
+printf "test $F_n $TEST... " $N
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT1 1
+$CMD2 >/dev/null 2>"${te}2" &
+pid2=$!
+waittcp4port $PORT2 1
+rc3=0
+for i in 1 2 3; do
+    echo "$da" |$CMD3 >>"$tf" 2>>"${te}3" || rc3=$?
+done
+kill $pid2 $pid1 2>/dev/null; wait
+if [ "$rc3" -ne 0 ] || [ "$(grep -c "^$da\$" "$tf")" -ne 3 ]; then
+    $PRINTF "$FAILED (rc3=$rc3)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    echo "$CMD3"
+    cat "${te}3" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "SSL session resumed" "${te}2"; then
+    $PRINTF "$FAILED (no session resumed)\n"
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2 &"; echo "$CMD3"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" "${te}3" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option openssl-session-cache with a forking OpenSSL server: the server
+# children find the sessions the others have stored
+NAME=OPENSSL_SESSION_CACHE_SERVER
+case "$TESTS" in
+*%$N%*|*%functions%*|*%openssl%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%fork%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: OpenSSL server session cache shared by children"
+# Start an OpenSSL echo server with option session-cache, and a forking TCP
+# listener that connects to it with option session-cache. Three clients must
+# get their data echoed, and the server must log that it resumed a session
+# from its cache
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN OPENSSL); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions openssl-session-cache) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+gentestcert testsrv
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+da="test$N $(date) $RANDOM"
+newport tcp4; PORT1=$PORT
+newport tcp4; PORT2=$PORT
+CMD1="$TRACE $SOCAT $opts -d -d -d OPENSSL-LISTEN:$PORT1,pf=ip4,$REUSEADDR,fork,$SOCAT_EGD,cert=testsrv.crt,key=testsrv.key,verify=0,session-cache PIPE"
+CMD2="$TRACE $SOCAT $opts -t 0.5 TCP4-LISTEN:$PORT2,$REUSEADDR,fork OPENSSL:$LOCALHOST:$PORT1,pf=ip4,verify=0,session-cache,$SOCAT_EGD"
+CMD3="$TRACE $SOCAT $opts -t 0.5 - TCP4:$LOCALHOST:$PORT2"
+printf "test $F_n $TEST... " $N
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT1 1
+$CMD2 >/dev/null 2>"${te}2" &
+pid2=$!
+waittcp4port $PORT2 1
+rc3=0
+for i in 1 2 3; do
+    echo "$da" |$CMD3 >>"$tf" 2>>"${te}3" || rc3=$?
+done
+kill $pid2 $pid1 2>/dev/null; wait
+if [ "$rc3" -ne 0 ] || [ "$(grep -c "^$da\$" "$tf")" -ne 3 ]; then
+    $PRINTF "$FAILED (rc3=$rc3)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    echo "$CMD3"
+    cat "${te}3" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "TLS session cache: session found" "${te}1" ||
+	! grep -q "SSL session resumed" "${te}1"; then
+    $PRINTF "$FAILED (no session resumed)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2 &"; echo "$CMD3"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" "${te}3" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option openssl-ticket-key-file: a client resumes its session after the
+# OpenSSL server has been restarted
+NAME=OPENSSL_TICKET_KEY_FILE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%openssl%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: OpenSSL session tickets survive server restart"
+# Create a ticket key file, start an OpenSSL echo server with it, and a forking
+# TCP listener that connects to it with option session-cache. Pass data through
+# once, restart the server, and pass data again; the second server must log
+# that it resumed the session
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN OPENSSL); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions openssl-ticket-key-file openssl-session-cache) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+gentestcert testsrv
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tk="$td/test$N.keys"
+da="test$N $(date) $RANDOM"
+openssl rand 80 >"$tk"
+newport tcp4; PORT1=$PORT
+newport tcp4; PORT2=$PORT
+CMD1="$TRACE $SOCAT $opts -d -d -d OPENSSL-LISTEN:$PORT1,pf=ip4,$REUSEADDR,fork,$SOCAT_EGD,cert=testsrv.crt,key=testsrv.key,verify=0,ticket-key-file=$tk PIPE"
+CMD2="$TRACE $SOCAT $opts -t 0.5 TCP4-LISTEN:$PORT2,$REUSEADDR,fork OPENSSL:$LOCALHOST:$PORT1,pf=ip4,verify=0,session-cache,$SOCAT_EGD"
+CMD3="$TRACE $SOCAT $opts -t 0.5 - TCP4:$LOCALHOST:$PORT2"
+printf "test $F_n $TEST... " $N
+$CMD2 >/dev/null 2>"${te}2" &
+pid2=$!
+waittcp4port $PORT2 1
+rc3=0
+for i in 1 2; do
+    $CMD1 >/dev/null 2>"${te}1.$i" &
+    pid1=$!
+    waittcp4port $PORT1 1
+    echo "$da" |$CMD3 >>"$tf" 2>>"${te}3" || rc3=$?
+    kill $pid1 2>/dev/null; wait $pid1
+done
+kill $pid2 2>/dev/null; wait
+if [ "$rc3" -ne 0 ] || [ "$(grep -c "^$da\$" "$tf")" -ne 2 ]; then
+    $PRINTF "$FAILED (rc3=$rc3)\n"
+    echo "$CMD1 &"
+    cat "${te}1.1" "${te}1.2" >&2
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    echo "$CMD3"
+    cat "${te}3" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "SSL session resumed" "${te}1.2"; then
+    $PRINTF "$FAILED (no session resumed)\n"
+    echo "$CMD1 &"
+    cat "${te}1.2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD2 &"; echo "$CMD1 &"; echo "$CMD3"; fi
+    if [ "$DEBUG" ];   then cat "${te}1.1" "${te}1.2" "${te}2" "${te}3" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option openssl-ktls: data passes an OpenSSL connection with kTLS
+# requested on both sides, whether or not the kernel takes over
+NAME=OPENSSL_KTLS
+case "$TESTS" in
+*%$N%*|*%functions%*|*%openssl%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: OpenSSL connection with option ktls"
+# Start an OpenSSL echo server with option ktls, send a 1MB file through it
+# with a client that also uses option ktls, and compare the echoed data
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN OPENSSL); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions openssl-ktls) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+gentestcert testsrv
+ti="$td/test$N.input"
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+dd if=/dev/urandom of="$ti" bs=1024 count=1024 2>/dev/null
+newport tcp4
+CMD1="$TRACE $SOCAT $opts -d -d -d OPENSSL-LISTEN:$PORT,pf=ip4,$REUSEADDR,$SOCAT_EGD,cert=testsrv.crt,key=testsrv.key,verify=0,ktls PIPE"
+CMD2="$TRACE $SOCAT $opts -t 1 -d -d -d - OPENSSL:$LOCALHOST:$PORT,pf=ip4,verify=0,ktls,$SOCAT_EGD"
+printf "test $F_n $TEST... " $N
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+$CMD2 <"$ti" >"$tf" 2>"${te}2"
+rc2=$?
+kill $pid1 2>/dev/null; wait
+if [ "$rc2" -ne 0 ] || ! cmp -s "$ti" "$tf"; then
+    $PRINTF "$FAILED (rc2=$rc2)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK"
+    if grep -q "kTLS active" "${te}2"; then echo; else echo " (kTLS not active)"; fi
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test options openssl-dynamic-records and openssl-read-ahead: bulk data
+# passes unmodified in both directions
+NAME=OPENSSL_RECORDS
+case "$TESTS" in
+*%$N%*|*%functions%*|*%openssl%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: OpenSSL record sizing and read-ahead"
+# Start an OpenSSL echo server with option dynamic-records,
+# send a 1MB file through it with a client that uses option read-ahead and a
+# large buffer, and compare the echoed data
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN OPENSSL); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions openssl-dynamic-records openssl-read-ahead) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+gentestcert testsrv
+ti="$td/test$N.input"
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+dd if=/dev/urandom of="$ti" bs=1024 count=1024 2>/dev/null
+newport tcp4
+CMD1="$TRACE $SOCAT $opts OPENSSL-LISTEN:$PORT,pf=ip4,$REUSEADDR,$SOCAT_EGD,cert=testsrv.crt,key=testsrv.key,verify=0,dynamic-records PIPE"
+CMD2="$TRACE $SOCAT $opts -b 65536 -t 1 - OPENSSL:$LOCALHOST:$PORT,pf=ip4,verify=0,read-ahead,dynamic-records,$SOCAT_EGD"
+printf "test $F_n $TEST... " $N
+$CMD1 >/dev/null 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+$CMD2 <"$ti" >"$tf" 2>"${te}2"
+rc2=$?
+kill $pid1 2>/dev/null; wait
+if [ "$rc2" -ne 0 ] || ! cmp -s "$ti" "$tf"; then
+    $PRINTF "$FAILED (rc2=$rc2)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test if socat uses sendfile() to transfer a regular file to a TCP socket, and
+# that the fast path honours the file position and option readbytes
+NAME=SENDFILE_TCP
+case "$TESTS" in
+*%$N%*|*%functions%*|*%file%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%listen%*|*%$NAME%*)
+TEST="$NAME: transfer of a regular file with sendfile()"
+# Start a TCP listener that writes to stdout; a second socat sends part of a
+# file, selected with options seek and readbytes, to it. Check that the sender
+# logs use of sendfile() and that the received data matches the file section
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP LISTEN FILE); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions seek readbytes) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! runsip4 >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}IPv4 not available on host${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+ti="$td/test$N.input"
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+dd if=/dev/urandom of="$ti" bs=1024 count=1024 2>/dev/null
+dd if="$ti" bs=1024 skip=1 count=500 2>/dev/null >"$td/test$N.expect"
+newport tcp4
+CMD1="$TRACE $SOCAT $opts -u TCP4-LISTEN:$PORT,$REUSEADDR -"
+CMD2="$TRACE $SOCAT $opts -d -d -d -u OPEN:$ti,seek=1024,readbytes=512000 TCP4:$LOCALHOST:$PORT"
+printf "test $F_n $TEST... " $N
+$CMD1 >"$tf" 2>"${te}1" &
+pid1=$!
+waittcp4port $PORT 1
+$CMD2 2>"${te}2"
+rc2=$?
+wait $pid1 2>/dev/null
+if [ "$rc2" -ne 0 ]; then
+    $PRINTF "$FAILED (rc2=$rc2)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "using sendfile()" "${te}2"; then
+    $PRINTF "$FAILED (sendfile() not used)\n"
+    echo "$CMD1 &"
+    cat "${te}1" >&2
+    echo "$CMD2"
+    cat "${te}2" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! cmp "$td/test$N.expect" "$tf" >"$tdiff" 2>&1; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD1 &"
+    echo "$CMD2"
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD1 &"; echo "$CMD2"; fi
+    if [ "$DEBUG" ];   then cat "${te}1" "${te}2" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option mmap: read a section of a file, selected with options seek and
+# readbytes, through small memory mapped windows
+NAME=OPEN_MMAP
+case "$TESTS" in
+*%$N%*|*%functions%*|*%file%*|*%open%*|*%$NAME%*)
+TEST="$NAME: read file through memory mapping"
+# Create a file of 1MB random data and let socat read 300000 bytes starting at
+# offset 1000 with options mmap and mmap-window=65536 (several window changes,
+# unaligned start). Check the log and compare the output with the file section
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats FILE); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions mmap mmap-window seek readbytes) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+ti="$td/test$N.input"
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+dd if=/dev/urandom of="$ti" bs=1024 count=1024 2>/dev/null
+tail -c +1001 "$ti" |head -c 300000 >"$td/test$N.expect"
+CMD="$TRACE $SOCAT $opts -d -d -d -u OPEN:$ti,mmap,mmap-window=65536,seek=1000,readbytes=300000 -"
+printf "test $F_n $TEST... " $N
+$CMD >"$tf" 2>"$te"
+rc=$?
+if [ "$rc" -ne 0 ]; then
+    $PRINTF "$FAILED (rc=$rc)\n"
+    echo "$CMD"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "memory mapped" "$te"; then
+    $PRINTF "$FAILED (mmap not used)\n"
+    echo "$CMD"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! cmp "$td/test$N.expect" "$tf" >"$tdiff" 2>&1; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD"
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD"; fi
+    if [ "$DEBUG" ];   then cat "$te" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option aio-buffers: read a section of a file, selected with options seek
+# and readbytes, with several asynchronous read requests in flight
+NAME=OPEN_AIO
+case "$TESTS" in
+*%$N%*|*%functions%*|*%file%*|*%open%*|*%$NAME%*)
+TEST="$NAME: read file with asynchronous read-ahead"
+# Create a file of 1MB random data and let socat read 300000 bytes starting at
+# offset 1000 with option aio-buffers=4 and block size 4096 (many requests,
+# short last block). Check the log and compare the output with the file section
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats FILE); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions aio-buffers seek readbytes) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+ti="$td/test$N.input"
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+dd if=/dev/urandom of="$ti" bs=1024 count=1024 2>/dev/null
+tail -c +1001 "$ti" |head -c 300000 >"$td/test$N.expect"
+CMD="$TRACE $SOCAT $opts -d -d -d -b 4096 -u OPEN:$ti,aio-buffers=4,seek=1000,readbytes=300000 -"
+printf "test $F_n $TEST... " $N
+$CMD >"$tf" 2>"$te"
+rc=$?
+if [ "$rc" -ne 0 ]; then
+    $PRINTF "$FAILED (rc=$rc)\n"
+    echo "$CMD"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "asynchronous requests" "$te"; then
+    $PRINTF "$FAILED (AIO not used)\n"
+    echo "$CMD"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! cmp "$td/test$N.expect" "$tf" >"$tdiff" 2>&1; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD"
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD"; fi
+    if [ "$DEBUG" ];   then cat "$te" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test options fadvise, drop-cache, and sync-range: copy a file with page
+# cache hints on both sides
+NAME=DROP_CACHE_SYNC_RANGE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%file%*|*%open%*|*%$NAME%*)
+TEST="$NAME: copy file with page cache hints"
+# Create a file of 1MB random data and let socat copy it with options
+# fadvise=sequential and drop-cache on the input and drop-cache with
+# sync-range=65536 on the output (many writeback steps). Check the log and
+# compare the copy with the original
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats FILE CREAT); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions fadvise drop-cache sync-range) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+ti="$td/test$N.input"
+tf="$td/test$N.output"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+dd if=/dev/urandom of="$ti" bs=1024 count=1024 2>/dev/null
+CMD="$TRACE $SOCAT $opts -d -d -d -u OPEN:$ti,fadvise=sequential,drop-cache CREATE:$tf,drop-cache,sync-range=65536"
+printf "test $F_n $TEST... " $N
+$CMD 2>"$te"
+rc=$?
+if [ "$rc" -ne 0 ]; then
+    $PRINTF "$FAILED (rc=$rc)\n"
+    echo "$CMD"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "writing back and dropping" "$te"; then
+    $PRINTF "$FAILED (no writeback)\n"
+    echo "$CMD"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! cmp "$ti" "$tf" >"$tdiff" 2>&1; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD"
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD"; fi
+    if [ "$DEBUG" ];   then cat "$te" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test options sparse and sparse-stream: copy a sparse file through a pipe
+# with hole records and expand it into a file again
+NAME=SPARSE_STREAM
+case "$TESTS" in
+*%$N%*|*%functions%*|*%file%*|*%pipe%*|*%$NAME%*)
+TEST="$NAME: copy sparse file via sparse stream"
+# Create a file with two data regions and holes between and behind them.
+# Let one socat read it with option sparse and write the sparse stream to
+# stdout, and a second one decode it from stdin into a new file. Check the
+# log for passed holes and compare the copy with the original
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats FILE CREAT STDIO); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions sparse sparse-stream) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+ti="$td/test$N.input"
+tf="$td/test$N.output"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+dd if=/dev/urandom of="$ti" bs=4096 count=2 2>/dev/null
+dd if=/dev/urandom of="$ti" bs=4096 seek=512 count=3 conv=notrunc 2>/dev/null
+dd if=/dev/null of="$ti" bs=4096 seek=1024 2>/dev/null
+CMD0="$TRACE $SOCAT $opts -d -d -d -u OPEN:$ti,sparse STDOUT,sparse-stream"
+CMD1="$TRACE $SOCAT $opts -u STDIN,sparse-stream CREATE:$tf"
+printf "test $F_n $TEST... " $N
+$CMD0 2>"${te}0" |$CMD1 2>"${te}1"
+rc=$?
+if [ "$rc" -ne 0 ]; then
+    $PRINTF "$FAILED (rc=$rc)\n"
+    echo "$CMD0 |"
+    cat "${te}0" >&2
+    echo "$CMD1"
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "passing hole" "${te}0"; then
+    $PRINTF "$FAILED (no holes passed)\n"
+    echo "$CMD0 |"
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! cmp "$ti" "$tf" >"$tdiff" 2>&1; then
+    $PRINTF "$FAILED (data differs)\n"
+    echo "$CMD0 |"
+    echo "$CMD1"
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 |"; echo "$CMD1"; fi
+    if [ "$DEBUG" ];   then cat "${te}0" "${te}1" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option follow: socat reads a log file that grows, is rotated, and is
+# truncated, and passes all data written to it
+NAME=OPEN_FOLLOW
+case "$TESTS" in
+*%$N%*|*%functions%*|*%file%*|*%ignoreeof%*|*%$NAME%*)
+TEST="$NAME: follow a file through rotation and truncation"
+# Start socat that follows the input file to an output file. Append a line,
+# rename the file, append to the old file and create a new one, then truncate
+# the new file and write it again. Check that all lines arrived in order and
+# that socat reopened the file and noticed the truncation
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats FILE CREAT); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions follow) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+ti="$td/test$N.log"
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD="$TRACE $SOCAT $opts -d -d -u OPEN:$ti,follow CREATE:$tf"
+printf "test $F_n $TEST... " $N
+echo "$da 1" >"$ti"
+$CMD 2>"$te" &
+pid=$!
+relsleep 2
+echo "$da 2" >>"$ti"
+relsleep 1
+mv "$ti" "$ti.1"
+echo "$da 3" >>"$ti.1"
+echo "$da 4" >"$ti"
+relsleep 2
+: >"$ti"
+echo "$da 5" >>"$ti"
+relsleep 2
+kill $pid 2>/dev/null; wait
+if ! printf "$da %d\n" 1 2 3 4 5 |diff - "$tf" >"$tdiff"; then
+    $PRINTF "$FAILED (diff)\n"
+    echo "$CMD &"
+    cat "$te" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "reopened rotated file" "$te" ||
+	! grep -q "has been truncated" "$te"; then
+    $PRINTF "$FAILED (no reopen or truncation message)\n"
+    echo "$CMD &"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD &"; fi
+    if [ "$DEBUG" ];   then cat "$te" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test if socat with option -W obtains the lock immediately after the holder
+# released it, not only after the next one second check
+NAME=WAITLOCK_HANDOVER
+case "$TESTS" in
+*%$N%*|*%functions%*|*%system%*|*%$NAME%*)
+TEST="$NAME: option -W obtains lock right after release"
+# Create the lock file, start socat with -W that writes a string to a file,
+# remove the lock file, and check that the string arrived well before one
+# second has passed
+if ! eval $NUMCOND; then :;
+elif [ "$UNAME" != Linux ]; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}only on Linux${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! F=$(testfeats SYSTEM CREAT); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tl="$td/test$N.lock"
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD="$TRACE $SOCAT $opts -d -d -W $tl -u SYSTEM:\"echo '$da'\" CREATE:$tf"
+printf "test $F_n $TEST... " $N
+touch "$tl"
+eval "$CMD" 2>"$te" &
+pid=$!
+relsleep 3
+rm -f "$tl"
+relsleep 3
+if ! echo "$da" |diff - "$tf" >"$tdiff" 2>&1; then
+    $PRINTF "$FAILED (lock not taken over in time)\n"
+    echo "$CMD &"
+    cat "$te" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "waiting for lock" "$te"; then
+    $PRINTF "$FAILED (did not wait)\n"
+    echo "$CMD &"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD &"; fi
+    if [ "$DEBUG" ];   then cat "$te" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+kill $pid 2>/dev/null; wait
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option spawn: the sub process of EXEC is started with posix_spawn()
+# and transfers data like a forked one
+NAME=EXEC_SPAWN
+case "$TESTS" in
+*%$N%*|*%functions%*|*%exec%*|*%$NAME%*)
+TEST="$NAME: EXEC with posix_spawn()"
+# Pass data through EXEC:cat with option spawn, and with pipes. Check that the
+# data came back and that socat spawned instead of forked the child process
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats EXEC STDIO); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions spawn) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -d -d - EXEC:$CAT,spawn"
+CMD1="$TRACE $SOCAT $opts -d -d - EXEC:$CAT,spawn,pipes"
+printf "test $F_n $TEST... " $N
+echo "$da" |$CMD0 >"${tf}0" 2>"${te}0"
+rc0=$?
+echo "$da" |$CMD1 >"${tf}1" 2>"${te}1"
+rc1=$?
+if [ "$rc0" -ne 0 -o "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED (rc0=$rc0, rc1=$rc1)\n"
+    echo "$CMD0"
+    cat "${te}0" >&2
+    echo "$CMD1"
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! echo "$da" |diff - "${tf}0" >"$tdiff" ||
+	! echo "$da" |diff - "${tf}1" >>"$tdiff"; then
+    $PRINTF "$FAILED (diff)\n"
+    echo "$CMD0"
+    echo "$CMD1"
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "spawned child process" "${te}0" ||
+	! grep -q "spawned child process" "${te}1"; then
+    $PRINTF "$FAILED (did not spawn)\n"
+    echo "$CMD0"
+    cat "${te}0" >&2
+    echo "$CMD1"
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0"; echo "$CMD1"; fi
+    if [ "$DEBUG" ];   then cat "${te}0" "${te}1" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+NAME=EXEC_INETD
+case "$TESTS" in
+*%$N%*|*%functions%*|*%exec%*|*%$NAME%*)
+TEST="$NAME: EXEC gets the first address with option inetd"
+# Pass data through EXEC:cat with option inetd. Check that the data came back
+# and that socat passed stdio to the child process. With option -v socat has
+# to see the data, so check that it relays them in this case
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats EXEC STDIO); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! o=$(testoptions inetd) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Option $o not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -d -d -d - EXEC:$CAT,inetd"
+CMD1="$TRACE $SOCAT $opts -d -d -d -v - EXEC:$CAT,inetd"
+printf "test $F_n $TEST... " $N
+echo "$da" |$CMD0 >"${tf}0" 2>"${te}0"
+rc0=$?
+echo "$da" |$CMD1 >"${tf}1" 2>"${te}1"
+rc1=$?
+if [ "$rc0" -ne 0 -o "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED (rc0=$rc0, rc1=$rc1)\n"
+    echo "$CMD0"
+    cat "${te}0" >&2
+    echo "$CMD1"
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! echo "$da" |diff - "${tf}0" >"$tdiff" ||
+	! echo "$da" |diff - "${tf}1" >>"$tdiff"; then
+    $PRINTF "$FAILED (diff)\n"
+    echo "$CMD0"
+    echo "$CMD1"
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "passing it the first address" "${te}0"; then
+    $PRINTF "$FAILED (did not pass)\n"
+    echo "$CMD0"
+    cat "${te}0" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "socat has to process the data, relaying" "${te}1"; then
+    $PRINTF "$FAILED (did not relay)\n"
+    echo "$CMD1"
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0"; echo "$CMD1"; fi
+    if [ "$DEBUG" ];   then cat "${te}0" "${te}1" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+NAME=SHM_RING
+case "$TESTS" in
+*%$N%*|*%functions%*|*%shmring%*|*%$NAME%*)
+TEST="$NAME: echo via shared memory ring"
+# Start a socat process that creates a SHM-RING and echoes the data with PIPE;
+# a second process attaches to the ring and sends data. Check that the data
+# came back and that unlink-close removed the file and the FIFOs
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats SHMRING PIPE STDIO); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! A=$(testaddrs SHM-RING) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Address $A not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+ts="$td/test$N.shm"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts SHM-RING:$ts,unlink-early,unlink-close PIPE"
+CMD1="$TRACE $SOCAT $opts - SHM-RING:$ts"
+printf "test $F_n $TEST... " $N
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waitfile "$ts"
+echo "$da" |$CMD1 >"${tf}1" 2>"${te}1"
+rc1=$?
+i=0; while kill -0 $pid0 2>/dev/null && [ $i -lt 20 ]; do relsleep 1; i=$((i+1)); done
+kill $pid0 2>/dev/null; wait
+if [ "$rc1" -ne 0 ]; then
+    $PRINTF "$FAILED (rc1=$rc1)\n"
+    echo "$CMD0 &"
+    cat "${te}0" >&2
+    echo "$CMD1"
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! echo "$da" |diff - "${tf}1" >"$tdiff"; then
+    $PRINTF "$FAILED (diff)\n"
+    echo "$CMD0 &"
+    cat "${te}0" >&2
+    echo "$CMD1"
+    cat "${te}1" >&2
+    echo "// diff:" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif [ -e "$ts" -o -e "$ts.0" -o -e "$ts.1" -o -e "$ts.2" -o -e "$ts.3" ]; then
+    $PRINTF "$FAILED (files not removed)\n"
+    echo "$CMD0 &"
+    cat "${te}0" >&2
+    echo "$CMD1"
+    cat "${te}1" >&2
+    ls -l "$ts"* >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1"; fi
+    if [ "$DEBUG" ];   then cat "${te}0" "${te}1" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+NAME=SHM_RING_PEER_GONE
+case "$TESTS" in
+*%$N%*|*%functions%*|*%shmring%*|*%$NAME%*)
+TEST="$NAME: shared memory ring with a killed peer"
+# Start a socat process that creates a SHM-RING and a second one that attaches
+# to it; kill the second one. Check that the first one reads EOF and
+# terminates. Then check that a new process creates the ring again although
+# the file was not removed, and that data are transferred
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats SHMRING STDIO); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+elif ! A=$(testaddrs SHM-RING) >/dev/null; then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Address $A not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+tf="$td/test$N.stdout"
+te="$td/test$N.stderr"
+ts="$td/test$N.shm"
+tp="$td/test$N.pipe"
+tdiff="$td/test$N.diff"
+da="test$N $(date) $RANDOM"
+CMD0="$TRACE $SOCAT $opts -u SHM-RING:$ts,unlink-early -"
+CMD1="$TRACE $SOCAT $opts -d -d -u - SHM-RING:$ts"
+CMD2="$TRACE $SOCAT $opts -d -d -u SHM-RING:$ts,unlink-close -"
+CMD3="$TRACE $SOCAT $opts -u - SHM-RING:$ts"
+printf "test $F_n $TEST... " $N
+mkfifo "$tp"
+$CMD0 >/dev/null 2>"${te}0" &
+pid0=$!
+waitfile "$ts"
+$CMD1 <>"$tp" >/dev/null 2>"${te}1" &
+pid1=$!
+i=0; while ! grep -q "attached" "${te}1" && [ $i -lt 20 ]; do relsleep 1; i=$((i+1)); done
+kill -9 $pid1 2>/dev/null; wait $pid1 2>/dev/null
+i=0; while kill -0 $pid0 2>/dev/null && [ $i -lt 30 ]; do relsleep 1; i=$((i+1)); done
+if kill -0 $pid0 2>/dev/null; then
+    rc0=hang; kill $pid0 2>/dev/null
+else
+    rc0=0
+fi
+wait $pid0 2>/dev/null
+$CMD2 >"${tf}2" 2>"${te}2" &
+pid2=$!
+i=0; while ! grep -q "created" "${te}2" && [ $i -lt 20 ]; do relsleep 1; i=$((i+1)); done
+echo "$da" |$CMD3 2>"${te}3"
+rc3=$?
+i=0; while kill -0 $pid2 2>/dev/null && [ $i -lt 20 ]; do relsleep 1; i=$((i+1)); done
+kill $pid2 2>/dev/null; wait
+if [ "$rc0" != 0 ] || ! grep -q "has terminated" "${te}0"; then
+    $PRINTF "$FAILED (first process did not terminate)\n"
+    echo "$CMD0 &"
+    cat "${te}0" >&2
+    echo "$CMD1 <>$tp &"
+    cat "${te}1" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif [ "$rc3" -ne 0 ]; then
+    $PRINTF "$FAILED (rc3=$rc3)\n"
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    echo "$CMD3"
+    cat "${te}3" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! echo "$da" |diff - "${tf}2" >"$tdiff"; then
+    $PRINTF "$FAILED (diff)\n"
+    echo "$CMD2 &"
+    cat "${te}2" >&2
+    echo "$CMD3"
+    cat "${te}3" >&2
+    echo "// diff:" >&2
+    cat "$tdiff" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD0 &"; echo "$CMD1 <>$tp &"; echo "$CMD2 &"; echo "$CMD3"; fi
+    if [ "$DEBUG" ];   then cat "${te}0" "${te}1" "${te}2" "${te}3" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
+# Test option resolve-timeout when the name resolution takes longer than
+# allowed: socat must give up without connecting and kill the helper process
+NAME=TCP4_RESOLVE_TIMEOUT_EXPIRED
+case "$TESTS" in
+*%$N%*|*%functions%*|*%tcp%*|*%tcp4%*|*%ip4%*|*%$NAME%*)
+TEST="$NAME: TCP4 connect with expired resolve-timeout"
+# A timeout of one microsecond expires before the helper process can answer;
+# socat must fail with the timeout message, must not try to connect, and the
+# helper process must be gone
+if ! eval $NUMCOND; then :;
+elif ! F=$(testfeats IP4 TCP STDIO); then
+    $PRINTF "test $F_n $TEST... ${YELLOW}Feature $F not available in $SOCAT${NORMAL}\n" $N
+    numCANT=$((numCANT+1))
+    listCANT="$listCANT $N"
+else
+te="$td/test$N.stderr"
+newport tcp4
+CMD="$TRACE $SOCAT $opts -d -d -d - TCP4:localhost:$PORT,resolve-timeout=0.000001"
+printf "test $F_n $TEST... " $N
+$CMD </dev/null >/dev/null 2>"$te"
+rc=$?
+helper=$(sed -n 's/.*resolving "localhost:'$PORT'" in process \([0-9]*\).*/\1/p' "$te")
+if [ -n "$helper" ]; then relsleep 1; fi
+if [ "$rc" -eq 0 ]; then
+    $PRINTF "$FAILED (rc=$rc)\n"
+    echo "$CMD"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif ! grep -q "name resolution of \"localhost:$PORT\" timed out" "$te"; then
+    $PRINTF "$FAILED (no timeout)\n"
+    echo "$CMD"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif grep -q "opening connection to" "$te"; then
+    $PRINTF "$FAILED (connected anyway)\n"
+    echo "$CMD"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+elif [ -z "$helper" ] || kill -0 "$helper" 2>/dev/null; then
+    $PRINTF "$FAILED (helper process \"$helper\" remains)\n"
+    echo "$CMD"
+    cat "$te" >&2
+    numFAIL=$((numFAIL+1))
+    listFAIL="$listFAIL $N"
+    namesFAIL="$namesFAIL $NAME"
+else
+    $PRINTF "$OK\n"
+    if [ "$VERBOSE" ]; then echo "$CMD"; fi
+    if [ "$DEBUG" ];   then cat "$te" >&2; fi
+    numOK=$((numOK+1))
+    listOK="$listOK $N"
+fi
+fi # NUMCOND
+ ;;
+esac
+N=$((N+1))
+
 # Test the children-shutup option
 NAME=CHILDREN_SHUTUP
 case "$TESTS" in
@@ -23,6 +23,9 @@
 #include "xiolockfile.h"
 
 #include "xio-pipe.h"
+#include "xio-session.h"
+#include "xio-cache.h"
+#include "xio-follow.h"
 
 
 /* command line options */
@@ -40,6 +43,7 @@ struct socat_opts {
    xiolock_t lock;	/* a lock file */
    unsigned long log_sigs;	/* signals to be caught just for logging */
    bool statistics; 	/* log statistics on exit */
+   const char *relays;	/* file with address pairs, one relay per line */
 } socat_opts = {
    false,	/* verbose */
    false,	/* verbhex */
@@ -53,7 +57,8 @@ struct socat_opts {
    false,	/* righttoleft */
    { NULL, 0 },	/* lock */
    1<<SIGHUP | 1<<SIGINT | 1<<SIGQUIT | 1<<SIGILL | 1<<SIGABRT | 1<<SIGBUS | 1<<SIGFPE | 1<<SIGSEGV | 1<<SIGTERM, 	/* log_sigs */
-   false	/* statistics */
+   false,	/* statistics */
+   NULL		/* relays */
 };
 
 void socat_usage(FILE *fd);
@@ -61,10 +66,23 @@ void socat_opt_hint(FILE *fd, char a, char b);
 void socat_version(FILE *fd);
 int socat(const char *address1, const char *address2);
 int _socat(void);
+#if _WITH_SOCKET
+static int socat_sessions(const char *address2);
+#endif
+static int socat_relays(const char *filename);
 int cv_newline(unsigned char *buff, ssize_t *bytes, int lineterm1, int lineterm2);
 void socat_signal(int sig);
 void socat_signal_logstats(int sig);
 static int socat_sigchild(struct single *file);
+static int socat_passed(void);
+static bool socat_readptr_check(xiofile_t *inpipe, xiofile_t *outpipe);
+#if HAVE_SENDFILE || HAVE_COPY_FILE_RANGE
+static int socat_zerocopy_check(xiofile_t *inpipe, xiofile_t *outpipe, bool righttoleft);
+static ssize_t socat_zerocopy(xiofile_t *inpipe, xiofile_t *outpipe, size_t bufsiz, bool righttoleft);
+#endif
+static void socat_sparse_check(xiofile_t *inpipe, xiofile_t *outpipe, bool righttoleft);
+static ssize_t socat_sparse_read(xiofile_t *inpipe, xiofile_t *outpipe, unsigned char *buff, size_t *bufsiz, bool righttoleft);
+static int socat_sparse_header(xiofile_t *outpipe, int type, unsigned long long len);
 
 void lftocrlf(char **in, ssize_t *len, size_t bufsiz);
 void crlftolf(char **in, ssize_t *len, size_t bufsiz);
@@ -333,6 +351,14 @@ int main(int argc, const char *argv[]) {
 	    xioparms.experimental = true;
 	 } else if (!strcmp("statistics", &arg1[0][2])) {
 	    socat_opts.statistics = true;
+	 } else if (!strncmp("relays=", &arg1[0][2], 7)) {
+	    socat_opts.relays = &arg1[0][9];
+	 } else if (!strcmp("relays", &arg1[0][2])) {
+	    ++arg1, --argc;
+	    if ((socat_opts.relays = *arg1) == NULL) {
+	       Error("option --relays requires an argument; use option \"-h\" for help");
+	       Exit(1);
+	    }
 	 } else {
 	    Error1("unknown option \"%s\"; use option \"-h\" for help", arg1[0]);
 	 }
@@ -357,7 +383,12 @@ int main(int argc, const char *argv[]) {
       }
       ++arg1; --argc;
    }
-   if (argc != 2) {
+   if (socat_opts.relays != NULL) {
+      if (argc != 0) {
+	 Error1("no addresses allowed with option --relays (there are %d)", argc);
+	 Exit(1);
+      }
+   } else if (argc != 2) {
       Error1("exactly 2 addresses required (there are %d); use option \"-h\" for help", argc);
       Exit(1);
    }
@@ -426,7 +457,7 @@ int main(int argc, const char *argv[]) {
 
    Atexit(socat_unlock);
 #if WITH_STATS
-   if (socat_opts.statistics) {
+   if (socat_opts.statistics && socat_opts.relays == NULL) {
       Atexit(socat_print_stats);
    }
 #endif /* WITH_STATS */
@@ -438,7 +469,11 @@ int main(int argc, const char *argv[]) {
    Info1("default listen IP version is %c", xioparms.default_ip);
    Info1("preferred resolve IP version is %c", xioparms.preferred_ip);
 
-   result = socat(arg1[0], arg1[1]);
+   if (socat_opts.relays != NULL) {
+      result = socat_relays(socat_opts.relays);
+   } else {
+      result = socat(arg1[0], arg1[1]);
+   }
    if (result == EXIT_SUCCESS && engine_result != EXIT_SUCCESS) {
       result = engine_result; 	/* a signal handler reports failure */
    }
@@ -452,6 +487,7 @@ void socat_usage(FILE *fd) {
    fputs(copyright_socat, fd); fputc('\n', fd);
    fputs("Usage:\n", fd);
    fputs("socat [options] <bi-address> <bi-address>\n", fd);
+   fputs("socat [options] --relays=<file>\n", fd);
    fputs("   options (general command line options):\n", fd);
    fputs("      -V     print version and feature information to stdout, and exit\n", fd);
 #if WITH_HELP
@@ -466,6 +502,7 @@ void socat_usage(FILE *fd) {
 #endif
    fputs("      --experimental enable experimental features\n", fd);
    fputs("      --statistics   output transfer statistics on exit\n", fd);
+   fputs("      --relays=<file> run the address pairs listed in file, one process per line\n", fd);
    fputs("      -ly[facility]  log to syslog, using facility (default is daemon)\n", fd);
    fputs("      -lf<logfile>   log to file\n", fd);
    fputs("      -ls            log to stderr (default if no other log)\n", fd);
@@ -633,6 +670,11 @@ void socat_version(FILE *fd) {
 #else
    fputs("  #undef WITH_POSIXMQ\n", fd);
 #endif
+#ifdef WITH_SHMRING
+   fprintf(fd, "  #define WITH_SHMRING %d\n", WITH_SHMRING);
+#else
+   fputs("  #undef WITH_SHMRING\n", fd);
+#endif
 #ifdef WITH_SOCKS4
    fprintf(fd, "  #define WITH_SOCKS4 %d\n", WITH_SOCKS4);
 #else
@@ -752,23 +794,53 @@ int closing = 0;	/* 0..no eof yet, 1..first eof just occurred,
 int sniffleft = -1; 		/* -1 or an FD for teeing data arriving on xfd1 */
 int sniffright = -1; 	/* -1 or an FD for teeing data arriving on xfd2 */
 
+#if HAVE_SENDFILE || HAVE_COPY_FILE_RANGE
+/* in-kernel copy method for each direction, determined when the transfer
+   loop starts; index 0 is left to right, 1 is right to left */
+enum {
+   ZEROCOPY_NONE,	/* read() into buff, write() from buff */
+   ZEROCOPY_SENDFILE,	/* file to socket or pipe */
+   ZEROCOPY_COPYRANGE	/* file to file */
+} ;
+static int zerocopy[2] = { ZEROCOPY_NONE, ZEROCOPY_NONE };
+#endif
+
+/* handling of holes for each direction (options sparse, sparse-stream),
+   determined when the transfer loop starts. On a sparse stream, data are
+   sent as records with a header of one type byte ('D' for data that follow,
+   'H' for a hole) and a 64 bit length in network byte order */
+#define SPARSE_HDRLEN	9
+enum {
+   SPARSE_NONE,		/* in: plain data; out: write holes as zero bytes */
+   SPARSE_FILE,		/* in: skip holes of file; out: recreate them */
+   SPARSE_STREAM	/* in: decode records; out: encode records */
+} ;
+static struct {
+   int   in, out;	/* SPARSE_* method */
+   off_t pos;		/* SPARSE_FILE input: current file offset */
+   off_t end;		/* SPARSE_FILE input: end of current data region */
+   unsigned char hdr[SPARSE_HDRLEN];	/* SPARSE_STREAM input: header */
+   size_t hdrlen;	/* bytes of hdr received */
+   unsigned long long left;	/* bytes left in current data record */
+} sparsetab[2];
+
 /* call this function when the common command line options are parsed, and the
    addresses are extracted (but not resolved). */
 int socat(const char *address1, const char *address2) {
    int mayexec;
 
    if (socat_opts.lefttoright) {
-      if ((sock1 = xioopen(address1, XIO_RDONLY|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT)) == NULL) {
+      if ((sock1 = xioopen(address1, XIO_RDONLY|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT|XIO_MAYSESSION)) == NULL) {
 	 return -1;
       }
       xiosetsigchild(sock1, socat_sigchild);
    } else if (socat_opts.righttoleft) {
-      if ((sock1 = xioopen(address1, XIO_WRONLY|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT)) == NULL) {
+      if ((sock1 = xioopen(address1, XIO_WRONLY|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT|XIO_MAYSESSION)) == NULL) {
 	 return -1;
       }
       xiosetsigchild(sock1, socat_sigchild);
    } else {
-      if ((sock1 = xioopen(address1, XIO_RDWR|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT)) == NULL) {
+      if ((sock1 = xioopen(address1, XIO_RDWR|XIO_MAYFORK|XIO_MAYCHILD|XIO_MAYCONVERT|XIO_MAYSESSION)) == NULL) {
 	 return -1;
       }
       xiosetsigchild(sock1, socat_sigchild);
@@ -797,7 +869,21 @@ int socat(const char *address1, const char *address2) {
    }
 #endif
 
+#if _WITH_SOCKET
+   if (sock1->common.flags & XIO_DOESSESSION) {
+      return socat_sessions(address2);
+   }
+#endif
+
    mayexec = (sock1->common.flags&XIO_DOESCONVERT ? 0 : XIO_MAYEXEC);
+   /* when socat does not look at the data, a child process may get address 1
+      directly */
+   if (mayexec && !socat_opts.verbose && !socat_opts.verbhex &&
+       !socat_opts.lefttoright && !socat_opts.righttoleft &&
+       socat_opts.total_timeout.tv_usec >= 1000000 &&
+       xioparms.sniffleft_name == NULL && xioparms.sniffright_name == NULL) {
+      mayexec |= XIO_MAYPASS;
+   }
    if (XIO_WRITABLE(sock1)) {
       if (XIO_READABLE(sock1)) {
 	 if ((sock2 = xioopen(address2, XIO_RDWR|XIO_MAYFORK|XIO_MAYCHILD|mayexec|XIO_MAYCONVERT)) == NULL) {
@@ -839,10 +925,757 @@ int socat(const char *address1, const char *address2) {
    }
 #endif
 
+   if (sock2->common.flags & XIO_DOESPASS) {
+      return socat_passed();
+   }
+
    Info("resolved and opened all sock addresses");
    return _socat();	/* nsocks, sockets are visible outside function */
 }
 
+/* address 2 has passed the fds of address 1 to its child process (option
+   inetd). Closes them here without shutdown, so the connection remains with
+   the child, and waits until the child terminates */
+static int socat_passed(void) {
+   struct single *sfd;
+   struct timeval start, now;
+   sigset_t chldmask, oldmask;
+   int i;
+
+   for (i = 0; i < 2; ++i) {
+      sfd = (i == 0 ? XIO_RDSTREAM(sock1) : XIO_WRSTREAM(sock1));
+      if (sfd->howtoend == END_SHUTDOWN)
+	 sfd->howtoend = END_CLOSE;
+      else if (sfd->howtoend == END_SHUTDOWN_KILL)
+	 sfd->howtoend = END_CLOSE_KILL;
+   }
+   xioclose(sock1);
+
+   Gettimeofday(&start, NULL);
+   Info1("passed first address to child process "F_pid", waiting",
+	 sock2->stream.para.exec.pid);
+   /* the SIGCHLD handler resets pid; block it while checking */
+   sigemptyset(&chldmask);
+   sigaddset(&chldmask, SIGCHLD);
+   Sigprocmask(SIG_BLOCK, &chldmask, &oldmask);
+   while (sock2->stream.para.exec.pid != 0) {
+      sigsuspend(&oldmask);
+   }
+   Sigprocmask(SIG_SETMASK, &oldmask, NULL);
+   Gettimeofday(&now, NULL);
+   now.tv_sec -= start.tv_sec;
+   if ((now.tv_usec -= start.tv_usec) < 0) {
+      now.tv_usec += 1000000;
+      now.tv_sec  -= 1;
+   }
+   Notice2("child process terminated after "F_tv_sec"."F_tv_usec" seconds",
+	   now.tv_sec, now.tv_usec);
+   return 0;
+}
+
+#if _WITH_SOCKET
+/* the listening address in session-table mode, for closing the sessions on
+   exit */
+static struct single *socat_sessions_sfd;
+
+/* closes the second address instance of a session and removes the session */
+static void socat_session_close(struct single *lsfd, struct xiosession *s) {
+   xiofile_t *up = s->upstream;
+
+   if (up != NULL) {
+      xioclose(up);
+      /* a child that still waits for its address would stay forever */
+      if (s->pid > 0 && !s->upeof && Kill(s->pid, SIGTERM) < 0) {
+	 Info2("kill("F_pid", SIGTERM): %s", s->pid, strerror(errno));
+      }
+      if ((up->tag & ~XIO_TAG_CLOSED) == XIO_TAG_DUAL) {
+	 free(up->dual.stream[0]);
+	 free(up->dual.stream[1]);
+      }
+      free(up);
+   }
+   xiosession_del(lsfd, s);
+}
+
+/* the instances of the second address are not registered in sock[], so
+   xioexit() does not close them */
+static void socat_sessions_exit(void) {
+   struct xiosession *s;
+
+   if (socat_sessions_sfd == NULL)
+      return;
+   while ((s = xiosession_first(socat_sessions_sfd)) != NULL)
+      socat_session_close(socat_sessions_sfd, s);
+   socat_sessions_sfd = NULL;
+}
+
+/* in the child process of a session: relays between its end of the socket
+   pair and the second address with the usual transfer loop. The listener
+   and the other sessions belong to the parent process. Does not return */
+static void socat_session_child(const char *address2, int upflags, int fd) {
+   struct xiosession *s;
+   char addr[16];
+
+   for (s = xiosession_first(socat_sessions_sfd); s != NULL; s = s->next) {
+      if (s->fd >= 0)  Close(s->fd);
+      if (s->upstream != NULL)  Close(XIO_GETRDFD(s->upstream));
+   }
+   Close(socat_sessions_sfd->fd);
+   socat_sessions_sfd = NULL;
+   sock[0] = sock[1] = NULL;
+   snprintf(addr, sizeof(addr), "FD:%d", fd);
+   if ((sock1 = xioopen(addr, socat_opts.lefttoright ? XIO_RDONLY : XIO_RDWR))
+       == NULL ||
+       (sock2 = xioopen(address2, upflags)) == NULL) {
+      Exit(1);
+   }
+   xiosetsigchild(sock2, socat_sigchild);
+   Exit(_socat() < 0 ? 1 : 0);
+}
+
+/* opens the second address for a new session. Opening may block, e.g. on a
+   slow connect, so it is done by a child process that then relays between
+   the address and a SOCK_SEQPACKET socket pair; the session uses the other
+   end of the pair, which keeps the packet boundaries.
+   returns the session's end as xio file and the child in *pid, or NULL on
+   error */
+static xiofile_t *socat_session_open(const char *address2, int upflags,
+				     pid_t *pid) {
+   xiofile_t *up;
+   char addr[16];
+   int sv[2];
+
+   if (Socketpair(PF_UNIX, SOCK_SEQPACKET, 0, sv) < 0) {
+      Warn1("socketpair(PF_UNIX, SOCK_SEQPACKET, 0, ...): %s",
+	    strerror(errno));
+      return NULL;
+   }
+   if ((*pid = xio_fork(false, E_WARN, 0)) < 0) {
+      Close(sv[0]);  Close(sv[1]);
+      return NULL;
+   }
+   if (*pid == 0) {
+      Close(sv[0]);
+      socat_session_child(address2, upflags, sv[1]);
+   }
+   Close(sv[1]);
+   snprintf(addr, sizeof(addr), "FD:%d", sv[0]);
+   up = xioopen(addr, upflags & XIO_ACCMODE);
+   /* xioopen() registers the address as sock[1]; the instances belong to
+      their sessions */
+   sock[1] = NULL;
+   if (up == NULL) {
+      Close(sv[0]);
+      Kill(*pid, SIGTERM);
+      return NULL;
+   }
+   return up;
+}
+
+/* returns true when the time end has passed; otherwise reduces *wait to the
+   time left until end (tv_sec<0 in *wait means no limit yet) */
+static bool socat_session_due(const struct timeval *end,
+			      const struct timeval *now, struct timeval *wait) {
+   struct timeval rest;
+
+   rest.tv_sec  = end->tv_sec  - now->tv_sec;
+   rest.tv_usec = end->tv_usec - now->tv_usec;
+   if (rest.tv_usec < 0) {
+      --rest.tv_sec;  rest.tv_usec += 1000000;
+   }
+   if (rest.tv_sec < 0 || rest.tv_sec == 0 && rest.tv_usec == 0)
+      return true;
+   if (wait->tv_sec < 0 || rest.tv_sec < wait->tv_sec ||
+       rest.tv_sec == wait->tv_sec && rest.tv_usec < wait->tv_usec)
+      *wait = rest;
+   return false;
+}
+
+/* starts the closing timeout (option -t) of a session, during which data
+   still passes in the direction that is not yet finished */
+static void socat_session_linger(struct xiosession *s,
+				 const struct timeval *now) {
+   s->closing.tv_sec  = now->tv_sec  + socat_opts.closwait.tv_sec;
+   s->closing.tv_usec = now->tv_usec + socat_opts.closwait.tv_usec;
+   if (s->closing.tv_usec >= 1000000) {
+      ++s->closing.tv_sec;  s->closing.tv_usec -= 1000000;
+   }
+}
+
+/* write types whose fd is written directly, so the upstream can be written
+   without blocking */
+static bool socat_session_direct(xiofile_t *up) {
+   switch (XIO_WRSTREAM(up)->dtype & XIODATA_WRITEMASK) {
+   case XIOWRITE_STREAM:
+   case XIOWRITE_PIPE:
+   case XIOWRITE_2PIPE:
+      return true;
+   }
+   return false;
+}
+
+/* writes the packet, or the pending rest of the previous packet when buff is
+   NULL, to the second address of the session. Direct write types are
+   written without blocking and a rest is kept for the next POLLOUT; other
+   types are only written after poll() reported POLLOUT.
+   returns 0 on success, or -1 when the second address failed */
+static int socat_session_write(struct xiosession *s,
+			       const unsigned char *buff, size_t bytes) {
+   xiofile_t *up = s->upstream;
+   ssize_t writt;
+
+   if (buff != NULL) {
+      if (s->pend == NULL && (s->pend = Malloc(xioparms.bufsiz)) == NULL)
+	 return -1;
+      memcpy(s->pend, buff, bytes);
+      s->pendlen = bytes;
+      if (!socat_session_direct(up))
+	 return 0;	/* wait for POLLOUT */
+   }
+   if (socat_session_direct(up)) {
+      do {
+	 writt = Write(XIO_GETWRFD(up), s->pend, s->pendlen);
+      } while (writt < 0 && errno == EINTR);
+      if (writt < 0) {
+	 if (errno == EAGAIN || errno == EWOULDBLOCK)
+	    return 0;
+	 Info4("write(%d, %p, "F_Zu"): %s",
+	       XIO_GETWRFD(up), s->pend, s->pendlen, strerror(errno));
+	 return -1;
+      }
+   } else if ((writt = xiowrite(up, s->pend, s->pendlen)) < 0) {
+      return -1;
+   }
+   s->pendlen -= writt;
+   if (s->pendlen > 0)
+      memmove(s->pend, s->pend+writt, s->pendlen);
+   return 0;
+}
+
+/* passes a packet from the peer to the session's second address. While a
+   previous packet is still pending the new one is dropped, like a full
+   socket buffer would do */
+static int socat_session_put(struct xiosession *s,
+			     const unsigned char *buff, size_t bytes) {
+   char infobuff[256];
+
+   if (s->shutwr || s->pendlen > 0) {
+      Info2("session from %s busy, dropping packet of "F_Zu" bytes",
+	    sockaddr_info(&s->peer.soa, s->peerlen,
+			  infobuff, sizeof(infobuff)), bytes);
+      return 0;
+   }
+   return socat_session_write(s, buff, bytes);
+}
+
+/* the transfer loop for a datagram server address with option session-table:
+   address2 is opened once per peer, and packets are passed between the peers
+   and their instances of address2. Each instance is opened and served by a
+   child process, and writes to it do not block, so a slow or stalled
+   instance does not hold up the other sessions.
+   An idle session gets the closing timeout (-t) for final replies before its
+   address2 is closed; option -T ends the loop when no session has data */
+static int socat_sessions(const char *address2) {
+   struct single *lsfd = &sock1->stream;
+   struct pollfd *fds = NULL;
+   struct xiosession **sess = NULL;
+   unsigned int maxsess = 0, nsess, i;
+   unsigned char *buff;
+   struct timeval active;	/* time of last data transfer, for -T */
+   int upflags;
+   int result = 0;
+
+   if (socat_opts.righttoleft) {
+      Error("option -U is not supported with session-table");
+      return -1;
+   }
+   upflags = (socat_opts.lefttoright ? XIO_WRONLY : XIO_RDWR) |
+      XIO_MAYCHILD|XIO_MAYCONVERT;
+
+   if ((buff = Malloc(xioparms.bufsiz+1)) == NULL)
+      return -1;
+   socat_sessions_sfd = lsfd;
+   Atexit(socat_sessions_exit);
+   xiosetchilddied();	/* reap the children of the sessions */
+   Info("resolved and opened first address, starting session loop");
+
+   Gettimeofday(&active, NULL);
+   while (true) {
+      struct xiosession *s, *next;
+      struct timeval wait, now;
+      union sockaddr_union pa;
+      socklen_t palen;
+      ssize_t bytes;
+      int n;
+
+      /* idle sessions, oldest first: stop writing to address2 and give it
+	 the closing timeout for its replies; close those that were idle
+	 already */
+      while ((s = xiosession_expired(lsfd, &wait)) != NULL) {
+	 char infobuff[256];
+	 Info1("session from %s timed out",
+	       sockaddr_info(&s->peer.soa, s->peerlen,
+			     infobuff, sizeof(infobuff)));
+	 if (s->closing.tv_sec != 0 || socat_opts.lefttoright || s->upeof) {
+	    socat_session_close(lsfd, s);
+	    continue;
+	 }
+	 s->pendlen = 0;
+	 xioshutdown(s->upstream, SHUT_WR);
+	 s->shutwr = true;
+	 Gettimeofday(&now, NULL);
+	 socat_session_linger(s, &now);
+	 xiosession_touch(lsfd, s);
+      }
+
+      Gettimeofday(&now, NULL);
+      if (socat_opts.total_timeout.tv_usec < 1000000) {
+	 struct timeval end;
+
+	 end.tv_sec  = active.tv_sec  + socat_opts.total_timeout.tv_sec;
+	 end.tv_usec = active.tv_usec + socat_opts.total_timeout.tv_usec;
+	 if (end.tv_usec >= 1000000) {
+	    ++end.tv_sec;  end.tv_usec -= 1000000;
+	 }
+	 if (socat_session_due(&end, &now, &wait)) {
+	    Notice("inactivity timeout triggered");
+	    break;
+	 }
+      }
+
+      /* sessions whose closing timeout is over */
+      nsess = 0;
+      for (s = xiosession_first(lsfd); s != NULL; s = next) {
+	 next = s->next;
+	 if (s->closing.tv_sec != 0 &&
+	     socat_session_due(&s->closing, &now, &wait)) {
+	    socat_session_close(lsfd, s);
+	    continue;
+	 }
+	 ++nsess;
+      }
+
+      /* one listener, then three entries per session: reading and writing
+	 upstream, and the connected per-session socket; unused entries have
+	 fd -1 */
+      if (nsess >= maxsess) {
+	 maxsess = 2*nsess+16;
+	 free(fds);  free(sess);
+	 if ((fds = Malloc((1+3*maxsess)*sizeof(struct pollfd))) == NULL ||
+	     (sess = Malloc(maxsess*sizeof(struct xiosession *))) == NULL) {
+	    result = -1;
+	    break;
+	 }
+      }
+      fds[0].fd = lsfd->fd;
+      fds[0].events = POLLIN;
+      for (i = 0, s = xiosession_first(lsfd); s != NULL; ++i, s = s->next) {
+	 sess[i] = s;
+	 fds[1+3*i].fd = socat_opts.lefttoright || s->upeof ?
+	    -1 : XIO_GETRDFD(s->upstream);
+	 fds[1+3*i].events = POLLIN;
+	 fds[2+3*i].fd = s->pendlen > 0 ? XIO_GETWRFD(s->upstream) : -1;
+	 fds[2+3*i].events = POLLOUT;
+	 fds[3+3*i].fd = s->fd;
+	 fds[3+3*i].events = POLLIN;
+      }
+
+      n = xiopoll(fds, 1+3*nsess, wait.tv_sec < 0 ? NULL : &wait);
+      if (n < 0) {
+	 if (errno == EINTR)
+	    continue;
+	 Error2("poll(..., %u, ...): %s", 1+3*nsess, strerror(errno));
+	 result = -1;
+	 break;
+      }
+      if (n == 0)
+	 continue;	/* expiry */
+
+      for (i = 0; i < nsess; ++i) {
+	 char infobuff[256];
+
+	 s = sess[i];
+	 if (fds[2+3*i].fd >= 0 && fds[2+3*i].revents) {
+	    if (socat_session_write(s, NULL, 0) < 0) {
+	       socat_session_close(lsfd, s);
+	       continue;
+	    }
+	    Gettimeofday(&active, NULL);
+	 }
+	 if (fds[3+3*i].fd >= 0 && fds[3+3*i].revents) {
+	    bytes = xiosession_recvflow(lsfd, s, buff, xioparms.bufsiz);
+	    if (bytes > 0) {
+	       xiosession_touch(lsfd, s);
+	       Gettimeofday(&active, NULL);
+	       if (socat_session_put(s, buff, bytes) < 0) {
+		  socat_session_close(lsfd, s);
+		  continue;
+	       }
+	    }
+	 }
+	 if (fds[1+3*i].fd >= 0 && fds[1+3*i].revents) {
+	    bytes = xioread(s->upstream, buff, xioparms.bufsiz);
+	    if (bytes > 0) {
+	       xiosession_touch(lsfd, s);
+	       Gettimeofday(&active, NULL);
+	       xiosession_send(lsfd, s, buff, bytes);
+	    } else if (bytes == 0 || errno != EAGAIN && errno != EINTR) {
+	       Info1("session from %s: second address at EOF",
+		     sockaddr_info(&s->peer.soa, s->peerlen,
+				   infobuff, sizeof(infobuff)));
+	       if (s->closing.tv_sec != 0) {
+		  socat_session_close(lsfd, s);
+		  continue;
+	       }
+	       /* like the first EOF in _socat(): the other direction gets the
+		  closing timeout */
+	       s->upeof = true;
+	       Gettimeofday(&now, NULL);
+	       socat_session_linger(s, &now);
+	    }
+	 }
+      }
+
+      if (fds[0].revents == 0)
+	 continue;
+      /* a limited number of packets per round, to not starve sessions */
+      for (i = 0; i < 64; ++i) {
+	 bytes = xiosession_recv(lsfd, buff, xioparms.bufsiz,
+				 &pa, &palen, &s);
+	 if (bytes < 0)
+	    break;
+	 if (bytes == 0)
+	    continue;
+	 if (s == NULL) {
+	    xiofile_t *up;
+
+	    if ((s = xiosession_new(lsfd, &pa, palen)) == NULL)
+	       continue;
+	    if ((up = socat_session_open(address2, upflags, &s->pid))
+		== NULL) {
+	       Warn("failed to open second address for session, dropping packet");
+	       xiosession_del(lsfd, s);
+	       continue;
+	    }
+	    s->upstream = up;
+	    if (socat_session_direct(up) &&
+		(n = Fcntl(XIO_GETWRFD(up), F_GETFL)) >= 0) {
+	       Fcntl_l(XIO_GETWRFD(up), F_SETFL, n|O_NONBLOCK);
+	    }
+	 }
+	 xiosession_touch(lsfd, s);
+	 Gettimeofday(&active, NULL);
+	 if (socat_session_put(s, buff, bytes) < 0)
+	    socat_session_close(lsfd, s);
+      }
+   }
+
+   socat_sessions_exit();
+   xiosession_free(lsfd);
+   xioclose(sock1);
+   free(sess);
+   free(fds);
+   free(buff);
+   return result;
+}
+#endif /* _WITH_SOCKET */
+
+/* one address pair of the --relays file */
+struct socat_relay {
+   char *address[2];
+   unsigned int lineno;
+   pid_t pid;		/* 0 when not running */
+} ;
+
+/* in a relay process: "file:line" of its address pair, for statistics */
+static char socat_relayname[256];
+
+/* signals received by the relay supervisor, as bit mask */
+static volatile sig_atomic_t socat_relays_sigs;
+static const int socat_relays_signals[] = { SIGHUP, SIGINT, SIGTERM, SIGUSR1 };
+#define SOCAT_NUMRELAYSIGS \
+   (sizeof(socat_relays_signals)/sizeof(socat_relays_signals[0]))
+
+static void socat_relays_signal(int signum) {
+   socat_relays_sigs |= 1<<signum;
+}
+
+/* splits a line into white space separated fields; quotes, brackets, and
+   backslash escapes are kept for the address parser but protect white
+   space. returns the number of fields, or -1 when there are too many */
+static int socat_relays_split(char *line, char *fields[], int maxfields) {
+   int n = 0, nest = 0;
+   char quote = '\0';
+   char *cp = line;
+
+   while (true) {
+      while (isspace((unsigned char)*cp))  ++cp;
+      if (*cp == '\0')
+	 return n;
+      if (n == maxfields)
+	 return -1;
+      fields[n++] = cp;
+      for (; *cp != '\0'; ++cp) {
+	 if (*cp == '\\' && cp[1] != '\0') {
+	    ++cp;
+	 } else if (quote) {
+	    if (*cp == quote)  quote = '\0';
+	 } else if (*cp == '"' || *cp == '\'') {
+	    quote = *cp;
+	 } else if (*cp == '[' || *cp == '{' || *cp == '(') {
+	    ++nest;
+	 } else if ((*cp == ']' || *cp == '}' || *cp == ')') && nest > 0) {
+	    --nest;
+	 } else if (nest == 0 && isspace((unsigned char)*cp)) {
+	    break;
+	 }
+      }
+      if (*cp != '\0')  *cp++ = '\0';
+   }
+}
+
+/* reads the address pairs from the --relays file.
+   returns the number of relays, or -1 on error */
+static void socat_relays_free(struct socat_relay *relays, int numrelays) {
+   int i;
+
+   for (i = 0; i < numrelays; ++i) {
+      free(relays[i].address[0]);
+      free(relays[i].address[1]);
+   }
+   free(relays);
+}
+
+static int socat_relays_read(const char *filename,
+			     struct socat_relay **relays) {
+   FILE *fp;
+   char line[4096];
+   char *fields[3];
+   unsigned int lineno = 0;
+   int num = 0, max = 0, n;
+   bool failed = false;
+
+   *relays = NULL;
+   if ((fp = fopen(filename, "r")) == NULL) {
+      Error2("fopen(\"%s\", \"r\"): %s", filename, strerror(errno));
+      return -1;
+   }
+   while (fgets(line, sizeof(line), fp) != NULL) {
+      ++lineno;
+      if (strchr(line, '\n') == NULL && !feof(fp)) {
+	 Error2("%s:%u: line too long", filename, lineno);
+	 failed = true;
+	 break;
+      }
+      if ((n = socat_relays_split(line, fields, 3)) == 0 || fields[0][0] == '#')
+	 continue;
+      if (n != 2) {
+	 Error2("%s:%u: exactly 2 addresses required", filename, lineno);
+	 failed = true;
+	 break;
+      }
+      if (num == max) {
+	 struct socat_relay *r;
+	 max = 2*max+8;
+	 if ((r = Realloc(*relays, max*sizeof(struct socat_relay))) == NULL) {
+	    failed = true;
+	    break;
+	 }
+	 *relays = r;
+      }
+      if (((*relays)[num].address[0] = strdup(fields[0])) == NULL ||
+	  ((*relays)[num].address[1] = strdup(fields[1])) == NULL) {
+	 Error1("strdup(): %s", strerror(errno));
+	 free((*relays)[num].address[0]);
+	 failed = true;
+	 break;
+      }
+      (*relays)[num].lineno = lineno;
+      (*relays)[num].pid = 0;
+      ++num;
+   }
+   if (ferror(fp)) {
+      Error2("%s: %s", filename, strerror(errno));
+      failed = true;
+   }
+   fclose(fp);
+   if (failed) {
+      socat_relays_free(*relays, num);
+      *relays = NULL;
+      return -1;
+   }
+   if (num == 0) {
+      Error1("%s: no relays defined", filename);
+      free(*relays);
+      *relays = NULL;
+      return -1;
+   }
+   return num;
+}
+
+static void socat_relays_list(const char *filename,
+			      struct socat_relay *relays, int numrelays) {
+   int i;
+
+   for (i = 0; i < numrelays; ++i) {
+      if (relays[i].pid > 0) {
+	 Notice3("relay %s:%u: running as process "F_pid,
+		 filename, relays[i].lineno, relays[i].pid);
+      } else {
+	 Notice2("relay %s:%u: terminated", filename, relays[i].lineno);
+      }
+   }
+}
+
+/* runs each address pair of the file in its own subprocess that is forked
+   after the common initialization, and waits until all have terminated.
+   SIGUSR1 lists the relays and makes them log their statistics; SIGHUP,
+   SIGINT, and SIGTERM are passed to all relays. */
+static int socat_relays(const char *filename) {
+   struct socat_relay *relays;
+   struct sigaction act, oldact[SOCAT_NUMRELAYSIGS], oldchld;
+   sigset_t mask, oldmask, waitmask;
+   int numrelays, running = 0, failed = 0, termsig = 0;
+   int i, j;
+
+   if ((numrelays = socat_relays_read(filename, &relays)) < 0) {
+      return 1;
+   }
+
+   memset(&act, 0, sizeof(act));
+   act.sa_handler = socat_relays_signal;
+   sigemptyset(&act.sa_mask);
+   act.sa_flags = 0;
+   for (j = 0; j < SOCAT_NUMRELAYSIGS; ++j) {
+      Sigaction(socat_relays_signals[j], &act, &oldact[j]);
+   }
+   /* SIGCHLD only needs to interrupt sigsuspend() */
+   Sigaction(SIGCHLD, &act, &oldchld);
+   /* the signals are blocked except in sigsuspend(), so none gets lost
+      between checking the flags and waiting */
+   sigemptyset(&mask);
+   sigaddset(&mask, SIGCHLD);
+   for (j = 0; j < SOCAT_NUMRELAYSIGS; ++j) {
+      sigaddset(&mask, socat_relays_signals[j]);
+   }
+   Sigprocmask(SIG_BLOCK, &mask, &oldmask);
+   waitmask = oldmask;
+   sigdelset(&waitmask, SIGCHLD);
+   for (j = 0; j < SOCAT_NUMRELAYSIGS; ++j) {
+      sigdelset(&waitmask, socat_relays_signals[j]);
+   }
+
+   for (i = 0; i < numrelays; ++i) {
+      struct socat_relay *r = &relays[i];
+      pid_t pid;
+
+      if ((pid = Fork()) < 0) {
+	 Error3("relay %s:%u: fork(): %s", filename, r->lineno, strerror(errno));
+	 ++failed;
+	 continue;
+      }
+      if (pid == 0) {	/* child: continue as normal socat */
+	 int result;
+
+	 for (j = 0; j < SOCAT_NUMRELAYSIGS; ++j) {
+	    Sigaction(socat_relays_signals[j], &oldact[j], NULL);
+	 }
+	 Sigaction(SIGCHLD, &oldchld, NULL);
+	 Sigprocmask(SIG_SETMASK, &oldmask, NULL);
+	 socat_newchild();
+	 snprintf(socat_relayname, sizeof(socat_relayname), "%s:%u",
+		  filename, r->lineno);
+#if WITH_STATS
+	 if (socat_opts.statistics) {
+	    Atexit(socat_print_stats);
+	 }
+#endif /* WITH_STATS */
+	 Info4("relay %s:%u: \"%s\" \"%s\"", filename, r->lineno,
+	       r->address[0], r->address[1]);
+	 result = socat(r->address[0], r->address[1]);
+	 if (result == EXIT_SUCCESS && engine_result != EXIT_SUCCESS) {
+	    result = engine_result;
+	 }
+	 Notice3("relay %s:%u: exiting with status %d",
+		 filename, r->lineno, result);
+	 Exit(result);
+      }
+      r->pid = pid;
+      ++running;
+      Info3("relay %s:%u: started process "F_pid, filename, r->lineno, pid);
+   }
+
+   while (running > 0) {
+      int status;
+      pid_t pid;
+
+      if (socat_relays_sigs) {
+	 int sigs = socat_relays_sigs;
+	 socat_relays_sigs = 0;
+
+	 for (j = 0; j < SOCAT_NUMRELAYSIGS; ++j) {
+	    int sig = socat_relays_signals[j];
+	    if (!(sigs & 1<<sig))
+	       continue;
+	    if (sig == SIGUSR1) {
+	       socat_relays_list(filename, relays, numrelays);
+#if !WITH_STATS
+	       continue;	/* relays would die of it */
+#endif
+	    } else {
+	       Notice1("passing signal %d to all relays", sig);
+	       termsig = sig;
+	    }
+	    for (i = 0; i < numrelays; ++i) {
+	       if (relays[i].pid > 0)
+		  Kill(relays[i].pid, sig);
+	    }
+	 }
+      }
+
+      if ((pid = Waitpid(-1, &status, WNOHANG)) < 0) {
+	 Error1("waitpid(): %s", strerror(errno));
+	 break;
+      }
+      if (pid == 0) {
+	 sigsuspend(&waitmask);
+	 continue;
+      }
+      for (i = 0; i < numrelays; ++i) {
+	 if (relays[i].pid == pid)
+	    break;
+      }
+      if (i == numrelays)
+	 continue;	/* not a relay */
+      relays[i].pid = 0;
+      --running;
+      if (WIFEXITED(status) &&
+	  (WEXITSTATUS(status) == 0 ||
+	   termsig && WEXITSTATUS(status) == 128+termsig)) {
+	 Notice2("relay %s:%u: terminated", filename, relays[i].lineno);
+      } else if (WIFEXITED(status)) {
+	 Warn3("relay %s:%u: terminated with status %d",
+	       filename, relays[i].lineno, WEXITSTATUS(status));
+	 ++failed;
+      } else if (WIFSIGNALED(status)) {
+	 if (WTERMSIG(status) != termsig)
+	    ++failed;
+	 Warn3("relay %s:%u: terminated by signal %d",
+	       filename, relays[i].lineno, WTERMSIG(status));
+      }
+   }
+
+   for (j = 0; j < SOCAT_NUMRELAYSIGS; ++j) {
+      Sigaction(socat_relays_signals[j], &oldact[j], NULL);
+   }
+   Sigaction(SIGCHLD, &oldchld, NULL);
+   Sigprocmask(SIG_SETMASK, &oldmask, NULL);
+   socat_relays_free(relays, numrelays);
+   if (termsig)
+      return 128+termsig;
+   return failed ? 1 : 0;
+}
+
 /* checks if this is a connection to a child process, and if so, sees if the
    child already died, leaving some data for us.
    returns <0 if an error occurred;
@@ -910,6 +1743,7 @@ int _socat(void) {
    unsigned char *buff;
    ssize_t bytes1, bytes2;
    int polling = 0;	/* handling ignoreeof */
+   bool follow1 = false, follow2 = false;	/* waiting for inotify events */
    int wasaction = 1;	/* last poll was active, do NOT sleep before next */
    struct timeval total_timeout;	/* the actual total timeout timer */
 
@@ -992,6 +1826,17 @@ int _socat(void) {
    }
    total_timeout = socat_opts.total_timeout;
 
+   if (!socat_opts.righttoleft)
+      socat_sparse_check(sock1, sock2, false);
+   if (!socat_opts.lefttoright)
+      socat_sparse_check(sock2, sock1, true);
+#if HAVE_SENDFILE || HAVE_COPY_FILE_RANGE
+   if (!socat_opts.righttoleft)
+      zerocopy[0] = socat_zerocopy_check(sock1, sock2, false);
+   if (!socat_opts.lefttoright)
+      zerocopy[1] = socat_zerocopy_check(sock2, sock1, true);
+#endif
+
    if (transferwaitstring = getenv("SOCAT_TRANSFER_WAIT")) {
       Info1("before starting data transfer loop: sleeping %ds (env:SOCAT_TRANSFER_WAIT)", atoi(transferwaitstring));
       sleep(atoi(transferwaitstring));
@@ -1078,6 +1923,13 @@ int _socat(void) {
 	 if (XIO_READABLE(sock1) &&
 	     !(XIO_RDSTREAM(sock1)->eof > 1 && !XIO_RDSTREAM(sock1)->ignoreeof) &&
 	     !socat_opts.righttoleft) {
+#if HAVE_SYS_INOTIFY_H
+	    if (follow1) {
+		/* at EOF of a followed file, wait until it changes */
+		fd1in->fd = xiofollow_fd(XIO_RDSTREAM(sock1));
+		fd1in->events = POLLIN;
+	    } else
+#endif
 	    if (!mayrd1 && !(XIO_RDSTREAM(sock1)->eof > 1)) {
 		fd1in->fd = XIO_GETRDFD(sock1);
 		fd1in->events = POLLIN;
@@ -1097,6 +1949,13 @@ int _socat(void) {
 	 if (XIO_READABLE(sock2) &&
 	     !(XIO_RDSTREAM(sock2)->eof > 1 && !XIO_RDSTREAM(sock2)->ignoreeof) &&
 	     !socat_opts.lefttoright) {
+#if HAVE_SYS_INOTIFY_H
+	    if (follow2) {
+		/* at EOF of a followed file, wait until it changes */
+		fd2in->fd = xiofollow_fd(XIO_RDSTREAM(sock2));
+		fd2in->events = POLLIN;
+	    } else
+#endif
 	    if (!mayrd2 && !(XIO_RDSTREAM(sock2)->eof > 1)) {
 		fd2in->fd = XIO_GETRDFD(sock2);
 		fd2in->events = POLLIN;
@@ -1176,6 +2035,15 @@ int _socat(void) {
 		  free(buff);
 	    return -1;
 	 }
+#if HAVE_SYS_INOTIFY_H
+	 if (follow1) {
+	    follow1 = false;
+	    if (xiofollow_event(XIO_RDSTREAM(sock1)) < 0) {
+	       free(buff);
+	       return -1;
+	    }
+	 }
+#endif
 	 mayrd1 = true;
       }
       if (XIO_READABLE(sock2) && XIO_GETRDFD(sock2) >= 0 &&
@@ -1185,6 +2053,15 @@ int _socat(void) {
 		  free(buff);
 	    return -1;
 	 }
+#if HAVE_SYS_INOTIFY_H
+	 if (follow2) {
+	    follow2 = false;
+	    if (xiofollow_event(XIO_RDSTREAM(sock2)) < 0) {
+	       free(buff);
+	       return -1;
+	    }
+	 }
+#endif
 	 mayrd2 = true;
       }
       if (XIO_GETWRFD(sock1) >= 0 && fd1out->fd >= 0 && fd1out->revents) {
@@ -1208,7 +2085,10 @@ int _socat(void) {
 	 mayrd1 = false;
 	 if ((bytes1 = xiotransfer(sock1, sock2, buff, xioparms.bufsiz, false))
 	     < 0) {
-	    if (errno != EAGAIN) {
+	    if (errno == EAGAIN) {
+	       /* output might be full (SHM-RING), ask poll() again */
+	       maywr2 = false;
+	    } else {
 	       closing = MAX(closing, 1);
 	       Notice("socket 1 to socket 2 is in error");
 	       if (socat_opts.lefttoright) {
@@ -1240,7 +2120,10 @@ int _socat(void) {
 	 mayrd2 = false;
 	 if ((bytes2 = xiotransfer(sock2, sock1, buff, xioparms.bufsiz, true))
 	     < 0) {
-	    if (errno != EAGAIN) {
+	    if (errno == EAGAIN) {
+	       /* output might be full (SHM-RING), ask poll() again */
+	       maywr1 = false;
+	    } else {
 	       closing = MAX(closing, 1);
 	       Notice("socket 2 to socket 1 is in error");
 	       if (socat_opts.righttoleft) {
@@ -1278,8 +2161,16 @@ int _socat(void) {
 	     !XIO_RDSTREAM(sock1)->actescape && !closing) {
 	    Debug1("socket 1 (fd %d) is at EOF, ignoring",
 		   XIO_RDSTREAM(sock1)->fd);	/*! */
-	    mayrd1 = true;
-	    polling = 1;	/* do not hook this eof fd to poll for pollintv*/
+#if HAVE_SYS_INOTIFY_H
+	    if (xiofollow_fd(XIO_RDSTREAM(sock1)) >= 0) {
+	       follow1 = true;	/* poll the inotify fd instead */
+	       mayrd1 = false;
+	    } else
+#endif
+	    {
+	       mayrd1 = true;
+	       polling = 1;	/* do not hook this eof fd to poll for pollintv*/
+	    }
 	 } else if (XIO_RDSTREAM(sock1)->eof <= 2) {
 	    Notice1("socket 1 (fd %d) is at EOF", XIO_GETRDFD(sock1));
 	    xioshutdown(sock2, SHUT_WR);
@@ -1301,8 +2192,16 @@ int _socat(void) {
 	     !XIO_RDSTREAM(sock2)->actescape && !closing) {
 	    Debug1("socket 2 (fd %d) is at EOF, ignoring",
 		   XIO_RDSTREAM(sock2)->fd);
-	    mayrd2 = true;
-	    polling = 1;	/* do not hook this eof fd to poll for pollintv*/
+#if HAVE_SYS_INOTIFY_H
+	    if (xiofollow_fd(XIO_RDSTREAM(sock2)) >= 0) {
+	       follow2 = true;	/* poll the inotify fd instead */
+	       mayrd2 = false;
+	    } else
+#endif
+	    {
+	       mayrd2 = true;
+	       polling = 1;	/* do not hook this eof fd to poll for pollintv*/
+	    }
 	 } else if (XIO_RDSTREAM(sock2)->eof <= 2) {
 	    Notice1("socket 2 (fd %d) is at EOF", XIO_GETRDFD(sock2));
 	    xioshutdown(sock1, SHUT_WR);
@@ -1418,10 +2317,56 @@ static int
 /* inpipe, outpipe must be single descriptors (not dual!) */
 int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 		unsigned char *buff, size_t bufsiz, bool righttoleft) {
+   const unsigned char *data;	/* buff, or input data mapped in memory */
    ssize_t bytes, writt = 0;
    ssize_t sniffed;
 
-	 bytes = xioread(inpipe, buff, bufsiz);
+   if (sparsetab[righttoleft].in != SPARSE_NONE &&
+       (bytes = socat_sparse_read(inpipe, outpipe, buff, &bufsiz,
+				  righttoleft)) != 0) {
+      return bytes;
+   }
+
+#if HAVE_SENDFILE || HAVE_COPY_FILE_RANGE
+   if (zerocopy[righttoleft] != ZEROCOPY_NONE &&
+       (bytes = socat_zerocopy(inpipe, outpipe, bufsiz, righttoleft))
+       != -2) {
+      if (bytes < 0) {
+	 return -1;
+      }
+      if (bytes == 0) {
+	 if (!XIO_RDSTREAM(inpipe)->ignoreeof || closing) {
+	    XIO_RDSTREAM(inpipe)->eof = 2;
+	    closing = MAX(closing, 1);
+	 }
+	 return 0;
+      }
+      Info3("transferred "F_Zu" bytes from %d to %d",
+	    bytes, XIO_GETRDFD(inpipe), XIO_GETWRFD(outpipe));
+#if WITH_STATS
+      ++XIO_RDSTREAM(inpipe)->blocks_read;
+      XIO_RDSTREAM(inpipe)->bytes_read += bytes;
+      ++XIO_WRSTREAM(outpipe)->blocks_written;
+      XIO_WRSTREAM(outpipe)->bytes_written += bytes;
+#endif
+      return bytes;
+   }
+#endif /* HAVE_SENDFILE || HAVE_COPY_FILE_RANGE */
+
+	 /* read only what the output takes without waiting: xiowrite() to a
+	    full SHM-RING would wait for the peer, which might wait for us */
+	 if ((bytes = xiowritespace(outpipe, bufsiz)) <= 0) {
+	    if (bytes == 0)
+	       errno = EAGAIN;
+	    return -1;
+	 }
+	 bufsiz = bytes;
+	 if (socat_readptr_check(inpipe, outpipe)) {
+	    bytes = xioreadptr(inpipe, buff, bufsiz, (const void **)&data);
+	 } else {
+	    bytes = xioread(inpipe, buff, bufsiz);
+	    data = buff;
+	 }
 	 if (bytes < 0) {
 	    if (errno != EAGAIN)
 	       XIO_RDSTREAM(inpipe)->eof = 2;
@@ -1433,9 +2378,18 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 	 } else if (bytes == 0) {
 	    XIO_RDSTREAM(inpipe)->eof = 2;
 	    closing = MAX(closing, 1);
+	    if (sparsetab[righttoleft].left > 0) {
+	       Warn2("sparse stream on fd %d ends with %llu bytes of a data record missing",
+		     XIO_GETRDFD(inpipe), sparsetab[righttoleft].left);
+	    }
 	 }
 
 	 if (bytes > 0) {
+	    if (sparsetab[righttoleft].in == SPARSE_FILE) {
+	       sparsetab[righttoleft].pos += bytes;
+	    } else if (sparsetab[righttoleft].in == SPARSE_STREAM) {
+	       sparsetab[righttoleft].left -= bytes;
+	    }
 #if WITH_STATS
 	    ++XIO_RDSTREAM(inpipe)->blocks_read;
 	    XIO_RDSTREAM(inpipe)->bytes_read += bytes;
@@ -1443,7 +2397,7 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 	    /* handle escape char */
 	    if (XIO_RDSTREAM(inpipe)->escape != -1) {
 	       /* check input data for escape char */
-	       unsigned char *ptr = buff;
+	       const unsigned char *ptr = data;
 	       size_t ctr = 0;
 	       while (ctr < bytes) {
 		  if (*ptr == XIO_RDSTREAM(inpipe)->escape) {
@@ -1465,6 +2419,11 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 
 	    if (XIO_RDSTREAM(inpipe)->lineterm !=
 		XIO_WRSTREAM(outpipe)->lineterm) {
+	       if (data != buff) {
+		  /* conversion needs writable space */
+		  memcpy(buff, data, bytes);
+		  data = buff;
+	       }
 	       cv_newline(buff, &bytes,
 			  XIO_RDSTREAM(inpipe)->lineterm,
 			  XIO_WRSTREAM(outpipe)->lineterm);
@@ -1474,7 +2433,7 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 	    }
 
 	    if (!righttoleft && sniffleft >= 0) {
-	       if ((sniffed = Write(sniffleft, buff, bytes)) < bytes) {
+	       if ((sniffed = Write(sniffleft, data, bytes)) < bytes) {
 		  if (sniffed < 0)
 		     Warn3("-r: write(%d, buff, "F_Zu"): %s",
 			   sniffleft, bytes, strerror(errno));
@@ -1483,7 +2442,7 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 			   sniffleft, bytes, sniffed);
 	       }
 	    } else if (righttoleft && sniffright >= 0) {
-	       if ((sniffed = Write(sniffright, buff, bytes)) < bytes) {
+	       if ((sniffed = Write(sniffright, data, bytes)) < bytes) {
 		  if (sniffed < 0)
 		     Warn3("-R: write(%d, buff, "F_Zu"): %s",
 			   sniffright, bytes, strerror(errno));
@@ -1499,8 +2458,8 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 	       size_t j;
 	       size_t N = 16;
 	       const unsigned char *end, *s, *t;
-	       s = buff;
-	       end = buff+bytes;
+	       s = data;
+	       end = data+bytes;
 	       xioprintblockheader(stderr, bytes, righttoleft);
 	       while (s < end) {
 		  /*! prefix? */
@@ -1546,8 +2505,8 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 	       size_t i = 0;
 	       xioprintblockheader(stderr, bytes, righttoleft);
 	       while (i < (size_t)bytes) {
-		  int c = buff[i];
-		  if (i > 0 && buff[i-1] == '\n')
+		  int c = data[i];
+		  if (i > 0 && data[i-1] == '\n')
 		     /*! prefix? */;
 		  switch (c) {
 		  case '\a' : fputs("\\a", stderr); break;
@@ -1571,12 +2530,16 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
 	       /* print prefix */
 	       xioprintblockheader(stderr, bytes, righttoleft);
 	       for (i = 0; i < bytes; ++i) {
-		  fprintf(stderr, " %02x", buff[i]);
+		  fprintf(stderr, " %02x", data[i]);
 	       }
 	       fputc('\n', stderr);
 	    }
 
-	    writt = xiowrite(outpipe, buff, bytes);
+	    if (sparsetab[righttoleft].out == SPARSE_STREAM &&
+		socat_sparse_header(outpipe, 'D', bytes) < 0) {
+	       return -1;
+	    }
+	    writt = xiowrite(outpipe, data, bytes);
 	    if (writt < 0) {
 	       /* EAGAIN when nonblocking but a mandatory lock is on file.
 		  the problem with EAGAIN is that the read cannot be repeated,
@@ -1600,6 +2563,450 @@ int xiotransfer(xiofile_t *inpipe, xiofile_t *outpipe,
    return writt;
 }
 
+/* Checks if xiotransfer() may leave the input data in the memory mapping of
+   option mmap instead of copying it to buff: only when nothing but the kernel
+   reads it. A write() from pages beyond the end of a truncated file fails
+   with EFAULT, while an access in user space (escape, line terminator
+   conversion, -v/-x, OpenSSL, readline, SHM-RING) raises SIGBUS outside of
+   the guarded copy in xioread_mmap() */
+static bool socat_readptr_check(xiofile_t *inpipe, xiofile_t *outpipe) {
+   struct single *in  = XIO_RDSTREAM(inpipe);
+   struct single *out = XIO_WRSTREAM(outpipe);
+
+   if ((in->dtype & XIODATA_READMASK) != XIOREAD_MMAP)
+      return true;
+   if (in->escape != -1 || in->lineterm != out->lineterm ||
+       socat_opts.verbose || socat_opts.verbhex)
+      return false;
+   if ((out->dtype & XIODATA_READMASK) == XIOREAD_READLINE)
+      return false;
+   switch (out->dtype & XIODATA_WRITEMASK) {
+   case XIOWRITE_STREAM:
+   case XIOWRITE_SENDTO:
+   case XIOWRITE_PIPE:
+   case XIOWRITE_2PIPE:
+      return true;
+   default:
+      return false;
+   }
+}
+
+#if HAVE_SENDFILE || HAVE_COPY_FILE_RANGE
+/* Checks if data from inpipe to outpipe can be copied by the kernel without
+   passing through the transfer buffer: the input must be a regular file, the
+   output a stream socket, pipe, or regular file, and no option may need to
+   see the data (escape, line terminator conversion, -r/-R, -v/-x).
+   Returns the ZEROCOPY_* method to use. */
+static int socat_zerocopy_check(xiofile_t *inpipe, xiofile_t *outpipe,
+				bool righttoleft) {
+   struct single *in  = XIO_RDSTREAM(inpipe);
+   struct single *out = XIO_WRSTREAM(outpipe);
+   struct stat instat, outstat;
+   int method = ZEROCOPY_NONE;
+   int flags;
+
+   if ((in->dtype & XIODATA_READMASK) != XIOREAD_STREAM)
+      return ZEROCOPY_NONE;
+   if ((out->dtype & XIODATA_WRITEMASK) != XIOWRITE_STREAM)
+      return ZEROCOPY_NONE;
+   if (sparsetab[righttoleft].in != SPARSE_NONE ||
+       sparsetab[righttoleft].out == SPARSE_STREAM)
+      return ZEROCOPY_NONE;
+   if (in->escape != -1 || in->lineterm != out->lineterm ||
+       socat_opts.verbose || socat_opts.verbhex ||
+       (righttoleft ? sniffright : sniffleft) >= 0)
+      return ZEROCOPY_NONE;
+   if (in->fd < 0 || out->fd < 0)
+      return ZEROCOPY_NONE;
+
+   if (Fstat(in->fd, &instat) < 0 || !S_ISREG(instat.st_mode))
+      return ZEROCOPY_NONE;
+   if (Fstat(out->fd, &outstat) < 0)
+      return ZEROCOPY_NONE;
+   /* write-only addresses may have been opened without read access */
+   if ((flags = Fcntl(in->fd, F_GETFL)) < 0 ||
+       (flags & O_ACCMODE) == O_WRONLY)
+      return ZEROCOPY_NONE;
+   /* both calls refuse output files opened with O_APPEND */
+   if ((flags = Fcntl(out->fd, F_GETFL)) < 0 || (flags & O_APPEND) ||
+       (flags & O_ACCMODE) == O_RDONLY)
+      return ZEROCOPY_NONE;
+
+   if (S_ISREG(outstat.st_mode)) {
+#if HAVE_COPY_FILE_RANGE
+      method = ZEROCOPY_COPYRANGE;
+#elif HAVE_SENDFILE
+      method = ZEROCOPY_SENDFILE;
+#endif
+#if HAVE_SENDFILE
+   } else if (S_ISFIFO(outstat.st_mode)) {
+      method = ZEROCOPY_SENDFILE;
+#if _WITH_SOCKET
+   } else if (S_ISSOCK(outstat.st_mode)) {
+      int type;
+      socklen_t typelen = sizeof(type);
+      /* datagram sockets keep the read()/write() block boundaries */
+      if (Getsockopt(out->fd, SOL_SOCKET, SO_TYPE, &type, &typelen) == 0 &&
+	  type == SOCK_STREAM)
+	 method = ZEROCOPY_SENDFILE;
+#endif /* _WITH_SOCKET */
+#endif /* HAVE_SENDFILE */
+   }
+
+   if (method != ZEROCOPY_NONE) {
+      Info3("using %s() for data from %d to %d",
+	    method==ZEROCOPY_COPYRANGE?"copy_file_range":"sendfile",
+	    in->fd, out->fd);
+   }
+   return method;
+}
+
+/* Lets the kernel copy up to bufsiz bytes from inpipe to outpipe, starting at
+   the current file positions and honouring option readbytes.
+   Returns the number of bytes copied, 0 on EOF, -1 on error (errno is valid),
+   or -2 when the method turned out to be unsupported for these files; the
+   caller then falls back to read() and write(). */
+static ssize_t socat_zerocopy(xiofile_t *inpipe, xiofile_t *outpipe,
+			      size_t bufsiz, bool righttoleft) {
+   struct single *in  = XIO_RDSTREAM(inpipe);
+   struct single *out = XIO_WRSTREAM(outpipe);
+   int *method = &zerocopy[righttoleft];
+   const char *name;
+   ssize_t bytes;
+   int _errno;
+
+   if (in->readbytes) {
+      if (in->actbytes == 0) {
+	 Info1("xioread(%d, ...): readbytes consumed, inserting EOF", in->fd);
+	 return 0;	/* EOF by count */
+      }
+      if (in->actbytes < bufsiz) {
+	 bufsiz = in->actbytes;
+      }
+   }
+
+   while (true) {
+      do {
+#if HAVE_COPY_FILE_RANGE
+	 if (*method == ZEROCOPY_COPYRANGE) {
+	    name = "copy_file_range";
+	    bytes = Copy_file_range(in->fd, NULL, out->fd, NULL, bufsiz, 0);
+	 } else
+#endif
+	 {
+	    name = "sendfile";
+#if HAVE_SENDFILE
+	    bytes = Sendfile(out->fd, in->fd, NULL, bufsiz);
+#else
+	    bytes = -1;  errno = ENOSYS;
+#endif
+	 }
+      } while (bytes < 0 && errno == EINTR);
+      if (bytes >= 0)
+	 break;
+
+      _errno = errno;
+      switch (_errno) {
+      case EINVAL:
+      case ENOSYS:
+      case EXDEV:
+      case EOPNOTSUPP:
+#if defined(ENOTSUP) && ENOTSUP != EOPNOTSUPP
+      case ENOTSUP:
+#endif
+	 /* nothing has been copied yet, try the next method */
+#if HAVE_SENDFILE
+	 if (*method == ZEROCOPY_COPYRANGE) {
+	    Info4("%s(%d, %d, ...): %s, trying sendfile()",
+		  name, in->fd, out->fd, strerror(_errno));
+	    *method = ZEROCOPY_SENDFILE;
+	    continue;
+	 }
+#endif
+	 Info4("%s(%d, %d, ...): %s, falling back to read()/write()",
+	       name, in->fd, out->fd, strerror(_errno));
+	 *method = ZEROCOPY_NONE;
+	 return -2;
+      case EPIPE:
+      case ECONNRESET:
+	 if (out->cool_write) {
+	    Notice4("%s(%d, %d, ...): %s",
+		    name, in->fd, out->fd, strerror(_errno));
+	    break;
+	 }
+	 /*PASSTHROUGH*/
+      default:
+	 Error4("%s(%d, %d, ...): %s",
+		name, in->fd, out->fd, strerror(_errno));
+      }
+      errno = _errno;
+      return -1;
+   }
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+   if (in->cache.rdrop && bytes > 0)
+      xiocache_read(in, bytes);
+   if (out->cache.wsync && bytes > 0)
+      xiocache_write(out, bytes);
+#endif
+   in->actbytes -= bytes;
+   return bytes;
+}
+#endif /* HAVE_SENDFILE || HAVE_COPY_FILE_RANGE */
+
+/* Determines how holes are handled for data from inpipe to outpipe */
+static void socat_sparse_check(xiofile_t *inpipe, xiofile_t *outpipe,
+			       bool righttoleft) {
+   struct single *in  = XIO_RDSTREAM(inpipe);
+   struct single *out = XIO_WRSTREAM(outpipe);
+   struct stat buf;
+   int flags;
+
+   if (in->sparse_stream) {
+      sparsetab[righttoleft].in = SPARSE_STREAM;
+   } else if (in->sparse) {
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+      if ((in->dtype & XIODATA_READMASK) != XIOREAD_STREAM || in->fd < 0 ||
+	  Fstat(in->fd, &buf) < 0 || !S_ISREG(buf.st_mode)) {
+	 Warn1("option sparse: fd %d does not read a regular file with read(), ignoring",
+	       in->fd);
+      } else {
+	 sparsetab[righttoleft].in  = SPARSE_FILE;
+	 sparsetab[righttoleft].pos = -1;
+	 sparsetab[righttoleft].end = -1;
+      }
+#else
+      Warn("option sparse: SEEK_DATA is not supported on this platform, ignoring");
+#endif
+   }
+
+   if (out->sparse_stream) {
+      sparsetab[righttoleft].out = SPARSE_STREAM;
+   } else if (sparsetab[righttoleft].in != SPARSE_NONE &&
+	      (out->dtype & XIODATA_WRITEMASK) == XIOWRITE_STREAM &&
+	      out->fd >= 0 &&
+	      Fstat(out->fd, &buf) == 0 && S_ISREG(buf.st_mode) &&
+	      (flags = Fcntl(out->fd, F_GETFL)) >= 0 && !(flags & O_APPEND)) {
+      sparsetab[righttoleft].out = SPARSE_FILE;
+   }
+   if (sparsetab[righttoleft].in != SPARSE_NONE ||
+       sparsetab[righttoleft].out != SPARSE_NONE) {
+      static const char *methods[] = { "none", "file", "stream" };
+      Info4("holes from %d to %d: input %s, output %s",
+	    in->fd, out->fd, methods[sparsetab[righttoleft].in],
+	    methods[sparsetab[righttoleft].out]);
+   }
+}
+
+/* Writes a sparse stream record header to outpipe.
+   Returns 0 on success, or -1 on error */
+static int socat_sparse_header(xiofile_t *outpipe, int type,
+			       unsigned long long len) {
+   unsigned char hdr[SPARSE_HDRLEN];
+   int i;
+
+   hdr[0] = type;
+   for (i = SPARSE_HDRLEN-1; i > 0; --i) {
+      hdr[i] = len & 0xff;
+      len >>= 8;
+   }
+   if (xiowrite(outpipe, hdr, SPARSE_HDRLEN) < 0) {
+      return -1;
+   }
+   return 0;
+}
+
+/* Passes a hole of len bytes to outpipe: as record on a sparse stream, by
+   skipping (and where old data exist, punching) the range of a regular file,
+   or else as zero bytes. buff of bufsiz bytes may be used for the zeroes.
+   Returns 0 on success, or -1 on error */
+static int socat_sparse_hole(xiofile_t *outpipe, unsigned char *buff,
+			     size_t bufsiz, off_t len, bool righttoleft) {
+   struct single *out = XIO_WRSTREAM(outpipe);
+   off_t start, zeroes = len, skip = 0;
+   struct stat buf;
+   ssize_t writt;
+
+   switch (sparsetab[righttoleft].out) {
+   case SPARSE_STREAM:
+      return socat_sparse_header(outpipe, 'H', len);
+   case SPARSE_FILE:
+      if ((start = Lseek(out->fd, 0, SEEK_CUR)) < 0 ||
+	  Fstat(out->fd, &buf) < 0) {
+	 Error2("lseek()/fstat() on fd %d: %s", out->fd, strerror(errno));
+	 return -1;
+      }
+      /* beyond the old end of file nothing needs to be written */
+      zeroes = 0;
+      if (start < buf.st_size) {
+	 zeroes = Min(len, buf.st_size - start);
+#if HAVE_FALLOCATE && defined(FALLOC_FL_PUNCH_HOLE)
+	 if (Fallocate(out->fd, FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE,
+		       start, zeroes) == 0) {
+	    zeroes = 0;
+	 } else {
+	    Info4("fallocate(%d, FALLOC_FL_PUNCH_HOLE, "F_off", "F_off"): %s",
+		  out->fd, start, zeroes, strerror(errno));
+	 }
+#endif
+      }
+      skip = len - zeroes;
+      break;
+   }
+
+   if (zeroes > 0) {
+      memset(buff, 0, bufsiz);
+      while (zeroes > 0) {
+	 if ((writt = xiowrite(outpipe, buff, Min((off_t)bufsiz, zeroes))) < 0) {
+	    return -1;
+	 }
+	 zeroes -= writt;
+      }
+   }
+   if (skip > 0) {
+      if ((start = Lseek(out->fd, skip, SEEK_CUR)) < 0) {
+	 Error3("lseek(%d, "F_off", SEEK_CUR): %s",
+		out->fd, skip, strerror(errno));
+	 return -1;
+      }
+      /* a hole at the end of the file */
+      if (start > buf.st_size && Ftruncate(out->fd, start) < 0) {
+	 Error3("ftruncate(%d, "F_off"): %s", out->fd, start, strerror(errno));
+	 return -1;
+      }
+   }
+   return 0;
+}
+
+/* Looks for a hole at the current input position: on a file with option
+   sparse it is skipped using SEEK_DATA and SEEK_HOLE, on a sparse stream
+   the next record header is read. A hole is passed to outpipe.
+   Returns the length of a passed hole (at most INT_MAX), -1 on error or with
+   EAGAIN when no data are available yet, or 0 when data are to be read next,
+   at most *bufsiz bytes, which may be reduced */
+static ssize_t socat_sparse_read(xiofile_t *inpipe, xiofile_t *outpipe,
+				 unsigned char *buff, size_t *bufsiz,
+				 bool righttoleft) {
+   struct single *in = XIO_RDSTREAM(inpipe);
+   off_t pos, hole = 0;
+   ssize_t bytes;
+   int i;
+
+   if (sparsetab[righttoleft].in == SPARSE_STREAM) {
+      if (sparsetab[righttoleft].left > 0) {
+	 if (sparsetab[righttoleft].left < *bufsiz)
+	    *bufsiz = sparsetab[righttoleft].left;
+	 return 0;
+      }
+      bytes = xioread(inpipe,
+		      sparsetab[righttoleft].hdr+sparsetab[righttoleft].hdrlen,
+		      SPARSE_HDRLEN-sparsetab[righttoleft].hdrlen);
+      if (bytes < 0) {
+	 if (errno != EAGAIN)
+	    in->eof = 2;
+	 return -1;
+      }
+      if (bytes == 0) {
+	 if (sparsetab[righttoleft].hdrlen > 0) {
+	    Warn1("sparse stream on fd %d ends within a record header",
+		  in->fd);
+	 }
+	 return 0;	/* the read by the caller handles EOF */
+      }
+      if ((sparsetab[righttoleft].hdrlen += bytes) < SPARSE_HDRLEN) {
+	 errno = EAGAIN;  return -1;
+      }
+      sparsetab[righttoleft].hdrlen = 0;
+      for (i = 1; i < SPARSE_HDRLEN; ++i) {
+	 hole = (hole << 8) | sparsetab[righttoleft].hdr[i];
+      }
+      if (hole < 0) {
+	 sparsetab[righttoleft].hdr[0] = '\0';	/* invalid */
+      }
+      switch (sparsetab[righttoleft].hdr[0]) {
+      case 'D':
+	 if (hole == 0) {
+	    errno = EAGAIN;  return -1;
+	 }
+	 sparsetab[righttoleft].left = hole;
+	 if (sparsetab[righttoleft].left < *bufsiz)
+	    *bufsiz = sparsetab[righttoleft].left;
+	 return 0;
+      case 'H':
+	 break;
+      default:
+	 Error1("sparse stream on fd %d: invalid record header", in->fd);
+	 in->eof = 2;
+	 errno = EPROTO;
+	 return -1;
+      }
+   } else {
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+      off_t data;
+      struct stat buf;
+
+      if ((pos = sparsetab[righttoleft].pos) < 0 &&
+	  (pos = Lseek(in->fd, 0, SEEK_CUR)) < 0) {
+	 Warn2("lseek(%d, 0, SEEK_CUR): %s, reading holes as zeroes",
+	       in->fd, strerror(errno));
+	 sparsetab[righttoleft].in = SPARSE_NONE;
+	 return 0;
+      }
+      if (pos < sparsetab[righttoleft].end) {
+	 if (sparsetab[righttoleft].end - pos < (off_t)*bufsiz)
+	    *bufsiz = sparsetab[righttoleft].end - pos;
+	 sparsetab[righttoleft].pos = pos;
+	 return 0;
+      }
+      /* at the end of a data region: find the next one */
+      if ((data = Lseek(in->fd, pos, SEEK_DATA)) < 0) {
+	 if (errno != ENXIO || Fstat(in->fd, &buf) < 0) {
+	    Warn3("lseek(%d, "F_off", SEEK_DATA): %s, reading holes as zeroes",
+		  in->fd, pos, strerror(errno));
+	    Lseek(in->fd, pos, SEEK_SET);
+	    sparsetab[righttoleft].in = SPARSE_NONE;
+	    return 0;
+	 }
+	 /* no more data: a hole up to the end of file, or EOF */
+	 data = Max(pos, buf.st_size);
+	 sparsetab[righttoleft].end = data;
+      } else if ((sparsetab[righttoleft].end = Lseek(in->fd, data, SEEK_HOLE))
+		 < 0) {
+	 sparsetab[righttoleft].end = data;
+      }
+      hole = data - pos;
+      if (in->readbytes && (size_t)hole > in->actbytes) {
+	 hole = in->actbytes;
+      }
+      if (Lseek(in->fd, pos+hole, SEEK_SET) < 0) {
+	 Error3("lseek(%d, "F_off", SEEK_SET): %s",
+		in->fd, pos+hole, strerror(errno));
+	 return -1;
+      }
+      sparsetab[righttoleft].pos = pos + hole;
+      if (hole == 0) {
+	 if (sparsetab[righttoleft].end - pos < (off_t)*bufsiz)
+	    *bufsiz = Max(sparsetab[righttoleft].end - pos, 1);
+	 return 0;
+      }
+      if (in->readbytes)
+	 in->actbytes -= hole;
+#endif /* defined(SEEK_DATA) && defined(SEEK_HOLE) */
+   }
+
+   Info3("passing hole of "F_off" bytes from %d to %d",
+	 hole, XIO_GETRDFD(inpipe), XIO_GETWRFD(outpipe));
+   if (socat_sparse_hole(outpipe, buff, *bufsiz, hole, righttoleft) < 0) {
+      return -1;
+   }
+#if WITH_STATS
+   ++in->blocks_read;
+   in->bytes_read += hole;
+   ++XIO_WRSTREAM(outpipe)->blocks_written;
+   XIO_WRSTREAM(outpipe)->bytes_written += hole;
+#endif
+   return Min(hole, INT_MAX);
+}
+
 #define CR '\r'
 #define LF '\n'
 
@@ -1803,6 +3210,10 @@ static void socat_print_stats(void)
 		Warn("transfer engine not yet started, statistics not available");
 		return;
 	}
+	if (sock2->common.flags & XIO_DOESPASS) {
+		Warn("data were passed directly to child process, statistics not available");
+		return;
+	}
 	if ((sock1->tag & ~XIO_TAG_CLOSED) == XIO_TAG_DUAL) {
 		sock1w = sock1->dual.stream[1];
 	} else {
@@ -1829,6 +3240,9 @@ static void socat_print_stats(void)
 	savelevel = diag_get_int('d');
 	diag_set_int('d', E_INFO);
 	Warn("statistics are experimental");
+	if (socat_relayname[0] != '\0') {
+		Info1("STATISTICS of relay %s", socat_relayname);
+	}
 	if (!socat_opts.righttoleft) {
 		Info2(ltorf1, sock2w->blocks_written, sock2w->bytes_written);
 	}
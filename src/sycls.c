@@ -669,6 +669,130 @@ int Ftruncate64(int fd, off64_t length) {
 }
 #endif /* HAVE_FTRUNCATE64 */
 
+#if HAVE_SYS_MMAN_H
+void *Mmap(void *addr, size_t length, int prot, int flags, int fd,
+	   off_t offset) {
+   void *retval;
+   int _errno;
+   Debug6("mmap(%p, "F_Zu", 0x%x, 0x%x, %d, "F_off")",
+	  addr, length, prot, flags, fd, offset);
+   retval = mmap(addr, length, prot, flags, fd, offset);
+   _errno = errno;
+   Debug1("mmap() -> %p", retval);
+   errno = _errno;
+   return retval;
+}
+
+int Munmap(void *addr, size_t length) {
+   int retval, _errno;
+   Debug2("munmap(%p, "F_Zu")", addr, length);
+   retval = munmap(addr, length);
+   _errno = errno;
+   Debug1("munmap() -> %d", retval);
+   errno = _errno;
+   return retval;
+}
+
+int Madvise(void *addr, size_t length, int advice) {
+   int retval, _errno;
+   Debug3("madvise(%p, "F_Zu", %d)", addr, length, advice);
+   retval = madvise(addr, length, advice);
+   _errno = errno;
+   Debug1("madvise() -> %d", retval);
+   errno = _errno;
+   return retval;
+}
+#endif /* HAVE_SYS_MMAN_H */
+
+#if HAVE_SENDFILE
+ssize_t Sendfile(int out_fd, int in_fd, off_t *offset, size_t count) {
+   ssize_t retval;
+   int _errno;
+   Debug4("sendfile(%d, %d, %p, "F_Zu")", out_fd, in_fd, offset, count);
+   retval = sendfile(out_fd, in_fd, offset, count);
+   _errno = errno;
+   Debug1("sendfile() -> "F_Zd, retval);
+   errno = _errno;
+   return retval;
+}
+#endif /* HAVE_SENDFILE */
+
+#if HAVE_COPY_FILE_RANGE
+ssize_t Copy_file_range(int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+			size_t len, unsigned int flags) {
+   ssize_t retval;
+   int _errno;
+   Debug6("copy_file_range(%d, %p, %d, %p, "F_Zu", 0x%x)",
+	  fd_in, off_in, fd_out, off_out, len, flags);
+   retval = copy_file_range(fd_in, off_in, fd_out, off_out, len, flags);
+   _errno = errno;
+   Debug1("copy_file_range() -> "F_Zd, retval);
+   errno = _errno;
+   return retval;
+}
+#endif /* HAVE_COPY_FILE_RANGE */
+
+#if HAVE_POSIX_FADVISE
+int Posix_fadvise(int fd, off_t offset, off_t len, int advice) {
+   int retval;
+   Debug4("posix_fadvise(%d, "F_off", "F_off", %d)", fd, offset, len, advice);
+   retval = posix_fadvise(fd, offset, len, advice);
+   Debug1("posix_fadvise() -> %d", retval);
+   return retval;
+}
+#endif /* HAVE_POSIX_FADVISE */
+
+#if HAVE_SYNC_FILE_RANGE
+int Sync_file_range(int fd, off_t offset, off_t nbytes, unsigned int flags) {
+   int retval, _errno;
+   Debug4("sync_file_range(%d, "F_off", "F_off", 0x%x)",
+	  fd, offset, nbytes, flags);
+   retval = sync_file_range(fd, offset, nbytes, flags);
+   _errno = errno;
+   Debug1("sync_file_range() -> %d", retval);
+   errno = _errno;
+   return retval;
+}
+#endif /* HAVE_SYNC_FILE_RANGE */
+
+#if HAVE_FALLOCATE
+int Fallocate(int fd, int mode, off_t offset, off_t len) {
+   int retval, _errno;
+   Debug4("fallocate(%d, 0x%x, "F_off", "F_off")", fd, mode, offset, len);
+   retval = fallocate(fd, mode, offset, len);
+   _errno = errno;
+   Debug1("fallocate() -> %d", retval);
+   errno = _errno;
+   return retval;
+}
+#endif /* HAVE_FALLOCATE */
+
+#if HAVE_POSIX_SPAWN
+int Posix_spawn(pid_t *pid, const char *path,
+		const posix_spawn_file_actions_t *file_actions,
+		const posix_spawnattr_t *attrp,
+		char *const argv[], char *const envp[]) {
+   int retval;
+   Debug4("posix_spawn(%p, \"%s\", %p, %p, ...)",
+	  pid, path, file_actions, attrp);
+   retval = posix_spawn(pid, path, file_actions, attrp, argv, envp);
+   Debug2("posix_spawn(-> {"F_pid"}) -> %d", *pid, retval);
+   return retval;
+}
+
+int Posix_spawnp(pid_t *pid, const char *file,
+		 const posix_spawn_file_actions_t *file_actions,
+		 const posix_spawnattr_t *attrp,
+		 char *const argv[], char *const envp[]) {
+   int retval;
+   Debug4("posix_spawnp(%p, \"%s\", %p, %p, ...)",
+	  pid, file, file_actions, attrp);
+   retval = posix_spawnp(pid, file, file_actions, attrp, argv, envp);
+   Debug2("posix_spawnp(-> {"F_pid"}) -> %d", *pid, retval);
+   return retval;
+}
+#endif /* HAVE_POSIX_SPAWN */
+
 #endif /* WITH_SYCLS */
 
 #if HAVE_FLOCK
@@ -1354,6 +1478,32 @@ int Recvmsg(int s, struct msghdr *msgh, int flags) {
 }
 #endif /* _WITH_SOCKET */
 
+#if _WITH_SOCKET
+int Sendmsg(int s, const struct msghdr *msgh, int flags) {
+   int retval, _errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+#if defined(HAVE_STRUCT_MSGHDR_MSGCONTROL) && defined(HAVE_STRUCT_MSGHDR_MSGCONTROLLEN) && defined(HAVE_STRUCT_MSGHDR_MSGFLAGS)
+   Debug10("sendmsg(%d, %p{%p,%u,%p,"F_Zu",%p,"F_Zu",%d}, %d)", s, msgh,
+	  msgh->msg_name, msgh->msg_namelen,  msgh->msg_iov,  msgh->msg_iovlen,
+	  msgh->msg_control,  msgh->msg_controllen,  msgh->msg_flags, flags);
+#else
+   Debug7("sendmsg(%d, %p{%p,%u,%p,%u}, %d)", s, msgh,
+	  msgh->msg_name, msgh->msg_namelen,  msgh->msg_iov,  msgh->msg_iovlen,
+	  flags);
+#endif
+#endif /* WITH_SYCLS */
+   retval = sendmsg(s, msgh, flags);
+   _errno = errno;
+   if (!diag_in_handler) diag_flush();
+#if WITH_SYCLS
+   Debug1("sendmsg() -> %d", retval);
+#endif /* WITH_SYCLS */
+   errno = _errno;
+   return retval;
+}
+#endif /* _WITH_SOCKET */
+
 #if _WITH_SOCKET
 int Send(int s, const void *mesg, size_t len, int flags) {
    int retval, _errno;
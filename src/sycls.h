@@ -69,6 +69,38 @@ int Ftruncate(int fd, off_t length);
 #if HAVE_FTRUNCATE64
 int Ftruncate64(int fd, off64_t length);
 #endif /* HAVE_FTRUNCATE64 */
+#if HAVE_SYS_MMAN_H
+void *Mmap(void *addr, size_t length, int prot, int flags, int fd,
+	   off_t offset);
+int Munmap(void *addr, size_t length);
+int Madvise(void *addr, size_t length, int advice);
+#endif /* HAVE_SYS_MMAN_H */
+#if HAVE_SENDFILE
+ssize_t Sendfile(int out_fd, int in_fd, off_t *offset, size_t count);
+#endif
+#if HAVE_COPY_FILE_RANGE
+ssize_t Copy_file_range(int fd_in, off_t *off_in, int fd_out, off_t *off_out,
+			size_t len, unsigned int flags);
+#endif
+#if HAVE_POSIX_FADVISE
+int Posix_fadvise(int fd, off_t offset, off_t len, int advice);
+#endif
+#if HAVE_SYNC_FILE_RANGE
+int Sync_file_range(int fd, off_t offset, off_t nbytes, unsigned int flags);
+#endif
+#if HAVE_FALLOCATE
+int Fallocate(int fd, int mode, off_t offset, off_t len);
+#endif
+#if HAVE_POSIX_SPAWN
+int Posix_spawn(pid_t *pid, const char *path,
+		const posix_spawn_file_actions_t *file_actions,
+		const posix_spawnattr_t *attrp,
+		char *const argv[], char *const envp[]);
+int Posix_spawnp(pid_t *pid, const char *file,
+		 const posix_spawn_file_actions_t *file_actions,
+		 const posix_spawnattr_t *attrp,
+		 char *const argv[], char *const envp[]);
+#endif
 #endif /* WITH_SYCLS */
 int Flock(int fd, int operation);
 int Ioctl(int d, int request, void *argp);
@@ -129,6 +161,7 @@ int Recv(int s, void *buf, size_t len, int flags);
 int Recvfrom(int s, void *buf, size_t len, int flags, struct sockaddr *from,
 	     socklen_t *fromlen);
 int Recvmsg(int s, struct msghdr *msg, int flags);
+int Sendmsg(int s, const struct msghdr *msgh, int flags);
 int Send(int s, const void *mesg, size_t len, int flags);
 int Sendto(int s, const void *msg, size_t len, int flags,
 	   const struct sockaddr *to, socklen_t tolen);
@@ -223,6 +256,16 @@ void Add_history(const char *string);
 #define Pipe(f) pipe(f)
 #define Ftruncate(f,l) ftruncate(f,l)
 #define Ftruncate64(f,l) ftruncate64(f,l)
+#define Mmap(a,l,p,f,d,o) mmap(a,l,p,f,d,o)
+#define Munmap(a,l) munmap(a,l)
+#define Madvise(a,l,d) madvise(a,l,d)
+#define Sendfile(o,i,f,c) sendfile(o,i,f,c)
+#define Copy_file_range(i,n,o,f,l,g) copy_file_range(i,n,o,f,l,g)
+#define Posix_fadvise(f,o,l,a) posix_fadvise(f,o,l,a)
+#define Sync_file_range(f,o,n,g) sync_file_range(f,o,n,g)
+#define Fallocate(f,m,o,l) fallocate(f,m,o,l)
+#define Posix_spawn(p,f,a,t,v,e) posix_spawn(p,f,a,t,v,e)
+#define Posix_spawnp(p,f,a,t,v,e) posix_spawnp(p,f,a,t,v,e)
 #define Close(f) close(f)
 #define Fchown(f,o,g) fchown(f,o,g)
 #define Fchmod(f,m) fchmod(f,m)
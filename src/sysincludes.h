@@ -35,6 +35,7 @@
 #include <syslog.h>	/* openlog(), syslog(), closelog() */
 #endif
 #include <signal.h>	/* signal(), SIGPIPE, SIG_IGN */
+#include <setjmp.h>	/* sigsetjmp(), siglongjmp() */
 #include <time.h>	/* struct timeval, strftime(), clock_gettime() */
 #if 0
 #include <sys/timeb.h>	/* struct timeb */
@@ -77,6 +78,28 @@
 #if HAVE_SYS_STAT_H
 #include <sys/stat.h>	/* struct stat, stat(), open() */
 #endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>	/* mmap() */
+#endif
+#if HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>	/* sendfile() */
+#endif
+#if HAVE_AIO_H
+#include <aio.h>		/* aio_read() */
+#endif
+#if HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>	/* inotify_init1() */
+#endif
+#if HAVE_SPAWN_H
+#include <spawn.h>		/* posix_spawn() */
+#endif
+#if WITH_SHMRING
+#include <linux/futex.h>	/* FUTEX_WAIT */
+#include <sys/syscall.h>	/* SYS_futex */
+#if HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>		/* epoll_create1() */
+#endif
+#endif
 #if HAVE_SYS_WAIT_H
 #include <sys/wait.h>	/* WNOHANG */
 #endif
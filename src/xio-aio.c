@@ -0,0 +1,319 @@
+/* source: xio-aio.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for asynchronous read-ahead on regular files
+   and block devices with POSIX AIO (option aio-buffers). A ring of aligned
+   buffers is kept in flight, so the disk keeps reading while the transfer
+   engine writes the previous block to the other address. The buffers are
+   page aligned and sized, which makes them usable with option o-direct.
+   glibc performs the requests in helper threads of its own; they only run
+   the reads, with all signals blocked, so signal handling is unchanged.
+   A child process does not inherit these threads: outstanding requests are
+   cancelled before fork() and submitted again on the next read, and a
+   process never waits for requests it has not submitted itself */
+
+#include "xiosysincludes.h"
+#include "xioopen.h"
+
+#include "xio-aio.h"
+
+
+#if HAVE_AIO_READ
+
+const struct optdesc opt_aio_buffers = { "aio-buffers", "aio", OPT_AIO_BUFFERS, GROUP_REG|GROUP_BLK, PH_LATE, TYPE_INT, OFUNC_SPEC };
+
+
+/* Retrieves option aio-buffers. When set and the address reads a regular file
+   or block device, switches the read method of sfd to XIOREAD_AIO. Buffers are
+   allocated and requests submitted on first read, so options like seek that
+   are applied later are honoured.
+   Returns 0 on success (even when AIO is not used), or -1 */
+int _xioopen_aio(struct single *sfd, int rw, struct opt *opts) {
+   int nbufs = 0;
+   struct stat buf;
+
+   if (retropt_int(opts, OPT_AIO_BUFFERS, &nbufs) < 0 || nbufs == 0) {
+      return 0;
+   }
+   if (nbufs < 0 || nbufs > 1024) {
+      Error1("option aio-buffers=%d: value out of range 1..1024", nbufs);
+      return -1;
+   }
+   if (rw == XIO_WRONLY) {
+      Warn("option aio-buffers has no effect on write-only addresses");
+      return 0;
+   }
+   if ((sfd->dtype & XIODATA_READMASK) != XIOREAD_STREAM) {
+      Warn("option aio-buffers: address does not read with read(), ignoring");
+      return 0;
+   }
+   if (Fstat(sfd->fd, &buf) < 0) {
+      Error2("fstat(%d, ...): %s", sfd->fd, strerror(errno));
+      return -1;
+   }
+   if (!S_ISREG(buf.st_mode) && !S_ISBLK(buf.st_mode)) {
+      Warn1("option aio-buffers: fd %d is neither regular file nor block device, using read()",
+	    sfd->fd);
+      return 0;
+   }
+   sfd->para.aio.nbufs   = nbufs;
+   sfd->para.aio.bufsiz  = 0;
+   sfd->para.aio.bufs    = NULL;
+   sfd->para.aio.cbs     = NULL;
+   sfd->para.aio.busy    = NULL;
+   sfd->para.aio.head    = 0;
+   sfd->para.aio.headpos = 0;
+   sfd->para.aio.headlen = -1;
+   sfd->para.aio.next    = -1;
+   sfd->para.aio.skip    = 0;
+   sfd->para.aio.started = false;
+   sfd->para.aio.draining = false;
+   sfd->para.aio.owner   = 0;
+   sfd->dtype = (sfd->dtype & ~XIODATA_READMASK) | XIOREAD_AIO;
+   Info2("fd %d: reading ahead with %d asynchronous requests", sfd->fd, nbufs);
+   return 0;
+}
+
+/* Allocates the aligned buffers and control blocks; their size is the
+   transfer block size (option -b) rounded up to full pages */
+static int xioaio_alloc(struct single *sfd) {
+   long pagesize = getpagesize();
+   int nbufs = sfd->para.aio.nbufs;
+   size_t bufsiz;
+   int _errno;
+
+   bufsiz = (xioparms.bufsiz + pagesize - 1) & ~((size_t)pagesize - 1);
+   if ((_errno = Posix_memalign((void **)&sfd->para.aio.bufs, pagesize,
+				nbufs*bufsiz)) != 0) {
+      Error1("posix_memalign(): %s", strerror(_errno));
+      return -1;
+   }
+   if ((sfd->para.aio.cbs = Malloc(nbufs*sizeof(struct aiocb))) == NULL ||
+       (sfd->para.aio.busy = Malloc(nbufs*sizeof(bool))) == NULL) {
+      return -1;
+   }
+   memset(sfd->para.aio.cbs, 0, nbufs*sizeof(struct aiocb));
+   memset(sfd->para.aio.busy, 0, nbufs*sizeof(bool));
+   sfd->para.aio.bufsiz = bufsiz;
+   return 0;
+}
+
+/* Queues a read request for buffer i at the next file offset */
+static int xioaio_submit(struct single *sfd, int i) {
+   struct aiocb *cb = &sfd->para.aio.cbs[i];
+
+   memset(cb, 0, sizeof(struct aiocb));
+   cb->aio_fildes = sfd->fd;
+   cb->aio_offset = sfd->para.aio.next;
+   cb->aio_buf    = sfd->para.aio.bufs + i*sfd->para.aio.bufsiz;
+   cb->aio_nbytes = sfd->para.aio.bufsiz;
+   cb->aio_sigevent.sigev_notify = SIGEV_NONE;
+   Debug4("aio_read({%d, "F_off", %p, "F_Zu"})",
+	  cb->aio_fildes, cb->aio_offset, cb->aio_buf, cb->aio_nbytes);
+   if (aio_read(cb) < 0) {
+      Error3("aio_read({%d, "F_off", ...}): %s",
+	     sfd->fd, cb->aio_offset, strerror(errno));
+      return -1;
+   }
+   sfd->para.aio.busy[i] = true;
+   sfd->para.aio.owner = Getpid();
+   sfd->para.aio.next += sfd->para.aio.bufsiz;
+   return 0;
+}
+
+/* Waits until the request of buffer i has finished.
+   Returns the number of bytes read, or -1 with errno set */
+static ssize_t xioaio_wait(struct single *sfd, int i) {
+   struct aiocb *cb = &sfd->para.aio.cbs[i];
+   const struct aiocb *list[1];
+   ssize_t bytes;
+   int err;
+
+   list[0] = cb;
+   while ((err = aio_error(cb)) == EINPROGRESS) {
+      if (aio_suspend(list, 1, NULL) < 0 && errno != EINTR && errno != EAGAIN) {
+	 err = errno;
+	 Error1("aio_suspend(): %s", strerror(err));
+	 break;
+      }
+   }
+   bytes = aio_return(cb);
+   sfd->para.aio.busy[i] = false;
+   Debug3("aio_read(fd=%d, offset="F_off") -> "F_Zd,
+	  sfd->fd, cb->aio_offset, bytes);
+   if (err != 0) {
+      errno = err;
+      return -1;
+   }
+   return bytes;
+}
+
+/* Cancels and reaps all outstanding requests; the next read submits new ones
+   starting at file offset restart. Requests that a parent process submitted
+   before fork() are only forgotten, they never complete here */
+static void xioaio_stop(struct single *sfd, off_t restart) {
+   bool ours = (sfd->para.aio.owner == Getpid());
+   int i;
+
+   for (i = 0; i < sfd->para.aio.nbufs; ++i) {
+      if (sfd->para.aio.busy[i]) {
+	 if (ours) {
+	    aio_cancel(sfd->fd, &sfd->para.aio.cbs[i]);
+	    xioaio_wait(sfd, i);
+	 } else {
+	    sfd->para.aio.busy[i] = false;
+	 }
+      }
+   }
+   sfd->para.aio.next     = restart;
+   sfd->para.aio.started  = false;
+   sfd->para.aio.draining = false;
+   sfd->para.aio.headlen  = -1;
+   sfd->para.aio.headpos  = 0;
+}
+
+/* Passes at most bufsiz bytes from the oldest completed request by pointing
+   *data into its buffer; the data stays valid until the next call.
+   Returns the number of bytes, 0 on EOF, or -1 on error */
+ssize_t xioread_aio(struct single *sfd, const void **data, size_t bufsiz) {
+   int nbufs = sfd->para.aio.nbufs;
+   int head;
+   ssize_t bytes;
+   off_t offset, start;
+   size_t avail;
+   int k;
+
+   if (sfd->para.aio.bufs == NULL && xioaio_alloc(sfd) < 0) {
+      return -1;
+   }
+
+   if (!sfd->para.aio.started) {
+      if (sfd->para.aio.next < 0) {
+	 /* first read: start where options like seek left the file offset */
+	 if ((sfd->para.aio.next = Lseek(sfd->fd, 0, SEEK_CUR)) < 0) {
+	    Error2("lseek(%d, 0, SEEK_CUR): %s", sfd->fd, strerror(errno));
+	    return -1;
+	 }
+      }
+      start = sfd->para.aio.next;
+      for (k = 0; k < nbufs; ++k) {
+	 if (xioaio_submit(sfd, (sfd->para.aio.head+k)%nbufs) < 0) {
+	    xioaio_stop(sfd, start);
+	    return -1;
+	 }
+      }
+      sfd->para.aio.started = true;
+   } else if (sfd->para.aio.headlen >= 0 &&
+	      sfd->para.aio.headpos >= (size_t)sfd->para.aio.headlen) {
+      /* the previous call passed the rest of head, now it may be reused */
+      if (sfd->para.aio.draining) {
+	 xioaio_stop(sfd, sfd->para.aio.next);
+	 return xioread_aio(sfd, data, bufsiz);
+      }
+      head = sfd->para.aio.head;
+      start = sfd->para.aio.cbs[head].aio_offset + sfd->para.aio.headlen;
+      if (xioaio_submit(sfd, head) < 0) {
+	 xioaio_stop(sfd, start);
+	 return -1;
+      }
+      sfd->para.aio.head = (head+1)%nbufs;
+      sfd->para.aio.headlen = -1;
+      sfd->para.aio.headpos = 0;
+   }
+
+   head = sfd->para.aio.head;
+   offset = sfd->para.aio.cbs[head].aio_offset;
+   if (sfd->para.aio.headlen < 0) {
+      if ((bytes = xioaio_wait(sfd, head)) < 0) {
+	 int _errno = errno;
+	 Error4("aio_read(%d, "F_off", "F_Zu"): %s",
+		sfd->fd, offset, sfd->para.aio.bufsiz, strerror(_errno));
+	 xioaio_stop(sfd, offset);
+	 errno = _errno;
+	 return -1;
+      }
+      if ((size_t)bytes <= sfd->para.aio.skip) {
+	 /* end of file; with ignoreeof, the next read starts here again */
+	 xioaio_stop(sfd, offset);
+	 return 0;
+      }
+      sfd->para.aio.headpos = sfd->para.aio.skip;
+      sfd->para.aio.skip = 0;
+      if ((size_t)bytes < sfd->para.aio.bufsiz) {
+	 /* end of file within this block: the requests behind it read beyond
+	    EOF, discard them after passing this block. Reading again starts
+	    at this block, which keeps the offset aligned for o-direct, and
+	    skips the bytes already passed */
+	 sfd->para.aio.next = offset;
+	 sfd->para.aio.skip = bytes;
+	 sfd->para.aio.draining = true;
+      }
+      sfd->para.aio.headlen = bytes;
+   }
+
+   avail = sfd->para.aio.headlen - sfd->para.aio.headpos;
+   if (avail > bufsiz) {
+      avail = bufsiz;
+   }
+   *data = (char *)sfd->para.aio.bufs + head*sfd->para.aio.bufsiz +
+      sfd->para.aio.headpos;
+   sfd->para.aio.headpos += avail;
+   return avail;
+}
+
+/* Stops the requests of sfd so that reading resumes at the first byte not
+   yet passed to the transfer engine */
+static void xioaio_pause(struct single *sfd) {
+   int head = sfd->para.aio.head;
+   off_t offset = sfd->para.aio.cbs[head].aio_offset;
+
+   if (sfd->para.aio.draining) {
+      /* next and skip already point to the last block */
+      xioaio_stop(sfd, sfd->para.aio.next);
+   } else if (sfd->para.aio.headlen < 0) {
+      /* head still in flight, skip stays for it */
+      xioaio_stop(sfd, offset);
+   } else if (sfd->para.aio.headpos >= (size_t)sfd->para.aio.headlen) {
+      /* head completely passed, it was a full block */
+      xioaio_stop(sfd, offset + sfd->para.aio.headlen);
+   } else {
+      sfd->para.aio.skip = sfd->para.aio.headpos;
+      xioaio_stop(sfd, offset);
+   }
+}
+
+/* Called before fork(): cancels the outstanding requests of the open
+   addresses, so neither process depends on helper threads and buffers that
+   are in use while the address space is copied */
+void xioaio_prefork(void) {
+   xiofile_t *socks[2];
+   struct single *sfd;
+   int i;
+
+   socks[0] = sock1;  socks[1] = sock2;
+   for (i = 0; i < 2; ++i) {
+      if (socks[i] == NULL || socks[i]->tag == XIO_TAG_INVALID ||
+	  (socks[i]->tag & XIO_TAG_CLOSED))
+	 continue;
+      sfd = XIO_RDSTREAM(socks[i]);
+      if ((sfd->dtype & XIODATA_READMASK) != XIOREAD_AIO ||
+	  !sfd->para.aio.started)
+	 continue;
+      Debug1("fd %d: stopping asynchronous reads before fork()", sfd->fd);
+      xioaio_pause(sfd);
+   }
+}
+
+int xioclose_aio(struct single *sfd) {
+   if (sfd->para.aio.bufs == NULL) {
+      return 0;
+   }
+   xioaio_stop(sfd, 0);
+   free(sfd->para.aio.busy);  sfd->para.aio.busy = NULL;
+   free(sfd->para.aio.cbs);   sfd->para.aio.cbs  = NULL;
+   free(sfd->para.aio.bufs);  sfd->para.aio.bufs = NULL;
+   return 0;
+}
+
+#endif /* HAVE_AIO_READ */
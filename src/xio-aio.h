@@ -0,0 +1,19 @@
+/* source: xio-aio.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_aio_h_included
+#define __xio_aio_h_included 1
+
+#if HAVE_AIO_READ
+
+extern const struct optdesc opt_aio_buffers;
+
+extern int _xioopen_aio(struct single *sfd, int rw, struct opt *opts);
+extern ssize_t xioread_aio(struct single *sfd, const void **data, size_t bufsiz);
+extern int xioclose_aio(struct single *sfd);
+extern void xioaio_prefork(void);
+
+#endif /* HAVE_AIO_READ */
+
+#endif /* !defined(__xio_aio_h_included) */
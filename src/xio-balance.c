@@ -0,0 +1,581 @@
+/* source: xio-balance.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for load balancing of TCP client addresses
+   over several backends (option backends) with passive and active health
+   checks */
+
+#include "xiosysincludes.h"
+
+#if WITH_TCP
+
+#include "xioopen.h"
+#include "xio-ip.h"
+
+#include "xio-balance.h"
+#include "xioshm.h"
+
+
+const struct optdesc opt_backends          = { "backends",          NULL, OPT_BACKENDS,          GROUP_IP_TCP, PH_INIT, TYPE_STRING,   OFUNC_SPEC };
+const struct optdesc opt_balance           = { "balance",           NULL, OPT_BALANCE,           GROUP_IP_TCP, PH_INIT, TYPE_STRING,   OFUNC_SPEC };
+const struct optdesc opt_backend_down_time = { "backend-down-time", NULL, OPT_BACKEND_DOWN_TIME, GROUP_IP_TCP, PH_INIT, TYPE_TIMESPEC, OFUNC_SPEC };
+const struct optdesc opt_health_check      = { "health-check",      NULL, OPT_HEALTH_CHECK,      GROUP_IP_TCP, PH_INIT, TYPE_TIMESPEC, OFUNC_SPEC };
+
+/* The state of the backends is kept in a table that is moved to shared
+   memory (xioshm.c) before the first fork(), so that all children of a
+   forking listener see the same failures, connection counts, and round
+   robin position. Each child records its pid with the backend it connected
+   to; entries of terminated processes are swept on selection. */
+
+#define XIOBALANCE_BACKENDS	64	/* table entries, shared by all sets */
+#define XIOBALANCE_CONNS	1024	/* tracked connections */
+#define XIOBALANCE_SETMAX	16	/* backends of one address */
+#define XIOBALANCE_DOWNTIME	10	/* default for backend-down-time */
+
+enum xiobalance_policy {
+   XIOBALANCE_ROUNDROBIN,
+   XIOBALANCE_LEASTCONN,
+   XIOBALANCE_HASH
+} ;
+
+static const char *xiobalance_policies[] = { "round-robin", "least-conn", "hash" };
+
+struct xiobalance_backend {
+   char name[NI_MAXHOST+NI_MAXSERV+2];	/* "host:port", empty when unused */
+   struct timespec down_until;	/* CLOCK_MONOTONIC, 0 when up */
+   unsigned int rr;		/* round robin position, of first backend */
+} ;
+
+struct xiobalance_conn {
+   pid_t pid;			/* 0 when unused */
+   int backend;
+} ;
+
+struct xiobalance_tab {
+   pid_t checker;		/* health check process, or 0 */
+   bool claimed;		/* a process is starting the checker */
+   struct xiobalance_backend backends[XIOBALANCE_BACKENDS];
+   struct xiobalance_conn conns[XIOBALANCE_CONNS];
+} ;
+
+static struct xiobalance_tab xiobalance_local;
+static struct xiobalance_tab *xiobalance = &xiobalance_local;
+static struct xioshm xiobalance_shm =
+   XIOSHM_INIT("backends", &xiobalance_local);
+
+/* the backends of the client address of this process */
+static struct {
+   int n;			/* 0 when balancing is not used */
+   enum xiobalance_policy policy;
+   char *host[XIOBALANCE_SETMAX];
+   char *port[XIOBALANCE_SETMAX];
+   int slot[XIOBALANCE_SETMAX];	/* index in xiobalance->backends */
+   bool tried[XIOBALANCE_SETMAX];
+   int cur;			/* selected backend, or -1 */
+   struct timespec downtime;
+   struct timespec checkintv;	/* health check interval, 0 for none */
+} xiobalance_set;
+
+
+/* Moves the backend table to shared memory so that processes forked from now
+   on share it with this one. Called before fork() */
+void xiobalance_share(void) {
+   if (xioshm_share(&xiobalance_shm, true) == 0)
+      xiobalance = xiobalance_shm.addr;
+}
+
+static bool xiobalance_isdown(const struct xiobalance_backend *b,
+			      const struct timespec *now) {
+   if (b->down_until.tv_sec == 0 && b->down_until.tv_nsec == 0)
+      return false;
+   return now->tv_sec < b->down_until.tv_sec ||
+      (now->tv_sec == b->down_until.tv_sec &&
+       now->tv_nsec < b->down_until.tv_nsec);
+}
+
+static void xiobalance_setdown(struct xiobalance_backend *b,
+			       const struct timespec *period) {
+   clock_gettime(CLOCK_MONOTONIC, &b->down_until);
+   b->down_until.tv_sec  += period->tv_sec;
+   b->down_until.tv_nsec += period->tv_nsec;
+   if (b->down_until.tv_nsec >= 1000000000) {
+      ++b->down_until.tv_sec;  b->down_until.tv_nsec -= 1000000000;
+   }
+}
+
+/* Finds or allocates the table entry of name; call with lock held.
+   Returns the index, or -1 when the table is full */
+static int xiobalance_slot(const char *name) {
+   int i, free = -1;
+
+   for (i = 0; i < XIOBALANCE_BACKENDS; ++i) {
+      if (!strcmp(xiobalance->backends[i].name, name))
+	 return i;
+      if (free < 0 && xiobalance->backends[i].name[0] == '\0')
+	 free = i;
+   }
+   if (free >= 0) {
+      strncpy(xiobalance->backends[free].name, name,
+	      sizeof(xiobalance->backends[free].name)-1);
+      xiobalance->backends[free].name[sizeof(xiobalance->backends[free].name)-1] = '\0';
+   }
+   return free;
+}
+
+static int xiobalance_add(const char *host, const char *port) {
+   int n = xiobalance_set.n;
+
+   if (n >= XIOBALANCE_SETMAX) {
+      Error1("backends: more than %d backends", XIOBALANCE_SETMAX);
+      return -1;
+   }
+   if ((xiobalance_set.host[n] = strdup(host)) == NULL ||
+       (xiobalance_set.port[n] = strdup(port)) == NULL) {
+      Error1("strdup(): %s", strerror(errno));
+      return -1;
+   }
+   xiobalance_set.tried[n] = false;
+   xiobalance_set.slot[n] = -1;
+   xiobalance_set.n = n+1;
+   return 0;
+}
+
+/* Consumes options backends, balance, backend-down-time, and health-check.
+   host and port are the target of the address, the first backend.
+   Returns 1 when balancing is configured, 0 when not, -1 on error */
+int xiobalance_init(struct opt *opts, const char *host, const char *port) {
+   char *backends = NULL, *policy = NULL;
+   char *tok, *save = NULL, *colon;
+   char name[sizeof(xiobalance->backends[0].name)];
+   int i;
+
+   xiobalance_set.downtime.tv_sec  = XIOBALANCE_DOWNTIME;
+   xiobalance_set.downtime.tv_nsec = 0;
+   retropt_timespec(opts, OPT_BACKEND_DOWN_TIME, &xiobalance_set.downtime);
+   retropt_timespec(opts, OPT_HEALTH_CHECK, &xiobalance_set.checkintv);
+   retropt_string(opts, OPT_BALANCE, &policy);
+   if (retropt_string(opts, OPT_BACKENDS, &backends) < 0) {
+      if (policy != NULL)
+	 Warn("option balance without option backends has no effect");
+      free(policy);
+      return 0;
+   }
+
+   xiobalance_set.policy = XIOBALANCE_ROUNDROBIN;
+   if (policy != NULL) {
+      if (!strcasecmp(policy, "round-robin") || !strcasecmp(policy, "rr")) {
+	 xiobalance_set.policy = XIOBALANCE_ROUNDROBIN;
+      } else if (!strcasecmp(policy, "least-conn")) {
+	 xiobalance_set.policy = XIOBALANCE_LEASTCONN;
+      } else if (!strcasecmp(policy, "hash")) {
+	 xiobalance_set.policy = XIOBALANCE_HASH;
+      } else {
+	 Error1("balance: unknown policy \"%s\"", policy);
+	 free(policy);  free(backends);
+	 return -1;
+      }
+      free(policy);
+   }
+
+   xiobalance_set.n = 0;
+   xiobalance_set.cur = -1;
+   if (xiobalance_add(host, port) < 0) {
+      free(backends);
+      return -1;
+   }
+   for (tok = strtok_r(backends, " ;", &save); tok != NULL;
+	tok = strtok_r(NULL, " ;", &save)) {
+      /* [IPv6 address]:port or host:port */
+      if ((colon = strrchr(tok, ':')) == NULL || colon == tok ||
+	  colon[1] == '\0') {
+	 Error1("backends: \"%s\": expected <host>:<port>", tok);
+	 free(backends);
+	 return -1;
+      }
+      *colon = '\0';
+      if (tok[0] == '[' && colon[-1] == ']') {
+	 colon[-1] = '\0';  ++tok;
+      }
+      if (xiobalance_add(tok, colon+1) < 0) {
+	 free(backends);
+	 return -1;
+      }
+   }
+   free(backends);
+
+   xioshm_lock(&xiobalance_shm);
+   for (i = 0; i < xiobalance_set.n; ++i) {
+      snprintf(name, sizeof(name), "%s:%s",
+	       xiobalance_set.host[i], xiobalance_set.port[i]);
+      xiobalance_set.slot[i] = xiobalance_slot(name);
+   }
+   xioshm_unlock(&xiobalance_shm);
+   for (i = 0; i < xiobalance_set.n; ++i) {
+      if (xiobalance_set.slot[i] < 0) {
+	 Error("backends: too many backends in total");
+	 return -1;
+      }
+   }
+   Info2("backends: balancing over %d backends with policy %s",
+	 xiobalance_set.n, xiobalance_policies[xiobalance_set.policy]);
+   return 1;
+}
+
+/* Returns true when this process balances its connection over backends */
+bool xiobalance_active(void) {
+   return xiobalance_set.n > 0;
+}
+
+/* Returns the number of backends that have not been tried yet */
+int xiobalance_remaining(void) {
+   int i, n = 0;
+
+   for (i = 0; i < xiobalance_set.n; ++i) {
+      if (!xiobalance_set.tried[i])
+	 ++n;
+   }
+   return n;
+}
+
+/* Makes all backends eligible again, for the next connection */
+void xiobalance_reset(void) {
+   int i;
+
+   for (i = 0; i < xiobalance_set.n; ++i) {
+      xiobalance_set.tried[i] = false;
+   }
+   xiobalance_set.cur = -1;
+}
+
+/* FNV-1a */
+static uint32_t xiobalance_hash(uint32_t h, const void *data, size_t len) {
+   const unsigned char *p = data;
+
+   while (len--) {
+      h ^= *p++;
+      h *= 16777619;
+   }
+   return h;
+}
+
+/* The key for consistent hashing: the address of the client on the first
+   address, without port. Returns false when there is none */
+static bool xiobalance_clientkey(uint32_t *key) {
+   union sockaddr_union sa;
+   socklen_t salen = sizeof(sa);
+   int fd;
+
+   if (sock1 == NULL || (fd = XIO_RDSTREAM(sock1)->fd) < 0)
+      return false;
+   if (Getpeername(fd, &sa.soa, &salen) < 0)
+      return false;
+   switch (sa.soa.sa_family) {
+#if WITH_IP4
+   case AF_INET:
+      *key = xiobalance_hash(2166136261u, &sa.ip4.sin_addr,
+			     sizeof(sa.ip4.sin_addr));
+      return true;
+#endif
+#if WITH_IP6
+   case AF_INET6:
+      *key = xiobalance_hash(2166136261u, &sa.ip6.sin6_addr,
+			     sizeof(sa.ip6.sin6_addr));
+      return true;
+#endif
+   default:
+      return false;
+   }
+}
+
+/* Chooses an untried backend by policy; backends marked down are only
+   chosen when no other is left. Call with lock held.
+   Returns the index in xiobalance_set, or -1 */
+static int xiobalance_choose(void) {
+   struct timespec now;
+   int counts[XIOBALANCE_SETMAX];
+   int candidates[XIOBALANCE_SETMAX];
+   int ncand = 0;
+   int i, j, best = -1;
+   uint32_t key, score, bestscore = 0;
+   bool down;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   for (down = false; ncand == 0; down = true) {
+      for (i = 0; i < xiobalance_set.n; ++i) {
+	 if (xiobalance_set.tried[i])
+	    continue;
+	 if (xiobalance_isdown(&xiobalance->backends[xiobalance_set.slot[i]],
+			       &now) != down)
+	    continue;
+	 candidates[ncand++] = i;
+      }
+      if (down)
+	 break;
+   }
+   if (ncand == 0)
+      return -1;
+
+   switch (xiobalance_set.policy) {
+   case XIOBALANCE_HASH:
+      /* rendezvous hashing: a backend going down only moves its own
+	 clients */
+      if (xiobalance_clientkey(&key)) {
+	 for (j = 0; j < ncand; ++j) {
+	    i = candidates[j];
+	    score = xiobalance_hash(key,
+				    xiobalance->backends[xiobalance_set.slot[i]].name,
+				    strlen(xiobalance->backends[xiobalance_set.slot[i]].name));
+	    if (best < 0 || score > bestscore) {
+	       best = i;  bestscore = score;
+	    }
+	 }
+	 return best;
+      }
+      /* no client address: round robin */
+      /* fall through */
+   case XIOBALANCE_ROUNDROBIN:
+      return candidates[xiobalance->backends[xiobalance_set.slot[0]].rr++ %
+			ncand];
+   case XIOBALANCE_LEASTCONN:
+      memset(counts, 0, sizeof(counts));
+      for (j = 0; j < XIOBALANCE_CONNS; ++j) {
+	 struct xiobalance_conn *c = &xiobalance->conns[j];
+	 if (c->pid == 0)
+	    continue;
+	 if (Kill(c->pid, 0) < 0 && errno == ESRCH) {
+	    c->pid = 0;
+	    continue;
+	 }
+	 for (i = 0; i < xiobalance_set.n; ++i) {
+	    if (xiobalance_set.slot[i] == c->backend)
+	       ++counts[i];
+	 }
+      }
+      /* ties are broken round robin */
+      key = xiobalance->backends[xiobalance_set.slot[0]].rr++;
+      for (j = 0; j < ncand; ++j) {
+	 i = candidates[(key+j) % ncand];
+	 if (best < 0 || counts[i] < counts[best])
+	    best = i;
+      }
+      return best;
+   }
+   return -1;
+}
+
+/* Selects the next backend to connect to and resolves its name.
+   On success replaces *themarr and sets *host and *port, returns 0;
+   returns -1 when all backends have been tried */
+int xiobalance_select(const char **host, const char **port,
+		      int pf, int socktype, int protocol,
+		      struct addrinfo ***themarr, const struct para_ip *ip) {
+   struct addrinfo **addrs;
+   int i, rc;
+
+   while (true) {
+      xioshm_lock(&xiobalance_shm);
+      i = xiobalance_choose();
+      xioshm_unlock(&xiobalance_shm);
+      if (i < 0)
+	 return -1;
+      xiobalance_set.tried[i] = true;
+      xiobalance_set.cur = i;
+      if (themarr == NULL)
+	 break;
+      rc = xiogetaddrinfo_cached(xiobalance_set.host[i],
+				 xiobalance_set.port[i],
+				 pf, socktype, protocol, &addrs, ip);
+      if (rc == 0) {
+	 if (*themarr != NULL)
+	    xiofreeaddrinfo(*themarr);
+	 *themarr = addrs;
+	 break;
+      }
+      Warn3("backends: resolving \"%s:%s\": %s",
+	    xiobalance_set.host[i], xiobalance_set.port[i],
+	    (rc == EAI_SYSTEM)?strerror(errno):gai_strerror(rc));
+      xiobalance_failed();
+   }
+   *host = xiobalance_set.host[i];
+   *port = xiobalance_set.port[i];
+   Info2("backends: selected \"%s:%s\"", *host, *port);
+   return 0;
+}
+
+/* Passive health check: marks the selected backend down for
+   backend-down-time after a failed connection attempt */
+void xiobalance_failed(void) {
+   struct xiobalance_backend *b;
+
+   if (xiobalance_set.cur < 0)
+      return;
+   b = &xiobalance->backends[xiobalance_set.slot[xiobalance_set.cur]];
+   Notice2("backends: \"%s\" failed, not using it for "F_time" seconds",
+	   b->name, xiobalance_set.downtime.tv_sec);
+   xioshm_lock(&xiobalance_shm);
+   xiobalance_setdown(b, &xiobalance_set.downtime);
+   xioshm_unlock(&xiobalance_shm);
+}
+
+/* Records that this process is connected to the selected backend */
+void xiobalance_connected(void) {
+   struct xiobalance_backend *b;
+   pid_t pid = Getpid();
+   int j, slot;
+
+   if (xiobalance_set.cur < 0)
+      return;
+   slot = xiobalance_set.slot[xiobalance_set.cur];
+   b = &xiobalance->backends[slot];
+   xioshm_lock(&xiobalance_shm);
+   b->down_until.tv_sec = 0;  b->down_until.tv_nsec = 0;
+   for (j = 0; j < XIOBALANCE_CONNS; ++j) {
+      if (xiobalance->conns[j].pid == 0 || xiobalance->conns[j].pid == pid) {
+	 xiobalance->conns[j].pid = pid;
+	 xiobalance->conns[j].backend = slot;
+	 break;
+      }
+   }
+   xioshm_unlock(&xiobalance_shm);
+   Notice1("backends: connected to \"%s\"", b->name);
+}
+
+
+/* Active health check: tries a TCP connection to the first address of each
+   backend, within the check interval. Returns 0 when connected */
+static int xiobalance_probe(int i, const struct para_ip *ip) {
+   struct addrinfo **addrs = NULL;
+   struct pollfd pfd;
+   struct timeval tmo;
+   int err = 0;
+   socklen_t errlen = sizeof(err);
+   int fd, rc;
+
+   if (xiogetaddrinfo(xiobalance_set.host[i], xiobalance_set.port[i],
+		      PF_UNSPEC, SOCK_STREAM, IPPROTO_TCP, &addrs,
+		      ip->ai_flags) != 0 || addrs == NULL || addrs[0] == NULL) {
+      if (addrs != NULL)
+	 xiofreeaddrinfo(addrs);
+      return -1;
+   }
+   if ((fd = Socket(addrs[0]->ai_family, SOCK_STREAM, IPPROTO_TCP)) < 0) {
+      xiofreeaddrinfo(addrs);
+      return -1;
+   }
+   Fcntl_l(fd, F_SETFL, O_NONBLOCK);
+   rc = Connect(fd, addrs[0]->ai_addr, addrs[0]->ai_addrlen);
+   xiofreeaddrinfo(addrs);
+   if (rc < 0 && errno == EINPROGRESS) {
+      pfd.fd = fd;  pfd.events = POLLOUT;  pfd.revents = 0;
+      tmo.tv_sec  = xiobalance_set.checkintv.tv_sec;
+      tmo.tv_usec = xiobalance_set.checkintv.tv_nsec/1000;
+      if (xiopoll(&pfd, 1, &tmo) > 0 &&
+	  Getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errlen) == 0 &&
+	  err == 0) {
+	 rc = 0;
+      }
+   }
+   Close(fd);
+   return rc < 0 ? -1 : 0;
+}
+
+static void xiobalance_checker(pid_t owner, const struct para_ip *ip) {
+   struct timespec down;
+   struct xiobalance_backend *b;
+   int i;
+
+   /* a failed backend stays down until the next round */
+   down.tv_sec  = 2*xiobalance_set.checkintv.tv_sec;
+   down.tv_nsec = 2*xiobalance_set.checkintv.tv_nsec;
+   if (down.tv_nsec >= 1000000000) {
+      ++down.tv_sec;  down.tv_nsec -= 1000000000;
+   }
+   Notice1("backends: health checks every "F_time" seconds",
+	   xiobalance_set.checkintv.tv_sec);
+   while (Kill(owner, 0) == 0 || errno != ESRCH) {
+      for (i = 0; i < xiobalance_set.n; ++i) {
+	 b = &xiobalance->backends[xiobalance_set.slot[i]];
+	 if (xiobalance_probe(i, ip) == 0) {
+	    Info1("backends: \"%s\" is up", b->name);
+	    xioshm_lock(&xiobalance_shm);
+	    b->down_until.tv_sec = 0;  b->down_until.tv_nsec = 0;
+	    xioshm_unlock(&xiobalance_shm);
+	 } else {
+	    Notice1("backends: health check of \"%s\" failed", b->name);
+	    xioshm_lock(&xiobalance_shm);
+	    xiobalance_setdown(b, &down);
+	    xioshm_unlock(&xiobalance_shm);
+	 }
+      }
+      Nanosleep(&xiobalance_set.checkintv, NULL);
+   }
+   Info("backends: listening process has terminated");
+}
+
+/* Starts the health check process when option health-check is given and
+   none is running for the shared table yet. Only children of a forking
+   listener share the table, so a single process probes for all of them */
+void xiobalance_check_start(const struct para_ip *ip) {
+   pid_t owner = Getppid();
+   pid_t pid;
+   int status;
+
+   if (xiobalance_set.n == 0 ||
+       (xiobalance_set.checkintv.tv_sec == 0 &&
+	xiobalance_set.checkintv.tv_nsec == 0))
+      return;
+   if (!xioshm_shared(&xiobalance_shm)) {
+      Info("backends: option health-check only applies with forking listener");
+      return;
+   }
+   xioshm_lock(&xiobalance_shm);
+   if (xiobalance->claimed ||
+       (xiobalance->checker != 0 &&
+	(Kill(xiobalance->checker, 0) == 0 || errno != ESRCH))) {
+      xioshm_unlock(&xiobalance_shm);
+      return;
+   }
+   xiobalance->claimed = true;
+   xioshm_unlock(&xiobalance_shm);
+
+   if ((pid = Fork()) < 0) {
+      Warn1("fork(): %s", strerror(errno));
+      xioshm_lock(&xiobalance_shm);
+      xiobalance->claimed = false;
+      xioshm_unlock(&xiobalance_shm);
+      return;
+   }
+   if (pid > 0) {
+      /* the intermediate process terminates at once */
+      Waitpid(pid, &status, 0);
+      return;
+   }
+   if ((pid = Fork()) != 0) {
+      xioshm_lock(&xiobalance_shm);
+      xiobalance->checker = pid > 0 ? pid : 0;
+      xiobalance->claimed = false;
+      xioshm_unlock(&xiobalance_shm);
+      _exit(pid < 0);
+   }
+
+   /* health check process */
+   diag_fork();
+   Signal(SIGHUP,  SIG_DFL);
+   Signal(SIGINT,  SIG_DFL);
+   Signal(SIGQUIT, SIG_DFL);
+   Signal(SIGTERM, SIG_DFL);
+   Signal(SIGCHLD, SIG_DFL);
+   if (sock1 != NULL) {
+      if (XIO_RDSTREAM(sock1)->fd >= 0)
+	 Close(XIO_RDSTREAM(sock1)->fd);
+      if (XIO_WRSTREAM(sock1) != XIO_RDSTREAM(sock1) &&
+	  XIO_WRSTREAM(sock1)->fd >= 0)
+	 Close(XIO_WRSTREAM(sock1)->fd);
+   }
+   xiobalance_checker(owner, ip);
+   diag_flush();
+   _exit(0);
+}
+
+#endif /* WITH_TCP */
@@ -0,0 +1,27 @@
+/* source: xio-balance.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_balance_h_included
+#define __xio_balance_h_included 1
+
+#if WITH_TCP
+
+extern const struct optdesc opt_backends;
+extern const struct optdesc opt_balance;
+extern const struct optdesc opt_backend_down_time;
+extern const struct optdesc opt_health_check;
+
+extern void xiobalance_share(void);
+extern int xiobalance_init(struct opt *opts, const char *host, const char *port);
+extern bool xiobalance_active(void);
+extern int xiobalance_remaining(void);
+extern void xiobalance_reset(void);
+extern int xiobalance_select(const char **host, const char **port, int pf, int socktype, int protocol, struct addrinfo ***themarr, const struct para_ip *ip);
+extern void xiobalance_failed(void);
+extern void xiobalance_connected(void);
+extern void xiobalance_check_start(const struct para_ip *ip);
+
+#endif /* WITH_TCP */
+
+#endif /* !defined(__xio_balance_h_included) */
@@ -0,0 +1,275 @@
+/* source: xio-cache.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for page cache hints on files (options
+   fadvise, drop-cache, and sync-range). Long sequential copies can tell the
+   kernel how they read, start the writeback of output data step by step
+   instead of leaving it all to close() or the flusher, and drop the data
+   they are done with, so the cache of other processes is not evicted */
+
+#include "xiosysincludes.h"
+#include "xioopen.h"
+
+#include "xio-cache.h"
+
+
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+
+#define XIOCACHE_WINDOW	(8*1024*1024)	/* default bytes per step */
+
+#if HAVE_POSIX_FADVISE
+const struct optdesc opt_fadvise    = { "fadvise",    NULL, OPT_FADVISE,    GROUP_REG|GROUP_BLK, PH_LATE, TYPE_STRING, OFUNC_SPEC };
+const struct optdesc opt_drop_cache = { "drop-cache", NULL, OPT_DROP_CACHE, GROUP_REG|GROUP_BLK, PH_LATE, TYPE_BOOL,   OFUNC_SPEC };
+
+static const struct {
+   const char *name;
+   int advice;
+} xiofadvise_names[] = {
+   { "normal",     POSIX_FADV_NORMAL },
+   { "sequential", POSIX_FADV_SEQUENTIAL },
+   { "random",     POSIX_FADV_RANDOM },
+   { "noreuse",    POSIX_FADV_NOREUSE },
+   { "willneed",   POSIX_FADV_WILLNEED },
+   { "dontneed",   POSIX_FADV_DONTNEED },
+   { NULL }
+} ;
+#endif /* HAVE_POSIX_FADVISE */
+#if HAVE_SYNC_FILE_RANGE
+const struct optdesc opt_sync_range = { "sync-range", NULL, OPT_SYNC_RANGE, GROUP_REG|GROUP_BLK, PH_LATE, TYPE_SIZE_T, OFUNC_SPEC };
+#endif
+
+
+/* Retrieves options fadvise, drop-cache, and sync-range. Applies fadvise to
+   the whole file and prepares sfd for the per step hints of the others.
+   Returns 0 on success (even when the file type does not support them),
+   or -1 */
+int _xioopen_cache(struct single *sfd, int rw, struct opt *opts) {
+   char *advice = NULL;
+   bool drop = false;
+   size_t window = 0;
+   struct stat buf;
+
+#if HAVE_POSIX_FADVISE
+   retropt_string(opts, OPT_FADVISE, &advice);
+   retropt_bool(opts, OPT_DROP_CACHE, &drop);
+#endif
+#if HAVE_SYNC_FILE_RANGE
+   retropt_size_t(opts, OPT_SYNC_RANGE, &window);
+#endif
+   if (advice == NULL && !drop && window == 0) {
+      return 0;
+   }
+   if (Fstat(sfd->fd, &buf) < 0) {
+      Error2("fstat(%d, ...): %s", sfd->fd, strerror(errno));
+      free(advice);
+      return -1;
+   }
+   if (!S_ISREG(buf.st_mode) && !S_ISBLK(buf.st_mode)) {
+      Warn1("fd %d is neither regular file nor block device, ignoring page cache options",
+	    sfd->fd);
+      free(advice);
+      return 0;
+   }
+
+#if HAVE_POSIX_FADVISE
+   if (advice != NULL) {
+      int i, rc;
+
+      for (i = 0; xiofadvise_names[i].name != NULL; ++i) {
+	 if (!strcasecmp(advice, xiofadvise_names[i].name))
+	    break;
+      }
+      if (xiofadvise_names[i].name == NULL) {
+	 Error1("option fadvise=%s: unknown advice", advice);
+	 free(advice);
+	 return -1;
+      }
+      if ((rc = Posix_fadvise(sfd->fd, 0, 0, xiofadvise_names[i].advice))
+	  != 0) {
+	 Warn3("posix_fadvise(%d, 0, 0, %s): %s",
+	       sfd->fd, xiofadvise_names[i].name, strerror(rc));
+      } else {
+	 Info2("fd %d: advised kernel of %s access",
+	       sfd->fd, xiofadvise_names[i].name);
+      }
+      free(advice);
+   }
+#endif /* HAVE_POSIX_FADVISE */
+
+   sfd->cache.window = window ? window : XIOCACHE_WINDOW;
+   sfd->cache.rcount = 0;
+   sfd->cache.rdone  = -1;
+   sfd->cache.wcount = 0;
+   sfd->cache.wsub   = -1;
+   sfd->cache.wdone  = -1;
+   if (rw != XIO_WRONLY) {
+      sfd->cache.rdrop = drop;
+   }
+   if (rw != XIO_RDONLY) {
+#if HAVE_SYNC_FILE_RANGE
+      /* dirty pages cannot be dropped, so drop-cache needs writeback */
+      sfd->cache.wsync = (window != 0 || drop);
+      sfd->cache.wdrop = drop;
+#else
+      if (drop) {
+	 Warn("option drop-cache: sync_file_range() not available, not dropping written data");
+      }
+#endif
+   }
+   if (sfd->cache.wsync) {
+      Info3("fd %d: writing back%s page cache every "F_Zu" bytes", sfd->fd,
+	    sfd->cache.wdrop ? " and dropping" : "", sfd->cache.window);
+   } else if (sfd->cache.rdrop) {
+      Info2("fd %d: dropping page cache every "F_Zu" bytes",
+	    sfd->fd, sfd->cache.window);
+   }
+   return 0;
+}
+
+#if HAVE_POSIX_FADVISE
+/* Returns the file offset up to which sfd has passed data to the transfer
+   engine, or -1 when unknown. Read methods that do not use the file offset
+   keep their own position */
+static off_t xiocache_rpos(struct single *sfd) {
+   off_t pos;
+
+   switch (sfd->dtype & XIODATA_READMASK) {
+#if HAVE_SYS_MMAN_H
+   case XIOREAD_MMAP:
+      return sfd->para.mmap.pos;
+#endif
+#if HAVE_AIO_READ
+   case XIOREAD_AIO:
+      if (sfd->para.aio.started && sfd->para.aio.headlen >= 0) {
+	 return sfd->para.aio.cbs[sfd->para.aio.head].aio_offset +
+	    sfd->para.aio.headpos;
+      }
+      return sfd->para.aio.next + sfd->para.aio.skip;
+#endif
+   default:
+      if ((pos = Lseek(sfd->fd, 0, SEEK_CUR)) < 0) {
+	 Info2("lseek(%d, 0, SEEK_CUR): %s", sfd->fd, strerror(errno));
+      }
+      return pos;
+   }
+}
+
+/* Drops the data that has been read since the previous step from the page
+   cache */
+static void xiocache_rdrop(struct single *sfd) {
+   off_t pos, start;
+   int rc;
+
+   if ((pos = xiocache_rpos(sfd)) < 0) {
+      return;
+   }
+   if ((start = sfd->cache.rdone) < 0) {
+      start = pos - sfd->cache.rcount;
+      if (start < 0)  start = 0;
+   }
+   if (pos > start &&
+       (rc = Posix_fadvise(sfd->fd, start, pos-start, POSIX_FADV_DONTNEED))
+       != 0) {
+      Info4("posix_fadvise(%d, "F_off", "F_off", POSIX_FADV_DONTNEED): %s",
+	    sfd->fd, start, pos-start, strerror(rc));
+   }
+   sfd->cache.rdone  = pos;
+   sfd->cache.rcount = 0;
+}
+#endif /* HAVE_POSIX_FADVISE */
+
+#if HAVE_SYNC_FILE_RANGE
+/* Starts writeback of the data written since the previous step, and waits
+   for the writeback started by the previous step, so at most two steps of
+   dirty data are pending. With last, waits for all data only when it is to
+   be dropped. */
+static void xiocache_writeback(struct single *sfd, bool last) {
+   off_t pos, end;
+
+   if ((pos = Lseek(sfd->fd, 0, SEEK_CUR)) < 0) {
+      Warn2("lseek(%d, 0, SEEK_CUR): %s, stopping incremental writeback",
+	    sfd->fd, strerror(errno));
+      sfd->cache.wsync = false;
+      return;
+   }
+   if (sfd->cache.wsub < 0) {
+      sfd->cache.wsub = pos - sfd->cache.wcount;
+      if (sfd->cache.wsub < 0)  sfd->cache.wsub = 0;
+      sfd->cache.wdone = sfd->cache.wsub;
+   }
+   if (pos > sfd->cache.wsub &&
+       Sync_file_range(sfd->fd, sfd->cache.wsub, pos - sfd->cache.wsub,
+		       SYNC_FILE_RANGE_WRITE) < 0) {
+      Warn4("sync_file_range(%d, "F_off", "F_off", SYNC_FILE_RANGE_WRITE): %s, stopping incremental writeback",
+	    sfd->fd, sfd->cache.wsub, pos - sfd->cache.wsub, strerror(errno));
+      sfd->cache.wsync = false;
+      return;
+   }
+   end = last ? pos : sfd->cache.wsub;
+   if (end > sfd->cache.wdone && (!last || sfd->cache.wdrop)) {
+      if (Sync_file_range(sfd->fd, sfd->cache.wdone, end - sfd->cache.wdone,
+			  SYNC_FILE_RANGE_WAIT_BEFORE|SYNC_FILE_RANGE_WRITE|
+			  SYNC_FILE_RANGE_WAIT_AFTER) < 0) {
+	 Warn4("sync_file_range(%d, "F_off", "F_off", ...): %s",
+	       sfd->fd, sfd->cache.wdone, end - sfd->cache.wdone,
+	       strerror(errno));
+      }
+#if HAVE_POSIX_FADVISE
+      else if (sfd->cache.wdrop) {
+	 int rc;
+	 if ((rc = Posix_fadvise(sfd->fd, sfd->cache.wdone,
+				 end - sfd->cache.wdone, POSIX_FADV_DONTNEED))
+	     != 0) {
+	    Info4("posix_fadvise(%d, "F_off", "F_off", POSIX_FADV_DONTNEED): %s",
+		  sfd->fd, sfd->cache.wdone, end - sfd->cache.wdone,
+		  strerror(rc));
+	 }
+      }
+#endif /* HAVE_POSIX_FADVISE */
+      sfd->cache.wdone = end;
+   }
+   sfd->cache.wsub   = pos;
+   sfd->cache.wcount = 0;
+}
+#endif /* HAVE_SYNC_FILE_RANGE */
+
+/* Accounts bytes that have been passed from sfd; called by the read
+   functions when option drop-cache is active */
+void xiocache_read(struct single *sfd, size_t bytes) {
+#if HAVE_POSIX_FADVISE
+   sfd->cache.rcount += bytes;
+   if (sfd->cache.rcount >= sfd->cache.window) {
+      xiocache_rdrop(sfd);
+   }
+#endif
+}
+
+/* Accounts bytes that have been written to sfd; called by the write
+   functions when incremental writeback is active */
+void xiocache_write(struct single *sfd, size_t bytes) {
+#if HAVE_SYNC_FILE_RANGE
+   sfd->cache.wcount += bytes;
+   if (sfd->cache.wcount >= sfd->cache.window) {
+      xiocache_writeback(sfd, false);
+   }
+#endif
+}
+
+/* Handles the last partial step; must be called before the read method
+   releases its resources */
+int xiocache_close(struct single *sfd) {
+#if HAVE_POSIX_FADVISE
+   if (sfd->cache.rdrop && sfd->cache.rcount > 0) {
+      xiocache_rdrop(sfd);
+   }
+#endif
+#if HAVE_SYNC_FILE_RANGE
+   if (sfd->cache.wsync && (sfd->cache.wcount > 0 || sfd->cache.wsub >= 0)) {
+      xiocache_writeback(sfd, true);
+   }
+#endif
+   return 0;
+}
+
+#endif /* HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE */
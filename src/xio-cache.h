@@ -0,0 +1,25 @@
+/* source: xio-cache.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_cache_h_included
+#define __xio_cache_h_included 1
+
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+
+#if HAVE_POSIX_FADVISE
+extern const struct optdesc opt_fadvise;
+extern const struct optdesc opt_drop_cache;
+#endif
+#if HAVE_SYNC_FILE_RANGE
+extern const struct optdesc opt_sync_range;
+#endif
+
+extern int _xioopen_cache(struct single *sfd, int rw, struct opt *opts);
+extern void xiocache_read(struct single *sfd, size_t bytes);
+extern void xiocache_write(struct single *sfd, size_t bytes);
+extern int xiocache_close(struct single *sfd);
+
+#endif /* HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE */
+
+#endif /* !defined(__xio_cache_h_included) */
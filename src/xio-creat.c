@@ -11,6 +11,7 @@
 #include "xioopen.h"
 #include "xio-named.h"
 #include "xio-creat.h"
+#include "xio-cache.h"
 
 
 static int xioopen_creat(int arg, const char *argv[], struct opt *opts, int rw, xiofile_t *fd, const struct addrdesc *addrdesc);
@@ -73,6 +74,11 @@ static int xioopen_creat(
       return result;
    sfd->fd = result;
 
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+   if ((result = _xioopen_cache(sfd, rw, opts)) < 0)
+      return result;
+#endif
+
    applyopts_named(filename, opts, PH_PASTOPEN);
    if ((result = applyopts2(sfd, -1, opts, PH_PASTOPEN, PH_LATE2)) < 0)
       return result;
@@ -32,6 +32,24 @@ static int xioopen_exec(
    bool dash = false;
    int duptostderr;
    int numleft;
+   const char *ends[] = { " ", NULL };
+   const char *hquotes[] = { "'", NULL };
+   const char *squotes[] = { "\"", NULL };
+   const char *nests[] = {
+      "'", "'",
+      "(", ")",
+      "[", "]",
+      "{", "}",
+      NULL
+   } ;
+   char **pargv = NULL;
+   int pargc;
+   size_t len;
+   const char *strp;
+   char *token; /*! */
+   char *tokp;
+   char *tmp;
+   struct xiospawn spawn;
 
    if (argc != 2) {
       xio_syntax(argv[0], 1, argc-1, addrdesc->syntax);
@@ -40,73 +58,61 @@ static int xioopen_exec(
 
    retropt_bool(opts, OPT_DASH, &dash);
 
-   status =
-      _xioopen_foxec(xioflags, sfd, addrdesc->groups, &opts, &duptostderr);
-   if (status < 0)
-      return status;
-   if (status == 0) {	/* child */
-      const char *ends[] = { " ", NULL };
-      const char *hquotes[] = { "'", NULL };
-      const char *squotes[] = { "\"", NULL };
-      const char *nests[] = {
-	 "'", "'",
-	 "(", ")",
-	 "[", "]",
-	 "{", "}",
-	 NULL
-      } ;
-      char **pargv = NULL;
-      int pargc;
-      size_t len;
-      const char *strp;
-      char *token; /*! */
-      char *tokp;
-      char *path = NULL;
-      char *tmp;
-
-      /*! Close(something) */
-      /* parse command line */
-      Debug1("child: args = \"%s\"", argv[1]);
-      pargv = Malloc(8*sizeof(char *));
-      if (pargv == NULL)  return STAT_RETRYLATER;
-      len = strlen(argv[1])+1;
-      strp = argv[1];
-      token = Malloc(len); /*! */
-      tokp = token;
+   /* parse command line; before forking, so it can also be spawned */
+   Debug1("args = \"%s\"", argv[1]);
+   pargv = Malloc(8*sizeof(char *));
+   if (pargv == NULL)  return STAT_RETRYLATER;
+   len = strlen(argv[1])+1;
+   strp = argv[1];
+   token = Malloc(len); /*! */
+   if (token == NULL)  return STAT_RETRYLATER;
+   tokp = token;
+   if (nestlex(&strp, &tokp, &len, ends, hquotes, squotes, nests,
+	       true, true, false) < 0) {
+      Error("internal: miscalculated string lengths");
+   }
+   *tokp++ = '\0';
+   pargv[0] = strrchr(tokp-1, '/');
+   if (pargv[0] == NULL)  pargv[0] = token;  else  ++pargv[0];
+   pargc = 1;
+   while (*strp == ' ') {
+      while (*++strp == ' ')  ;
+      if ((pargc & 0x07) == 0) {
+	 pargv = Realloc(pargv, (pargc+8)*sizeof(char *));
+	 if (pargv == NULL)  return STAT_RETRYLATER;
+      }
+      pargv[pargc++] = tokp;
       if (nestlex(&strp, &tokp, &len, ends, hquotes, squotes, nests,
 		  true, true, false) < 0) {
 	 Error("internal: miscalculated string lengths");
       }
       *tokp++ = '\0';
-      pargv[0] = strrchr(tokp-1, '/');
-      if (pargv[0] == NULL)  pargv[0] = token;  else  ++pargv[0];
-      pargc = 1;
-      while (*strp == ' ') {
-	 while (*++strp == ' ')  ;
-	 if ((pargc & 0x07) == 0) {
-	    pargv = Realloc(pargv, (pargc+8)*sizeof(char *));
-	    if (pargv == NULL)  return STAT_RETRYLATER;
-	 }
-	 pargv[pargc++] = tokp;
-	 if (nestlex(&strp, &tokp, &len, ends, hquotes, squotes, nests,
-		     true, true, false) < 0) {
-	    Error("internal: miscalculated string lengths");
-	 }
-	 *tokp++ = '\0';
-      }
-      pargv[pargc] = NULL;
+   }
+   pargv[pargc] = NULL;
 
-      if ((tmp = Malloc(strlen(pargv[0])+2)) == NULL) {
-	 return STAT_RETRYLATER;
-      }
-      if (dash) {
-	 tmp[0] = '-';
-	 strcpy(tmp+1, pargv[0]);
-      } else {
-	 strcpy(tmp, pargv[0]);
-      }
-      pargv[0] = tmp;
+   if ((tmp = Malloc(strlen(pargv[0])+2)) == NULL) {
+      return STAT_RETRYLATER;
+   }
+   if (dash) {
+      tmp[0] = '-';
+      strcpy(tmp+1, pargv[0]);
+   } else {
+      strcpy(tmp, pargv[0]);
+   }
+   pargv[0] = tmp;
 
+   spawn.file   = token;
+   spawn.argv   = pargv;
+   spawn.search = true;
+   status =
+      _xioopen_foxec(xioflags, sfd, addrdesc->groups, &opts, &duptostderr,
+		     &spawn);
+   if (status < 0)
+      return status;
+   if (status == 0) {	/* child */
+      char *path = NULL;
+
+      /*! Close(something) */
       if (setopt_path(opts, &path) < 0) {
 	 /* this could be dangerous, so let us abort this child... */
 	 Exit(1);
@@ -144,6 +150,9 @@ static int xioopen_exec(
    }
 
    /* parent */
+   free(pargv[0]);
+   free(pargv);
+   free(token);
    _xio_openlate(sfd, opts);
    return 0;
 }
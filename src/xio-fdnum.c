@@ -10,6 +10,7 @@
 #include "xio-listen.h"
 
 #include "xio-fdnum.h"
+#include "xio-cache.h"
 
 
 #if WITH_FDNUM
@@ -129,6 +130,11 @@ int xioopen_fd(struct opt *opts, int rw, struct single *sfd, int numfd) {
 
    applyopts2(sfd, -1, opts, PH_INIT, PH_FD);
 
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+   if (_xioopen_cache(sfd, rw, opts) < 0)
+      return -1;
+#endif
+
    return _xio_openlate(sfd, opts);
 }
 
@@ -0,0 +1,217 @@
+/* source: xio-follow.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for following a growing file like
+   "tail -F" (option follow). Instead of polling at EOF in intervals, the
+   transfer loop waits on an inotify instance that reports modifications,
+   truncation, and rotation of the file */
+
+#include "xiosysincludes.h"
+#include "xioopen.h"
+
+#include "xio-follow.h"
+
+
+#if HAVE_SYS_INOTIFY_H
+
+const struct optdesc opt_follow = { "follow", NULL, OPT_FOLLOW, GROUP_REG, PH_LATE, TYPE_BOOL, OFUNC_SPEC };
+
+#define XIOFOLLOW_FILEMASK	(IN_MODIFY|IN_ATTRIB|IN_MOVE_SELF|IN_DELETE_SELF)
+#define XIOFOLLOW_DIRMASK	(IN_CREATE|IN_MOVED_TO)
+
+
+/* Retrieves option follow. When set and the address reads a regular file,
+   creates an inotify instance that watches the file and its directory, and
+   sets ignoreeof.
+   Returns 0 on success (even when the file cannot be followed), or -1 */
+int _xioopen_follow(struct single *sfd, const char *filename, int rw,
+		    struct opt *opts) {
+   bool dofollow = false;
+   struct stat buf;
+   char *dir, *slash;
+
+   retropt_bool(opts, OPT_FOLLOW, &dofollow);
+   if (!dofollow) {
+      return 0;
+   }
+   if (rw == XIO_WRONLY) {
+      Warn("option follow has no effect on write-only addresses");
+      return 0;
+   }
+   if ((sfd->dtype & XIODATA_READMASK) != XIOREAD_STREAM) {
+      Warn("option follow: address does not read with read(), ignoring");
+      return 0;
+   }
+   if (Fstat(sfd->fd, &buf) < 0) {
+      Error2("fstat(%d, ...): %s", sfd->fd, strerror(errno));
+      return -1;
+   }
+   if (!S_ISREG(buf.st_mode)) {
+      Warn1("option follow: fd %d is not a regular file, ignoring", sfd->fd);
+      return 0;
+   }
+
+   if ((sfd->follow.path = strdup(filename)) == NULL) {
+      Error1("strdup("F_Zu"): out of memory", strlen(filename));
+      return -1;
+   }
+   if ((sfd->follow.fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC)) < 0) {
+      Error1("inotify_init1(IN_NONBLOCK|IN_CLOEXEC): %s", strerror(errno));
+      free(sfd->follow.path);  sfd->follow.path = NULL;
+      return -1;
+   }
+   if ((sfd->follow.filewd =
+	inotify_add_watch(sfd->follow.fd, filename, XIOFOLLOW_FILEMASK)) < 0) {
+      Error2("inotify_add_watch(\"%s\", ...): %s", filename, strerror(errno));
+      xioclose_follow(sfd);
+      return -1;
+   }
+   /* the directory tells when a rotated file is replaced */
+   if ((dir = strdup(filename)) == NULL) {
+      Error1("strdup("F_Zu"): out of memory", strlen(filename));
+      xioclose_follow(sfd);
+      return -1;
+   }
+   if ((slash = strrchr(dir, '/')) == NULL) {
+      strcpy(dir, ".");
+   } else if (slash == dir) {
+      dir[1] = '\0';
+   } else {
+      *slash = '\0';
+   }
+   if ((sfd->follow.dirwd =
+	inotify_add_watch(sfd->follow.fd, dir, XIOFOLLOW_DIRMASK)) < 0) {
+      Warn2("inotify_add_watch(\"%s\", ...): %s, not following rotation",
+	    dir, strerror(errno));
+   }
+   free(dir);
+
+   sfd->follow.rotated = false;
+   sfd->follow.active  = true;
+   sfd->ignoreeof = true;
+   Info2("fd %d: following file \"%s\" with inotify", sfd->fd, filename);
+   return 0;
+}
+
+/* Returns the inotify fd to wait on when sfd is at EOF, or -1 when sfd does
+   not follow its file */
+int xiofollow_fd(struct single *sfd) {
+   if (!sfd->follow.active) {
+      return -1;
+   }
+   return sfd->follow.fd;
+}
+
+/* Replaces the fd of a rotated file with the new file of the same name.
+   Returns 1 when reopened, 0 when the new file does not exist yet, or -1 */
+static int xiofollow_reopen(struct single *sfd) {
+   int flags, newfd;
+
+   if ((flags = Fcntl(sfd->fd, F_GETFL)) < 0) {
+      Error2("fcntl(%d, F_GETFL): %s", sfd->fd, strerror(errno));
+      return -1;
+   }
+   flags &= ~(O_CREAT|O_EXCL|O_TRUNC);
+   if ((newfd = Open(sfd->follow.path, flags, 0)) < 0) {
+      if (errno == ENOENT) {
+	 return 0;
+      }
+      Error3("open(\"%s\", 0%o, ...): %s",
+	     sfd->follow.path, flags, strerror(errno));
+      return -1;
+   }
+   /* keep the fd number, the transfer loop knows it */
+   if (Dup2(newfd, sfd->fd) < 0) {
+      Error3("dup2(%d, %d): %s", newfd, sfd->fd, strerror(errno));
+      Close(newfd);
+      return -1;
+   }
+   Close(newfd);
+   if (sfd->follow.filewd >= 0) {
+      inotify_rm_watch(sfd->follow.fd, sfd->follow.filewd);
+   }
+   if ((sfd->follow.filewd =
+	inotify_add_watch(sfd->follow.fd, sfd->follow.path,
+			  XIOFOLLOW_FILEMASK)) < 0) {
+      Warn2("inotify_add_watch(\"%s\", ...): %s",
+	    sfd->follow.path, strerror(errno));
+   }
+   sfd->follow.rotated = false;
+   Notice2("fd %d: reopened rotated file \"%s\"", sfd->fd, sfd->follow.path);
+   return 1;
+}
+
+/* Processes the events of the inotify instance of sfd: after truncation the
+   file is read from its beginning again; after rotation the rest of the old
+   file is read, then the new file is opened.
+   Returns 0 when the caller should try to read, or -1 on error */
+int xiofollow_event(struct single *sfd) {
+   union {
+      struct inotify_event ev;
+      char space[4096];
+   } buff;
+   ssize_t bytes;
+   char *p;
+   const struct inotify_event *ev;
+   struct stat buf;
+   off_t pos;
+
+   while ((bytes = Read(sfd->follow.fd, &buff, sizeof(buff))) > 0) {
+      for (p = buff.space; p < buff.space + bytes;
+	   p += sizeof(struct inotify_event) + ev->len) {
+	 ev = (const struct inotify_event *)p;
+	 Debug3("inotify event: wd=%d mask=0x%x name=\"%s\"",
+		ev->wd, ev->mask, ev->len ? ev->name : "");
+	 if (ev->wd == sfd->follow.filewd) {
+	    if (ev->mask & (IN_MOVE_SELF|IN_DELETE_SELF)) {
+	       Info2("fd %d: file \"%s\" has been moved or removed",
+		     sfd->fd, sfd->follow.path);
+	       sfd->follow.rotated = true;
+	    }
+	    if (ev->mask & IN_IGNORED) {
+	       sfd->follow.filewd = -1;
+	    }
+	 }
+      }
+   }
+   if (bytes < 0 && errno != EAGAIN && errno != EINTR) {
+      Error2("read(%d, ...): %s", sfd->follow.fd, strerror(errno));
+      return -1;
+   }
+
+   if (Fstat(sfd->fd, &buf) < 0 ||
+       (pos = Lseek(sfd->fd, 0, SEEK_CUR)) < 0) {
+      Error2("fstat()/lseek() on fd %d: %s", sfd->fd, strerror(errno));
+      return -1;
+   }
+   if (buf.st_size < pos) {
+      Notice2("fd %d: file \"%s\" has been truncated, reading from start",
+	      sfd->fd, sfd->follow.path);
+      if (Lseek(sfd->fd, 0, SEEK_SET) < 0) {
+	 Error2("lseek(%d, 0, SEEK_SET): %s", sfd->fd, strerror(errno));
+	 return -1;
+      }
+   } else if (sfd->follow.rotated && buf.st_size == pos) {
+      /* all data of the old file have been passed */
+      if (xiofollow_reopen(sfd) < 0) {
+	 return -1;
+      }
+   }
+   return 0;
+}
+
+int xioclose_follow(struct single *sfd) {
+   if (sfd->follow.path == NULL) {
+      return 0;
+   }
+   if (sfd->follow.fd >= 0) {
+      Close(sfd->follow.fd);
+   }
+   free(sfd->follow.path);
+   sfd->follow.path = NULL;
+   sfd->follow.active = false;
+   return 0;
+}
+
+#endif /* HAVE_SYS_INOTIFY_H */
@@ -0,0 +1,19 @@
+/* source: xio-follow.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_follow_h_included
+#define __xio_follow_h_included 1
+
+#if HAVE_SYS_INOTIFY_H
+
+extern const struct optdesc opt_follow;
+
+extern int _xioopen_follow(struct single *sfd, const char *filename, int rw, struct opt *opts);
+extern int xiofollow_fd(struct single *sfd);
+extern int xiofollow_event(struct single *sfd);
+extern int xioclose_follow(struct single *sfd);
+
+#endif /* HAVE_SYS_INOTIFY_H */
+
+#endif /* !defined(__xio_follow_h_included) */
@@ -8,6 +8,10 @@
 #include "xioopen.h"
 
 #include "xio-named.h"
+#include "xio-mmap.h"
+#include "xio-aio.h"
+#include "xio-cache.h"
+#include "xio-follow.h"
 #include "xio-unix.h"
 #include "xio-gopen.h"
 
@@ -126,6 +130,23 @@ static int xioopen_gopen(
    if ((result = applyopts2(sfd, -1, opts, PH_PASTSOCKET, PH_CONNECTED)) < 0)
       return result;
 
+#if HAVE_SYS_MMAN_H
+   if ((result = _xioopen_mmap(sfd, xioflags&XIO_ACCMODE, opts)) < 0)
+      return result;
+#endif
+#if HAVE_AIO_READ
+   if ((result = _xioopen_aio(sfd, xioflags&XIO_ACCMODE, opts)) < 0)
+      return result;
+#endif
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+   if ((result = _xioopen_cache(sfd, xioflags&XIO_ACCMODE, opts)) < 0)
+      return result;
+#endif
+#if HAVE_SYS_INOTIFY_H
+   if ((result = _xioopen_follow(sfd, filename, xioflags&XIO_ACCMODE, opts)) < 0)
+      return result;
+#endif
+
    if ((result = _xio_openlate(sfd, opts)) < 0)
       return result;
    return 0;
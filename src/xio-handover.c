@@ -0,0 +1,371 @@
+/* source: xio-handover.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for the handover option: a listening socket
+   is passed from a running socat process to a newly started one over a UNIX
+   domain socket (SCM_RIGHTS), so the listener can be restarted without
+   closing the socket */
+
+#include "xiosysincludes.h"
+#include "xioopen.h"
+
+#include "xio-handover.h"
+
+
+#if WITH_LISTEN
+
+const struct optdesc opt_handover = { "handover", NULL, OPT_HANDOVER, GROUP_LISTEN, PH_PASTACCEPT, TYPE_FILENAME, OFUNC_SPEC };
+
+/* Only one listening socket of a socat process waits for connections at a
+   time, so a single handover socket is sufficient */
+static struct {
+   char *path;		/* name of the UNIX socket for handover requests */
+   int fd;		/* listening handover socket, or -1 */
+} xiohandover = { NULL, -1 };
+
+
+/* seconds the old process has to answer a handover request */
+#define XIOHANDOVER_TIMEOUT 5
+
+
+static void xiohandover_sockaddr(struct sockaddr_un *sa) {
+   memset(sa, 0, sizeof(*sa));
+   sa->sun_family = AF_UNIX;
+   strncpy(sa->sun_path, xiohandover.path, sizeof(sa->sun_path)-1);
+}
+
+/* Consumes option handover.
+   Returns 1 when the option was given, 0 when not, -1 on error */
+int xiohandover_retropt(struct opt *opts) {
+   char *path = NULL;
+
+   if (retropt_string(opts, OPT_HANDOVER, &path) < 0)
+      return 0;
+   if (strlen(path) >= sizeof(((struct sockaddr_un *)0)->sun_path)) {
+      Error1("handover: socket name \"%s\" is too long", path);
+      free(path);
+      return -1;
+   }
+   free(xiohandover.path);
+   xiohandover.path = path;
+   return 1;
+}
+
+/* Checks if the received socket is bound to the requested address us; a
+   requested port 0 matches any port.
+   Returns true when it matches */
+static bool xiohandover_match(const union sockaddr_union *la, socklen_t lalen,
+			      const struct sockaddr *us, socklen_t uslen) {
+   const union sockaddr_union *ua = (const union sockaddr_union *)us;
+
+   if (la->soa.sa_family != us->sa_family)
+      return false;
+   switch (us->sa_family) {
+#if _WITH_IP4
+   case PF_INET:
+      return la->ip4.sin_addr.s_addr == ua->ip4.sin_addr.s_addr &&
+	 (ua->ip4.sin_port == 0 || la->ip4.sin_port == ua->ip4.sin_port);
+#endif
+#if WITH_IP6
+   case PF_INET6:
+      return !memcmp(&la->ip6.sin6_addr, &ua->ip6.sin6_addr,
+		     sizeof(ua->ip6.sin6_addr)) &&
+	 (ua->ip6.sin6_port == 0 || la->ip6.sin6_port == ua->ip6.sin6_port);
+#endif
+#if WITH_UNIX
+   case PF_UNIX:
+      if (ua->un.sun_path[0] == '\0') {
+	 /* abstract name, length counts */
+	 return lalen == uslen &&
+	    !memcmp(la->un.sun_path, ua->un.sun_path,
+		    uslen-offsetof(struct sockaddr_un, sun_path));
+      }
+      return !strncmp(la->un.sun_path, ua->un.sun_path,
+		      sizeof(ua->un.sun_path));
+#endif
+   }
+   return lalen == uslen && !memcmp(la, us, uslen);
+}
+
+/* Asks a running socat process listening on the handover socket for its
+   listening socket. pf and socktype describe the socket the current address
+   would create, us is the address it would bind to; a received socket of
+   different kind or on another address is not used.
+   The old process keeps accepting connections until the socket has been
+   checked and confirmed with one byte.
+   Returns the adopted file descriptor, or -1 when there is no socket to
+   take over; the caller then creates its own listening socket */
+int xiohandover_adopt(int pf, int socktype, const struct sockaddr *us,
+		      socklen_t uslen, int level) {
+   struct sockaddr_un sa;
+   union sockaddr_union la;
+   socklen_t lalen = sizeof(la);
+   struct pollfd pfd;
+   struct timeval timeout = { XIOHANDOVER_TIMEOUT, 0 };
+   union {
+      struct cmsghdr cm;
+      char buff[CMSG_SPACE(sizeof(int))];
+   } ctl;
+   struct cmsghdr *cmsg;
+   struct msghdr msgh;
+   struct iovec iov;
+   char c;
+   int type;
+   socklen_t optlen;
+   int cfd, lfd = -1;
+   ssize_t n;
+   char infobuff[256];
+
+   if (xiohandover.path == NULL)
+      return -1;
+
+   xiohandover_sockaddr(&sa);
+   if ((cfd = Socket(PF_UNIX, SOCK_STREAM, 0)) < 0) {
+      Msg1(level, "socket(PF_UNIX, SOCK_STREAM, 0): %s", strerror(errno));
+      return -1;
+   }
+   if (Connect(cfd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+      Info2("handover: \"%s\": %s, not taking over a listening socket",
+	    xiohandover.path, strerror(errno));
+      Close(cfd);
+      return -1;
+   }
+
+   iov.iov_base = &c;
+   iov.iov_len  = 1;
+   memset(&msgh, 0, sizeof(msgh));
+   msgh.msg_iov        = &iov;
+   msgh.msg_iovlen     = 1;
+   msgh.msg_control    = ctl.buff;
+   msgh.msg_controllen = sizeof(ctl.buff);
+   /* a hanging old process must not keep the new one from starting */
+   pfd.fd = cfd;
+   pfd.events = POLLIN;
+   do {
+      n = xiopoll(&pfd, 1, &timeout);
+   } while (n < 0 && errno == EINTR);
+   if (n > 0) {
+      do {
+	 n = Recvmsg(cfd, &msgh, MSG_DONTWAIT);
+      } while (n < 0 && errno == EINTR);
+      if (n < 0) {
+	 Warn2("handover: recvmsg(\"%s\"): %s",
+	       xiohandover.path, strerror(errno));
+      }
+   } else if (n == 0) {
+      Warn2("handover: no answer from \"%s\" within %d seconds",
+	    xiohandover.path, XIOHANDOVER_TIMEOUT);
+   } else {
+      Warn2("handover: poll(\"%s\"): %s", xiohandover.path, strerror(errno));
+   }
+   if (n > 0) {
+      for (cmsg = CMSG_FIRSTHDR(&msgh); cmsg != NULL;
+	   cmsg = CMSG_NXTHDR(&msgh, cmsg)) {
+	 if (cmsg->cmsg_level == SOL_SOCKET &&
+	     cmsg->cmsg_type  == SCM_RIGHTS &&
+	     cmsg->cmsg_len   >= CMSG_LEN(sizeof(int))) {
+	    memcpy(&lfd, CMSG_DATA(cmsg), sizeof(int));
+	    break;
+	 }
+      }
+   }
+   if (lfd < 0) {
+      Warn1("handover: no listening socket received from \"%s\"",
+	    xiohandover.path);
+      Close(cfd);
+      return -1;
+   }
+
+   optlen = sizeof(type);
+   if (Getsockopt(lfd, SOL_SOCKET, SO_TYPE, &type, &optlen) < 0 ||
+       Getsockname(lfd, &la.soa, &lalen) < 0) {
+      Warn2("handover: received socket %d: %s", lfd, strerror(errno));
+      Close(lfd);
+      Close(cfd);
+      return -1;
+   }
+   if (type != socktype || la.soa.sa_family != pf) {
+      Warn4("handover: received socket is of family %d type %d, expected %d %d",
+	    la.soa.sa_family, type, pf, socktype);
+      Close(lfd);
+      Close(cfd);
+      return -1;
+   }
+   if (!xiohandover_match(&la, lalen, us, uslen)) {
+      char usbuff[256];
+      Warn2("handover: received socket is bound to %s, expected %s",
+	    sockaddr_info(&la.soa, lalen, infobuff, sizeof(infobuff)),
+	    sockaddr_info(us, uslen, usbuff, sizeof(usbuff)));
+      Close(lfd);
+      Close(cfd);
+      return -1;
+   }
+   /* now the old process stops accepting */
+   c = 'A';
+   if (Send(cfd, &c, 1, 0
+#ifdef MSG_NOSIGNAL
+	    |MSG_NOSIGNAL
+#endif
+	    ) < 0) {
+      Warn2("handover: send(\"%s\"): %s", xiohandover.path, strerror(errno));
+      Close(lfd);
+      Close(cfd);
+      return -1;
+   }
+   Close(cfd);
+   Notice2("handover: took over listening socket %s from \"%s\"",
+	   sockaddr_info(&la.soa, lalen, infobuff, sizeof(infobuff)),
+	   xiohandover.path);
+   return lfd;
+}
+
+/* Creates the handover socket on which a later socat process may request
+   the listening socket. A stale socket entry is removed first; when a socket
+   has just been taken over, the old process is still holding a socket on the
+   now unlinked name and answers no further requests.
+   Returns 0 on success or when option handover was not given, -1 on error */
+int xiohandover_listen(int level) {
+   struct sockaddr_un sa;
+   int fd;
+
+   if (xiohandover.path == NULL || xiohandover.fd >= 0)
+      return 0;
+
+   xiohandover_sockaddr(&sa);
+   if ((fd = Socket(PF_UNIX, SOCK_STREAM, 0)) < 0) {
+      Msg1(level, "socket(PF_UNIX, SOCK_STREAM, 0): %s", strerror(errno));
+      return -1;
+   }
+   if (Unlink(xiohandover.path) < 0 && errno != ENOENT) {
+      Warn2("unlink(\"%s\"): %s", xiohandover.path, strerror(errno));
+   }
+   if (Bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+      Msg2(level, "handover: bind(\"%s\"): %s",
+	   xiohandover.path, strerror(errno));
+      Close(fd);
+      return -1;
+   }
+   if (Listen(fd, 1) < 0) {
+      Msg2(level, "handover: listen(\"%s\"): %s",
+	   xiohandover.path, strerror(errno));
+      Close(fd);
+      return -1;
+   }
+   if (Fcntl_l(fd, F_SETFD, FD_CLOEXEC) < 0) {
+      Warn2("fcntl(%d, F_SETFD, FD_CLOEXEC): %s", fd, strerror(errno));
+   }
+   xiohandover.fd = fd;
+   Info2("handover: accepting requests on \"%s\" (fd %d)",
+	 xiohandover.path, fd);
+   return 0;
+}
+
+/* Returns the handover socket to wait on, or -1 */
+int xiohandover_fd(void) {
+   return xiohandover.fd;
+}
+
+/* Accepts a request on the handover socket and passes listenfd to the
+   requesting process, then waits until the process confirms that it uses
+   the socket.
+   Returns 0 when the socket has been handed over, then the caller must stop
+   accepting connections on it; -1 when not */
+int xiohandover_send(int listenfd) {
+   union {
+      struct cmsghdr cm;
+      char buff[CMSG_SPACE(sizeof(int))];
+   } ctl;
+   struct cmsghdr *cmsg;
+   struct msghdr msgh;
+   struct iovec iov;
+   char c = 'H';
+   union sockaddr_union pa;
+   socklen_t palen = sizeof(pa);
+   struct pollfd pfd;
+   struct timeval timeout = { XIOHANDOVER_TIMEOUT, 0 };
+   ssize_t n;
+   int cfd;
+#if defined(SO_PEERCRED) && defined(__linux__)
+   struct ucred cred;
+   socklen_t optlen = sizeof(cred);
+#endif
+
+   if ((cfd = Accept(xiohandover.fd, &pa.soa, &palen)) < 0) {
+      if (errno != EINTR && errno != ECONNABORTED) {
+	 Warn2("handover: accept(%d): %s", xiohandover.fd, strerror(errno));
+      }
+      return -1;
+   }
+
+#if defined(SO_PEERCRED) && defined(__linux__)
+   /* the socket name may be reachable by other users; only pass the listener
+      to a process of the same user (or root) */
+   if (Getsockopt(cfd, SOL_SOCKET, SO_PEERCRED, &cred, &optlen) < 0) {
+      Warn2("handover: getsockopt(%d, SO_PEERCRED): %s", cfd, strerror(errno));
+      Close(cfd);
+      return -1;
+   }
+   if (cred.uid != 0 && cred.uid != Geteuid()) {
+      Warn2("handover: refusing request from process "F_pid" of user "F_uid,
+	    cred.pid, cred.uid);
+      Close(cfd);
+      return -1;
+   }
+#endif
+
+   iov.iov_base = &c;
+   iov.iov_len  = 1;
+   memset(&msgh, 0, sizeof(msgh));
+   memset(&ctl, 0, sizeof(ctl));
+   msgh.msg_iov        = &iov;
+   msgh.msg_iovlen     = 1;
+   msgh.msg_control    = ctl.buff;
+   msgh.msg_controllen = sizeof(ctl.buff);
+   cmsg = CMSG_FIRSTHDR(&msgh);
+   cmsg->cmsg_level = SOL_SOCKET;
+   cmsg->cmsg_type  = SCM_RIGHTS;
+   cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+   memcpy(CMSG_DATA(cmsg), &listenfd, sizeof(int));
+   if (Sendmsg(cfd, &msgh, 0) < 0) {
+      Warn2("handover: sendmsg(%d): %s", cfd, strerror(errno));
+      Close(cfd);
+      return -1;
+   }
+
+   /* the new process closes the connection without confirmation when it
+      cannot use the socket; then this process keeps serving */
+   pfd.fd = cfd;
+   pfd.events = POLLIN;
+   do {
+      n = xiopoll(&pfd, 1, &timeout);
+   } while (n < 0 && errno == EINTR);
+   if (n > 0) {
+      do {
+	 n = Read(cfd, &c, 1);
+      } while (n < 0 && errno == EINTR);
+   }
+   Close(cfd);
+   if (n <= 0 || c != 'A') {
+      Warn1("handover: new process did not take over the listening socket via \"%s\", continuing",
+	    xiohandover.path);
+      return -1;
+   }
+   Notice1("handover: passed listening socket to new process via \"%s\"",
+	   xiohandover.path);
+   return 0;
+}
+
+/* Closes the handover socket (in child processes, and when this process
+   does no longer accept connections). The socket name is not removed, it
+   might already belong to a newer process */
+void xiohandover_close(void) {
+   if (xiohandover.fd < 0)
+      return;
+   if (Close(xiohandover.fd) < 0) {
+      Info2("close(%d): %s", xiohandover.fd, strerror(errno));
+   }
+   xiohandover.fd = -1;
+}
+
+#endif /* WITH_LISTEN */
@@ -0,0 +1,21 @@
+/* source: xio-handover.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_handover_h_included
+#define __xio_handover_h_included 1
+
+#if WITH_LISTEN
+
+extern const struct optdesc opt_handover;
+
+extern int xiohandover_retropt(struct opt *opts);
+extern int xiohandover_adopt(int pf, int socktype, const struct sockaddr *us, socklen_t uslen, int level);
+extern int xiohandover_listen(int level);
+extern int xiohandover_fd(void);
+extern int xiohandover_send(int listenfd);
+extern void xiohandover_close(void);
+
+#endif /* WITH_LISTEN */
+
+#endif /* !defined(__xio_handover_h_included) */
@@ -14,6 +14,7 @@
 #include "xio-socket.h"
 #include "xio-ip.h"
 #include "xio-ip6.h"
+#include "xioshm.h"
 #include "nestlex.h"
 
 
@@ -93,6 +94,9 @@ const struct optdesc opt_ai_v4mapped   = { "ai-v4mapped",   "v4mapped",   OPT_AI
 #ifdef AI_PASSIVE
 const struct optdesc opt_ai_passive    = { "ai-passive",    "passive",    OPT_AI_PASSIVE,    GROUP_SOCK_IP, PH_OFFSET, TYPE_BOOL, OFUNC_OFFSET_MASKS, XIO_OFFSETOF(para.socket.ip.ai_flags), XIO_SIZEOF(para.socket.ip.ai_flags), AI_PASSIVE    };
 #endif
+const struct optdesc opt_resolve_ttl          = { "resolve-ttl",          NULL, OPT_RESOLVE_TTL,          GROUP_SOCK_IP, PH_OFFSET, TYPE_TIMEVAL, OFUNC_OFFSET, XIO_OFFSETOF(para.socket.ip.resolve_ttl) };
+const struct optdesc opt_resolve_timeout      = { "resolve-timeout",      NULL, OPT_RESOLVE_TIMEOUT,      GROUP_SOCK_IP, PH_OFFSET, TYPE_TIMEVAL, OFUNC_OFFSET, XIO_OFFSETOF(para.socket.ip.resolve_timeout) };
+const struct optdesc opt_resolve_negative_ttl = { "resolve-negative-ttl", NULL, OPT_RESOLVE_NEGATIVE_TTL, GROUP_SOCK_IP, PH_OFFSET, TYPE_TIMEVAL, OFUNC_OFFSET, XIO_OFFSETOF(para.socket.ip.resolve_negative_ttl) };
 
 #if WITH_RESOLVE
 #if WITH_RES_DEPRECATED
@@ -765,11 +769,626 @@ void xiofreeaddrinfo(struct addrinfo **ai_sorted) {
    while (ai_sorted[ain] != NULL)
       ++ain;
    res = ai_sorted[ain+1];
-   _xiofreeaddrinfo(res);
+   if (res != NULL) 	/* NULL with records from resolver cache */
+      _xiofreeaddrinfo(res);
    free(ai_sorted);
 }
 
 
+/* Resolver cache (options resolve-ttl, resolve-negative-ttl).
+   The addresses of a name are kept for resolve-ttl; when they have expired
+   they are still used, while a helper process resolves the name again in the
+   background. So only the very first connection waits for the resolver, and
+   record changes are followed anyway. Failed lookups are remembered for
+   resolve-negative-ttl.
+   Before the first fork() the table is moved to anonymous shared memory; the
+   parent and all its children then use and refresh the same entries. */
+
+#define XIORESCACHE_ENTRIES	16
+#define XIORESCACHE_ADDRS	16	/* addresses kept per name */
+#define XIORESCACHE_REFRESHMAX	30	/* seconds until another process may
+					   retry a hanging refresh */
+
+struct xiorescache_addr {
+   int family;
+   int socktype;
+   int protocol;
+   socklen_t addrlen;
+   union {
+      struct sockaddr soa;
+#if WITH_IP4
+      struct sockaddr_in ip4;
+#endif
+#if WITH_IP6
+      struct sockaddr_in6 ip6;
+#endif
+   } addr;
+} ;
+
+struct xiorescache_entry {
+   bool used;
+   char node[256];
+   char service[64];
+   int family;
+   int socktype;
+   int protocol;
+   int ai_flags[2];
+   struct timespec expires;	/* CLOCK_MONOTONIC */
+   struct timespec refreshing;	/* start of background refresh, or 0 */
+   int rc;			/* result of last lookup: 0 or EAI_* */
+   int naddrs;
+   struct xiorescache_addr addrs[XIORESCACHE_ADDRS];
+} ;
+
+struct xiorescache_tab {
+   struct xiorescache_entry entry[XIORESCACHE_ENTRIES];
+} ;
+
+static struct xiorescache_tab xiorescache_local;
+static struct xiorescache_tab *xiorescache = &xiorescache_local;
+static struct xioshm xiorescache_shm =
+   XIOSHM_INIT("resolver cache", &xiorescache_local);
+static pid_t xiorescache_helper;	/* last refresh process of this process */
+
+
+/* Builds an array of addresses like xiogetaddrinfo() does from naddrs plain
+   address records; it is freed with xiofreeaddrinfo() */
+static int xioaddrs_addrinfo(const struct xiorescache_addr *addrs, int naddrs,
+			     struct addrinfo ***ai_sorted) {
+   struct addrinfo **arr, *ai;
+   struct xiorescache_addr *ca;
+   int i;
+
+   arr = Malloc((naddrs+2)*sizeof(struct addrinfo *) +
+		naddrs*(sizeof(struct addrinfo)+sizeof(struct xiorescache_addr)));
+   if (arr == NULL)
+      return EAI_MEMORY;
+   ai = (struct addrinfo *)&arr[naddrs+2];
+   ca = (struct xiorescache_addr *)&ai[naddrs];
+   memcpy(ca, addrs, naddrs*sizeof(struct xiorescache_addr));
+   for (i = 0; i < naddrs; ++i) {
+      memset(&ai[i], 0, sizeof(ai[i]));
+      ai[i].ai_family   = ca[i].family;
+      ai[i].ai_socktype = ca[i].socktype;
+      ai[i].ai_protocol = ca[i].protocol;
+      ai[i].ai_addrlen  = ca[i].addrlen;
+      ai[i].ai_addr     = &ca[i].addr.soa;
+      ai[i].ai_next     = (i+1 < naddrs) ? &ai[i+1] : NULL;
+      arr[i] = &ai[i];
+   }
+   arr[i] = NULL;
+   arr[i+1] = NULL;
+   *ai_sorted = arr;
+   return 0;
+}
+
+/* Copies up to max addresses from a sorted array to plain records; returns
+   their number */
+static int xioaddrs_copy(struct addrinfo **ai_sorted,
+			 struct xiorescache_addr *addrs, int max) {
+   int i;
+
+   for (i = 0; i < max && ai_sorted[i] != NULL; ++i) {
+      if (ai_sorted[i]->ai_addrlen > sizeof(addrs[i].addr))
+	 break;
+      addrs[i].family   = ai_sorted[i]->ai_family;
+      addrs[i].socktype = ai_sorted[i]->ai_socktype;
+      addrs[i].protocol = ai_sorted[i]->ai_protocol;
+      addrs[i].addrlen  = ai_sorted[i]->ai_addrlen;
+      memcpy(&addrs[i].addr, ai_sorted[i]->ai_addr, ai_sorted[i]->ai_addrlen);
+   }
+   return i;
+}
+
+/* Helper processes are reaped by the SIGCHLD handler when it is installed
+   (fork mode), otherwise by the function that started them */
+static bool xioip_sigchld_handled(void) {
+#if HAVE_SIGACTION
+   struct sigaction act;
+
+   if (Sigaction(SIGCHLD, NULL, &act) < 0)
+      return false;
+   return act.sa_handler == childdied;
+#else
+   return false;
+#endif
+}
+
+
+static void xiorescache_deadline(struct timespec *end,
+				 const struct timespec *now,
+				 const struct timeval *ttl) {
+   end->tv_sec  = now->tv_sec  + ttl->tv_sec;
+   end->tv_nsec = now->tv_nsec + 1000*ttl->tv_usec;
+   if (end->tv_nsec >= 1000000000) {
+      ++end->tv_sec;  end->tv_nsec -= 1000000000;
+   }
+}
+
+static bool xiorescache_expired(const struct timespec *end,
+				const struct timespec *now) {
+   return now->tv_sec > end->tv_sec ||
+      (now->tv_sec == end->tv_sec && now->tv_nsec >= end->tv_nsec);
+}
+
+/* Returns the entry of the name, or NULL. With create, a missing entry is set
+   up, if necessary by replacing the one that expired first.
+   Call with lock held */
+static struct xiorescache_entry *xiorescache_find(
+	const char *node, const char *service,
+	int family, int socktype, int protocol,
+	const int ai_flags[2], bool create) {
+   struct xiorescache_entry *e, *victim = NULL;
+   int i;
+
+   for (i = 0; i < XIORESCACHE_ENTRIES; ++i) {
+      e = &xiorescache->entry[i];
+      if (!e->used) {
+	 if (victim == NULL || victim->used)
+	    victim = e;
+	 continue;
+      }
+      if (e->family == family && e->socktype == socktype &&
+	  e->protocol == protocol &&
+	  e->ai_flags[0] == ai_flags[0] && e->ai_flags[1] == ai_flags[1] &&
+	  !strcmp(e->node, node) && !strcmp(e->service, service))
+	 return e;
+      if (victim == NULL ||
+	  (victim->used && xiorescache_expired(&e->expires, &victim->expires)))
+	 victim = e;
+   }
+   if (!create)
+      return NULL;
+   e = victim;
+   memset(e, 0, sizeof(*e));
+   e->used = true;
+   strcpy(e->node, node);
+   strcpy(e->service, service);
+   e->family   = family;
+   e->socktype = socktype;
+   e->protocol = protocol;
+   e->ai_flags[0] = ai_flags[0];
+   e->ai_flags[1] = ai_flags[1];
+   return e;
+}
+
+/* Stores the result of a lookup, and ends a refresh */
+static void xiorescache_store(const char *node, const char *service,
+			      int family, int socktype, int protocol,
+			      const struct para_ip *ip,
+			      int rc, struct addrinfo **ai_sorted) {
+   struct xiorescache_entry *e;
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   xioshm_lock(&xiorescache_shm);
+   e = xiorescache_find(node, service, family, socktype, protocol,
+			ip->ai_flags, true);
+   e->refreshing.tv_sec = 0;  e->refreshing.tv_nsec = 0;
+   if (rc != 0) {
+      if (e->rc == 0 && e->naddrs > 0) {
+	 /* keep the old addresses, try again later */
+	 xiorescache_deadline(&e->expires, &now,
+			      (ip->resolve_negative_ttl.tv_sec != 0 ||
+			       ip->resolve_negative_ttl.tv_usec != 0) ?
+			      &ip->resolve_negative_ttl : &ip->resolve_ttl);
+      } else {
+	 e->rc = rc;
+	 e->naddrs = 0;
+	 xiorescache_deadline(&e->expires, &now, &ip->resolve_negative_ttl);
+      }
+      xioshm_unlock(&xiorescache_shm);
+      return;
+   }
+   e->rc = 0;
+   e->naddrs = xioaddrs_copy(ai_sorted, e->addrs, XIORESCACHE_ADDRS);
+   xiorescache_deadline(&e->expires, &now, &ip->resolve_ttl);
+   xioshm_unlock(&xiorescache_shm);
+}
+
+static int xiorescache_addrinfo(const struct xiorescache_entry *e,
+				struct addrinfo ***ai_sorted) {
+   return xioaddrs_addrinfo(e->addrs, e->naddrs, ai_sorted);
+}
+
+/* Starts a helper process that resolves the name again and updates the shared
+   cache entry, unless another process is already doing this */
+static void xiorescache_refresh(const char *node, const char *service,
+				int family, int socktype, int protocol,
+				const struct para_ip *ip,
+				const struct timespec *now) {
+   struct xiorescache_entry *e;
+   struct addrinfo **ai_sorted = NULL;
+   pid_t pid;
+   int status;
+   int rc;
+
+   xioshm_lock(&xiorescache_shm);
+   e = xiorescache_find(node, service, family, socktype, protocol,
+			ip->ai_flags, false);
+   if (e == NULL ||
+       (e->refreshing.tv_sec != 0 &&
+	now->tv_sec < e->refreshing.tv_sec + XIORESCACHE_REFRESHMAX)) {
+      xioshm_unlock(&xiorescache_shm);
+      return;
+   }
+   e->refreshing = *now;
+   xioshm_unlock(&xiorescache_shm);
+
+   if (xiorescache_helper > 0) {
+      /* without SIGCHLD handler nobody else reaps it */
+      Waitpid(xiorescache_helper, &status, WNOHANG);
+      xiorescache_helper = 0;
+   }
+   xioip_rescache_share();
+   if (xiorescache == &xiorescache_local ||
+       (pid = Fork()) < 0) {
+      /* no shared memory or no process: refresh synchronously */
+      if (xiorescache != &xiorescache_local)
+	 Warn1("fork(): %s", strerror(errno));
+      rc = xiogetaddrinfo(node, service, family, socktype, protocol,
+			  &ai_sorted, ip->ai_flags);
+      xiorescache_store(node, service, family, socktype, protocol, ip,
+			rc, ai_sorted);
+      if (rc == 0)
+	 xiofreeaddrinfo(ai_sorted);
+      return;
+   }
+   if (pid == 0) {
+      /* helper process: must not run the exit handlers, they would shut
+	 down connections of the parent */
+      diag_fork();
+      Signal(SIGHUP,  SIG_DFL);
+      Signal(SIGINT,  SIG_DFL);
+      Signal(SIGQUIT, SIG_DFL);
+      Signal(SIGTERM, SIG_DFL);
+      rc = xiogetaddrinfo(node, service, family, socktype, protocol,
+			  &ai_sorted, ip->ai_flags);
+      if (rc != 0) {
+	 Warn3("resolver cache: refreshing \"%s:%s\": %s", node, service,
+	       (rc == EAI_SYSTEM)?strerror(errno):gai_strerror(rc));
+      }
+      xiorescache_store(node, service, family, socktype, protocol, ip,
+			rc, ai_sorted);
+      Info2("resolver cache: refreshed \"%s:%s\"", node, service);
+      diag_flush();
+      _exit(0);
+   }
+   if (xioip_sigchld_handled()) {
+      ++num_child; 	/* like xio_fork(), handler decrements it */
+   }
+   xiorescache_helper = pid;
+   Info3("resolver cache: process "F_pid" refreshes \"%s:%s\"",
+	 pid, node, service);
+}
+
+/* Moves the resolver cache to shared memory so that processes forked from now
+   on share it with this one. Called before fork() */
+void xioip_rescache_share(void) {
+   if (xioshm_share(&xiorescache_shm, true) == 0)
+      xiorescache = xiorescache_shm.addr;
+}
+
+/* Asynchronous name resolution (option resolve-timeout): getaddrinfo() runs
+   in a helper process that passes the sorted addresses through a pipe; the
+   caller waits for them at most until the deadline and then abandons the
+   helper. xiogetaddrinfo_prefetch() starts the helper early, so that name
+   resolution overlaps with other setup work like loading TLS certificates. */
+
+#define XIOGAI_MAXADDRS	64
+
+struct xiogai_request {
+   pid_t pid;			/* helper process, or 0 */
+   int fd;			/* read end of result pipe */
+   char *node;
+   char *service;
+   int family;
+   int socktype;
+   int protocol;
+   int ai_flags[2];
+   struct timespec deadline;	/* CLOCK_MONOTONIC */
+} ;
+
+/* what the helper process writes to the pipe */
+struct xiogai_result {
+   int rc;
+   int _errno;
+   int naddrs;
+   struct xiorescache_addr addrs[XIOGAI_MAXADDRS];
+} ;
+
+/* the prefetch of this process that has not yet been collected */
+static struct xiogai_request xiogai_pending = { 0, -1 };
+
+static void xiogai_release(struct xiogai_request *req, bool kill) {
+   int status;
+
+   if (kill) {
+      Kill(req->pid, SIGKILL);
+   }
+   Close(req->fd);
+   if (!xioip_sigchld_handled()) {
+      Waitpid(req->pid, &status, 0);
+   }
+   free(req->node);
+   free(req->service);
+   req->pid = 0;
+   req->fd = -1;
+}
+
+static bool xiogai_matches(const struct xiogai_request *req,
+			   const char *node, const char *service,
+			   int family, int socktype, int protocol,
+			   const int ai_flags[2]) {
+   return req->pid != 0 &&
+      req->family == family && req->socktype == socktype &&
+      req->protocol == protocol &&
+      req->ai_flags[0] == ai_flags[0] && req->ai_flags[1] == ai_flags[1] &&
+      !strcmp(req->node, node) && !strcmp(req->service, service);
+}
+
+/* Forks the helper process. Returns 0 on success, or -1 when the caller
+   has to resolve synchronously */
+static int xiogai_start(struct xiogai_request *req,
+			const char *node, const char *service,
+			int family, int socktype, int protocol,
+			const struct para_ip *ip) {
+   struct timespec now;
+   int pipefd[2];
+   pid_t pid;
+
+   if (Pipe(pipefd) < 0) {
+      Warn1("pipe(): %s", strerror(errno));
+      return -1;
+   }
+   if ((pid = Fork()) < 0) {
+      Warn1("fork(): %s", strerror(errno));
+      Close(pipefd[0]);  Close(pipefd[1]);
+      return -1;
+   }
+   if (pid == 0) {
+      /* helper process; it must not run the exit handlers */
+      struct xiogai_result res;
+      struct addrinfo **ai_sorted = NULL;
+
+      diag_fork();
+      Signal(SIGHUP,  SIG_DFL);
+      Signal(SIGINT,  SIG_DFL);
+      Signal(SIGQUIT, SIG_DFL);
+      Signal(SIGTERM, SIG_DFL);
+      Close(pipefd[0]);
+      memset(&res, 0, sizeof(res));
+      res.rc = xiogetaddrinfo(node, service, family, socktype, protocol,
+			      &ai_sorted, ip->ai_flags);
+      res._errno = errno;
+      if (res.rc == 0) {
+	 res.naddrs = xioaddrs_copy(ai_sorted, res.addrs, XIOGAI_MAXADDRS);
+	 xiofreeaddrinfo(ai_sorted);
+      }
+      writefull(pipefd[1], &res, (char *)&res.addrs[res.naddrs]-(char *)&res);
+      diag_flush();
+      _exit(0);
+   }
+   Close(pipefd[1]);
+   if (xioip_sigchld_handled()) {
+      ++num_child; 	/* like xio_fork(), handler decrements it */
+   }
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   req->pid = pid;
+   req->fd = pipefd[0];
+   req->node = strdup(node);
+   req->service = strdup(service);
+   req->family   = family;
+   req->socktype = socktype;
+   req->protocol = protocol;
+   req->ai_flags[0] = ip->ai_flags[0];
+   req->ai_flags[1] = ip->ai_flags[1];
+   xiorescache_deadline(&req->deadline, &now, &ip->resolve_timeout);
+   Info3("resolving \"%s:%s\" in process "F_pid, node, service, pid);
+   return 0;
+}
+
+/* Waits for the result of the helper process until the deadline.
+   Returns like xiogetaddrinfo(); EAI_AGAIN on timeout */
+static int xiogai_finish(struct xiogai_request *req,
+			 struct addrinfo ***ai_sorted) {
+   struct xiogai_result res;
+   size_t got = 0;
+   struct timespec now;
+   struct timeval tmo;
+   struct pollfd pfd;
+   ssize_t n;
+   int rc;
+
+   while (true) {
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      if (xiorescache_expired(&req->deadline, &now)) {
+	 Warn2("name resolution of \"%s:%s\" timed out",
+	       req->node, req->service);
+	 xiogai_release(req, true);
+	 return EAI_AGAIN;
+      }
+      tmo.tv_sec  = req->deadline.tv_sec - now.tv_sec;
+      tmo.tv_usec = (req->deadline.tv_nsec - now.tv_nsec) / 1000;
+      if (tmo.tv_usec < 0) {
+	 --tmo.tv_sec;  tmo.tv_usec += 1000000;
+      }
+      pfd.fd = req->fd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      if (xiopoll(&pfd, 1, &tmo) < 0) {
+	 if (errno == EINTR)
+	    continue;
+	 Warn2("xiopoll({%d,POLLIN},...): %s", req->fd, strerror(errno));
+	 break;
+      }
+      if (pfd.revents == 0)
+	 continue;
+      n = Read(req->fd, (char *)&res+got, sizeof(res)-got);
+      if (n < 0) {
+	 if (errno == EINTR)
+	    continue;
+	 Warn2("read(%d, ...): %s", req->fd, strerror(errno));
+	 break;
+      }
+      if (n == 0)
+	 break;
+      got += n;
+   }
+   xiogai_release(req, false);
+
+   if (got < (size_t)((char *)&res.addrs[0]-(char *)&res) ||
+       res.naddrs < 0 || res.naddrs > XIOGAI_MAXADDRS ||
+       got < (size_t)((char *)&res.addrs[res.naddrs]-(char *)&res)) {
+      Warn("name resolution: incomplete result from helper process");
+      return EAI_FAIL;
+   }
+   if (res.rc != 0) {
+      errno = res._errno;
+      return res.rc;
+   }
+   rc = xioaddrs_addrinfo(res.addrs, res.naddrs, ai_sorted);
+   return rc;
+}
+
+/* Starts resolving the name in the background when option resolve-timeout
+   was given; a following xiogetaddrinfo_cached() with the same parameters
+   collects the result */
+void xiogetaddrinfo_prefetch(const char *node, const char *service,
+			     int family, int socktype, int protocol,
+			     const struct para_ip *ip) {
+   struct xiorescache_entry *e;
+   struct timespec now;
+   bool cached = false;
+
+   if ((ip->resolve_timeout.tv_sec == 0 && ip->resolve_timeout.tv_usec == 0) ||
+       node == NULL || service == NULL)
+      return;
+   if (ip->resolve_ttl.tv_sec != 0 || ip->resolve_ttl.tv_usec != 0) {
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      xioshm_lock(&xiorescache_shm);
+      e = xiorescache_find(node, service, family, socktype, protocol,
+			   ip->ai_flags, false);
+      cached = (e != NULL && !xiorescache_expired(&e->expires, &now));
+      xioshm_unlock(&xiorescache_shm);
+   }
+   if (cached)
+      return;
+   if (xiogai_pending.pid != 0)
+      xiogai_release(&xiogai_pending, true);
+   xiogai_start(&xiogai_pending, node, service, family, socktype, protocol,
+		ip);
+}
+
+/* xiogetaddrinfo() with the deadline of option resolve-timeout, collecting a
+   matching prefetch */
+static int xiogetaddrinfo_timed(const char *node, const char *service,
+				int family, int socktype, int protocol,
+				struct addrinfo ***ai_sorted,
+				const struct para_ip *ip) {
+   struct xiogai_request req;
+
+   if (xiogai_pending.pid != 0) {
+      if (node != NULL && service != NULL &&
+	  xiogai_matches(&xiogai_pending, node, service,
+			 family, socktype, protocol, ip->ai_flags)) {
+	 return xiogai_finish(&xiogai_pending, ai_sorted);
+      }
+      xiogai_release(&xiogai_pending, true);
+   }
+   if ((ip->resolve_timeout.tv_sec == 0 && ip->resolve_timeout.tv_usec == 0) ||
+       node == NULL || service == NULL ||
+       xiogai_start(&req, node, service, family, socktype, protocol, ip) < 0) {
+      return xiogetaddrinfo(node, service, family, socktype, protocol,
+			    ai_sorted, ip->ai_flags);
+   }
+   return xiogai_finish(&req, ai_sorted);
+}
+
+/* Like xiogetaddrinfo(), but uses the resolver cache when option resolve-ttl
+   was given */
+int xiogetaddrinfo_cached(const char *node, const char *service,
+			  int family, int socktype, int protocol,
+			  struct addrinfo ***ai_sorted,
+			  const struct para_ip *ip) {
+   struct xiorescache_entry *e, copy;
+   struct timespec now;
+   int rc;
+
+   if ((ip->resolve_ttl.tv_sec == 0 && ip->resolve_ttl.tv_usec == 0) ||
+       node == NULL || service == NULL ||
+       strlen(node) >= sizeof(copy.node) ||
+       strlen(service) >= sizeof(copy.service)) {
+      return xiogetaddrinfo_timed(node, service, family, socktype, protocol,
+				  ai_sorted, ip);
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   xioshm_lock(&xiorescache_shm);
+   e = xiorescache_find(node, service, family, socktype, protocol,
+			ip->ai_flags, false);
+   if (e != NULL)
+      copy = *e;
+   xioshm_unlock(&xiorescache_shm);
+
+   if (e != NULL &&
+       (!xiorescache_expired(&copy.expires, &now) || copy.rc == 0) &&
+       xiogai_pending.pid != 0) {
+      /* not needed */
+      xiogai_release(&xiogai_pending, true);
+   }
+   if (e != NULL) {
+      if (!xiorescache_expired(&copy.expires, &now)) {
+	 if (copy.rc != 0) {
+	    Info3("resolver cache: \"%s:%s\": %s (cached)", node, service,
+		  gai_strerror(copy.rc));
+	    return copy.rc;
+	 }
+	 Info2("resolver cache: using addresses of \"%s:%s\"",
+	       node, service);
+	 return xiorescache_addrinfo(&copy, ai_sorted);
+      }
+      if (copy.rc == 0 && copy.naddrs > 0) {
+	 Info2("resolver cache: addresses of \"%s:%s\" expired, using them during refresh",
+	       node, service);
+	 xiorescache_refresh(node, service, family, socktype, protocol, ip,
+			     &now);
+	 return xiorescache_addrinfo(&copy, ai_sorted);
+      }
+   }
+
+   /* unknown, or failure expired: resolve now */
+   rc = xiogetaddrinfo_timed(node, service, family, socktype, protocol,
+			     ai_sorted, ip);
+   if (rc == 0 ||
+       ((ip->resolve_negative_ttl.tv_sec != 0 ||
+	 ip->resolve_negative_ttl.tv_usec != 0) &&
+	rc != EAI_SYSTEM && rc != EAI_MEMORY)) {
+      xiorescache_store(node, service, family, socktype, protocol, ip,
+			rc, rc==0?*ai_sorted:NULL);
+   }
+   return rc;
+}
+
+/* In a loop of connection attempts, replaces *ai_sorted with the current
+   addresses from the resolver cache. Does nothing without option
+   resolve-ttl or when the name cannot be resolved now */
+void xiogetaddrinfo_renew(const char *node, const char *service,
+			  int family, int socktype, int protocol,
+			  struct addrinfo ***ai_sorted,
+			  const struct para_ip *ip) {
+   struct addrinfo **renewed;
+
+   if (ip->resolve_ttl.tv_sec == 0 && ip->resolve_ttl.tv_usec == 0)
+      return;
+   if (xiogetaddrinfo_cached(node, service, family, socktype, protocol,
+			     &renewed, ip) != 0)
+      return;
+   xiofreeaddrinfo(*ai_sorted);
+   *ai_sorted = renewed;
+}
+
+
 /* A simple resolver interface that just returns one address,
    the first found by calling xiogetaddrinfo(), but ev.respects preferred_ip;
    pf may be AF_INET, AF_INET6, or AF_UNSPEC;
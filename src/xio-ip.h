@@ -33,6 +33,9 @@ extern const struct optdesc opt_ai_addrconfig;
 extern const struct optdesc opt_ai_all;
 extern const struct optdesc opt_ai_passive;
 extern const struct optdesc opt_ai_v4mapped;
+extern const struct optdesc opt_resolve_ttl;
+extern const struct optdesc opt_resolve_negative_ttl;
+extern const struct optdesc opt_resolve_timeout;
 
 extern const struct optdesc opt_res_debug;
 extern const struct optdesc opt_res_aaonly;
@@ -51,6 +54,10 @@ extern int xioinit_ip(int *pf, char ipv);
 
 extern int xiogetaddrinfo(const char *node, const char *service, int family, int socktype, int protocol, struct addrinfo ***ai_sorted, const int ai_flags[2]);
 extern void xiofreeaddrinfo(struct addrinfo **ai_sorted);
+extern int xiogetaddrinfo_cached(const char *node, const char *service, int family, int socktype, int protocol, struct addrinfo ***ai_sorted, const struct para_ip *ip);
+extern void xiogetaddrinfo_renew(const char *node, const char *service, int family, int socktype, int protocol, struct addrinfo ***ai_sorted, const struct para_ip *ip);
+extern void xioip_rescache_share(void);
+extern void xiogetaddrinfo_prefetch(const char *node, const char *service, int family, int socktype, int protocol, const struct para_ip *ip);
 extern int _xio_sort_ip_addresses(struct addrinfo *themlist, struct addrinfo **ai_sorted);
 extern int xioresolve(const char *node, const char *service, int family, int socktype, int protocol, union sockaddr_union *addr, socklen_t *addrlen, const int ai_flags[2]);
 extern int xiolog_ancillary_ip(struct single *sfd, struct cmsghdr *cmsg, int *num, char *typbuff, int typlen, char *nambuff, int namlen, char *envbuff, int envlen, char *valbuff, int vallen);
@@ -14,10 +14,16 @@
 #include "xio-listen.h"
 #include "xio-ip6.h"
 #include "xio-ipapp.h"
+#include "xio-pool.h"
+#include "xio-balance.h"
 
 const struct optdesc opt_sourceport = { "sourceport", "sp",       OPT_SOURCEPORT,  GROUP_IPAPP,     PH_LATE,TYPE_2BYTE,	OFUNC_SPEC };
 /*const struct optdesc opt_port = { "port",  NULL,    OPT_PORT,        GROUP_IPAPP, PH_BIND,    TYPE_USHORT,	OFUNC_SPEC };*/
 const struct optdesc opt_lowport = { "lowport", NULL, OPT_LOWPORT, GROUP_IPAPP, PH_LATE, TYPE_BOOL, OFUNC_SPEC };
+#if WITH_TCP
+const struct optdesc opt_happy_eyeballs = { "happy-eyeballs", NULL, OPT_HAPPY_EYEBALLS, GROUP_IP_TCP, PH_INIT, TYPE_BOOL, OFUNC_OFFSET, XIO_OFFSETOF(para.socket.ip.happy_eyeballs) };
+const struct optdesc opt_happy_eyeballs_delay = { "happy-eyeballs-delay", NULL, OPT_HAPPY_EYEBALLS_DELAY, GROUP_IP_TCP, PH_INIT, TYPE_TIMEVAL, OFUNC_OFFSET, XIO_OFFSETOF(para.socket.ip.happy_eyeballs_delay) };
+#endif /* WITH_TCP */
 
 #if WITH_IP4
 /* we expect the form "host:port" */
@@ -45,6 +51,7 @@ int xioopen_ipapp_connect(
    bool lowport = false;
    int level;
    int i;
+   int balanced = 0;
    int result;
 
    if (argc != 3) {
@@ -52,6 +59,11 @@ int xioopen_ipapp_connect(
       return STAT_NORETRY;
    }
 
+#if WITH_TCP
+   if ((balanced = xiobalance_init(opts, hostname, portname)) < 0)
+      return STAT_NORETRY;
+#endif
+
    if (sfd->howtoend == END_UNSPEC)
       sfd->howtoend = END_SHUTDOWN;
 
@@ -75,10 +87,29 @@ int xioopen_ipapp_connect(
        return STAT_NORETRY;
    }
 
-   if (_xioopen_ipapp_prepare(opts, &opts0, hostname, portname, &pf, ipproto,
-			      sfd->para.socket.ip.ai_flags,
+#if WITH_TCP
+   /* a backend that does not resolve counts as failed, the next one is
+      tried; so the address is not resolved by _xioopen_ipapp_prepare() */
+   if (balanced) {
+      retropt_socket_pf(opts, &pf);
+      themarr = NULL;
+      if (xiobalance_select(&hostname, &portname, pf, socktype, ipproto,
+			    &themarr, &sfd->para.socket.ip) < 0) {
+	 Error("backends: no backend available");
+	 return STAT_RETRYLATER;
+      }
+      xiobalance_check_start(&sfd->para.socket.ip);
+   }
+#endif
+
+   if (_xioopen_ipapp_prepare(opts, &opts0,
+			      balanced ? NULL : hostname,
+			      balanced ? NULL : portname, &pf, ipproto,
+			      &sfd->para.socket.ip,
 			      &themarr, us, &uslen, &needbind, &lowport,
 			      socktype) != STAT_OK) {
+      if (balanced)
+	 xiofreeaddrinfo(themarr);
       return STAT_NORETRY;
    }
 
@@ -86,6 +117,26 @@ int xioopen_ipapp_connect(
       xiosetchilddied();	/* set SIGCHLD handler */
    }
 
+#if WITH_TCP
+   /* in a child of a forking listener, take an established connection from
+      the pool */
+   if (sfd->para.socket.ip.pool > 0 && socktype == SOCK_STREAM && !dofork &&
+       !balanced && xiopool_applies()) {
+      if ((sfd->fd = xiopool_get(hostname, portname)) >= 0) {
+	 xiofreeaddrinfo(themarr);
+	 /* the manager applied these when it connected the socket */
+	 dropopts2(opts, PH_INIT, PH_LATE-1);
+	 result = _xio_openlate(sfd, opts);
+	 free(opts0); free(opts);
+	 return result < 0 ? result : 0;
+      }
+      if (errno == ENOENT) {
+	 xiopool_start(sfd, hostname, portname, needbind?us:NULL, uslen,
+		       themarr, opts0, pf, socktype, ipproto, lowport);
+      }
+   }
+#endif /* WITH_TCP */
+
    if (xioparms.logopt == 'm') {
       Info("starting connect loop, switching to syslog");
       diag_set('y', xioparms.syslogfac);  xioparms.logopt = 'y';
@@ -109,15 +160,19 @@ int xioopen_ipapp_connect(
 	    level = E_INFO;
 	 } else if (themarr[i] != NULL) {
 	    level = E_WARN;
+#if WITH_TCP
+	 } else if (balanced && xiobalance_remaining() > 0) {
+	    level = E_WARN;
+#endif
          } else
 #endif /* WITH_RETRY */
 	    level = E_ERROR;
 
        result =
-	 _xioopen_connect(sfd,
+	 _xioopen_ipapp_connect(sfd,
 			  needbind?us:NULL, uslen,
-			  themp->ai_addr, themp->ai_addrlen,
-			  opts, pf?pf:themp->ai_family, socktype, ipproto,
+			  themarr, &i,
+			  opts, pf, socktype, ipproto,
 			  lowport, level);
        if (result == STAT_OK)
 	  break;
@@ -126,6 +181,17 @@ int xioopen_ipapp_connect(
 	  result = STAT_RETRYLATER;
        }
       }
+#if WITH_TCP
+      /* passive health check: try the next backend */
+      if (result != STAT_OK && balanced) {
+	 xiobalance_failed();
+	 if (xiobalance_select(&hostname, &portname, pf, socktype, ipproto,
+			       &themarr, &sfd->para.socket.ip) == 0) {
+	    dropopts(opts, PH_ALL); free(opts); opts = copyopts(opts0, GROUP_ALL);
+	    continue;
+	 }
+      }
+#endif
       switch (result) {
       case STAT_OK: break;
 #if WITH_RETRY
@@ -137,6 +203,15 @@ int xioopen_ipapp_connect(
 	       Nanosleep(&sfd->intervall, NULL);
 	    }
 	    dropopts(opts, PH_ALL); free(opts); opts = copyopts(opts0, GROUP_ALL);
+#if WITH_TCP
+	    if (balanced) {
+	       xiobalance_reset();
+	       xiobalance_select(&hostname, &portname, pf, socktype, ipproto,
+				 &themarr, &sfd->para.socket.ip);
+	    } else
+#endif
+	    xiogetaddrinfo_renew(hostname, portname, pf, socktype, ipproto,
+				 &themarr, &sfd->para.socket.ip);
 	    continue;
 	 }
 #endif /* WITH_RETRY */
@@ -177,6 +252,17 @@ int xioopen_ipapp_connect(
 	    Nanosleep(&sfd->intervall, NULL);
 	 }
 	 dropopts(opts, PH_ALL); free(opts); opts = copyopts(opts0, GROUP_ALL);
+#if WITH_TCP
+	 if (balanced) {
+	    /* next connection, next backend */
+	    xiobalance_reset();
+	    xiobalance_select(&hostname, &portname, pf, socktype, ipproto,
+			      &themarr, &sfd->para.socket.ip);
+	 } else
+#endif
+	 /* addresses might have been refreshed meanwhile */
+	 xiogetaddrinfo_renew(hostname, portname, pf, socktype, ipproto,
+			      &themarr, &sfd->para.socket.ip);
 	 continue;	/* with next socket() bind() connect() */
       } else
 #endif /* WITH_RETRY */
@@ -186,6 +272,10 @@ int xioopen_ipapp_connect(
    } while (true);
    /* only "active" process breaks (master without fork, or child) */
    xiofreeaddrinfo(themarr);
+#if WITH_TCP
+   if (balanced)
+      xiobalance_connected();
+#endif
 
    if ((result = _xio_openlate(sfd, opts)) < 0) {
 	   free(opts0);free(opts);
@@ -209,7 +299,7 @@ int
 	   const char *portname,
 	   int *pf,
 	   int protocol,
-	   const int ai_flags[2],
+	   const struct para_ip *ip,
 	   struct addrinfo ***themarr,
 	   union sockaddr_union *us,
 	   socklen_t *uslen,
@@ -222,8 +312,8 @@ int
    retropt_socket_pf(opts, pf);
 
    if (hostname != NULL || portname != NULL) {
-      rc = xiogetaddrinfo(hostname, portname, *pf, socktype, protocol,
-			  themarr, ai_flags);
+      rc = xiogetaddrinfo_cached(hostname, portname, *pf, socktype, protocol,
+				 themarr, ip);
       if (rc == EAI_AGAIN) {
 	 Warn4("_xioopen_ipapp_prepare(node=\"%s\", service=\"%s\", pf=%d, ...): %s",
 	       hostname?hostname:"NULL", portname?portname:"NULL",
@@ -242,7 +332,7 @@ int
    /* 3 means: IP address AND port accepted */
    if (retropt_bind(opts, (*pf!=PF_UNSPEC)?*pf:(**themarr)->ai_family,
 		    socktype, protocol, (struct sockaddr *)us, uslen, 3,
-		    ai_flags)
+		    ip->ai_flags)
        != STAT_NOACTION) {
       *needbind = true;
    } else {
@@ -279,6 +369,298 @@ int
 #endif /* WITH_IP4 */
 
 
+#if WITH_TCP
+/* one connection attempt of _xioopen_ipapp_race() */
+struct xioipapp_attempt {
+   int fd;
+   struct addrinfo *ai;
+} ;
+
+static void _xioipapp_tvadd(struct timeval *tv, const struct timeval *add) {
+   tv->tv_sec  += add->tv_sec;
+   tv->tv_usec += add->tv_usec;
+   if (tv->tv_usec >= 1000000) {
+      ++tv->tv_sec;  tv->tv_usec -= 1000000;
+   }
+}
+
+/* sets *diff to end-now, returns false when end is already reached */
+static bool _xioipapp_tvleft(const struct timeval *end, const struct timeval *now,
+			     struct timeval *diff) {
+   diff->tv_sec  = end->tv_sec  - now->tv_sec;
+   diff->tv_usec = end->tv_usec - now->tv_usec;
+   if (diff->tv_usec < 0) {
+      --diff->tv_sec;  diff->tv_usec += 1000000;
+   }
+   if (diff->tv_sec < 0 || (diff->tv_sec == 0 && diff->tv_usec == 0)) {
+      diff->tv_sec = 0;  diff->tv_usec = 0;
+      return false;
+   }
+   return true;
+}
+
+/* Connection racing as described in RFC 8305 ("Happy Eyeballs v2"):
+   starts non blocking connects to the addresses of themarr, alternating
+   address families starting with the preferred one, each attempt
+   happy-eyeballs-delay after the previous one or immediately when an attempt
+   failed. The first established connection wins, the others are closed.
+   Option connect-timeout limits the whole race.
+   Returns STAT_OK with the connected socket in sfd->fd, or STAT_RETRYLATER */
+static int _xioopen_ipapp_race(struct single *sfd,
+			       union sockaddr_union *us, socklen_t uslen,
+			       struct addrinfo **themarr,
+			       struct opt *opts, int pf, int socktype,
+			       int protocol, bool alt, int level) {
+   struct addrinfo **order, **rest;
+   struct xioipapp_attempt *att;
+   struct pollfd *pfds;
+   struct timeval delay = { 0, 250000 };	/* RFC 8305 recommendation */
+   struct timeval now, nextstart, deadline, tmo, left;
+   bool dodeadline = false;
+   int fcntl_flags = 0;
+   int family;
+   int n, k, j;
+   int started = 0, pending = 0;
+   int winner = -1;
+   struct addrinfo *winai = NULL;
+   union sockaddr_union la;
+   socklen_t lalen;
+   char infobuff[256];
+   char sockname[256];
+   int result = STAT_RETRYLATER;
+
+   if (sfd->para.socket.ip.happy_eyeballs_delay.tv_sec  != 0 ||
+       sfd->para.socket.ip.happy_eyeballs_delay.tv_usec != 0) {
+      delay = sfd->para.socket.ip.happy_eyeballs_delay;
+   }
+
+   for (n = 0; themarr[n] != NULL; ++n) ;
+   order = Calloc(2*n, sizeof(struct addrinfo *));
+   att   = Calloc(n, sizeof(struct xioipapp_attempt));
+   pfds  = Calloc(n, sizeof(struct pollfd));
+   if (order == NULL || att == NULL || pfds == NULL) {
+      free(order);  free(att);  free(pfds);
+      return STAT_RETRYLATER;
+   }
+
+   /* themarr is sorted by preferred IP version; interleave the families,
+      beginning with the first address */
+   rest = order + n;
+   memcpy(rest, themarr, n*sizeof(struct addrinfo *));
+   family = rest[0]->ai_family;
+   for (k = 0; k < n; ++k) {
+      for (j = 0; j < n; ++j) {
+	 if (rest[j] != NULL && rest[j]->ai_family == family)
+	    break;
+      }
+      if (j == n) {
+	 for (j = 0; rest[j] == NULL; ++j) ;
+      }
+      order[k] = rest[j];
+      rest[j] = NULL;
+      family = (order[k]->ai_family == PF_INET6 ? PF_INET : PF_INET6);
+   }
+
+   Gettimeofday(&now, NULL);
+   nextstart = now;
+   if (sfd->para.socket.connect_timeout.tv_sec  != 0 ||
+       sfd->para.socket.connect_timeout.tv_usec != 0) {
+      deadline = now;
+      _xioipapp_tvadd(&deadline, &sfd->para.socket.connect_timeout);
+      dodeadline = true;
+   }
+
+   while (true) {
+      /* start the next attempt when it is due, or when none is pending */
+      while (started < n &&
+	     (pending == 0 || !_xioipapp_tvleft(&nextstart, &now, &left))) {
+	 struct addrinfo *ai = order[started++];
+
+	 Info1("happy-eyeballs: connecting to %s",
+	       sockaddr_info(ai->ai_addr, ai->ai_addrlen,
+			     infobuff, sizeof(infobuff)));
+	 if (_xioopen_connect_socket(sfd, us, uslen, opts,
+				     pf?pf:ai->ai_family, socktype, protocol,
+				     alt, E_INFO)
+	     != STAT_OK) {
+	    if (sfd->fd >= 0)  Close(sfd->fd);
+	    continue;
+	 }
+	 fcntl_flags = Fcntl(sfd->fd, F_GETFL);
+	 Fcntl_l(sfd->fd, F_SETFL, fcntl_flags|O_NONBLOCK);
+	 if (Connect(sfd->fd, ai->ai_addr, ai->ai_addrlen) >= 0) {
+	    winner = sfd->fd;  winai = ai;
+	    break;
+	 }
+	 if (errno != EINPROGRESS) {
+	    Info4("connect(%d, %s, "F_Zd"): %s", sfd->fd,
+		  sockaddr_info(ai->ai_addr, ai->ai_addrlen,
+				infobuff, sizeof(infobuff)),
+		  (size_t)ai->ai_addrlen, strerror(errno));
+	    Close(sfd->fd);
+	    continue;
+	 }
+	 att[pending].fd = sfd->fd;
+	 att[pending].ai = ai;
+	 ++pending;
+	 nextstart = now;
+	 _xioipapp_tvadd(&nextstart, &delay);
+      }
+      if (winner >= 0 || pending == 0)
+	 break;
+
+      /* wait for an attempt to complete, for the next one to start, or for
+	 the end of connect-timeout */
+      for (k = 0; k < pending; ++k) {
+	 pfds[k].fd = att[k].fd;
+	 pfds[k].events = POLLOUT;
+	 pfds[k].revents = 0;
+      }
+      if (started < n) {
+	 _xioipapp_tvleft(&nextstart, &now, &tmo);
+	 if (dodeadline && _xioipapp_tvleft(&deadline, &now, &left) &&
+	     (left.tv_sec < tmo.tv_sec ||
+	      (left.tv_sec == tmo.tv_sec && left.tv_usec < tmo.tv_usec))) {
+	    tmo = left;
+	 }
+      } else if (dodeadline) {
+	 _xioipapp_tvleft(&deadline, &now, &tmo);
+      }
+      if (xiopoll(pfds, pending, (started < n || dodeadline) ? &tmo : NULL)
+	  < 0) {
+	 if (errno != EINTR) {
+	    Msg2(level, "xiopoll({%d,POLLOUT},...): %s",
+		 pfds[0].fd, strerror(errno));
+	    break;
+	 }
+      }
+      for (k = 0; k < pending; ) {
+	 int err = 0;
+	 socklen_t errlen = sizeof(err);
+
+	 if (pfds[k].revents == 0) {
+	    ++k;
+	    continue;
+	 }
+	 if (Getsockopt(att[k].fd, SOL_SOCKET, SO_ERROR, &err, &errlen) < 0) {
+	    err = errno;
+	 }
+	 if (err == 0) {
+	    winner = att[k].fd;  winai = att[k].ai;
+	    att[k] = att[--pending];  pfds[k] = pfds[pending];
+	    break;
+	 }
+	 Info4("connect(%d, %s, "F_Zd"): %s", att[k].fd,
+	       sockaddr_info(att[k].ai->ai_addr, att[k].ai->ai_addrlen,
+			     infobuff, sizeof(infobuff)),
+	       (size_t)att[k].ai->ai_addrlen, strerror(err));
+	 Close(att[k].fd);
+	 att[k] = att[--pending];  pfds[k] = pfds[pending];
+	 /* a failed attempt lets the next one start immediately */
+	 Gettimeofday(&nextstart, NULL);
+      }
+      if (winner >= 0)
+	 break;
+
+      Gettimeofday(&now, NULL);
+      if (dodeadline && !_xioipapp_tvleft(&deadline, &now, &left)) {
+	 Msg2(level, "connecting to %s: %s",
+	      sockaddr_info(order[0]->ai_addr, order[0]->ai_addrlen,
+			    infobuff, sizeof(infobuff)),
+	      strerror(ETIMEDOUT));
+	 break;
+      }
+   }
+
+   /* cancel the attempts that did not win */
+   for (k = 0; k < pending; ++k) {
+      Info1("happy-eyeballs: cancelling connection to %s",
+	    sockaddr_info(att[k].ai->ai_addr, att[k].ai->ai_addrlen,
+			  infobuff, sizeof(infobuff)));
+      Close(att[k].fd);
+   }
+
+   if (winner >= 0) {
+      sfd->fd = winner;
+      Fcntl_l(sfd->fd, F_SETFL, fcntl_flags);
+      la.soa.sa_family = winai->ai_family;  lalen = sizeof(la);
+      if (Getsockname(sfd->fd, &la.soa, &lalen) < 0) {
+	 Info4("getsockname(%d, %p, {%d}): %s",
+	       sfd->fd, &la.soa, lalen, strerror(errno));
+      }
+      Notice2("successfully connected to %s from local address %s",
+	      sockaddr_info(winai->ai_addr, winai->ai_addrlen,
+			    infobuff, sizeof(infobuff)),
+	      sockaddr_info(&la.soa, lalen, sockname, sizeof(sockname)));
+      _xioopen_connect_late(sfd, us, opts, pf?pf:winai->ai_family);
+      result = STAT_OK;
+   } else {
+      sfd->fd = -1;
+      if (started == n && pending == 0) {
+	 Msg1(level, "connecting to %s: all addresses failed",
+	      sockaddr_info(order[0]->ai_addr, order[0]->ai_addrlen,
+			    infobuff, sizeof(infobuff)));
+      }
+   }
+   free(order);  free(att);  free(pfds);
+   return result;
+}
+#endif /* WITH_TCP */
+
+#if WITH_TCP
+/* Returns the port of the local address us, or 0 when not fixed */
+static uint16_t _xioopen_ipapp_localport(const union sockaddr_union *us) {
+   switch (us->soa.sa_family) {
+#if WITH_IP4
+   case PF_INET:  return ntohs(us->ip4.sin_port);
+#endif
+#if WITH_IP6
+   case PF_INET6: return ntohs(us->ip6.sin6_port);
+#endif
+   }
+   return 0;
+}
+#endif /* WITH_TCP */
+
+/* Connects to the address themarr[*i-1] with _xioopen_connect(). With option
+   happy-eyeballs on stream sockets, instead races connections to this and
+   all following addresses and advances *i to the end of themarr; not with
+   a fixed source port (options bind, sourceport), which only one of the
+   sockets could use.
+   Returns STAT_OK on success */
+int _xioopen_ipapp_connect(struct single *sfd,
+			   union sockaddr_union *us, socklen_t uslen,
+			   struct addrinfo **themarr, int *i,
+			   struct opt *opts, int pf, int socktype,
+			   int protocol, bool alt, int level) {
+   struct addrinfo *themp = themarr[*i-1];
+#if WITH_TCP
+   int result;
+
+   if (sfd->para.socket.ip.happy_eyeballs && socktype == SOCK_STREAM &&
+       themarr[*i] != NULL && _xioopen_ipapp_localport(us) != 0) {
+      Info1("happy-eyeballs: source port %hu is fixed, connecting to the addresses one after the other",
+	    _xioopen_ipapp_localport(us));
+   } else if (sfd->para.socket.ip.happy_eyeballs && socktype == SOCK_STREAM &&
+	      themarr[*i] != NULL) {
+#if WITH_RETRY
+      if (sfd->forever || sfd->retry) {
+	 level = E_INFO;
+      } else
+#endif /* WITH_RETRY */
+	 level = E_ERROR;
+      result = _xioopen_ipapp_race(sfd, us, uslen, themarr+*i-1, opts,
+				   pf, socktype, protocol, alt, level);
+      while (themarr[*i] != NULL)  ++*i;
+      return result;
+   }
+#endif /* WITH_TCP */
+   return _xioopen_connect(sfd, us, uslen, themp->ai_addr, themp->ai_addrlen,
+			   opts, pf?pf:themp->ai_family, socktype, protocol,
+			   alt, level);
+}
+
+
 #if WITH_TCP && WITH_LISTEN
 /*
    applies and consumes the following options:
@@ -13,9 +13,12 @@
 extern const struct optdesc opt_sourceport;
 /*extern const struct optdesc opt_port;*/
 extern const struct optdesc opt_lowport;
+extern const struct optdesc opt_happy_eyeballs;
+extern const struct optdesc opt_happy_eyeballs_delay;
 
 extern int xioopen_ipapp_connect(int argc, const char *argv[], struct opt *opts, int xioflags, xiofile_t *fd, const struct addrdesc *addrdesc);
-extern int _xioopen_ipapp_prepare(struct opt *opts, struct opt **opts0, const char *hostname, const char *portname, int *pf, int protocol, const int ai_flags[2], struct addrinfo ***themlist, union sockaddr_union *us,  socklen_t *uslen, bool *needbind, bool *lowport, int socktype);
+extern int _xioopen_ipapp_prepare(struct opt *opts, struct opt **opts0, const char *hostname, const char *portname, int *pf, int protocol, const struct para_ip *ip, struct addrinfo ***themlist, union sockaddr_union *us,  socklen_t *uslen, bool *needbind, bool *lowport, int socktype);
+extern int _xioopen_ipapp_connect(struct single *sfd, union sockaddr_union *us, socklen_t uslen, struct addrinfo **themarr, int *i, struct opt *opts, int pf, int socktype, int protocol, bool alt, int level);
 extern int _xioopen_ip4app_connect(const char *hostname, const char *portname,
 				   struct single *xfd,
 				   int socktype, int ipproto, void *protname,
@@ -15,6 +15,8 @@
 #include "xio-ip4.h"
 #include "xio-listen.h"
 #include "xio-tcpwrap.h"
+#include "xio-range.h"
+#include "xio-handover.h"
 
 /***** LISTEN options *****/
 const struct optdesc opt_backlog = { "backlog",   NULL, OPT_BACKLOG,     GROUP_LISTEN, PH_LISTEN, TYPE_INT,    OFUNC_SPEC };
@@ -108,8 +110,28 @@ int _xioopen_listen(struct single *sfd, int xioflags, struct sockaddr *us, sockl
    int backlog = 5;	/* why? 1 seems to cause problems under some load */
    char infobuff[256];
 
+   if (xiohandover_retropt(opts) < 0)  return STAT_NORETRY;
    if (applyopts_single(sfd, opts, PH_INIT) < 0)  return -1;
 
+   if ((sfd->fd = xiohandover_adopt(pf?pf:us->sa_family, socktype,
+					 us, uslen, level)) >= 0) {
+      /* the socket has been created, bound, and configured by the process
+	 that handed it over */
+      applyopts_offset(sfd, opts);
+      applyopts_cloexec(sfd->fd, opts);
+      dropopts(opts, PH_PASTSOCKET);
+      dropopts2(opts, PH_PREBIND, PH_PASTBIND);
+      dropopts2(opts, PH_PRELISTEN, PH_LISTEN);
+#if WITH_UNIX
+      if (us->sa_family == AF_UNIX) {
+	 dropopts(opts, PH_FD);
+	 dropopts(opts, PH_EARLY);
+	 dropopts(opts, PH_PREOPEN);
+      }
+#endif /* WITH_UNIX */
+      return _xioopen_accept_fd(sfd, xioflags, us, uslen, opts, pf, proto,level);
+   }
+
    if ((sfd->fd = xiosocket(opts, pf?pf:us->sa_family, socktype, proto, level)) < 0) {
       return STAT_RETRYLATER;
    }
@@ -164,6 +186,32 @@ int _xioopen_listen(struct single *sfd, int xioflags, struct sockaddr *us, sockl
    return _xioopen_accept_fd(sfd, xioflags, us, uslen, opts, pf, proto,level);
 }
 
+/* After the listening socket has been handed over: waits until all child
+   processes have terminated, then exits */
+static void _xioopen_listen_drain(void) {
+   struct sigaction act;
+
+   Notice("Waiting for child processes to terminate");
+   memset(&act, 0, sizeof(struct sigaction));
+   act.sa_flags   = SA_NOCLDSTOP
+#ifdef SA_SIGINFO /* not on Linux 2.0(.33) */
+      |SA_SIGINFO
+#endif
+#ifdef SA_NOMASK
+      |SA_NOMASK
+#endif
+      ;
+#if HAVE_STRUCT_SIGACTION_SA_SIGACTION && defined(SA_SIGINFO)
+   act.sa_sigaction = 0;
+#else /* Linux 2.0(.33) does not have sigaction.sa_sigaction */
+   act.sa_handler = 0;
+#endif
+   sigemptyset(&act.sa_mask);
+   Sigaction(SIGCHLD, &act, NULL);
+   while (wait(NULL) >= 0 || errno == EINTR) ;
+   Exit(0);
+}
+
 int _xioopen_accept_fd(
 	struct single *sfd,
 	int xioflags,
@@ -229,6 +277,12 @@ int _xioopen_accept_fd(
    }
 #endif
 
+#if WITH_TCP || WITH_UDP
+   if (xio_retropt_rangefile(sfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
 #if (WITH_TCP || WITH_UDP) && WITH_LIBWRAP
    xio_retropt_tcpwrap(sfd, opts);
 #endif /* && (WITH_TCP || WITH_UDP) && WITH_LIBWRAP */
@@ -240,6 +294,11 @@ int _xioopen_accept_fd(
    retropt_bool(opts, OPT_LOWPORT, &sfd->para.socket.ip.lowport);
 #endif /* WITH_TCP || WITH_UDP */
 
+   if (xiohandover_listen(level) < 0) {
+      Close(sfd->fd);
+      return STAT_RETRYLATER;
+   }
+
    if (xioparms.logopt == 'm') {
       Info("starting accept loop, switching to syslog");
       diag_set('y', xioparms.syslogfac);  xioparms.logopt = 'y';
@@ -257,17 +316,25 @@ int _xioopen_accept_fd(
 	 /*? int level = E_ERROR;*/
 	 Notice1("listening on %s", sockaddr_info(us, uslen, lisname, sizeof(lisname)));
 	 if (sfd->para.socket.accept_timeout.tv_sec > 0 ||
-	     sfd->para.socket.accept_timeout.tv_usec > 0) {
+	     sfd->para.socket.accept_timeout.tv_usec > 0 ||
+	     xiohandover_fd() >= 0) {
 	    fd_set rfd;
-	    struct timeval tmo;
-	    FD_ZERO(&rfd);
-	    FD_SET(sfd->fd, &rfd);
-	    tmo.tv_sec = sfd->para.socket.accept_timeout.tv_sec;
-	    tmo.tv_usec = sfd->para.socket.accept_timeout.tv_usec;
+	    struct timeval tmo, *tmop = NULL;
+	    int hfd = xiohandover_fd();
+	    int nfds = (hfd > sfd->fd ? hfd : sfd->fd) + 1;
+	    if (sfd->para.socket.accept_timeout.tv_sec > 0 ||
+		sfd->para.socket.accept_timeout.tv_usec > 0) {
+	       tmo.tv_sec = sfd->para.socket.accept_timeout.tv_sec;
+	       tmo.tv_usec = sfd->para.socket.accept_timeout.tv_usec;
+	       tmop = &tmo;
+	    }
 	    while (1) {
-	       if (Select(sfd->fd+1, &rfd, NULL, NULL, &tmo) < 0) {
+	       FD_ZERO(&rfd);
+	       FD_SET(sfd->fd, &rfd);
+	       if (hfd >= 0)  FD_SET(hfd, &rfd);
+	       if (Select(nfds, &rfd, NULL, NULL, tmop) < 0) {
 		  if (errno != EINTR) {
-		     Error5("Select(%d, &0x%lx, NULL, NULL, {%ld.%06ld}): %s", sfd->fd+1, 1L<<(sfd->fd+1),
+		     Error5("Select(%d, &0x%lx, NULL, NULL, {%ld.%06ld}): %s", nfds, 1L<<(nfds-1),
 			    sfd->para.socket.accept_timeout.tv_sec, sfd->para.socket.accept_timeout.tv_usec,
 			    strerror(errno));
 		  }
@@ -275,6 +342,17 @@ int _xioopen_accept_fd(
 		  break;
 	       }
 	    }
+	    if (hfd >= 0 && FD_ISSET(hfd, &rfd)) {
+	       if (xiohandover_send(sfd->fd) == 0) {
+		  /* the new process accepts connections now; the socket name
+		     of a UNIX listener belongs to it */
+		  xiohandover_close();
+		  Close(sfd->fd);
+		  sfd->opt_unlink_close = false;
+		  _xioopen_listen_drain();
+	       }
+	       continue;
+	    }
 	    if (!FD_ISSET(sfd->fd, &rfd)) {
 	       struct sigaction act;
 
@@ -373,6 +451,7 @@ int _xioopen_accept_fd(
 
 	    Info1("just born: child process "F_pid, cpid);
 	    xiosetenvulong("PID", cpid, 1);
+	    xiohandover_close();
 
 	    if (Close(sfd->fd) < 0) {
 	       Info2("close(%d): %s", sfd->fd, strerror(errno));
@@ -408,10 +487,14 @@ int _xioopen_accept_fd(
 	 }
 	 Info("still listening");
       } else {
+	 xiohandover_close();
 	 if (Close(sfd->fd) < 0) {
 	    Info2("close(%d): %s", sfd->fd, strerror(errno));
 	 }
 	 sfd->fd = ps;
+#if WITH_TCP || WITH_UDP
+	 xio_rangefile_sigrestore();
+#endif
 	break;
       }
    }
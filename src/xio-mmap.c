@@ -0,0 +1,261 @@
+/* source: xio-mmap.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for reading regular files through a memory
+   mapping (option mmap). The transfer engine writes directly from the mapped
+   window, saving the read() calls and the copy into its buffer.
+   A file that is truncated while mapped raises SIGBUS on access to pages
+   beyond its new end; the accesses of this module are guarded, and reading
+   continues with read() then. The transfer engine uses the mapped data
+   directly only when just the kernel reads it (see socat_readptr_check()) */
+
+#include "xiosysincludes.h"
+#include "xioopen.h"
+
+#include "xio-mmap.h"
+
+
+#if HAVE_SYS_MMAN_H
+
+#define XIOMMAP_WINDOW	(16*1024*1024)	/* default size of mapped window */
+
+const struct optdesc opt_mmap        = { "mmap",        NULL, OPT_MMAP,        GROUP_REG, PH_LATE, TYPE_BOOL,   OFUNC_SPEC };
+const struct optdesc opt_mmap_window = { "mmap-window", NULL, OPT_MMAP_WINDOW, GROUP_REG, PH_LATE, TYPE_SIZE_T, OFUNC_SPEC };
+
+#if HAVE_SIGACTION
+static sigjmp_buf xiommap_jmpbuf;
+static volatile sig_atomic_t xiommap_guarded;	/* jmpbuf is valid */
+
+static void xiommap_sigbus(int signum) {
+   struct sigaction act;
+
+   if (xiommap_guarded) {
+      xiommap_guarded = 0;
+      siglongjmp(xiommap_jmpbuf, 1);
+   }
+   /* not caused by a mapped window */
+   memset(&act, 0, sizeof(act));
+   act.sa_handler = SIG_DFL;
+   sigaction(signum, &act, NULL);
+   raise(signum);
+}
+
+/* Installs the SIGBUS handler once per process. SA_NODEFER leaves SIGBUS
+   unblocked after siglongjmp(), so sigsetjmp() need not save the mask */
+static void xiommap_guard_init(void) {
+   static bool installed = false;
+   struct sigaction act;
+
+   if (installed)
+      return;
+   memset(&act, 0, sizeof(act));
+   act.sa_handler = xiommap_sigbus;
+   sigemptyset(&act.sa_mask);
+   act.sa_flags = SA_NODEFER;
+   if (Sigaction(SIGBUS, &act, NULL) < 0) {
+      Warn1("sigaction(SIGBUS, ...): %s", strerror(errno));
+      return;
+   }
+   installed = true;
+}
+#endif /* HAVE_SIGACTION */
+
+
+/* Retrieves options mmap and mmap-window. When mmap is set and the address
+   reads a regular file, switches the read method of sfd to XIOREAD_MMAP.
+   The window is mapped on first read, so options like seek and readbytes
+   that are applied later are honoured.
+   Returns 0 on success (even when the file cannot be mapped), or -1 */
+int _xioopen_mmap(struct single *sfd, int rw, struct opt *opts) {
+   bool domap = false;
+   size_t window = XIOMMAP_WINDOW;
+   struct stat buf;
+   long pagesize = getpagesize();
+
+   retropt_bool(opts, OPT_MMAP, &domap);
+   retropt_size_t(opts, OPT_MMAP_WINDOW, &window);
+   if (!domap) {
+      return 0;
+   }
+   if (rw == XIO_WRONLY) {
+      Warn("option mmap has no effect on write-only addresses");
+      return 0;
+   }
+   if ((sfd->dtype & XIODATA_READMASK) != XIOREAD_STREAM) {
+      Warn("option mmap: address does not read with read(), ignoring");
+      return 0;
+   }
+   if (Fstat(sfd->fd, &buf) < 0) {
+      Error2("fstat(%d, ...): %s", sfd->fd, strerror(errno));
+      return -1;
+   }
+   if (!S_ISREG(buf.st_mode)) {
+      Warn1("option mmap: fd %d is not a regular file, using read()",
+	    sfd->fd);
+      return 0;
+   }
+   /* the window must cover at least one page beyond an unaligned start */
+   if (window < 2*(size_t)pagesize) {
+      window = 2*pagesize;
+   }
+   window = (window + pagesize - 1) & ~((size_t)pagesize - 1);
+
+   sfd->para.mmap.window = window;
+   sfd->para.mmap.map    = NULL;
+   sfd->para.mmap.maplen = 0;
+   sfd->para.mmap.mapoff = 0;
+   sfd->para.mmap.pos    = -1;
+   sfd->dtype = (sfd->dtype & ~XIODATA_READMASK) | XIOREAD_MMAP;
+#if HAVE_SIGACTION
+   xiommap_guard_init();
+#endif
+   Info2("fd %d: reading through memory mapped windows of "F_Zu" bytes",
+	 sfd->fd, window);
+   return 0;
+}
+
+/* Maps the window of the file that contains position pos, not beyond the
+   current end of file.
+   Returns 1 on success, 0 when pos is at or beyond end of file, or -1 */
+static int xiommap_window(struct single *sfd, off_t pos) {
+   long pagesize = getpagesize();
+   struct stat buf;
+   off_t mapoff;
+   size_t maplen;
+   void *map;
+
+   if (sfd->para.mmap.map != NULL) {
+      Munmap(sfd->para.mmap.map, sfd->para.mmap.maplen);
+      sfd->para.mmap.map = NULL;
+      sfd->para.mmap.maplen = 0;
+   }
+   /* the file might have grown or shrunk since the previous window was
+      mapped */
+   if (Fstat(sfd->fd, &buf) < 0) {
+      Error2("fstat(%d, ...): %s", sfd->fd, strerror(errno));
+      return -1;
+   }
+   if (pos >= buf.st_size) {
+      return 0;
+   }
+   mapoff = pos & ~((off_t)pagesize - 1);
+   maplen = sfd->para.mmap.window;
+   if ((off_t)maplen > buf.st_size - mapoff) {
+      maplen = buf.st_size - mapoff;
+   }
+   if ((map = Mmap(NULL, maplen, PROT_READ, MAP_SHARED, sfd->fd, mapoff))
+       == MAP_FAILED) {
+      Error4("mmap(NULL, "F_Zu", PROT_READ, MAP_SHARED, %d, "F_off"): %s",
+	     maplen, sfd->fd, mapoff, strerror(errno));
+      return -1;
+   }
+#ifdef MADV_SEQUENTIAL
+   if (Madvise(map, maplen, MADV_SEQUENTIAL) < 0) {
+      Info3("madvise(%p, "F_Zu", MADV_SEQUENTIAL): %s",
+	    map, maplen, strerror(errno));
+   }
+#endif
+   sfd->para.mmap.map    = map;
+   sfd->para.mmap.maplen = maplen;
+   sfd->para.mmap.mapoff = mapoff;
+   return 1;
+}
+
+/* The file has shrunk below the mapped window: unmaps it and reads the
+   file with read() from pos on, now and for the rest of the transfer */
+static ssize_t xioread_mmap_fallback(struct single *sfd, off_t pos,
+				     void *buff, size_t bufsiz,
+				     const void **data) {
+   ssize_t bytes;
+
+   Warn1("fd %d: file has been truncated while mapped, using read()",
+	 sfd->fd);
+   Munmap(sfd->para.mmap.map, sfd->para.mmap.maplen);
+   sfd->para.mmap.map = NULL;
+   sfd->para.mmap.maplen = 0;
+   sfd->dtype = (sfd->dtype & ~XIODATA_READMASK) | XIOREAD_STREAM;
+   if (Lseek(sfd->fd, pos, SEEK_SET) < 0) {
+      Error3("lseek(%d, "F_off", SEEK_SET): %s",
+	     sfd->fd, pos, strerror(errno));
+      return -1;
+   }
+   do {
+      bytes = Read(sfd->fd, buff, bufsiz);
+   } while (bytes < 0 && errno == EINTR);
+   if (bytes < 0) {
+      Error4("read(%d, %p, "F_Zu"): %s",
+	     sfd->fd, buff, bufsiz, strerror(errno));
+      return -1;
+   }
+   if (data != NULL)
+      *data = buff;
+   return bytes;
+}
+
+/* Passes at most bufsiz bytes of the file, starting at the current read
+   position: with data NULL they are copied to buff, otherwise *data points
+   into the mapped window, valid until the next call. The pages passed are
+   touched here, so a truncated file is detected before the data is used;
+   reading then continues with read() into buff.
+   Returns the number of bytes, 0 on EOF, or -1 on error */
+ssize_t xioread_mmap(struct single *sfd, void *buff, size_t bufsiz,
+		     const void **data) {
+   long pagesize = getpagesize();
+   volatile off_t pos = sfd->para.mmap.pos;	/* used after siglongjmp() */
+   const volatile char *src;
+   size_t avail, off;
+   int rc;
+
+   if (pos < 0) {
+      /* first read: start where options like seek left the file offset */
+      if ((pos = Lseek(sfd->fd, 0, SEEK_CUR)) < 0) {
+	 Error2("lseek(%d, 0, SEEK_CUR): %s", sfd->fd, strerror(errno));
+	 return -1;
+      }
+   }
+   if (sfd->para.mmap.map == NULL ||
+       pos >= sfd->para.mmap.mapoff + (off_t)sfd->para.mmap.maplen) {
+      if ((rc = xiommap_window(sfd, pos)) <= 0) {
+	 sfd->para.mmap.pos = pos;
+	 return rc;
+      }
+   }
+   avail = sfd->para.mmap.mapoff + sfd->para.mmap.maplen - pos;
+   if (avail > bufsiz) {
+      avail = bufsiz;
+   }
+   src = (char *)sfd->para.mmap.map + (pos - sfd->para.mmap.mapoff);
+#if HAVE_SIGACTION
+   if (sigsetjmp(xiommap_jmpbuf, 0) != 0) {
+      return xioread_mmap_fallback(sfd, pos, buff, bufsiz, data);
+   }
+   xiommap_guarded = 1;
+#endif
+   if (data == NULL) {
+      memcpy(buff, (const char *)src, avail);
+   } else {
+      for (off = 0; off < avail; off += pagesize) {
+	 (void)src[off];
+      }
+      (void)src[avail-1];
+   }
+#if HAVE_SIGACTION
+   xiommap_guarded = 0;
+#endif
+   if (data != NULL) {
+      *data = (const char *)src;
+   }
+   sfd->para.mmap.pos = pos + avail;
+   return avail;
+}
+
+int xioclose_mmap(struct single *sfd) {
+   if (sfd->para.mmap.map != NULL) {
+      Munmap(sfd->para.mmap.map, sfd->para.mmap.maplen);
+      sfd->para.mmap.map = NULL;
+   }
+   return 0;
+}
+
+#endif /* HAVE_SYS_MMAN_H */
@@ -0,0 +1,20 @@
+/* source: xio-mmap.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_mmap_h_included
+#define __xio_mmap_h_included 1
+
+#if HAVE_SYS_MMAN_H
+
+extern const struct optdesc opt_mmap;
+extern const struct optdesc opt_mmap_window;
+
+extern int _xioopen_mmap(struct single *sfd, int rw, struct opt *opts);
+extern ssize_t xioread_mmap(struct single *sfd, void *buff, size_t bufsiz,
+			    const void **data);
+extern int xioclose_mmap(struct single *sfd);
+
+#endif /* HAVE_SYS_MMAN_H */
+
+#endif /* !defined(__xio_mmap_h_included) */
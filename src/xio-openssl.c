@@ -20,6 +20,7 @@
 #include "xio-ip6.h"
 
 #include "xio-openssl.h"
+#include "xio-tlscache.h"
 
 /* the openssl library requires a file descriptor for external communications.
    so our best effort is to provide any possible kind of un*x file descriptor
@@ -119,6 +120,9 @@ const struct optdesc opt_openssl_max_proto_version = { "openssl-max-proto-versio
 const struct optdesc opt_openssl_verify     = { "openssl-verify",     "verify",  OPT_OPENSSL_VERIFY,     GROUP_OPENSSL, PH_SPEC, TYPE_BOOL,   OFUNC_SPEC };
 const struct optdesc opt_openssl_certificate = { "openssl-certificate", "cert",  OPT_OPENSSL_CERTIFICATE, GROUP_OPENSSL, PH_SPEC, TYPE_FILENAME, OFUNC_SPEC };
 const struct optdesc opt_openssl_key         = { "openssl-key",         "key",   OPT_OPENSSL_KEY,         GROUP_OPENSSL, PH_SPEC, TYPE_FILENAME, OFUNC_SPEC };
+#ifdef SSL_OP_ENABLE_KTLS
+const struct optdesc opt_openssl_ktls        = { "openssl-ktls",        "ktls",  OPT_OPENSSL_KTLS,        GROUP_OPENSSL, PH_SPEC, TYPE_BOOL,     OFUNC_SPEC };
+#endif
 const struct optdesc opt_openssl_dhparam     = { "openssl-dhparam",     "dh",    OPT_OPENSSL_DHPARAM,     GROUP_OPENSSL, PH_SPEC, TYPE_FILENAME, OFUNC_SPEC };
 const struct optdesc opt_openssl_cafile      = { "openssl-cafile",     "cafile", OPT_OPENSSL_CAFILE,      GROUP_OPENSSL, PH_SPEC, TYPE_FILENAME, OFUNC_SPEC };
 const struct optdesc opt_openssl_capath      = { "openssl-capath",     "capath", OPT_OPENSSL_CAPATH,      GROUP_OPENSSL, PH_SPEC, TYPE_FILENAME, OFUNC_SPEC };
@@ -130,6 +134,9 @@ const struct optdesc opt_openssl_maxfraglen  = { "openssl-maxfraglen",  "maxfrag
 const struct optdesc opt_openssl_maxsendfrag = { "openssl-maxsendfrag", "maxsendfrag", OPT_OPENSSL_MAXSENDFRAG, GROUP_OPENSSL, PH_SPEC, TYPE_INT, OFUNC_SPEC };
 #endif
 const struct optdesc opt_openssl_pseudo      = { "openssl-pseudo",     "pseudo", OPT_OPENSSL_PSEUDO,      GROUP_OPENSSL, PH_SPEC, TYPE_BOOL,     OFUNC_SPEC };
+const struct optdesc opt_openssl_dynamic_records = { "openssl-dynamic-records", "dynamic-records", OPT_OPENSSL_DYNAMIC_RECORDS, GROUP_OPENSSL, PH_SPEC, TYPE_BOOL, OFUNC_SPEC };
+const struct optdesc opt_openssl_read_ahead  = { "openssl-read-ahead",  "read-ahead", OPT_OPENSSL_READ_AHEAD,  GROUP_OPENSSL, PH_SPEC, TYPE_BOOL,     OFUNC_SPEC };
+const struct optdesc opt_openssl_session_cache = { "openssl-session-cache", "session-cache", OPT_OPENSSL_SESSION_CACHE, GROUP_OPENSSL, PH_SPEC, TYPE_BOOL, OFUNC_SPEC };
 #if OPENSSL_VERSION_NUMBER >= 0x00908000L && !defined(OPENSSL_NO_COMP)
 const struct optdesc opt_openssl_compress    = { "openssl-compress",   "compress", OPT_OPENSSL_COMPRESS,  GROUP_OPENSSL, PH_SPEC, TYPE_STRING,   OFUNC_SPEC };
 #endif
@@ -140,6 +147,7 @@ const struct optdesc opt_openssl_commonname  = { "openssl-commonname", "cn",
 #if defined(HAVE_SSL_set_tlsext_host_name) || defined(SSL_set_tlsext_host_name)
 const struct optdesc opt_openssl_no_sni      = { "openssl-no-sni",    "nosni",   OPT_OPENSSL_NO_SNI,      GROUP_OPENSSL, PH_SPEC, TYPE_BOOL,     OFUNC_SPEC };
 const struct optdesc opt_openssl_snihost     = { "openssl-snihost",   "snihost", OPT_OPENSSL_SNIHOST,     GROUP_OPENSSL, PH_SPEC, TYPE_STRING,   OFUNC_SPEC };
+const struct optdesc opt_openssl_ticket_key_file = { "openssl-ticket-key-file", "ticket-key-file", OPT_OPENSSL_TICKET_KEY_FILE, GROUP_OPENSSL, PH_SPEC, TYPE_FILENAME, OFUNC_SPEC };
 #endif
 
 /* If FIPS is compiled in, we need to track if the user asked for FIPS mode.
@@ -197,6 +205,7 @@ static void openssl_conn_loginfo(SSL *ssl) {
       Warn1("SSL_get_session(%p) failed", ssl);
       return;
    }
+   Info1("SSL session %s", SSL_session_reused(ssl)?"resumed":"negotiated");
 #if HAVE_SSL_CTX_set_tlsext_max_fragment_length || defined(SSL_CTX_set_tlsext_max_fragment_length)
    {
       uint8_t fragcod;
@@ -219,6 +228,29 @@ static void openssl_conn_loginfo(SSL *ssl) {
 #endif
 }
 
+/* Checks if the kernel has taken over record encryption and decryption
+   (option openssl-ktls). Data is still written with SSL_write() and read
+   with SSL_read(): OpenSSL then passes plain data to the kernel, but it can
+   still send the records it has queued, e.g. the answer to a KeyUpdate, and
+   handle alerts and handshake messages */
+static void openssl_conn_ktls(struct single *sfd) {
+#ifdef SSL_OP_ENABLE_KTLS
+   SSL *ssl = sfd->para.openssl.ssl;
+
+   if (!(SSL_get_options(ssl) & SSL_OP_ENABLE_KTLS))
+      return;
+   sfd->para.openssl.ktls_send = (BIO_get_ktls_send(SSL_get_wbio(ssl)) > 0);
+   sfd->para.openssl.ktls_recv = (BIO_get_ktls_recv(SSL_get_rbio(ssl)) > 0);
+   if (!sfd->para.openssl.ktls_send && !sfd->para.openssl.ktls_recv) {
+      Notice("kTLS not active, kernel or cipher do not support it");
+      return;
+   }
+   Info2("kTLS active: send offload %s, receive offload %s",
+	 sfd->para.openssl.ktls_send?"yes":"no",
+	 sfd->para.openssl.ktls_recv?"yes":"no");
+#endif /* SSL_OP_ENABLE_KTLS */
+}
+
 /* the open function for OpenSSL client */
 static int xioopen_openssl_connect(
 	int argc,
@@ -308,9 +340,21 @@ static int xioopen_openssl_connect(
    }
 #endif
 
+   /* with option resolve-timeout the target name is resolved while the
+      TLS context is set up; this needs the protocol family that
+      _xioopen_ipapp_prepare() would determine, otherwise the prefetch does
+      not match */
+   retropt_socket_pf(opts, &pf);
+   xiogetaddrinfo_prefetch(hostname, portname, pf,
+			   use_dtls?SOCK_DGRAM:SOCK_STREAM,
+			   use_dtls?IPPROTO_UDP:IPPROTO_TCP,
+			   &sfd->para.socket.ip);
+
    result =
       _xioopen_openssl_prepare(opts, sfd, false, &opt_ver, opt_cert, &ctx, (bool *)&use_dtls);
    if (result != STAT_OK)  return STAT_NORETRY;
+   if (sfd->para.openssl.session_cache)
+      xiotlscache_client_target(hostname, portname);
 
    if (use_dtls) {
       socktype = SOCK_DGRAM;
@@ -321,7 +365,7 @@ static int xioopen_openssl_connect(
 
    result =
       _xioopen_ipapp_prepare(opts, &opts0, hostname, portname, &pf, ipproto,
-			     sfd->para.socket.ip.ai_flags,
+			     &sfd->para.socket.ip,
 			     &themarr, us, &uslen,
 			     &needbind, &lowport, socktype);
    if (result != STAT_OK)  return STAT_NORETRY;
@@ -349,10 +393,10 @@ static int xioopen_openssl_connect(
 
 	 /* This cannot fork because we retrieved fork option above */
        result =
-	 _xioopen_connect(sfd,
+	 _xioopen_ipapp_connect(sfd,
 			  needbind?us:NULL, uslen,
-			  themp->ai_addr, themp->ai_addrlen,
-			  opts, pf?pf:themp->ai_addr->sa_family, socktype, ipproto, lowport, level);
+			  themarr, &i,
+			  opts, pf, socktype, ipproto, lowport, level);
        if (result == STAT_OK)
 	  break;
        themp = themarr[i++];
@@ -447,6 +491,7 @@ static int xioopen_openssl_connect(
    xiofreeaddrinfo(themarr);
 
    openssl_conn_loginfo(sfd->para.openssl.ssl);
+   openssl_conn_ktls(sfd);
 
    free((void *)opt_commonname);
    free((void *)opt_snihost);
@@ -502,6 +547,9 @@ int _xioopen_openssl_connect(struct single *sfd,
    }
 #endif
 
+   if (sfd->para.openssl.session_cache)
+      xiotlscache_client_offer(ssl);
+
    result = xioSSL_connect(sfd, opt_commonname, opt_ver, level);
    if (result != STAT_OK) {
       sycSSL_free(sfd->para.openssl.ssl);
@@ -687,6 +735,7 @@ static int xioopen_openssl_listen(
       }
 
       openssl_conn_loginfo(sfd->para.openssl.ssl);
+      openssl_conn_ktls(sfd);
       break;
 
    }	/* drop out on success */
@@ -975,10 +1024,12 @@ int
    char *opt_cafile = NULL;	/* certificate authority file */
    char *opt_capath = NULL;	/* certificate authority directory */
    char *opt_egd = NULL;	/* entropy gathering daemon socket path */
+   char *opt_ticketkeys = NULL;	/* session ticket key file */
 #if OPENSSL_VERSION_NUMBER >= 0x00908000L
    char *opt_compress = NULL;	/* compression method */
 #endif
    bool opt_pseudo = false;	/* use pseudo entropy if nothing else */
+   bool opt_ktls = false;	/* kernel TLS offload */
    unsigned long err;
    int result;
 
@@ -994,6 +1045,13 @@ int
    retropt_string(opts, OPT_OPENSSL_DHPARAM, &opt_dhparam);
    retropt_string(opts, OPT_OPENSSL_EGD, &opt_egd);
    retropt_bool(opts,OPT_OPENSSL_PSEUDO, &opt_pseudo);
+   retropt_bool(opts, OPT_OPENSSL_SESSION_CACHE, &sfd->para.openssl.session_cache);
+   retropt_string(opts, OPT_OPENSSL_TICKET_KEY_FILE, &opt_ticketkeys);
+#ifdef SSL_OP_ENABLE_KTLS
+   retropt_bool(opts, OPT_OPENSSL_KTLS, &opt_ktls);
+#endif
+   retropt_bool(opts, OPT_OPENSSL_DYNAMIC_RECORDS, &sfd->para.openssl.dynrecords);
+   retropt_bool(opts, OPT_OPENSSL_READ_AHEAD, &sfd->para.openssl.read_ahead);
 #if OPENSSL_VERSION_NUMBER >= 0x00908000L
    retropt_string(opts, OPT_OPENSSL_COMPRESS, &opt_compress);
 #endif
@@ -1227,6 +1285,38 @@ int
    sfd->para.openssl.ctx = ctx;
    *ctxp = ctx;
 
+   if (sfd->para.openssl.session_cache) {
+      if (server) {
+	 result = xiotlscache_server_setup(ctx, opt_ticketkeys != NULL);
+	 if (result != STAT_OK)
+	    return result;
+      } else {
+	 xiotlscache_client_setup(ctx);
+      }
+   }
+   if (sfd->para.openssl.read_ahead) {
+      Debug1("SSL_CTX_set_read_ahead(%p, 1)", ctx);
+      SSL_CTX_set_read_ahead(ctx, 1);
+   }
+#ifdef SSL_OP_ENABLE_KTLS
+   if (opt_ktls) {
+      if (*use_dtls) {
+	 Warn("option openssl-ktls has no effect with DTLS");
+      } else {
+	 Debug1("SSL_CTX_set_options(%p, SSL_OP_ENABLE_KTLS)", ctx);
+	 SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+      }
+   }
+#endif
+   if (opt_ticketkeys != NULL) {
+      if (!server) {
+	 Warn("option openssl-ticket-key-file has no effect on client addresses");
+      } else if ((result = xiotlscache_ticket_keys(ctx, opt_ticketkeys))
+		 != STAT_OK) {
+	 return result;
+      }
+   }
+
 #if HAVE_SSL_CTX_set_min_proto_version || defined(SSL_CTX_set_min_proto_version)
    if (sfd->para.openssl.min_proto_version != NULL) {
       int sslver, rc;
@@ -2035,13 +2125,41 @@ static int xioSSL_connect(struct single *sfd, const char *opt_commonname,
 }
 
 /* on result < 0: errno is set (at least to EIO) */
+/* Returns true when OpenSSL has data that SSL_read() can return without
+   reading from the socket: decrypted data, or (with read-ahead) buffered
+   records */
+static bool xioSSL_readable(struct single *pipe) {
+   if (sycSSL_pending(pipe->para.openssl.ssl) > 0)
+      return true;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+   if (pipe->para.openssl.read_ahead &&
+       SSL_has_pending(pipe->para.openssl.ssl))
+      return true;
+#endif
+   return false;
+}
+
 ssize_t xioread_openssl(struct single *pipe, void *buff, size_t bufsiz) {
    unsigned long err;
    char error_string[120];
    int _errno = EIO;	/* if we have no better idea about nature of error */
-   int errint, ret;
+   int errint, ret, more;
 
+   pipe->para.openssl.readagain = false;
    ret = sycSSL_read(pipe->para.openssl.ssl, buff, bufsiz);
+   /* SSL_read() returns the contents of one record; fill the buffer with
+      the following records as far as OpenSSL already has them. EOF and
+      errors are reported by the next call */
+   while (ret > 0 && ret < bufsiz && xioSSL_readable(pipe)) {
+      more = sycSSL_read(pipe->para.openssl.ssl, (char *)buff+ret, bufsiz-ret);
+      if (more <= 0) {
+	 errint = SSL_get_error(pipe->para.openssl.ssl, more);
+	 if (errint != SSL_ERROR_WANT_READ && errint != SSL_ERROR_WANT_WRITE)
+	    pipe->para.openssl.readagain = true;
+	 break;
+      }
+      ret += more;
+   }
    if (ret < 0) {
       errint = SSL_get_error(pipe->para.openssl.ssl, ret);
       switch (errint) {
@@ -2092,11 +2210,20 @@ ssize_t xioread_openssl(struct single *pipe, void *buff, size_t bufsiz) {
 
 ssize_t xiopending_openssl(struct single *pipe) {
    int bytes = sycSSL_pending(pipe->para.openssl.ssl);
+   if (bytes == 0 && pipe->para.openssl.readagain)
+      bytes = 1;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+   /* with read-ahead, records may wait in OpenSSL's buffer while the socket
+      is empty */
+   if (bytes == 0 && pipe->para.openssl.read_ahead &&
+       SSL_has_pending(pipe->para.openssl.ssl))
+      bytes = 1;
+#endif
    return bytes;
 }
 
 /* on result < 0: errno is set (at least to EIO) */
-ssize_t xiowrite_openssl(struct single *pipe, const void *buff, size_t bufsiz) {
+static ssize_t xioSSL_write(struct single *pipe, const void *buff, size_t bufsiz) {
    unsigned long err;
    char error_string[120];
    int _errno = EIO;	/* if we have no better idea about nature of error */
@@ -2149,6 +2276,49 @@ ssize_t xiowrite_openssl(struct single *pipe, const void *buff, size_t bufsiz) {
    return ret;
 }
 
+/* Option openssl-dynamic-records: at the start of a connection and after a
+   pause, data is sent in records that fit into one TCP segment, so the peer
+   can decrypt the first bytes without waiting for a full 16KB record; later
+   records get the maximal size to minimize per record overhead */
+#define XIO_OPENSSL_DYNREC_SMALL	1369	/* 1500 bytes MTU minus headers */
+#define XIO_OPENSSL_DYNREC_BYTES	65536	/* bytes sent in small records */
+#define XIO_OPENSSL_DYNREC_IDLE		1	/* seconds to start over */
+
+static size_t xioSSL_dynrec_size(struct single *pipe, size_t bytes) {
+   struct timeval now;
+
+   Gettimeofday(&now, NULL);
+   if (now.tv_sec - pipe->para.openssl.dynrec_last.tv_sec >=
+       XIO_OPENSSL_DYNREC_IDLE) {
+      pipe->para.openssl.dynrec_sent = 0;
+   }
+   pipe->para.openssl.dynrec_last = now;
+   if (pipe->para.openssl.dynrec_sent >= XIO_OPENSSL_DYNREC_BYTES)
+      return bytes;
+   return Min(bytes, XIO_OPENSSL_DYNREC_SMALL);
+}
+
+/* Writes all data, in several SSL_write() calls with dynamic record sizing.
+   on result < 0: errno is set (at least to EIO) */
+ssize_t xiowrite_openssl(struct single *pipe, const void *buff, size_t bufsiz) {
+   size_t written = 0, chunk;
+   ssize_t ret;
+
+   while (written < bufsiz) {
+      chunk = bufsiz - written;
+      if (pipe->para.openssl.dynrecords)
+	 chunk = xioSSL_dynrec_size(pipe, chunk);
+      ret = xioSSL_write(pipe, (const char *)buff+written, chunk);
+      if (ret < 0)
+	 return -1;
+      if (ret == 0)
+	 break;
+      written += ret;
+      pipe->para.openssl.dynrec_sent += ret;
+   }
+   return written;
+}
+
 int xioshutdown_openssl(struct single *sfd, int how)
 {
    int rc;
@@ -22,6 +22,7 @@ extern const struct optdesc opt_openssl_max_proto_version;
 extern const struct optdesc opt_openssl_verify;
 extern const struct optdesc opt_openssl_certificate;
 extern const struct optdesc opt_openssl_key;
+extern const struct optdesc opt_openssl_ktls;
 extern const struct optdesc opt_openssl_dhparam;
 extern const struct optdesc opt_openssl_cafile;
 extern const struct optdesc opt_openssl_capath;
@@ -33,6 +34,9 @@ extern const struct optdesc opt_openssl_maxfraglen;
 extern const struct optdesc opt_openssl_maxsendfrag;
 #endif
 extern const struct optdesc opt_openssl_pseudo;
+extern const struct optdesc opt_openssl_dynamic_records;
+extern const struct optdesc opt_openssl_read_ahead;
+extern const struct optdesc opt_openssl_session_cache;
 #if OPENSSL_VERSION_NUMBER >= 0x00908000L
 extern const struct optdesc opt_openssl_compress;
 #endif
@@ -42,6 +46,7 @@ extern const struct optdesc opt_openssl_fips;
 extern const struct optdesc opt_openssl_commonname;
 extern const struct optdesc opt_openssl_no_sni;
 extern const struct optdesc opt_openssl_snihost;
+extern const struct optdesc opt_openssl_ticket_key_file;
 
 extern int
    _xioopen_openssl_prepare(struct opt *opts, struct single *xfd,
@@ -0,0 +1,585 @@
+/* source: xio-pool.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for the pool option: with a forking listener
+   in front of a TCP client address, a pool manager process keeps connections
+   to the target established, and each new child takes one of them instead of
+   connecting itself */
+
+#include "xiosysincludes.h"
+
+#if WITH_TCP
+
+#include "xioopen.h"
+#include "xio-socket.h"
+#include "xio-ipapp.h"
+
+#include "xio-pool.h"
+
+
+const struct optdesc opt_pool          = { "pool",          NULL, OPT_POOL,          GROUP_IP_TCP, PH_INIT, TYPE_INT,     OFUNC_OFFSET, XIO_OFFSETOF(para.socket.ip.pool) };
+const struct optdesc opt_pool_max_idle = { "pool-max-idle", NULL, OPT_POOL_MAX_IDLE, GROUP_IP_TCP, PH_INIT, TYPE_TIMEVAL, OFUNC_OFFSET, XIO_OFFSETOF(para.socket.ip.pool_max_idle) };
+
+#if WITH_ABSTRACT_UNIXSOCKET && defined(SO_PEERCRED)
+
+#define XIOPOOL_MAX	1024	/* connections per pool */
+#define XIOPOOL_BACKOFF	1	/* seconds after failed connect */
+#define XIOPOOL_TIMEOUT	1	/* seconds a child waits for the manager */
+
+#ifdef POLLRDHUP
+#  define XIOPOOL_RDHUP POLLRDHUP
+#else
+#  define XIOPOOL_RDHUP 0
+#endif
+
+/* an established connection waiting in the pool */
+struct xiopool_conn {
+   int fd;
+   bool hasdata;		/* target has sent data (e.g. a banner) */
+   struct timespec since;	/* CLOCK_MONOTONIC */
+} ;
+
+/* the connection the pool manager is establishing */
+struct xiopool_attempt {
+   struct single sfd;		/* sfd.fd < 0: no attempt pending */
+   struct opt *opts;
+   int ai;			/* index of the current address in themarr */
+   int flags;			/* file status flags before O_NONBLOCK */
+   struct timespec deadline;	/* with connect-timeout, else tv_sec 0 */
+} ;
+
+
+/* The pool manager is found by an abstract UNIX socket name made of the pid
+   of the listening process and the target */
+static void xiopool_sockaddr(struct sockaddr_un *sa, socklen_t *salen,
+			     pid_t owner, const char *host, const char *port) {
+   memset(sa, 0, sizeof(*sa));
+   sa->sun_family = AF_UNIX;
+   snprintf(sa->sun_path+1, sizeof(sa->sun_path)-1,
+	    "socat-pool-"F_pid"-%s:%s", owner, host, port);
+   *salen = offsetof(struct sockaddr_un, sun_path) + 1 +
+      strlen(sa->sun_path+1);
+}
+
+/* A pool only makes sense in the children of a forking first address */
+bool xiopool_applies(void) {
+   return sock1 != NULL && (XIO_RDSTREAM(sock1)->flags & XIO_DOESFORK);
+}
+
+/* Asks the pool manager for an established connection.
+   Returns the file descriptor, or -1 with errno ENOENT when no manager is
+   running, or other errno when the pool could not provide a connection */
+int xiopool_get(const char *host, const char *port) {
+   struct sockaddr_un sa;
+   socklen_t salen;
+   union {
+      struct cmsghdr cm;
+      char buff[CMSG_SPACE(sizeof(int))];
+   } ctl;
+   struct cmsghdr *cmsg;
+   struct msghdr msgh;
+   struct iovec iov;
+   struct pollfd pfd;
+   struct ucred cred;
+   socklen_t optlen = sizeof(cred);
+   char c = '\0';
+   int cfd, fd = -1;
+   ssize_t n;
+
+   xiopool_sockaddr(&sa, &salen, Getppid(), host, port);
+   if ((cfd = Socket(PF_UNIX, SOCK_STREAM, 0)) < 0) {
+      Warn1("socket(PF_UNIX, SOCK_STREAM, 0): %s", strerror(errno));
+      errno = EAGAIN;
+      return -1;
+   }
+   if (Connect(cfd, (struct sockaddr *)&sa, salen) < 0) {
+      Info2("pool: no manager for \"%s:%s\"", host, port);
+      Close(cfd);
+      errno = ENOENT;
+      return -1;
+   }
+   /* abstract names are not protected, accept connections only from a
+      manager of the same user */
+   if (Getsockopt(cfd, SOL_SOCKET, SO_PEERCRED, &cred, &optlen) < 0 ||
+       cred.uid != Geteuid()) {
+      Warn2("pool: manager for \"%s:%s\" is not ours, ignoring it",
+	    host, port);
+      Close(cfd);
+      errno = EPERM;
+      return -1;
+   }
+
+   iov.iov_base = &c;
+   iov.iov_len  = 1;
+   memset(&msgh, 0, sizeof(msgh));
+   msgh.msg_iov        = &iov;
+   msgh.msg_iovlen     = 1;
+   msgh.msg_control    = ctl.buff;
+   msgh.msg_controllen = sizeof(ctl.buff);
+   /* the manager never blocks, but it might be stopped or overloaded; the
+      caller then connects directly */
+   pfd.fd = cfd;  pfd.events = POLLIN;  pfd.revents = 0;
+   do {
+      n = xiopoll(&pfd, 1, &(struct timeval){XIOPOOL_TIMEOUT,0});
+   } while (n < 0 && errno == EINTR);
+   if (n == 0) {
+      Info2("pool: no answer from manager for \"%s:%s\"", host, port);
+      Close(cfd);
+      errno = ETIMEDOUT;
+      return -1;
+   }
+   do {
+      n = Recvmsg(cfd, &msgh, MSG_DONTWAIT);
+   } while (n < 0 && errno == EINTR);
+   Close(cfd);
+   if (n > 0 && c == 'C') {
+      for (cmsg = CMSG_FIRSTHDR(&msgh); cmsg != NULL;
+	   cmsg = CMSG_NXTHDR(&msgh, cmsg)) {
+	 if (cmsg->cmsg_level == SOL_SOCKET &&
+	     cmsg->cmsg_type  == SCM_RIGHTS &&
+	     cmsg->cmsg_len   >= CMSG_LEN(sizeof(int))) {
+	    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+	    break;
+	 }
+      }
+   }
+   if (fd < 0) {
+      Info2("pool for \"%s:%s\" is empty", host, port);
+      errno = EAGAIN;
+      return -1;
+   }
+   Notice2("pool: took established connection to \"%s:%s\"", host, port);
+   return fd;
+}
+
+/* Starts establishing a pool connection without blocking, with the address
+   themarr[att->ai] and the following ones.
+   Returns 1 while the connect is in progress, 0 when the connection is
+   established, or -1 when all addresses failed */
+static int xiopool_connect_start(struct xiopool_attempt *att,
+				 union sockaddr_union *us, socklen_t uslen,
+				 struct addrinfo **themarr,
+				 int pf, int socktype, int protocol,
+				 bool lowport) {
+   struct addrinfo *ai;
+   char infobuff[256];
+
+   while ((ai = themarr[att->ai]) != NULL) {
+      if (_xioopen_connect_socket(&att->sfd, us, uslen, att->opts,
+				  pf?pf:ai->ai_family, socktype, protocol,
+				  lowport, E_INFO)
+	  != STAT_OK) {
+	 if (att->sfd.fd >= 0)  Close(att->sfd.fd);
+	 att->sfd.fd = -1;
+	 ++att->ai;
+	 continue;
+      }
+      att->flags = Fcntl(att->sfd.fd, F_GETFL);
+      Fcntl_l(att->sfd.fd, F_SETFL, att->flags|O_NONBLOCK);
+      if (Connect(att->sfd.fd, ai->ai_addr, ai->ai_addrlen) >= 0)
+	 return 0;
+      if (errno == EINPROGRESS)
+	 return 1;
+      Info4("connect(%d, %s, "F_Zd"): %s", att->sfd.fd,
+	    sockaddr_info(ai->ai_addr, ai->ai_addrlen,
+			  infobuff, sizeof(infobuff)),
+	    (size_t)ai->ai_addrlen, strerror(errno));
+      Close(att->sfd.fd);
+      att->sfd.fd = -1;
+      ++att->ai;
+   }
+   return -1;
+}
+
+/* Continues the pending connect after poll() reported it, or after
+   connect-timeout expired (timedout). Returns like xiopool_connect_start() */
+static int xiopool_connect_cont(struct xiopool_attempt *att, bool timedout,
+				union sockaddr_union *us, socklen_t uslen,
+				struct addrinfo **themarr,
+				int pf, int socktype, int protocol,
+				bool lowport) {
+   struct addrinfo *ai = themarr[att->ai];
+   char infobuff[256];
+   int err = 0;
+   socklen_t errlen = sizeof(err);
+
+   if (timedout) {
+      err = ETIMEDOUT;
+   } else if (Getsockopt(att->sfd.fd, SOL_SOCKET, SO_ERROR, &err, &errlen)
+	      < 0) {
+      err = errno;
+   }
+   if (err == 0)
+      return 0;
+   Info4("connect(%d, %s, "F_Zd"): %s", att->sfd.fd,
+	 sockaddr_info(ai->ai_addr, ai->ai_addrlen,
+		       infobuff, sizeof(infobuff)),
+	 (size_t)ai->ai_addrlen, strerror(err));
+   Close(att->sfd.fd);
+   att->sfd.fd = -1;
+   ++att->ai;
+   return xiopool_connect_start(att, us, uslen, themarr,
+				pf, socktype, protocol, lowport);
+}
+
+/* Sets the end of connect-timeout for the connect just started */
+static void xiopool_deadline(struct xiopool_attempt *att) {
+   struct timeval *tmo = &att->sfd.para.socket.connect_timeout;
+
+   att->deadline.tv_sec = 0;
+   att->deadline.tv_nsec = 0;
+   if (att->sfd.fd < 0 || (tmo->tv_sec == 0 && tmo->tv_usec == 0))
+      return;
+   clock_gettime(CLOCK_MONOTONIC, &att->deadline);
+   att->deadline.tv_sec  += tmo->tv_sec;
+   att->deadline.tv_nsec += tmo->tv_usec*1000;
+   if (att->deadline.tv_nsec >= 1000000000) {
+      ++att->deadline.tv_sec;
+      att->deadline.tv_nsec -= 1000000000;
+   }
+}
+
+/* Takes the result of xiopool_connect_start() or xiopool_connect_cont():
+   an established connection joins the pool, a failure delays the next
+   attempt. Pending attempts (rc > 0) are left alone */
+static void xiopool_connect_end(struct xiopool_attempt *att, int rc,
+				struct xiopool_conn *conns, int *nconns,
+				int size, struct timespec *retry,
+				union sockaddr_union *us,
+				struct addrinfo **themarr, int pf,
+				const char *host) {
+   if (rc > 0)
+      return;
+   if (rc == 0) {
+      Fcntl_l(att->sfd.fd, F_SETFL, att->flags);
+      _xioopen_connect_late(&att->sfd, us, att->opts,
+			    pf?pf:themarr[att->ai]->ai_family);
+      conns[*nconns].fd = att->sfd.fd;
+      conns[*nconns].hasdata = false;
+      clock_gettime(CLOCK_MONOTONIC, &conns[*nconns].since);
+      ++*nconns;
+      Info3("pool: %d of %d connections to \"%s\" established",
+	    *nconns, size, host);
+   } else {
+      Info1("pool: could not connect to \"%s\"", host);
+      clock_gettime(CLOCK_MONOTONIC, retry);
+      retry->tv_sec += XIOPOOL_BACKOFF;
+   }
+   att->sfd.fd = -1;
+   dropopts(att->opts, PH_ALL);
+   free(att->opts);
+   att->opts = NULL;
+}
+
+/* Checks an idle connection that poll() reported. Data from the target,
+   e.g. the greeting of SMTP, FTP, or SSH, is kept for the client; only a
+   closed or failed connection is dropped.
+   Returns true when the connection is still usable */
+static bool xiopool_alive(struct xiopool_conn *conn, short revents) {
+   char c;
+   int n;
+
+   if (revents & (POLLERR|POLLHUP|POLLNVAL|XIOPOOL_RDHUP))
+      return false;
+   if (revents & POLLIN) {
+      do {
+	 n = Recv(conn->fd, &c, 1, MSG_PEEK|MSG_DONTWAIT);
+      } while (n < 0 && errno == EINTR);
+      if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+	 return false;
+      /* readable until the client takes it, do not poll for it again */
+      if (n > 0)
+	 conn->hasdata = true;
+   }
+   return true;
+}
+
+/* poll() events to watch on an idle connection */
+static short xiopool_events(struct xiopool_conn *conn) {
+   return (conn->hasdata ? 0 : POLLIN) | XIOPOOL_RDHUP;
+}
+
+/* Hands the oldest healthy connection to the requesting child; idle
+   connections closed by the target are dropped */
+static void xiopool_serve(int lfd, struct xiopool_conn *conns, int *nconns,
+			  const char *host, const char *port) {
+   union {
+      struct cmsghdr cm;
+      char buff[CMSG_SPACE(sizeof(int))];
+   } ctl;
+   struct cmsghdr *cmsg;
+   struct msghdr msgh;
+   struct iovec iov;
+   struct pollfd pfd;
+   struct xiopool_conn conn;
+   union sockaddr_union pa;
+   socklen_t palen = sizeof(pa);
+   char c = 'E';
+   int cfd, fd = -1;
+
+   if ((cfd = Accept(lfd, &pa.soa, &palen)) < 0) {
+      if (errno != EINTR && errno != ECONNABORTED)
+	 Warn2("pool: accept(%d): %s", lfd, strerror(errno));
+      return;
+   }
+   while (*nconns > 0 && fd < 0) {
+      conn = conns[0];
+      fd = conn.fd;
+      memmove(&conns[0], &conns[1], (*nconns-1)*sizeof(conns[0]));
+      --*nconns;
+      pfd.fd = fd;  pfd.events = xiopool_events(&conn);  pfd.revents = 0;
+      if (xiopoll(&pfd, 1, &(struct timeval){0,0}) > 0 &&
+	  !xiopool_alive(&conn, pfd.revents)) {
+	 Info1("pool: dropping connection to \"%s\" closed by peer", host);
+	 Close(fd);
+	 fd = -1;
+      }
+   }
+
+   iov.iov_base = &c;
+   iov.iov_len  = 1;
+   memset(&msgh, 0, sizeof(msgh));
+   msgh.msg_iov        = &iov;
+   msgh.msg_iovlen     = 1;
+   if (fd >= 0) {
+      c = 'C';
+      memset(&ctl, 0, sizeof(ctl));
+      msgh.msg_control    = ctl.buff;
+      msgh.msg_controllen = sizeof(ctl.buff);
+      cmsg = CMSG_FIRSTHDR(&msgh);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type  = SCM_RIGHTS;
+      cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+      memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+   }
+   if (Sendmsg(cfd, &msgh, 0) < 0) {
+      /* EPIPE: the child gave up waiting and connected itself */
+      Msg2(errno == EPIPE ? E_INFO : E_WARN,
+	   "pool: sendmsg(%d): %s", cfd, strerror(errno));
+   }
+   Close(cfd);
+   if (fd >= 0) {
+      Close(fd);
+      Info3("pool: passed connection to \"%s:%s\", %d left",
+	    host, port, *nconns);
+   }
+}
+
+/* The pool manager process: keeps pool connections to the target
+   established and serves requests until the listening process terminates */
+static void xiopool_manage(int lfd, pid_t owner, struct single *sfd,
+			   const char *host, const char *port,
+			   union sockaddr_union *us, socklen_t uslen,
+			   struct addrinfo **themarr, struct opt *opts0,
+			   int pf, int socktype, int protocol, bool lowport) {
+   int size = sfd->para.socket.ip.pool;
+   struct timeval maxidle = sfd->para.socket.ip.pool_max_idle;
+   struct xiopool_conn *conns;
+   struct xiopool_attempt att;
+   struct pollfd *pfds;
+   struct timespec now, retry = { 0, 0 };
+   struct timeval tmo;
+   long left;
+   int nconns = 0;
+   int i, k, n, rc;
+
+   conns = Malloc(size*sizeof(struct xiopool_conn));
+   pfds  = Malloc((size+2)*sizeof(struct pollfd));
+   if (conns == NULL || pfds == NULL)
+      return;
+   att.sfd.fd = -1;
+   att.opts = NULL;
+   Notice3("pool: keeping %d connections to \"%s:%s\" established",
+	   size, host, port);
+
+   while (Kill(owner, 0) == 0 || errno != ESRCH) {
+      clock_gettime(CLOCK_MONOTONIC, &now);
+
+      /* max-idle eviction, the connections are ordered by age */
+      while (nconns > 0 && (maxidle.tv_sec != 0 || maxidle.tv_usec != 0) &&
+	     (now.tv_sec - conns[0].since.tv_sec)*1000000 +
+	     (now.tv_nsec - conns[0].since.tv_nsec)/1000 >=
+	     maxidle.tv_sec*1000000 + maxidle.tv_usec) {
+	 Info1("pool: closing connection to \"%s\" idle for too long", host);
+	 Close(conns[0].fd);
+	 memmove(&conns[0], &conns[1], (nconns-1)*sizeof(conns[0]));
+	 --nconns;
+      }
+
+      /* refill: one connection at a time is established without blocking,
+	 requests are served meanwhile */
+      if (att.sfd.fd >= 0 && att.deadline.tv_sec != 0 &&
+	  (now.tv_sec > att.deadline.tv_sec ||
+	   (now.tv_sec == att.deadline.tv_sec &&
+	    now.tv_nsec >= att.deadline.tv_nsec))) {
+	 rc = xiopool_connect_cont(&att, true, us, uslen, themarr,
+				   pf, socktype, protocol, lowport);
+	 xiopool_deadline(&att);
+	 xiopool_connect_end(&att, rc, conns, &nconns, size, &retry,
+			     us, themarr, pf, host);
+      }
+      if (att.sfd.fd < 0 && nconns < size &&
+	  (now.tv_sec > retry.tv_sec ||
+	   (now.tv_sec == retry.tv_sec && now.tv_nsec >= retry.tv_nsec))) {
+	 memcpy(&att.sfd, sfd, sizeof(att.sfd));
+	 att.sfd.fd = -1;
+	 att.opts = copyopts(opts0, GROUP_ALL);
+	 att.ai = 0;
+	 rc = xiopool_connect_start(&att, us, uslen, themarr,
+				    pf, socktype, protocol, lowport);
+	 xiopool_deadline(&att);
+	 xiopool_connect_end(&att, rc, conns, &nconns, size, &retry,
+			     us, themarr, pf, host);
+      }
+
+      pfds[0].fd = lfd;
+      pfds[0].events = POLLIN;
+      pfds[0].revents = 0;
+      for (i = 0; i < nconns; ++i) {
+	 pfds[1+i].fd = conns[i].fd;
+	 pfds[1+i].events = xiopool_events(&conns[i]);
+	 pfds[1+i].revents = 0;
+      }
+      k = 1+nconns;
+      pfds[k].fd = att.sfd.fd; 	/* poll() ignores fd -1 */
+      pfds[k].events = POLLOUT;
+      pfds[k].revents = 0;
+      /* wake up at least once per second to check the listening process */
+      tmo.tv_sec = 1;
+      tmo.tv_usec = 0;
+      if (att.sfd.fd < 0 && nconns < size && retry.tv_sec <= now.tv_sec) {
+	 tmo.tv_sec = 0;
+      } else if (att.sfd.fd >= 0 && att.deadline.tv_sec != 0) {
+	 left = (att.deadline.tv_sec - now.tv_sec)*1000000 +
+	    (att.deadline.tv_nsec - now.tv_nsec)/1000;
+	 if (left < 1000000) {
+	    tmo.tv_sec = 0;
+	    tmo.tv_usec = left > 0 ? left : 0;
+	 }
+      }
+      if ((n = xiopoll(pfds, 2+nconns, &tmo)) < 0) {
+	 if (errno == EINTR)
+	    continue;
+	 Warn1("pool: poll(): %s", strerror(errno));
+	 break;
+      }
+      if (n == 0)
+	 continue;
+
+      /* health check: idle connections must not be closed by the target */
+      for (i = nconns-1; i >= 0; --i) {
+	 if (pfds[1+i].revents != 0 &&
+	     !xiopool_alive(&conns[i], pfds[1+i].revents)) {
+	    Info1("pool: dropping connection to \"%s\" closed by peer", host);
+	    Close(conns[i].fd);
+	    memmove(&conns[i], &conns[i+1], (nconns-i-1)*sizeof(conns[0]));
+	    --nconns;
+	 }
+      }
+      if (att.sfd.fd >= 0 && pfds[k].revents != 0) {
+	 rc = xiopool_connect_cont(&att, false, us, uslen, themarr,
+				   pf, socktype, protocol, lowport);
+	 if (rc > 0)
+	    xiopool_deadline(&att);
+	 xiopool_connect_end(&att, rc, conns, &nconns, size, &retry,
+			     us, themarr, pf, host);
+      }
+      if (pfds[0].revents & POLLIN) {
+	 xiopool_serve(lfd, conns, &nconns, host, port);
+      }
+   }
+   Info("pool: listening process has terminated");
+}
+
+/* Starts the pool manager in a detached process, unless another child won
+   the race for the socket name. This process does not wait for it and
+   connects itself this time */
+void xiopool_start(struct single *sfd, const char *host, const char *port,
+		   union sockaddr_union *us, socklen_t uslen,
+		   struct addrinfo **themarr, struct opt *opts0,
+		   int pf, int socktype, int protocol, bool lowport) {
+   struct sockaddr_un sa;
+   socklen_t salen;
+   pid_t owner = Getppid();
+   pid_t pid;
+   int status;
+   int lfd;
+
+   if (sfd->para.socket.ip.pool > XIOPOOL_MAX) {
+      Warn2("pool: size %d too large, using %d",
+	    sfd->para.socket.ip.pool, XIOPOOL_MAX);
+      sfd->para.socket.ip.pool = XIOPOOL_MAX;
+   }
+   if ((pid = Fork()) < 0) {
+      Warn1("fork(): %s", strerror(errno));
+      return;
+   }
+   if (pid > 0) {
+      /* the intermediate process terminates at once */
+      Waitpid(pid, &status, 0);
+      return;
+   }
+   if ((pid = Fork()) != 0) {
+      _exit(pid < 0);
+   }
+
+   /* manager process: must neither hold the client connection open nor run
+      the exit handlers */
+   diag_fork();
+   Signal(SIGHUP,  SIG_DFL);
+   Signal(SIGINT,  SIG_DFL);
+   Signal(SIGQUIT, SIG_DFL);
+   Signal(SIGTERM, SIG_DFL);
+   Signal(SIGCHLD, SIG_DFL);
+   if (sock1 != NULL) {
+      if (XIO_RDSTREAM(sock1)->fd >= 0)
+	 Close(XIO_RDSTREAM(sock1)->fd);
+      if (XIO_WRSTREAM(sock1) != XIO_RDSTREAM(sock1) &&
+	  XIO_WRSTREAM(sock1)->fd >= 0)
+	 Close(XIO_WRSTREAM(sock1)->fd);
+   }
+   xiopool_sockaddr(&sa, &salen, owner, host, port);
+   if ((lfd = Socket(PF_UNIX, SOCK_STREAM, 0)) < 0) {
+      Warn1("socket(PF_UNIX, SOCK_STREAM, 0): %s", strerror(errno));
+      diag_flush();
+      _exit(1);
+   }
+   if (Bind(lfd, (struct sockaddr *)&sa, salen) < 0) {
+      /* another child has started the manager meanwhile */
+      Info1("pool: bind(): %s", strerror(errno));
+      diag_flush();
+      _exit(0);
+   }
+   if (Listen(lfd, 64) < 0) {
+      Warn1("pool: listen(): %s", strerror(errno));
+      diag_flush();
+      _exit(1);
+   }
+   xiopool_manage(lfd, owner, sfd, host, port, us, uslen, themarr, opts0,
+		  pf, socktype, protocol, lowport);
+   diag_flush();
+   _exit(0);
+}
+
+#else /* !(WITH_ABSTRACT_UNIXSOCKET && defined(SO_PEERCRED)) */
+
+bool xiopool_applies(void) {
+   Warn("option pool is not supported on this platform");
+   return false;
+}
+
+int xiopool_get(const char *host, const char *port) {
+   errno = ENOSYS;
+   return -1;
+}
+
+void xiopool_start(struct single *sfd, const char *host, const char *port,
+		   union sockaddr_union *us, socklen_t uslen,
+		   struct addrinfo **themarr, struct opt *opts0,
+		   int pf, int socktype, int protocol, bool lowport) {
+}
+
+#endif /* !(WITH_ABSTRACT_UNIXSOCKET && defined(SO_PEERCRED)) */
+
+#endif /* WITH_TCP */
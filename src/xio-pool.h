@@ -0,0 +1,19 @@
+/* source: xio-pool.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_pool_h_included
+#define __xio_pool_h_included 1
+
+#if WITH_TCP
+
+extern const struct optdesc opt_pool;
+extern const struct optdesc opt_pool_max_idle;
+
+extern bool xiopool_applies(void);
+extern int xiopool_get(const char *host, const char *port);
+extern void xiopool_start(struct single *sfd, const char *host, const char *port, union sockaddr_union *us, socklen_t uslen, struct addrinfo **themarr, struct opt *opts0, int pf, int socktype, int protocol, bool lowport);
+
+#endif /* WITH_TCP */
+
+#endif /* !defined(__xio_pool_h_included) */
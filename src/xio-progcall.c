@@ -39,6 +39,128 @@ const struct optdesc opt_nofork  = { "nofork",    NULL, OPT_NOFORK,      GROUP_F
 const struct optdesc opt_sighup  = { "sighup",    NULL, OPT_SIGHUP,      GROUP_PARENT, PH_LATE,        TYPE_CONST,      OFUNC_SIGNAL, SIGHUP };
 const struct optdesc opt_sigint  = { "sigint",    NULL, OPT_SIGINT,      GROUP_PARENT, PH_LATE,        TYPE_CONST,      OFUNC_SIGNAL, SIGINT };
 const struct optdesc opt_sigquit = { "sigquit",   NULL, OPT_SIGQUIT,     GROUP_PARENT, PH_LATE,        TYPE_CONST,      OFUNC_SIGNAL, SIGQUIT };
+const struct optdesc opt_inetd   = { "inetd",     NULL, OPT_INETD,       GROUP_FORK,   PH_BIGEN,       TYPE_BOOL,       OFUNC_SPEC };
+#if HAVE_POSIX_SPAWN
+const struct optdesc opt_spawn   = { "spawn",     NULL, OPT_SPAWN,       GROUP_FORK,   PH_BIGEN,       TYPE_BOOL,       OFUNC_SPEC };
+#endif
+
+
+/* checks if the first address can be passed to the child process instead of
+   relaying its data (option inetd): socat must not look at the data, and the
+   first address must be a plain bidirectional stream without options that
+   apply to the transfer.
+   returns true when its fds may become stdin/stdout of the child */
+static bool _xioopen_inetd_ok(int xioflags, short fdi) {
+   struct single *sfd;
+   int i;
+
+   if (!(xioflags & XIO_MAYPASS)) {
+      Info("option inetd: socat has to process the data, relaying");
+      return false;
+   }
+   if ((xioflags & XIO_ACCMODE) != XIO_RDWR) {
+      Info("option inetd: transfer is unidirectional, relaying");
+      return false;
+   }
+   for (i = 0; i < 2; ++i) {
+      sfd = (i == 0 ? XIO_RDSTREAM(sock[0]) : XIO_WRSTREAM(sock[0]));
+      if ((sfd->dtype & XIODATA_READMASK) != XIOREAD_STREAM ||
+	  (sfd->dtype & XIODATA_WRITEMASK) != XIOWRITE_STREAM) {
+	 Info("option inetd: first address is not a plain stream, relaying");
+	 return false;
+      }
+      if (sfd->lineterm != LINETERM_RAW || sfd->ignoreeof ||
+	  sfd->readbytes != 0 || sfd->escape != -1) {
+	 Info("option inetd: first address has transfer options, relaying");
+	 return false;
+      }
+   }
+   if (XIO_GETRDFD(sock[0]) != XIO_GETWRFD(sock[0]) &&
+       XIO_GETWRFD(sock[0]) == fdi) {
+      Info1("option inetd: fd %d is in use, relaying", fdi);
+      return false;
+   }
+   return true;
+}
+
+
+#if HAVE_POSIX_SPAWN
+/* starts the child process with posix_spawn(). The file actions do with the
+   descriptors what the forked child would do: ci becomes fdi, co becomes fdo,
+   the parent's ends pi and po are closed (-1 when not used).
+   returns the pid, 0 when the child needs fork() because of options or fd
+   conflicts, or -1 on error */
+static pid_t _xioopen_spawn(const struct xiospawn *spawn,
+			    int ci, int co, int pi, int po,
+			    short fdi, short fdo, bool withstderr,
+			    struct opt *copts) {
+   posix_spawn_file_actions_t actions;
+   posix_spawnattr_t attr;
+   sigset_t sigdef;
+   const struct opt *opt;
+   pid_t pid;
+   int rc;
+
+   if (spawn == NULL) {
+      Info("address does not support spawn, forking");
+      return 0;
+   }
+   for (opt = copts; opt != NULL && opt->desc != ODESC_END; ++opt) {
+      if (opt->desc != ODESC_DONE && opt->desc != ODESC_ERROR) {
+	 Info1("option \"%s\" must be applied in child process, forking",
+	       opt->desc->defname);
+	 return 0;
+      }
+   }
+   if (delayeduser) {
+      Info("user must be changed in child process, forking");
+      return 0;
+   }
+   if (ci >= 0 && co >= 0 && ci != co && co == fdi) {
+      Info1("fd %d is in use, forking", fdi);
+      return 0;
+   }
+
+   posix_spawn_file_actions_init(&actions);
+   if (ci >= 0 && ci != fdi)
+      posix_spawn_file_actions_adddup2(&actions, ci, fdi);
+   if (co >= 0 && co != fdo)
+      posix_spawn_file_actions_adddup2(&actions, co, fdo);
+   if (pi >= 0 && pi != fdi && pi != fdo)
+      posix_spawn_file_actions_addclose(&actions, pi);
+   if (po >= 0 && po != pi && po != fdi && po != fdo)
+      posix_spawn_file_actions_addclose(&actions, po);
+   if (ci >= 0 && ci != fdi && ci != fdo)
+      posix_spawn_file_actions_addclose(&actions, ci);
+   if (co >= 0 && co != ci && co != fdi && co != fdo)
+      posix_spawn_file_actions_addclose(&actions, co);
+   if (withstderr && fdo != 2)
+      posix_spawn_file_actions_adddup2(&actions, fdo, 2);
+
+   /* the child should have default handling for SIGCHLD */
+   posix_spawnattr_init(&attr);
+   sigemptyset(&sigdef);
+   sigaddset(&sigdef, SIGCHLD);
+   posix_spawnattr_setsigdefault(&attr, &sigdef);
+   posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+
+   Notice1("spawning \"%s\"", spawn->file);
+   if (spawn->search) {
+      rc = Posix_spawnp(&pid, spawn->file, &actions, &attr,
+			spawn->argv, environ);
+   } else {
+      rc = Posix_spawn(&pid, spawn->file, &actions, &attr,
+		       spawn->argv, environ);
+   }
+   posix_spawnattr_destroy(&attr);
+   posix_spawn_file_actions_destroy(&actions);
+   if (rc != 0) {
+      Error2("posix_spawn(\"%s\", ...): %s", spawn->file, strerror(rc));
+      return -1;
+   }
+   return pid;
+}
+#endif /* HAVE_POSIX_SPAWN */
 
 
 /* fork for exec/system, but return before exec'ing.
@@ -50,7 +172,8 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
 		struct single *sfd,
 		   groups_t groups,
 		   struct opt **optsp,	/* in: opts; out: opts for parent/child */
-		   int *duptostderr	/* out: redirect stderr to output fd */
+		   int *duptostderr,	/* out: redirect stderr to output fd */
+		   const struct xiospawn *spawn	/* for option spawn, or NULL */
 		) {
    struct opt *opts;		/* common options */
    struct opt *popts = NULL;	/* parent options */
@@ -77,6 +200,9 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
    bool withstderr = false;
    bool nofork = false;
    bool withfork;
+   bool usespawn = false;
+   bool spawned = false;
+   bool useinetd = false;
    char *tn = NULL;
    int trigger[2]; 	/* [0] watched by parent, [1] closed by child when ready */
 
@@ -86,6 +212,10 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
 
    retropt_bool(opts, OPT_NOFORK, &nofork);
    withfork = !nofork;
+#if HAVE_POSIX_SPAWN
+   retropt_bool(opts, OPT_SPAWN, &usespawn);
+#endif
+   retropt_bool(opts, OPT_INETD, &useinetd);
 
    retropt_bool(opts, OPT_PIPES, &usepipes);
 #if HAVE_PTY
@@ -121,6 +251,23 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
       }
    }
 
+   if (useinetd) {
+      if (nofork) {
+	 Info("option inetd has no effect with nofork");
+	 useinetd = false;
+#if HAVE_PTY
+      } else if (usepty) {
+	 Warn("options \"inetd\" and \"pty\" must not be specified together; ignoring \"inetd\"");
+	 useinetd = false;
+#endif /* HAVE_PTY */
+      } else if (usepipes) {
+	 Warn("options \"inetd\" and \"pipes\" must not be specified together; ignoring \"inetd\"");
+	 useinetd = false;
+      } else {
+	 useinetd = _xioopen_inetd_ok(xioflags, fdi);
+      }
+   }
+
    if (withfork) {
       if (!(xioflags&XIO_MAYCHILD)) {
 	 Error("cannot fork off child process here");
@@ -129,6 +276,9 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
       }
       sfd->flags |= XIO_DOESCHILD;
 
+      if (useinetd) {
+	 Notice("forking off child, passing it the first address");
+      } else {
 #if HAVE_PTY
       Notice2("forking off child, using %s for %s",
 	    &("socket\0\0pipes\0\0\0pty\0\0\0\0\0"[(usepipes<<3)|(usepty<<4)]),
@@ -138,6 +288,7 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
 	      &("socket\0\0pipes\0\0\0"[(usepipes<<3)]),
 	      ddirection[rw]);
 #endif /* HAVE_PTY */
+      }
    }
    applyopts(sfd, -1, opts, PH_PREBIGEN);
 
@@ -214,6 +365,19 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
       }
       /* !withfork */
    } else /* withfork */
+   if (useinetd) {
+      /* the child gets the fds of the first address as they are, socat does
+	 not take part in the transfer and just waits for the child */
+      if ((copts = moveopts(opts, GROUP_ALL&~GROUP_PARENT)) == NULL) {
+	 return -1;
+      }
+      popts = opts;
+      sfd->flags |= XIO_DOESPASS;
+      /* with this, the sigchld handler knows the child */
+      sfd->howtoend = END_CLOSE_KILL;
+      sfd->fd = -1;
+      /* end withfork, inetd */
+   } else
 #if HAVE_PTY
    if (usepty) {
 
@@ -396,7 +560,37 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
 
    xiosetchilddied();	/* set SIGCHLD handler */
 
-   if (withfork) {
+#if HAVE_POSIX_SPAWN
+   if (withfork && usespawn) {
+#if HAVE_PTY
+      if (usepty) {
+	 Info("pseudo terminal must be set up in child process, forking");
+      } else
+#endif /* HAVE_PTY */
+      if (useinetd) {
+	 pid = _xioopen_spawn(spawn,
+			      XIO_GETRDFD(sock[0]), XIO_GETWRFD(sock[0]),
+			      -1, -1, fdi, fdo, withstderr, copts);
+      } else if (usepipes) {
+	 pid = _xioopen_spawn(spawn,
+			      rw != XIO_RDONLY ? wrpip[0] : -1,
+			      rw != XIO_WRONLY ? rdpip[1] : -1,
+			      rw != XIO_WRONLY ? rdpip[0] : -1,
+			      rw != XIO_RDONLY ? wrpip[1] : -1,
+			      fdi, fdo, withstderr, copts);
+      } else {
+	 pid = _xioopen_spawn(spawn,
+			      rw != XIO_RDONLY ? sv[1] : -1,
+			      rw != XIO_WRONLY ? sv[1] : -1,
+			      sv[0], -1, fdi, fdo, withstderr, copts);
+      }
+      if (pid < 0) {
+	 return -1;
+      }
+      spawned = (pid > 0);
+   }
+#endif /* HAVE_POSIX_SPAWN */
+   if (withfork && !spawned) {
       Socketpair(PF_UNIX, SOCK_STREAM, 0, trigger);
       pid = xio_fork(true, E_ERROR, 0);
       if (pid < 0) {
@@ -413,6 +607,39 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
 	    Warn1("signal(SIGCHLD, SIG_DFL): %s", strerror(errno));
 	 }
 
+	 if (useinetd) {
+	    int rdfd = XIO_GETRDFD(sock[0]), wrfd = XIO_GETWRFD(sock[0]);
+
+	    if (rdfd == fdi) {
+	       if (Fcntl_l(fdi, F_SETFD, 0) < 0) {
+		  Warn2("fcntl(%d, F_SETFD, 0): %s", fdi, strerror(errno));
+	       }
+	    } else {
+	       /* make sure that the internal diagnostic socket pair fds do not
+		  conflict with our choices */
+	       diag_reserve_fd(fdi);
+	       if (Dup2(rdfd, fdi) < 0) {
+		  Error3("dup2(%d, %d): %s", rdfd, fdi, strerror(errno));
+		  return -1; }
+	    }
+	    if (wrfd == fdo) {
+	       if (Fcntl_l(fdo, F_SETFD, 0) < 0) {
+		  Warn2("fcntl(%d, F_SETFD, 0): %s", fdo, strerror(errno));
+	       }
+	    } else {
+	       diag_reserve_fd(fdo);
+	       if (Dup2(wrfd, fdo) < 0) {
+		  Error3("dup2(%d, %d): %s", wrfd, fdo, strerror(errno));
+		  return -1; }
+	    }
+	    if (rdfd != fdi && rdfd != fdo)
+	       Close(rdfd);
+	    if (wrfd != rdfd && wrfd != fdi && wrfd != fdo)
+	       Close(wrfd);
+
+	    applyopts(sfd, fdi, copts, PH_LATE);
+	    applyopts(sfd, fdi, copts, PH_LATE2);
+	 } else
 #if HAVE_PTY
 	 if (usepty) {
 	    applyopts_named(tn, copts, PH_PREOPEN);
@@ -576,9 +803,16 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
    }
 
    /* for parent (this is our socat process) */
-   Notice1("forked off child process "F_pid, pid);
-   Close(trigger[1]); 	/* in parent */
+   if (spawned) {
+      Notice1("spawned child process "F_pid, pid);
+   } else {
+      Notice1("forked off child process "F_pid, pid);
+      Close(trigger[1]); 	/* in parent */
+   }
 
+   if (useinetd) {
+      ;	/* socat closes the first address */
+   } else
 #if HAVE_PTY
    if (usepty) {
 #  if 0
@@ -606,7 +840,7 @@ int _xioopen_foxec(int xioflags,	/* XIO_RDONLY etc. */
       return STAT_NORETRY;
    }
 
-   {
+   if (!spawned) {
       struct pollfd fds[1];
       fds[0].fd = trigger[0];
       fds[0].events = POLLIN|POLLHUP;
@@ -18,12 +18,23 @@ extern const struct optdesc opt_nofork;
 extern const struct optdesc opt_sighup;
 extern const struct optdesc opt_sigint;
 extern const struct optdesc opt_sigquit;
+extern const struct optdesc opt_spawn;
+extern const struct optdesc opt_inetd;
+
+/* what the child process executes; lets _xioopen_foxec() start it with
+   posix_spawn() instead of returning in a forked child */
+struct xiospawn {
+   const char *file;	/* program to execute */
+   char *const *argv;	/* its arguments, beginning with argv[0] */
+   bool search;		/* look up file in PATH like execvp() */
+} ;
 
 extern int _xioopen_foxec(int rw,	/* O_RDONLY etc. */
 		struct single *fd,
 			  groups_t groups,
 		struct opt **opts,
-			  int *duptostderr
+			  int *duptostderr,
+			  const struct xiospawn *spawn
 		);
 extern int setopt_path(struct opt *opts, char **path);
 extern
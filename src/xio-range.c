@@ -0,0 +1,305 @@
+/* source: xio-range.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for the range-file option: a table of
+   IPv4/IPv6 networks that is searched with longest prefix match */
+
+#include "xiosysincludes.h"
+#include "xioopen.h"
+
+#include "xio-range.h"
+
+
+#if WITH_TCP || WITH_UDP
+
+const struct optdesc opt_range_file = { "range-file", NULL, OPT_RANGE_FILE, GROUP_RANGE, PH_ACCEPT, TYPE_FILENAME, OFUNC_SPEC };
+
+/* The table consists of two binary tries (IPv4 and IPv6) that share one
+   array of nodes. Children are referenced by their index in the array, index
+   0 (the IPv4 root) can never be a child and thus means "none". Lookup walks
+   at most prefix-length nodes and remembers the verdict of the deepest node
+   that carries one. */
+
+#define XIORANGE_ROOT4 0
+#define XIORANGE_ROOT6 1
+
+struct xiorangenode {
+   unsigned int child[2];
+   signed char verdict;	/* 0: no entry here, 1: allow, -1: deny */
+} ;
+
+struct xiorangetab {
+   char *filename;
+   unsigned int gen;	/* value of xio_rangefile_gen when loaded */
+   struct xiorangenode *nodes;
+   unsigned int numnodes;
+   unsigned int maxnodes;
+   unsigned int numentries;
+} ;
+
+/* incremented by SIGHUP; tables of an older generation are reloaded with the
+   next check */
+static volatile sig_atomic_t xio_rangefile_gen;
+static bool xio_rangefile_havesig;
+static struct sigaction xio_rangefile_oldact;
+
+
+static void xio_rangefile_sighup(int signum) {
+   int _errno = errno;
+   ++xio_rangefile_gen;
+   errno = _errno;
+}
+
+static int xio_rangefile_setsig(void) {
+   struct sigaction act;
+
+   if (xio_rangefile_havesig)
+      return 0;
+   memset(&act, 0, sizeof(act));
+   act.sa_handler = xio_rangefile_sighup;
+   sigemptyset(&act.sa_mask);
+   act.sa_flags = SA_RESTART;
+   if (Sigaction(SIGHUP, &act, &xio_rangefile_oldact) < 0) {
+      Warn1("sigaction(SIGHUP, ...): %s", strerror(errno));
+      return -1;
+   }
+   xio_rangefile_havesig = true;
+   return 0;
+}
+
+/* Child processes do not check peers anymore, so SIGHUP gets back its
+   previous meaning */
+void xio_rangefile_sigrestore(void) {
+   if (!xio_rangefile_havesig)
+      return;
+   Sigaction(SIGHUP, &xio_rangefile_oldact, NULL);
+   xio_rangefile_havesig = false;
+}
+
+
+static void xio_rangetab_free(struct xiorangetab *tab) {
+   if (tab == NULL)
+      return;
+   free(tab->nodes);
+   free(tab->filename);
+   free(tab);
+}
+
+static int xio_rangetab_newnode(struct xiorangetab *tab) {
+   if (tab->numnodes == tab->maxnodes) {
+      struct xiorangenode *nodes;
+      unsigned int maxnodes = 2*tab->maxnodes;
+
+      if ((nodes = Realloc(tab->nodes, maxnodes*sizeof(struct xiorangenode)))
+	  == NULL) {
+	 return -1;
+      }
+      tab->nodes = nodes;
+      tab->maxnodes = maxnodes;
+   }
+   memset(&tab->nodes[tab->numnodes], 0, sizeof(struct xiorangenode));
+   return tab->numnodes++;
+}
+
+/* insert the prefix of <bits> length from addr (network byte order) */
+static int xio_rangetab_insert(struct xiorangetab *tab, unsigned int root,
+			       const unsigned char *addr, unsigned int bits,
+			       int verdict) {
+   unsigned int n = root, i;
+   int b, c;
+
+   for (i = 0; i < bits; ++i) {
+      b = (addr[i>>3] >> (7-(i&7))) & 1;
+      if (tab->nodes[n].child[b] == 0) {
+	 if ((c = xio_rangetab_newnode(tab)) < 0)
+	    return -1;
+	 tab->nodes[n].child[b] = c;
+      }
+      n = tab->nodes[n].child[b];
+   }
+   tab->nodes[n].verdict = verdict;
+   return 0;
+}
+
+static int xio_rangetab_lookup(const struct xiorangetab *tab,
+			       unsigned int root,
+			       const unsigned char *addr, unsigned int bits) {
+   unsigned int n = root, i;
+   int verdict = tab->nodes[n].verdict;
+
+   for (i = 0; i < bits; ++i) {
+      n = tab->nodes[n].child[(addr[i>>3] >> (7-(i&7))) & 1];
+      if (n == 0)
+	 break;
+      if (tab->nodes[n].verdict)
+	 verdict = tab->nodes[n].verdict;
+   }
+   return verdict;
+}
+
+/* parses one line of a range file. Allowed forms are
+   [!]a.b.c.d[/bits] and [!][ip6-address][/bits], also without brackets.
+   Returns 0 on success, 1 for empty line, -1 on syntax error */
+static int xio_rangefile_parseline(struct xiorangetab *tab, char *line) {
+   unsigned char addr[16];
+   char *cp, *endp, *slash;
+   int verdict = 1;
+   unsigned int bits, maxbits;
+   unsigned int root;
+
+   if ((cp = strchr(line, '#')) != NULL)
+      *cp = '\0';
+   while (isspace((unsigned char)*line))  ++line;
+   cp = line+strlen(line);
+   while (cp > line && isspace((unsigned char)cp[-1]))  *--cp = '\0';
+   if (*line == '\0')
+      return 1;
+
+   if (*line == '!') {
+      verdict = -1;
+      ++line;
+      while (isspace((unsigned char)*line))  ++line;
+   }
+   if ((slash = strrchr(line, '/')) != NULL) {
+      *slash++ = '\0';
+      bits = strtoul(slash, &endp, 10);
+      if (*slash == '\0' || *endp != '\0')
+	 return -1;
+   }
+   if (*line == '[') {
+      ++line;
+      if ((cp = strchr(line, ']')) == NULL || cp[1] != '\0')
+	 return -1;
+      *cp = '\0';
+   }
+   if (inet_pton(AF_INET, line, addr) == 1) {
+      root = XIORANGE_ROOT4;  maxbits = 32;
+#if WITH_IP6
+   } else if (inet_pton(AF_INET6, line, addr) == 1) {
+      root = XIORANGE_ROOT6;  maxbits = 128;
+#endif
+   } else {
+      return -1;
+   }
+   if (slash == NULL) {
+      bits = maxbits;
+   } else if (bits > maxbits) {
+      return -1;
+   }
+   if (xio_rangetab_insert(tab, root, addr, bits, verdict) < 0)
+      return -1;
+   ++tab->numentries;
+   return 0;
+}
+
+static struct xiorangetab *xio_rangefile_load(const char *filename) {
+   struct xiorangetab *tab;
+   FILE *fp;
+   char line[256];
+   unsigned int lineno = 0;
+
+   if ((fp = fopen(filename, "r")) == NULL) {
+      Error2("fopen(\"%s\", \"r\"): %s", filename, strerror(errno));
+      return NULL;
+   }
+   if ((tab = Calloc(1, sizeof(struct xiorangetab))) == NULL) {
+      fclose(fp);
+      return NULL;
+   }
+   tab->gen = xio_rangefile_gen;
+   tab->maxnodes = 256;
+   if ((tab->filename = strdup(filename)) == NULL ||
+       (tab->nodes = Calloc(tab->maxnodes, sizeof(struct xiorangenode)))
+       == NULL) {
+      xio_rangetab_free(tab);
+      fclose(fp);
+      return NULL;
+   }
+   tab->numnodes = 2;	/* the two roots */
+
+   while (fgets(line, sizeof(line), fp) != NULL) {
+      ++lineno;
+      if (strchr(line, '\n') == NULL && !feof(fp)) {
+	 Error2("%s:%u: line too long", filename, lineno);
+	 xio_rangetab_free(tab);
+	 fclose(fp);
+	 return NULL;
+      }
+      if (xio_rangefile_parseline(tab, line) < 0) {
+	 Error2("%s:%u: invalid network specification", filename, lineno);
+	 xio_rangetab_free(tab);
+	 fclose(fp);
+	 return NULL;
+      }
+   }
+   fclose(fp);
+   Info4("range file \"%s\": %u networks in %u nodes ("F_Zu" bytes)",
+	 filename, tab->numentries, tab->numnodes,
+	 tab->numnodes*sizeof(struct xiorangenode));
+   return tab;
+}
+
+
+/* returns 0 if option was found and could be applied
+   returns 1 if option was not found
+   returns -1 if option was found but failed */
+int xio_retropt_rangefile(struct single *sfd, struct opt *opts) {
+   char *filename;
+
+   if (retropt_string(opts, OPT_RANGE_FILE, &filename) < 0)
+      return 1;
+   xio_rangetab_free(sfd->para.socket.ip.rangetab);
+   sfd->para.socket.ip.rangetab = xio_rangefile_load(filename);
+   free(filename);
+   if (sfd->para.socket.ip.rangetab == NULL)
+      return -1;
+   xio_rangefile_setsig();
+   return 0;
+}
+
+/* returns -1 if forbidden, 0 if no range file check, or 1 if explicitely
+   allowed */
+int xio_rangefile_check(struct single *sfd, union sockaddr_union *pa) {
+   struct xiorangetab *tab = sfd->para.socket.ip.rangetab;
+   const unsigned char *addr;
+
+   if (tab == NULL)
+      return 0;
+   if (pa == NULL)
+      return -1;
+
+   if (tab->gen != xio_rangefile_gen) {
+      struct xiorangetab *newtab;
+
+      Notice1("reloading range file \"%s\"", tab->filename);
+      if ((newtab = xio_rangefile_load(tab->filename)) == NULL) {
+	 Warn1("keeping previous contents of range file \"%s\"",
+	       tab->filename);
+	 tab->gen = xio_rangefile_gen;
+      } else {
+	 xio_rangetab_free(tab);
+	 sfd->para.socket.ip.rangetab = tab = newtab;
+      }
+   }
+
+   switch (pa->soa.sa_family) {
+#if WITH_IP4
+   case PF_INET:
+      addr = (const unsigned char *)&pa->ip4.sin_addr;
+      return xio_rangetab_lookup(tab, XIORANGE_ROOT4, addr, 32) > 0 ? 1 : -1;
+#endif
+#if WITH_IP6
+   case PF_INET6:
+      addr = (const unsigned char *)&pa->ip6.sin6_addr;
+      if (IN6_IS_ADDR_V4MAPPED(&pa->ip6.sin6_addr)) {
+	 return xio_rangetab_lookup(tab, XIORANGE_ROOT4, addr+12, 32) > 0 ?
+	    1 : -1;
+      }
+      return xio_rangetab_lookup(tab, XIORANGE_ROOT6, addr, 128) > 0 ? 1 : -1;
+#endif
+   }
+   return -1;
+}
+
+#endif /* WITH_TCP || WITH_UDP */
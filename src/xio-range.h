@@ -0,0 +1,20 @@
+/* source: xio-range.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_range_h_included
+#define __xio_range_h_included 1
+
+#if WITH_TCP || WITH_UDP
+
+struct xiorangetab;
+
+extern const struct optdesc opt_range_file;
+
+extern int xio_retropt_rangefile(xiosingle_t *sfd, struct opt *opts);
+extern int xio_rangefile_check(xiosingle_t *sfd, union sockaddr_union *pa);
+extern void xio_rangefile_sigrestore(void);
+
+#endif /* WITH_TCP || WITH_UDP */
+
+#endif /* !defined(__xio_range_h_included) */
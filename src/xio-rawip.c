@@ -13,6 +13,7 @@
 #include "xio-ip.h"
 #include "xio-ip6.h"
 #include "xio-tcpwrap.h"
+#include "xio-range.h"
 
 #include "xio-rawip.h"
 
@@ -184,6 +185,15 @@ static int xioopen_rawip_datagram(
       free(rangename);
    }
 
+#if WITH_TCP || WITH_UDP
+   if (xio_retropt_rangefile(sfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+   if (sfd->para.socket.ip.rangetab != NULL) {
+      sfd->dtype |= XIOREAD_RECV_CHECKRANGE;
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
 #if WITH_LIBWRAP
    xio_retropt_tcpwrap(sfd, opts);
 #endif /* WITH_LIBWRAP */
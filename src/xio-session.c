@@ -0,0 +1,419 @@
+/* source: xio-session.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the source for the session-table option: a datagram
+   server address keeps one process and demultiplexes the incoming packets
+   into sessions by their peer address, instead of forking per packet or
+   per peer */
+
+#include "xiosysincludes.h"
+#include "xioopen.h"
+
+#include "xio-socket.h"
+#include "xio-session.h"
+
+
+#if _WITH_SOCKET
+
+const struct optdesc opt_session_table     = { "session-table",     NULL, OPT_SESSION_TABLE,     GROUP_CHILD, PH_PASTACCEPT, TYPE_BOOL, OFUNC_SPEC };
+const struct optdesc opt_session_max       = { "session-max",       NULL, OPT_SESSION_MAX,       GROUP_CHILD, PH_INIT, TYPE_INT,     OFUNC_OFFSET, XIO_OFFSETOF(para.socket.session.max) };
+const struct optdesc opt_session_timeout   = { "session-timeout",   NULL, OPT_SESSION_TIMEOUT,   GROUP_CHILD, PH_INIT, TYPE_TIMEVAL, OFUNC_OFFSET, XIO_OFFSETOF(para.socket.session.timeout) };
+const struct optdesc opt_session_connected = { "session-connected", NULL, OPT_SESSION_CONNECTED, GROUP_CHILD, PH_INIT, TYPE_BOOL,    OFUNC_OFFSET, XIO_OFFSETOF(para.socket.session.connected) };
+
+/* Sessions are found by a hash over the peer address and port; all sessions
+   are also kept in a list ordered by last activity, so idle ones are found at
+   its head */
+struct xiosessiontab {
+   struct xiosession **hash;
+   unsigned int hashsize;	/* power of 2 */
+   unsigned int num;		/* number of sessions */
+   struct xiosession *oldest, *newest;
+   union sockaddr_union us;	/* address of the listening socket */
+   socklen_t uslen;
+   int proto;			/* for PEER environment variables */
+} ;
+
+#define XIOSESSION_HASHMIN  256
+#define XIOSESSION_HASHMAX  65536
+
+
+/* returns the part of the socket address that identifies the peer */
+static const unsigned char *xiosession_key(const union sockaddr_union *pa,
+					   socklen_t palen, size_t *keylen,
+					   uint16_t *port) {
+   *port = 0;
+   switch (pa->soa.sa_family) {
+#if WITH_IP4
+   case PF_INET:
+      *keylen = sizeof(pa->ip4.sin_addr);
+      *port = pa->ip4.sin_port;
+      return (const unsigned char *)&pa->ip4.sin_addr;
+#endif
+#if WITH_IP6
+   case PF_INET6:
+      *keylen = sizeof(pa->ip6.sin6_addr);
+      *port = pa->ip6.sin6_port;
+      return (const unsigned char *)&pa->ip6.sin6_addr;
+#endif
+   }
+   *keylen = palen;
+   return (const unsigned char *)pa;
+}
+
+/* FNV-1a */
+static unsigned int xiosession_hash(const union sockaddr_union *pa,
+				    socklen_t palen) {
+   const unsigned char *key;
+   size_t keylen, i;
+   uint16_t port;
+   uint32_t h = 2166136261U;
+
+   key = xiosession_key(pa, palen, &keylen, &port);
+   for (i = 0; i < keylen; ++i) {
+      h = (h ^ key[i]) * 16777619U;
+   }
+   h = (h ^ (port & 0xff)) * 16777619U;
+   h = (h ^ (port >> 8)) * 16777619U;
+   return h;
+}
+
+static bool xiosession_match(const struct xiosession *s,
+			     const union sockaddr_union *pa, socklen_t palen) {
+   const unsigned char *k1, *k2;
+   size_t l1, l2;
+   uint16_t p1, p2;
+
+   if (s->peer.soa.sa_family != pa->soa.sa_family)
+      return false;
+   k1 = xiosession_key(&s->peer, s->peerlen, &l1, &p1);
+   k2 = xiosession_key(pa, palen, &l2, &p2);
+   return l1 == l2 && p1 == p2 && !memcmp(k1, k2, l1);
+}
+
+static struct xiosession *xiosession_lookup(struct xiosessiontab *tab,
+					    const union sockaddr_union *pa,
+					    socklen_t palen) {
+   struct xiosession *s;
+
+   s = tab->hash[xiosession_hash(pa, palen) & (tab->hashsize-1)];
+   while (s != NULL && !xiosession_match(s, pa, palen))
+      s = s->hnext;
+   return s;
+}
+
+/* doubles the hash when chains get long; keeps the old one on failure */
+static void xiosession_rehash(struct xiosessiontab *tab) {
+   struct xiosession **hash, *s;
+   unsigned int hashsize = 2*tab->hashsize, h;
+
+   if ((hash = Calloc(hashsize, sizeof(struct xiosession *))) == NULL)
+      return;
+   for (s = tab->oldest; s != NULL; s = s->next) {
+      h = xiosession_hash(&s->peer, s->peerlen) & (hashsize-1);
+      s->hnext = hash[h];
+      hash[h] = s;
+   }
+   free(tab->hash);
+   tab->hash = hash;
+   tab->hashsize = hashsize;
+}
+
+static void xiosession_unlist(struct xiosessiontab *tab, struct xiosession *s) {
+   if (s->prev)  s->prev->next = s->next;  else  tab->oldest = s->next;
+   if (s->next)  s->next->prev = s->prev;  else  tab->newest = s->prev;
+   s->prev = s->next = NULL;
+}
+
+static void xiosession_append(struct xiosessiontab *tab, struct xiosession *s) {
+   s->prev = tab->newest;
+   s->next = NULL;
+   if (tab->newest)  tab->newest->next = s;  else  tab->oldest = s;
+   tab->newest = s;
+}
+
+
+/* retrieves the session-table option.
+   returns 1 if the address is to run in session mode, 0 if not, or -1 on
+   error */
+int xiosession_retropt(struct single *sfd, struct opt *opts, int xioflags,
+		       bool dofork) {
+   bool dosession = false;
+
+   retropt_bool(opts, OPT_SESSION_TABLE, &dosession);
+   if (!dosession)
+      return 0;
+   if (!(xioflags & XIO_MAYSESSION)) {
+      Error("option session-table not allowed here");
+      return -1;
+   }
+   if (dofork) {
+      Error("options fork and session-table are mutually exclusive");
+      return -1;
+   }
+   if (sfd->para.socket.session.max < 0) {
+      Error1("session-max=%d: value must not be negative",
+	     sfd->para.socket.session.max);
+      return -1;
+   }
+   if (sfd->para.socket.session.timeout.tv_sec == 0 &&
+       sfd->para.socket.session.timeout.tv_usec == 0) {
+      sfd->para.socket.session.timeout.tv_sec = 60;
+   }
+   sfd->flags |= XIO_DOESSESSION;
+   return 1;
+}
+
+/* creates the session table of an opened and bound datagram socket.
+   returns 0 on success, -1 on error */
+int xiosession_prepare(struct single *sfd, int proto) {
+   struct xiosessiontab *tab;
+   unsigned int hashsize = XIOSESSION_HASHMIN;
+
+   while (hashsize < XIOSESSION_HASHMAX &&
+	  hashsize < (unsigned int)sfd->para.socket.session.max) {
+      hashsize <<= 1;
+   }
+   if ((tab = Calloc(1, sizeof(struct xiosessiontab))) == NULL)
+      return -1;
+   if ((tab->hash = Calloc(hashsize, sizeof(struct xiosession *))) == NULL) {
+      free(tab);
+      return -1;
+   }
+   tab->hashsize = hashsize;
+   tab->proto = proto;
+   tab->uslen = sizeof(tab->us);
+   if (Getsockname(sfd->fd, &tab->us.soa, &tab->uslen) < 0) {
+      Warn4("getsockname(%d, %p, {"F_socklen"}): %s",
+	    sfd->fd, &tab->us.soa, tab->uslen, strerror(errno));
+      tab->uslen = 0;
+   }
+   if (sfd->para.socket.session.connected &&
+       (tab->uslen == 0 ||
+	tab->us.soa.sa_family != PF_INET && tab->us.soa.sa_family != PF_INET6)) {
+      Warn("option session-connected only supported with IP sockets");
+      sfd->para.socket.session.connected = false;
+   }
+   sfd->para.socket.session.tab = tab;
+   Info3("session table: max %d sessions, idle timeout "F_tv_sec"s%s",
+	 sfd->para.socket.session.max,
+	 sfd->para.socket.session.timeout.tv_sec,
+	 sfd->para.socket.session.connected?", connected sockets":"");
+   return 0;
+}
+
+/* receives one packet on the listening socket without blocking.
+   Returns the number of bytes and the existing session in *sess, or
+   NULL in *sess when the packet starts a new (permitted) session; the peer
+   address is returned in pa, palen.
+   Returns 0 when the packet was dropped, or -1 on error (EAGAIN when no
+   packet was waiting) */
+ssize_t xiosession_recv(struct single *sfd, void *buff, size_t bufsiz,
+			union sockaddr_union *pa, socklen_t *palen,
+			struct xiosession **sess) {
+   struct xiosessiontab *tab = sfd->para.socket.session.tab;
+   char infobuff[256];
+   ssize_t bytes;
+
+   *sess = NULL;
+   *palen = sizeof(union sockaddr_union);
+   do {
+      bytes = Recvfrom(sfd->fd, buff, bufsiz, MSG_DONTWAIT, &pa->soa, palen);
+   } while (bytes < 0 && errno == EINTR);
+   if (bytes < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+	 Warn4("recvfrom(%d, %p, "F_Zu", ...): %s",
+	       sfd->fd, buff, bufsiz, strerror(errno));
+      }
+      return -1;
+   }
+   if (bytes == 0) {
+      Info("dropping empty packet");
+      return 0;
+   }
+   if ((*sess = xiosession_lookup(tab, pa, *palen)) != NULL) {
+      return bytes;
+   }
+
+   sockaddr_info(&pa->soa, *palen, infobuff, sizeof(infobuff));
+   if (sfd->para.socket.session.max > 0 &&
+       tab->num >= (unsigned int)sfd->para.socket.session.max) {
+      Notice2("session table full (%u sessions), dropping packet from %s",
+	      tab->num, infobuff);
+      return 0;
+   }
+   if (xiocheckpeer(sfd, pa, tab->uslen?&tab->us:NULL) < 0) {
+      Notice1("forbidding session from %s", infobuff);
+      return 0;
+   }
+   Info1("permitting session from %s", infobuff);
+   xiosetsockaddrenv("PEER", pa, *palen, tab->proto);
+   return bytes;
+}
+
+/* creates a session entry for a permitted peer, with option
+   session-connected also its connected socket.
+   returns the new session, or NULL on error */
+struct xiosession *xiosession_new(struct single *sfd,
+				  const union sockaddr_union *pa,
+				  socklen_t palen) {
+   struct xiosessiontab *tab = sfd->para.socket.session.tab;
+   struct xiosession *s;
+   unsigned int h;
+
+   if ((s = Calloc(1, sizeof(struct xiosession))) == NULL)
+      return NULL;
+   memcpy(&s->peer, pa, palen);
+   s->peerlen = palen;
+   s->fd = -1;
+
+   if (sfd->para.socket.session.connected) {
+      char infobuff[256];
+      int one = 1;
+
+      /* the kernel prefers the connected socket for packets of this peer,
+	 so they no longer pass the listener */
+      if ((s->fd = Socket(tab->us.soa.sa_family, SOCK_DGRAM, tab->proto)) < 0) {
+	 Warn1("session-connected: %s, using listening socket",
+	       strerror(errno));
+      } else if (Setsockopt(s->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one))
+		 < 0 ||
+		 Bind(s->fd, &tab->us.soa, tab->uslen) < 0 ||
+		 Connect(s->fd, &pa->soa, palen) < 0) {
+	 Warn2("session-connected to %s: %s, using listening socket",
+	       sockaddr_info(&pa->soa, palen, infobuff, sizeof(infobuff)),
+	       strerror(errno));
+	 Close(s->fd);
+	 s->fd = -1;
+      } else {
+	 Fcntl_l(s->fd, F_SETFD, FD_CLOEXEC);
+      }
+   }
+
+   h = xiosession_hash(pa, palen) & (tab->hashsize-1);
+   s->hnext = tab->hash[h];
+   tab->hash[h] = s;
+   Gettimeofday(&s->last, NULL);
+   xiosession_append(tab, s);
+   ++tab->num;
+   if (tab->num > 2*tab->hashsize && tab->hashsize < XIOSESSION_HASHMAX)
+      xiosession_rehash(tab);
+   return s;
+}
+
+/* receives one packet on the connected socket of a session without
+   blocking. returns the number of bytes, or -1 on error */
+ssize_t xiosession_recvflow(struct single *sfd, struct xiosession *s,
+			    void *buff, size_t bufsiz) {
+   ssize_t bytes;
+
+   do {
+      bytes = Recv(s->fd, buff, bufsiz, MSG_DONTWAIT);
+   } while (bytes < 0 && errno == EINTR);
+   if (bytes < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+      Info4("recv(%d, %p, "F_Zu", ...): %s",
+	    s->fd, buff, bufsiz, strerror(errno));
+   }
+   return bytes;
+}
+
+/* sends a packet to the peer of the session without blocking; when the
+   socket buffer is full the packet is dropped */
+ssize_t xiosession_send(struct single *sfd, struct xiosession *s,
+			const void *buff, size_t bytes) {
+   ssize_t written;
+   char infobuff[256];
+
+   do {
+      if (s->fd >= 0) {
+	 written = Send(s->fd, buff, bytes, MSG_DONTWAIT);
+      } else {
+	 written = Sendto(sfd->fd, buff, bytes, MSG_DONTWAIT,
+			  &s->peer.soa, s->peerlen);
+      }
+   } while (written < 0 && errno == EINTR);
+   if (written < 0) {
+      Warn3("sending "F_Zu" bytes to %s: %s", bytes,
+	    sockaddr_info(&s->peer.soa, s->peerlen,
+			  infobuff, sizeof(infobuff)),
+	    strerror(errno));
+   }
+   return written;
+}
+
+/* marks the session as active now */
+void xiosession_touch(struct single *sfd, struct xiosession *s) {
+   struct xiosessiontab *tab = sfd->para.socket.session.tab;
+
+   Gettimeofday(&s->last, NULL);
+   if (tab->newest != s) {
+      xiosession_unlist(tab, s);
+      xiosession_append(tab, s);
+   }
+}
+
+/* for iterating over all sessions via the next member */
+struct xiosession *xiosession_first(struct single *sfd) {
+   return sfd->para.socket.session.tab->oldest;
+}
+
+/* returns the oldest session when its idle timeout has expired, otherwise
+   NULL and the time until the next expiry in *wait (tv_sec=-1 when there
+   are no sessions) */
+struct xiosession *xiosession_expired(struct single *sfd,
+				      struct timeval *wait) {
+   struct xiosessiontab *tab = sfd->para.socket.session.tab;
+   struct timeval now, end;
+
+   if (tab->oldest == NULL) {
+      wait->tv_sec = -1;  wait->tv_usec = 0;
+      return NULL;
+   }
+   Gettimeofday(&now, NULL);
+   end.tv_sec  = tab->oldest->last.tv_sec  + sfd->para.socket.session.timeout.tv_sec;
+   end.tv_usec = tab->oldest->last.tv_usec + sfd->para.socket.session.timeout.tv_usec;
+   if (end.tv_usec >= 1000000) {
+      ++end.tv_sec;  end.tv_usec -= 1000000;
+   }
+   if (now.tv_sec > end.tv_sec ||
+       now.tv_sec == end.tv_sec && now.tv_usec >= end.tv_usec) {
+      return tab->oldest;
+   }
+   wait->tv_sec  = end.tv_sec  - now.tv_sec;
+   wait->tv_usec = end.tv_usec - now.tv_usec;
+   if (wait->tv_usec < 0) {
+      --wait->tv_sec;  wait->tv_usec += 1000000;
+   }
+   return NULL;
+}
+
+/* removes the session from the table and closes its connected socket; the
+   upstream must be closed by the caller */
+void xiosession_del(struct single *sfd, struct xiosession *s) {
+   struct xiosessiontab *tab = sfd->para.socket.session.tab;
+   struct xiosession **sp;
+
+   sp = &tab->hash[xiosession_hash(&s->peer, s->peerlen) & (tab->hashsize-1)];
+   while (*sp != NULL && *sp != s)  sp = &(*sp)->hnext;
+   if (*sp != NULL)  *sp = s->hnext;
+   xiosession_unlist(tab, s);
+   --tab->num;
+   if (s->fd >= 0)
+      Close(s->fd);
+   free(s->pend);
+   free(s);
+}
+
+void xiosession_free(struct single *sfd) {
+   struct xiosessiontab *tab = sfd->para.socket.session.tab;
+
+   if (tab == NULL)
+      return;
+   while (tab->oldest != NULL)
+      xiosession_del(sfd, tab->oldest);
+   free(tab->hash);
+   free(tab);
+   sfd->para.socket.session.tab = NULL;
+}
+
+#endif /* _WITH_SOCKET */
@@ -0,0 +1,46 @@
+/* source: xio-session.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_session_h_included
+#define __xio_session_h_included 1
+
+#if _WITH_SOCKET
+
+/* one datagram flow of a session-table address, identified by peer address */
+struct xiosession {
+   union sockaddr_union peer;
+   socklen_t peerlen;
+   int fd;		/* connected per-flow socket, or -1 */
+   xiofile_t *upstream;	/* the other address, opened for this flow */
+   pid_t pid;		/* child process serving upstream, or 0 */
+   struct timeval last;	/* time of last activity */
+   struct timeval closing;	/* end of the closing timeout, or 0 */
+   bool upeof;		/* upstream reached EOF */
+   bool shutwr;		/* upstream was shut down for writing */
+   unsigned char *pend;	/* packet not yet completely written upstream */
+   size_t pendlen;
+   struct xiosession *hnext;	/* hash chain */
+   struct xiosession *prev, *next;	/* LRU list, oldest first */
+} ;
+
+extern const struct optdesc opt_session_table;
+extern const struct optdesc opt_session_max;
+extern const struct optdesc opt_session_timeout;
+extern const struct optdesc opt_session_connected;
+
+extern int xiosession_retropt(struct single *sfd, struct opt *opts, int xioflags, bool dofork);
+extern int xiosession_prepare(struct single *sfd, int proto);
+extern ssize_t xiosession_recv(struct single *sfd, void *buff, size_t bufsiz, union sockaddr_union *pa, socklen_t *palen, struct xiosession **sess);
+extern struct xiosession *xiosession_new(struct single *sfd, const union sockaddr_union *pa, socklen_t palen);
+extern ssize_t xiosession_recvflow(struct single *sfd, struct xiosession *s, void *buff, size_t bufsiz);
+extern ssize_t xiosession_send(struct single *sfd, struct xiosession *s, const void *buff, size_t bytes);
+extern void xiosession_touch(struct single *sfd, struct xiosession *s);
+extern struct xiosession *xiosession_first(struct single *sfd);
+extern struct xiosession *xiosession_expired(struct single *sfd, struct timeval *wait);
+extern void xiosession_del(struct single *sfd, struct xiosession *s);
+extern void xiosession_free(struct single *sfd);
+
+#endif /* _WITH_SOCKET */
+
+#endif /* !defined(__xio_session_h_included) */
@@ -35,6 +35,8 @@ static int xioopen_shell(
 	char *shellpath = NULL;
 	const char *shellname;
 	const char *string = argv[1];
+	char *spawnargv[4];
+	struct xiospawn spawn;
 
 	if (argc != 2) {
 		xio_syntax(argv[0], 1, argc-1, addrdesc->syntax);
@@ -56,7 +58,18 @@ static int xioopen_shell(
 	}
 	++shellname;
 
-	status = _xioopen_foxec(xioflags, sfd, addrdesc->groups, &opts, &duptostderr);
+	spawnargv[0] = (char *)shellname;
+	spawnargv[1] = "-c";
+	spawnargv[2] = (char *)string;
+	spawnargv[3] = NULL;
+	spawn.file   = shellpath;
+	spawn.argv   = spawnargv;
+	spawn.search = false;
+	/* the child sets SHELL when option shell changed it */
+	status = _xioopen_foxec(xioflags, sfd, addrdesc->groups, &opts, &duptostderr,
+				getenv("SHELL") != NULL &&
+				!strcmp(getenv("SHELL"), shellpath) ?
+				&spawn : NULL);
 	if (status < 0)  return status;
 	if (status == 0) {	/* child */
 		int numleft;
@@ -0,0 +1,762 @@
+/* source: xio-shmring.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* This file contains the source for the SHM-RING address: a pair of single
+   producer single consumer byte rings in a shared memory file, for low
+   latency data exchange between two local processes. The layout is described
+   in xio-shmring.h */
+
+#include "xiosysincludes.h"
+#include "xioopen.h"
+
+#include "xio-named.h"
+#include "xio-shmring.h"
+
+
+#if WITH_SHMRING
+
+#define XIOSHMRING_DEFAULT_SIZE	65536
+#define XIOSHMRING_MAX_SIZE	0x40000000
+
+static int xioopen_shmring(int argc, const char *argv[], struct opt *opts, int xioflags, xiofile_t *xfd, const struct addrdesc *addrdesc);
+
+const struct addrdesc xioaddr_shmring = { "SHM-RING", 3, xioopen_shmring, GROUP_FD|GROUP_NAMED|GROUP_SHMRING|GROUP_RETRY, 0, 0, 0 HELP(":<filename>") };
+
+const struct optdesc opt_shmring_size = { "shm-size", NULL, OPT_SHM_SIZE, GROUP_SHMRING, PH_INIT, TYPE_SIZE_T, OFUNC_SPEC };
+
+
+static int _xioshmring_unlink(const char *name, int level) {
+   char bellname[PATH_MAX];
+   int i;
+
+   if (Unlink(name) < 0 && errno != ENOENT) {
+      Msg2(level, "unlink(\"%s\"): %s", name, strerror(errno));
+   }
+   for (i = 0; i < 4; ++i) {
+      snprintf(bellname, sizeof(bellname), "%s.%d", name, i);
+      if (Unlink(bellname) < 0 && errno != ENOENT) {
+	 Msg2(level, "unlink(\"%s\"): %s", bellname, strerror(errno));
+      }
+   }
+   return 0;
+}
+
+static int _xioshmring_futex(uint32_t *addr, int op, uint32_t val,
+			     const struct timespec *timeout) {
+   return syscall(SYS_futex, addr, op, val, timeout, NULL, 0);
+}
+
+/* Writes a byte to the doorbell FIFO; when it is already full the reader
+   will be woken anyway */
+static void _xioshmring_ring(int fd) {
+   char c = '\0';
+
+   if (Write(fd, &c, 1) < 0 && errno != EAGAIN) {
+      Warn2("write(%d, \"\", 1): %s", fd, strerror(errno));
+   }
+}
+
+static void _xioshmring_drain(int fd) {
+   char buff[4096];
+
+   while (Read(fd, buff, sizeof(buff)) == sizeof(buff)) ;
+}
+
+/* Fills the space doorbell FIFO of a full ring, so poll() does not report it
+   writable until the consumer has drained it */
+static void _xioshmring_fill(int fd) {
+   static const char buff[4096];
+
+   while (Write(fd, buff, sizeof(buff)) > 0) ;
+   /* EPIPE: the consumer has just terminated, poll() reports an error */
+   if (errno != EAGAIN && errno != EPIPE) {
+      Warn3("write(%d, ..., "F_Zu"): %s", fd, sizeof(buff), strerror(errno));
+   }
+}
+
+/* Returns the pid of the process on the given side when it has terminated,
+   else 0. With a pidfd of that process (>= 0) its state is taken from the
+   pidfd, which a reused pid does not fool; otherwise both processes must be
+   in the same PID namespace */
+static pid_t _xioshmring_dead(struct xioshmring *shm, int side, int pidfd) {
+   pid_t pid = __atomic_load_n(&shm->pid[side], __ATOMIC_ACQUIRE);
+   struct pollfd fds;
+   struct timeval zero = { 0, 0 };
+
+   if (pid <= 0)
+      return 0; 	/* not attached yet */
+   if (pidfd >= 0) {
+      /* a pidfd becomes readable when the process terminates */
+      fds.fd = pidfd;
+      fds.events = POLLIN;
+      fds.revents = 0;
+      if (xiopoll(&fds, 1, &zero) > 0 && (fds.revents & POLLIN))
+	 return pid;
+      return 0;
+   }
+   if (Kill(pid, 0) < 0 && errno == ESRCH)
+      return pid;
+   return 0;
+}
+
+/* Adds a pidfd of the peer process to the epoll fd that socat polls, so
+   poll() reports the termination of the peer. Without epoll or pidfd_open()
+   (Linux 5.3) it is only detected when the ring is read or written */
+static void _xioshmring_watch(struct single *sfd) {
+#if HAVE_SYS_EPOLL_H && defined(SYS_pidfd_open)
+   struct epoll_event ev;
+   pid_t pid;
+   int pidfd;
+
+   if (sfd->para.shmring.pidfd != -1)
+      return;
+   pid = __atomic_load_n(&sfd->para.shmring.shm->pid[1-sfd->para.shmring.side],
+			 __ATOMIC_ACQUIRE);
+   if (pid <= 0)
+      return;
+   sfd->para.shmring.pidfd = -2;
+   if ((pidfd = syscall(SYS_pidfd_open, pid, 0)) < 0) {
+      Info2("pidfd_open("F_pid", 0): %s", pid, strerror(errno));
+      return;
+   }
+   memset(&ev, 0, sizeof(ev));
+   ev.events = EPOLLIN;
+   ev.data.fd = pidfd;
+   if (epoll_ctl(sfd->fd, EPOLL_CTL_ADD, pidfd, &ev) < 0) {
+      Info3("epoll_ctl(%d, EPOLL_CTL_ADD, %d, ...): %s",
+	    sfd->fd, pidfd, strerror(errno));
+      Close(pidfd);
+      return;
+   }
+   sfd->para.shmring.pidfd = pidfd;
+#endif /* HAVE_SYS_EPOLL_H && defined(SYS_pidfd_open) */
+}
+
+/* A file left by processes that did not remove it (option unlink-close) is
+   stale when its creator or the attached process has terminated; the ring
+   cannot be used again. Removes it unless another process has already
+   replaced it. fd is open on the stale file.
+   Returns STAT_RETRYNOW to create the file again, or STAT_RETRYLATER */
+static int _xioshmring_remove_stale(const char *name, int fd, pid_t pid,
+				    int level) {
+   struct stat fbuf, nbuf;
+   struct flock l;
+
+   /* serializes processes that found the same stale file */
+   memset(&l, 0, sizeof(l));
+   l.l_type   = F_WRLCK;
+   l.l_whence = SEEK_SET;
+   l.l_start  = 0;
+   l.l_len    = 1;
+   while (Fcntl_lock(fd, F_SETLKW, &l) < 0) {
+      if (errno != EINTR) {
+	 Msg2(level, "fcntl(%d, F_SETLKW, ...): %s", fd, strerror(errno));
+	 return STAT_RETRYLATER;
+      }
+   }
+   if (Fstat(fd, &fbuf) < 0 || Stat(name, &nbuf) < 0 ||
+       fbuf.st_dev != nbuf.st_dev || fbuf.st_ino != nbuf.st_ino) {
+      /* removed or replaced meanwhile */
+      return STAT_RETRYNOW;
+   }
+   Notice2("\"%s\": process "F_pid" of a previous session has terminated, creating the shared memory ring again",
+	   name, pid);
+   if (Unlink(name) < 0) {
+      Msg2(level, "unlink(\"%s\"): %s", name, strerror(errno));
+      return STAT_RETRYLATER;
+   }
+   _xioshmring_unlink(name, E_WARN);
+   return STAT_RETRYNOW;
+}
+
+/* Opens the doorbell FIFOs, <name>.<ring> for data and <name>.<2+ring> for
+   space. The data doorbells are opened O_RDWR, which never blocks and keeps
+   a FIFO from reporting EOF. The space doorbell of the own ring is opened
+   for writing only and that of the peer's ring for reading only, so poll()
+   reports an error to a producer whose consumer has terminated; the creator
+   keeps a read end of its space doorbell in *rdfd until the peer has
+   attached.
+   Returns 0 on success, or -1 */
+static int _xioshmring_bells(const char *name, int side, int bell[4],
+			     int *rdfd) {
+   char bellname[PATH_MAX];
+   int flags;
+   int i;
+
+   *rdfd = -1;
+   for (i = 0; i < 4; ++i) {
+      snprintf(bellname, sizeof(bellname), "%s.%d", name, i);
+      if (i < 2) {
+	 flags = O_RDWR;
+      } else if (i == 2+side) {
+	 flags = O_WRONLY;
+	 if (side == 0 &&
+	     (*rdfd = Open(bellname, O_RDONLY|O_NONBLOCK|O_CLOEXEC, 0)) < 0) {
+	    Error2("open(\"%s\", O_RDONLY|O_NONBLOCK): %s",
+		   bellname, strerror(errno));
+	    break;
+	 }
+      } else {
+	 flags = O_RDONLY;
+      }
+      if ((bell[i] = Open(bellname, flags|O_NONBLOCK|O_CLOEXEC, 0)) < 0) {
+	 Error3("open(\"%s\", 0%o): %s", bellname, flags|O_NONBLOCK,
+		strerror(errno));
+	 break;
+      }
+#ifdef F_SETPIPE_SZ
+      /* a small space doorbell is filled with few writes */
+      if (i >= 2)
+	 Fcntl_l(bell[i], F_SETPIPE_SZ, 4096);
+#endif
+   }
+   if (i < 4) {
+      while (--i >= 0)  Close(bell[i]);
+      if (*rdfd >= 0)  Close(*rdfd);
+      *rdfd = -1;
+      return -1;
+   }
+   return 0;
+}
+
+/* Creates the file, or attaches to a file created by the peer.
+   Returns STAT_OK, STAT_RETRYNOW after removing a stale file,
+   STAT_RETRYLATER, or STAT_NORETRY */
+static int _xioopen_shmring(
+	struct single *sfd,
+	const char *name,
+	size_t size,
+	mode_t mode,
+	int level)
+{
+   char bellname[PATH_MAX];
+   int bell[4], bellrdfd;
+   struct stat buf;
+   struct xioshmring *shm;
+   size_t mapsize;
+   uint32_t expected;
+   struct timespec pause = { 0, 10000000 };
+   pid_t dead;
+   int fd, i, side, tries;
+   int epfd;
+   int result;
+
+   if ((fd = Open(name, O_RDWR|O_CREAT|O_EXCL|O_CLOEXEC, mode)) >= 0) {
+      side = 0;
+      for (i = 0; i < 4; ++i) {
+	 snprintf(bellname, sizeof(bellname), "%s.%d", name, i);
+	 if (Mkfifo(bellname, mode) < 0 && errno != EEXIST) {
+	    Error2("mkfifo(\"%s\", ...): %s", bellname, strerror(errno));
+	    Close(fd);
+	    _xioshmring_unlink(name, E_WARN);
+	    return STAT_NORETRY;
+	 }
+      }
+      mapsize = sizeof(struct xioshmring) + 2*size;
+      if (Ftruncate(fd, mapsize) < 0) {
+	 Error3("ftruncate(%d, "F_Zu"): %s", fd, mapsize, strerror(errno));
+	 Close(fd);
+	 _xioshmring_unlink(name, E_WARN);
+	 return STAT_NORETRY;
+      }
+   } else if (errno == EEXIST) {
+      side = 1;
+      if ((fd = Open(name, O_RDWR|O_CLOEXEC, 0)) < 0) {
+	 Msg2(level, "open(\"%s\", O_RDWR): %s", name, strerror(errno));
+	 return STAT_RETRYLATER;
+      }
+      /* the creator might just be initializing the file */
+      for (tries = 100; ; --tries) {
+	 if (Fstat(fd, &buf) < 0) {
+	    Error3("fstat(%d, %p): %s", fd, &buf, strerror(errno));
+	    Close(fd);
+	    return STAT_NORETRY;
+	 }
+	 if (buf.st_size >= sizeof(struct xioshmring) || tries == 0)
+	    break;
+	 Nanosleep(&pause, NULL);
+      }
+      if (buf.st_size < sizeof(struct xioshmring)) {
+	 Msg1(level, "\"%s\": shared memory ring has not been initialized", name);
+	 Close(fd);
+	 return STAT_RETRYLATER;
+      }
+      mapsize = buf.st_size;
+   } else {
+      Msg2(level, "open(\"%s\", O_RDWR|O_CREAT|O_EXCL): %s",
+	   name, strerror(errno));
+      return STAT_RETRYLATER;
+   }
+
+   shm = Mmap(NULL, mapsize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+   if (shm == MAP_FAILED) {
+      Error3("mmap(NULL, "F_Zu", PROT_READ|PROT_WRITE, MAP_SHARED, %d, 0): %s",
+	     mapsize, fd, strerror(errno));
+      Close(fd);
+      if (side == 0)  _xioshmring_unlink(name, E_WARN);
+      return STAT_NORETRY;
+   }
+
+   if (side == 0) {
+      Close(fd);
+      shm->version = XIOSHMRING_VERSION;
+      shm->size = size;
+      shm->attached = 1;
+      shm->pid[0] = Getpid();
+      /* nobody is reading yet, so the first data must ring the doorbell */
+      shm->ring[0].sleeping = 1;
+      shm->ring[1].sleeping = 1;
+      /* the peer opens the write end of the space doorbell of ring 1 */
+      if (_xioshmring_bells(name, side, bell, &bellrdfd) < 0) {
+	 Munmap(shm, mapsize);
+	 _xioshmring_unlink(name, E_WARN);
+	 return STAT_NORETRY;
+      }
+      __atomic_store_n(&shm->magic, XIOSHMRING_MAGIC, __ATOMIC_RELEASE);
+   } else {
+      for (tries = 100;
+	   __atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != XIOSHMRING_MAGIC;
+	   --tries) {
+	 if (tries == 0) {
+	    Msg1(level, "\"%s\": shared memory ring has not been initialized",
+		 name);
+	    Munmap(shm, mapsize);
+	    Close(fd);
+	    return STAT_RETRYLATER;
+	 }
+	 Nanosleep(&pause, NULL);
+      }
+      if (shm->version != XIOSHMRING_VERSION ||
+	  shm->size == 0 || (shm->size & (shm->size-1)) != 0 ||
+	  mapsize != sizeof(struct xioshmring) + 2*(size_t)shm->size) {
+	 Error1("\"%s\": incompatible shared memory ring", name);
+	 Munmap(shm, mapsize);
+	 Close(fd);
+	 return STAT_NORETRY;
+      }
+      if ((dead = _xioshmring_dead(shm, 0, -1)) == 0 &&
+	  __atomic_load_n(&shm->attached, __ATOMIC_ACQUIRE) == 2)
+	 dead = _xioshmring_dead(shm, 1, -1);
+      if (dead != 0) {
+	 Munmap(shm, mapsize);
+	 result = _xioshmring_remove_stale(name, fd, dead, level);
+	 Close(fd);
+	 return result;
+      }
+      Close(fd);
+      /* before attached, so the creator may close its read end of the
+	 space doorbell of ring 0 then */
+      if (_xioshmring_bells(name, side, bell, &bellrdfd) < 0) {
+	 Munmap(shm, mapsize);
+	 return STAT_NORETRY;
+      }
+      expected = 1;
+      if (!__atomic_compare_exchange_n(&shm->attached, &expected, 2, false,
+				       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+	 Msg1(level, "\"%s\": shared memory ring is already in use (use option unlink-early with the first process)", name);
+	 for (i = 0; i < 4; ++i)  Close(bell[i]);
+	 Munmap(shm, mapsize);
+	 return STAT_RETRYLATER;
+      }
+      __atomic_store_n(&shm->pid[1], Getpid(), __ATOMIC_RELEASE);
+   }
+
+   /* socat polls the doorbell of the ring it consumes; with epoll also the
+      termination of the peer */
+   epfd = bell[1-side];
+#if HAVE_SYS_EPOLL_H
+   if ((i = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+      Info1("epoll_create1(EPOLL_CLOEXEC): %s", strerror(errno));
+   } else {
+      struct epoll_event ev;
+
+      memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN;
+      ev.data.fd = bell[1-side];
+      if (epoll_ctl(i, EPOLL_CTL_ADD, bell[1-side], &ev) < 0) {
+	 Info3("epoll_ctl(%d, EPOLL_CTL_ADD, %d, ...): %s",
+	       i, bell[1-side], strerror(errno));
+	 Close(i);
+      } else {
+	 epfd = i;
+      }
+   }
+#endif /* HAVE_SYS_EPOLL_H */
+   sfd->fd = epfd;
+   sfd->para.shmring.rdbellfd = bell[1-side];
+   sfd->para.shmring.bellfd = bell[side];
+   sfd->para.shmring.wrbellfd = bell[2+side];
+   sfd->para.shmring.wrbellrdfd = bellrdfd;
+   sfd->para.shmring.spacebellfd = bell[3-side];
+   sfd->para.shmring.pidfd = (epfd == bell[1-side]) ? -2 : -1;
+   sfd->para.shmring.shm = shm;
+   sfd->para.shmring.mapsize = mapsize;
+   sfd->para.shmring.side = side;
+   _xioshmring_watch(sfd);
+   if (side == 1 &&
+       __atomic_exchange_n(&shm->ring[1].sleeping, 0, __ATOMIC_SEQ_CST)) {
+      /* tell the creator our pid */
+      _xioshmring_ring(bell[1]);
+   }
+   Notice4("%s shared memory ring \"%s\" with 2*"F_Zu" bytes, side %d",
+	   side==0?"created":"attached to", name, (size_t)shm->size, side);
+   return STAT_OK;
+}
+
+static int xioopen_shmring(
+	int argc,
+	const char *argv[],
+	struct opt *opts,
+	int xioflags,
+	xiofile_t *xfd,
+	const struct addrdesc *addrdesc)
+{
+   xiosingle_t *sfd = &xfd->stream;
+   const char *name;
+   size_t size = XIOSHMRING_DEFAULT_SIZE;
+   mode_t mode = 0600;
+   bool unlink_early = false;
+   int stale = 0;
+   int level;
+   int result;
+
+   if (argc != 2) {
+      xio_syntax(argv[0], 1, argc-1, addrdesc->syntax);
+      return STAT_NORETRY;
+   }
+   name = argv[1];
+
+   retropt_size_t(opts, OPT_SHM_SIZE, &size);
+   if (size < 4096 || size > XIOSHMRING_MAX_SIZE || (size & (size-1)) != 0) {
+      Error2("%s: shm-size="F_Zu" must be a power of 2 between 4K and 1G",
+	     argv[0], size);
+      return STAT_NORETRY;
+   }
+
+   applyopts_offset(sfd, opts);
+   if (applyopts_single(sfd, opts, PH_INIT) < 0)  return STAT_NORETRY;
+   applyopts(sfd, -1, opts, PH_INIT);
+
+   retropt_mode(opts, OPT_PERM, &mode);
+
+   retropt_bool(opts, OPT_UNLINK_EARLY, &unlink_early);
+   if (unlink_early) {
+      _xioshmring_unlink(name, E_WARN);
+   }
+   retropt_bool(opts, OPT_UNLINK_CLOSE, &sfd->opt_unlink_close);
+
+   if ((sfd->para.shmring.name = strdup(name)) == NULL) {
+      Error1("strdup(\"%s\"): out of memory", name);
+      return STAT_NORETRY;
+   }
+
+   while (true) {
+#if WITH_RETRY
+      if (sfd->forever || sfd->retry) {
+	 level = E_INFO;
+      } else
+#endif /* WITH_RETRY */
+	 level = E_ERROR;
+
+      result = _xioopen_shmring(sfd, name, size, mode, level);
+      if (result == STAT_RETRYNOW && ++stale < 3)
+	 continue;
+#if WITH_RETRY
+      if (result == STAT_RETRYLATER && (sfd->forever || sfd->retry)) {
+	 --sfd->retry;
+	 Nanosleep(&sfd->intervall, NULL);
+	 continue;
+      }
+#endif /* WITH_RETRY */
+      break;
+   }
+   if (result == STAT_RETRYNOW) {
+      Error1("\"%s\": cannot replace stale shared memory ring", name);
+      result = STAT_RETRYLATER;
+   }
+   if (result != STAT_OK) {
+      free(sfd->para.shmring.name);
+      sfd->para.shmring.name = NULL;
+      return result;
+   }
+
+   if (sfd->howtoend == END_UNSPEC)
+      sfd->howtoend = END_CLOSE;
+   sfd->dtype = XIODATA_SHMRING;
+
+   return _xio_openlate(sfd, opts);
+}
+
+
+/* Copies data from the ring of the peer. Returns 0 on EOF, also when the peer
+   has terminated, and -1 with errno EAGAIN when the ring is empty; the
+   doorbell then wakes poll() when the peer has written more data */
+ssize_t xioread_shmring(
+	struct single *sfd,
+	void *buff,
+	size_t bufsiz)
+{
+   struct xioshmring *shm = sfd->para.shmring.shm;
+   struct xioshmring_ring *r = &shm->ring[1-sfd->para.shmring.side];
+   const char *data = (const char *)(shm+1) + (1-sfd->para.shmring.side)*(size_t)shm->size;
+   uint32_t mask = shm->size - 1;
+   uint32_t head, tail, off;
+   size_t bytes, part;
+   pid_t dead;
+
+   tail = r->tail;
+   while (true) {
+      head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+      if (head != tail)
+	 break;
+      if (__atomic_load_n(&r->closed, __ATOMIC_ACQUIRE)) {
+	 if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == tail) {
+	    Info1("shared memory ring \"%s\": end of data", sfd->para.shmring.name);
+	    return 0;
+	 }
+	 continue;
+      }
+      if ((dead = _xioshmring_dead(shm, 1-sfd->para.shmring.side,
+				   sfd->para.shmring.pidfd)) != 0) {
+	 if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == tail) {
+	    Warn2("shared memory ring \"%s\": peer process "F_pid" has terminated",
+		  sfd->para.shmring.name, dead);
+	    return 0;
+	 }
+	 continue;
+      }
+      _xioshmring_watch(sfd);
+      /* Go to sleep; the doorbell is only drained here, so whenever sleeping
+	 is 0 there is a byte in the doorbell */
+      _xioshmring_drain(sfd->para.shmring.rdbellfd);
+      __atomic_store_n(&r->sleeping, 1, __ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&r->head, __ATOMIC_SEQ_CST) == tail &&
+	  !__atomic_load_n(&r->closed, __ATOMIC_SEQ_CST)) {
+	 errno = EAGAIN;
+	 return -1;
+      }
+   }
+
+   bytes = MIN(bufsiz, (size_t)(head - tail));
+   off = tail & mask;
+   part = MIN(bytes, (size_t)shm->size - off);
+   memcpy(buff, data+off, part);
+   memcpy((char *)buff+part, data, bytes-part);
+   tail += bytes;
+   __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+   if (__atomic_load_n(&r->full, __ATOMIC_RELAXED) &&
+       __atomic_exchange_n(&r->full, 0, __ATOMIC_SEQ_CST)) {
+      _xioshmring_drain(sfd->para.shmring.spacebellfd);
+      _xioshmring_futex(&r->tail, FUTEX_WAKE, 1, NULL);
+   }
+   if (head != tail &&
+       __atomic_exchange_n(&r->sleeping, 0, __ATOMIC_SEQ_CST)) {
+      /* more data than fits in buff: make poll() return again */
+      _xioshmring_ring(sfd->para.shmring.rdbellfd);
+   }
+   return bytes;
+}
+
+/* Returns the number of bytes that can be written to the own ring without
+   waiting. When it is full, the space doorbell is filled so poll() reports
+   the ring writable only after the consumer has made room, and 0 is
+   returned. Returns -1 with errno EPIPE when the consumer does not read
+   anymore */
+ssize_t xiospace_shmring(
+	struct single *sfd)
+{
+   struct xioshmring *shm = sfd->para.shmring.shm;
+   struct xioshmring_ring *r = &shm->ring[sfd->para.shmring.side];
+   uint32_t head = r->head;
+   size_t space;
+   pid_t dead;
+
+   if (sfd->para.shmring.wrbellrdfd >= 0 &&
+       __atomic_load_n(&shm->attached, __ATOMIC_ACQUIRE) == 2) {
+      /* the peer has the read end now */
+      Close(sfd->para.shmring.wrbellrdfd);
+      sfd->para.shmring.wrbellrdfd = -1;
+   }
+   space = shm->size - (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE));
+   if (space > 0)
+      return space;
+   if (__atomic_load_n(&r->gone, __ATOMIC_ACQUIRE)) {
+      Error1("shared memory ring \"%s\": peer does not read anymore",
+	     sfd->para.shmring.name);
+      errno = EPIPE;
+      return -1;
+   }
+   _xioshmring_watch(sfd);
+   if ((dead = _xioshmring_dead(shm, 1-sfd->para.shmring.side,
+				sfd->para.shmring.pidfd)) != 0) {
+      Error2("shared memory ring \"%s\": peer process "F_pid" has terminated",
+	     sfd->para.shmring.name, dead);
+      errno = EPIPE;
+      return -1;
+   }
+   /* fill first: the consumer drains after taking full */
+   _xioshmring_fill(sfd->para.shmring.wrbellfd);
+   __atomic_store_n(&r->full, 1, __ATOMIC_SEQ_CST);
+   space = shm->size - (head - __atomic_load_n(&r->tail, __ATOMIC_SEQ_CST));
+   if (space > 0 && __atomic_exchange_n(&r->full, 0, __ATOMIC_SEQ_CST)) {
+      /* the consumer made room meanwhile but did not see full; the own end
+	 is write only */
+      char bellname[PATH_MAX];
+      int fd;
+
+      snprintf(bellname, sizeof(bellname), "%s.%d", sfd->para.shmring.name,
+	       2+sfd->para.shmring.side);
+      if ((fd = Open(bellname, O_RDONLY|O_NONBLOCK|O_CLOEXEC, 0)) < 0) {
+	 Warn2("open(\"%s\", O_RDONLY|O_NONBLOCK): %s",
+	       bellname, strerror(errno));
+      } else {
+	 _xioshmring_drain(fd);
+	 Close(fd);
+      }
+   }
+   return space;
+}
+
+/* Copies all data into the own ring. socat only passes as much data as
+   xiospace_shmring() reported, other callers wait while the ring is full,
+   like with write() to a pipe */
+ssize_t xiowrite_shmring(
+	struct single *sfd,
+	const void *buff,
+	size_t bytes)
+{
+   struct xioshmring *shm = sfd->para.shmring.shm;
+   struct xioshmring_ring *r = &shm->ring[sfd->para.shmring.side];
+   char *data = (char *)(shm+1) + sfd->para.shmring.side*(size_t)shm->size;
+   uint32_t mask = shm->size - 1;
+   uint32_t head, tail, off;
+   size_t writt = 0, space, chunk, part;
+   /* wake up now and then to handle deferred signals and to check the peer */
+   struct timespec timeout = { 1, 0 };
+   bool waited = false;
+   pid_t dead;
+
+   head = r->head;
+   while (writt < bytes) {
+      if (__atomic_load_n(&r->gone, __ATOMIC_ACQUIRE)) {
+	 Error1("shared memory ring \"%s\": peer does not read anymore",
+		sfd->para.shmring.name);
+	 errno = EPIPE;
+	 return -1;
+      }
+      tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+      space = shm->size - (head - tail);
+      if (space == 0) {
+	 if (waited &&
+	     (dead = _xioshmring_dead(shm, 1-sfd->para.shmring.side,
+				      sfd->para.shmring.pidfd)) != 0) {
+	    Error2("shared memory ring \"%s\": peer process "F_pid" has terminated",
+		   sfd->para.shmring.name, dead);
+	    errno = EPIPE;
+	    return -1;
+	 }
+	 __atomic_store_n(&r->full, 1, __ATOMIC_SEQ_CST);
+	 tail = __atomic_load_n(&r->tail, __ATOMIC_SEQ_CST);
+	 if (shm->size - (head - tail) == 0 &&
+	     !__atomic_load_n(&r->gone, __ATOMIC_SEQ_CST)) {
+	    if (_xioshmring_futex(&r->tail, FUTEX_WAIT, tail, &timeout) < 0 &&
+		errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT) {
+	       Error2("futex(%p, FUTEX_WAIT, ...): %s", &r->tail, strerror(errno));
+	       return -1;
+	    }
+	 }
+	 diag_flush();
+	 waited = true;
+	 continue;
+      }
+      waited = false;
+      chunk = MIN(space, bytes-writt);
+      off = head & mask;
+      part = MIN(chunk, (size_t)shm->size - off);
+      memcpy(data+off, (const char *)buff+writt, part);
+      memcpy(data, (const char *)buff+writt+part, chunk-part);
+      head += chunk;
+      writt += chunk;
+      __atomic_store_n(&r->head, head, __ATOMIC_RELEASE);
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&r->sleeping, __ATOMIC_RELAXED) &&
+	  __atomic_exchange_n(&r->sleeping, 0, __ATOMIC_SEQ_CST)) {
+	 _xioshmring_ring(sfd->para.shmring.bellfd);
+      }
+   }
+   return writt;
+}
+
+/* how: 0 stops reading, 1 stops writing, 2 both */
+int xioshutdown_shmring(
+	struct single *sfd,
+	int how)
+{
+   struct xioshmring *shm = sfd->para.shmring.shm;
+   struct xioshmring_ring *r;
+
+   if (shm == NULL)
+      return 0;
+   if ((how+1)&1) {
+      /* discard what is left and release a producer waiting on a full ring */
+      r = &shm->ring[1-sfd->para.shmring.side];
+      __atomic_store_n(&r->gone, 1, __ATOMIC_SEQ_CST);
+      __atomic_store_n(&r->tail, __atomic_load_n(&r->head, __ATOMIC_ACQUIRE),
+		       __ATOMIC_SEQ_CST);
+      _xioshmring_drain(sfd->para.shmring.spacebellfd);
+      _xioshmring_futex(&r->tail, FUTEX_WAKE, 1, NULL);
+   }
+   if ((how+1)&2) {
+      r = &shm->ring[sfd->para.shmring.side];
+      if (!__atomic_exchange_n(&r->closed, 1, __ATOMIC_SEQ_CST)) {
+	 _xioshmring_ring(sfd->para.shmring.bellfd);
+      }
+   }
+   return 0;
+}
+
+int xioclose_shmring(
+	struct single *sfd)
+{
+   if (sfd->para.shmring.shm == NULL)
+      return 0;
+   xioshutdown_shmring(sfd, 2);
+   if (Munmap(sfd->para.shmring.shm, sfd->para.shmring.mapsize) < 0) {
+      Warn3("munmap(%p, "F_Zu"): %s", sfd->para.shmring.shm,
+	    sfd->para.shmring.mapsize, strerror(errno));
+   }
+   sfd->para.shmring.shm = NULL;
+   if (Close(sfd->para.shmring.bellfd) < 0) {
+      Info2("close(%d): %s", sfd->para.shmring.bellfd, strerror(errno));
+   }
+   if (Close(sfd->para.shmring.wrbellfd) < 0) {
+      Info2("close(%d): %s", sfd->para.shmring.wrbellfd, strerror(errno));
+   }
+   if (Close(sfd->para.shmring.spacebellfd) < 0) {
+      Info2("close(%d): %s", sfd->para.shmring.spacebellfd, strerror(errno));
+   }
+   if (sfd->para.shmring.wrbellrdfd >= 0) {
+      Close(sfd->para.shmring.wrbellrdfd);
+      sfd->para.shmring.wrbellrdfd = -1;
+   }
+   /* fd itself is closed by the caller */
+   if (sfd->para.shmring.rdbellfd != sfd->fd &&
+       Close(sfd->para.shmring.rdbellfd) < 0) {
+      Info2("close(%d): %s", sfd->para.shmring.rdbellfd, strerror(errno));
+   }
+   if (sfd->para.shmring.pidfd >= 0) {
+      Close(sfd->para.shmring.pidfd);
+      sfd->para.shmring.pidfd = -2;
+   }
+   if (sfd->opt_unlink_close) {
+      _xioshmring_unlink(sfd->para.shmring.name, E_WARN);
+   }
+   free(sfd->para.shmring.name);
+   sfd->para.shmring.name = NULL;
+   return 0;
+}
+
+#endif /* WITH_SHMRING */
@@ -0,0 +1,70 @@
+/* source: xio-shmring.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_shmring_h_included
+#define __xio_shmring_h_included 1
+
+/* Layout of the file of address SHM-RING, for applications that exchange
+   data with socat without linking it.
+   The file contains this header, followed by the data of ring 0 and of
+   ring 1. The process that created the file writes ring 0 and reads ring 1,
+   the process that attached does the opposite. head and tail count bytes
+   modulo 2^32, size is a power of 2.
+   A consumer that finds its ring empty may set sleeping and must then check
+   head again; the producer clears sleeping after advancing head and writes
+   a byte to the FIFO <file>.<ring> when it was set; sleeping starts with 1
+   so the first data ring the doorbell. A producer that finds its
+   ring full sets full and waits with FUTEX_WAIT on tail, or it fills the
+   FIFO <file>.<2+ring> first and then waits until that is writable again;
+   the consumer clears full after advancing tail, empties the FIFO, and
+   wakes the producer. The producer opens this FIFO write only and the
+   consumer read only, so the producer's end reports an error when the
+   consumer has terminated. closed is set by the producer after
+   its last data, gone by the consumer when it stops reading; it then sets
+   tail to head to release a waiting producer.
+   pid holds the process ids of both sides, the creator sets its own before
+   magic, the other process after attached; it then rings the doorbell of
+   ring 1 once, so the creator learns its pid. A terminated peer means EOF
+   to a consumer with an empty ring and EPIPE to a producer with a full
+   one. A file whose creator or attached process has terminated is stale and
+   is created again by the next process. */
+#define XIOSHMRING_MAGIC	0x53524e47	/* "SRNG" */
+#define XIOSHMRING_VERSION	3
+
+struct xioshmring_ring {
+   uint32_t head;	/* written by producer */
+   uint32_t closed;	/* producer will not write anymore */
+   uint32_t pad0[14];	/* keep producer and consumer in own cache lines */
+   uint32_t tail;	/* written by consumer, futex for a full ring */
+   uint32_t sleeping;	/* consumer waits for its doorbell */
+   uint32_t full;	/* producer waits on tail */
+   uint32_t gone;	/* consumer will not read anymore */
+   uint32_t pad1[12];
+} ;
+
+struct xioshmring {
+   uint32_t magic;	/* set by the creator when the header is valid */
+   uint32_t version;
+   uint32_t size;	/* bytes of data of each ring */
+   uint32_t attached;	/* 1 with the creator, 2 when the peer attached */
+   int32_t  pid[2];	/* process of side 0 (creator) and side 1 */
+   uint32_t pad[10];
+   struct xioshmring_ring ring[2];
+} ;
+
+#if WITH_SHMRING
+
+extern const struct addrdesc xioaddr_shmring;
+
+extern const struct optdesc opt_shmring_size;
+
+extern ssize_t xioread_shmring(struct single *sfd, void *buff, size_t bufsiz);
+extern ssize_t xiospace_shmring(struct single *sfd);
+extern ssize_t xiowrite_shmring(struct single *sfd, const void *buff, size_t bytes);
+extern int xioshutdown_shmring(struct single *sfd, int how);
+extern int xioclose_shmring(struct single *sfd);
+
+#endif /* WITH_SHMRING */
+
+#endif /* !defined(__xio_shmring_h_included) */
@@ -28,6 +28,8 @@
 #include "xio-interface.h"
 #include "xio-ipapp.h"	/*! not clean */
 #include "xio-tcpwrap.h"
+#include "xio-range.h"
+#include "xio-session.h"
 
 
 static int xioopen_socket_connect(int argc, const char *argv[], struct opt *opts, int xioflags, xiofile_t *xfd, const struct addrdesc *addrdesc);
@@ -549,6 +551,12 @@ int xioopen_socket_recvfrom(
       free(rangename);
    }
 
+#if WITH_TCP || WITH_UDP
+   if (xio_retropt_rangefile(sfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
    if ((result =
 	_xioopen_dgram_recvfrom(sfd, xioflags, &us->soa, uslen,
 				opts, pf, socktype, proto, E_ERROR))
@@ -635,6 +643,12 @@ int xioopen_socket_recv(
       free(rangename);
    }
 
+#if WITH_TCP || WITH_UDP
+   if (xio_retropt_rangefile(sfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
    if ((result =
 	_xioopen_dgram_recv(sfd, xioflags, &us.soa,
 			    uslen, opts, pf, socktype, proto, E_ERROR))
@@ -722,6 +736,15 @@ static int xioopen_socket_datagram(
       free(rangename);
    }
 
+#if WITH_TCP || WITH_UDP
+   if (xio_retropt_rangefile(sfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+   if (sfd->para.socket.ip.rangetab != NULL) {
+      sfd->dtype |= XIOREAD_RECV_CHECKRANGE;
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
    _xio_openlate(sfd, opts);
    return STAT_OK;
 }
@@ -798,28 +821,13 @@ int _xioopen_connect(struct single *sfd, union sockaddr_union *us, size_t uslen,
    int _errno;
    int result;
 
-#if WITH_UNIX
-   if (pf == PF_UNIX && us != NULL) {
-      applyopts_named(us->un.sun_path, opts, PH_EARLY);
-   }
-#endif
-
-   if ((sfd->fd = xiosocket(opts, pf, socktype, protocol, level)) < 0) {
-      return STAT_RETRYLATER;
-   }
-
-   applyopts_offset(sfd, opts);
-   applyopts(sfd, -1, opts, PH_PASTSOCKET);
-   applyopts(sfd, -1, opts, PH_FD);
-
-   applyopts_cloexec(sfd->fd, opts);
-
-   if (xiobind(sfd, us, uslen, opts, pf, alt, level) < 0) {
-      return -1;
+   if ((result =
+	_xioopen_connect_socket(sfd, us, uslen, opts, pf, socktype, protocol,
+				alt, level))
+       != STAT_OK) {
+      return result;
    }
 
-   applyopts(sfd, -1, opts, PH_CONNECT);
-
    if (sfd->para.socket.connect_timeout.tv_sec  != 0 ||
        sfd->para.socket.connect_timeout.tv_usec != 0) {
       fcntl_flags = Fcntl(sfd->fd, F_GETFL);
@@ -932,6 +940,44 @@ int _xioopen_connect(struct single *sfd, union sockaddr_union *us, size_t uslen,
 	      sockaddr_info(&la.soa, themlen, infobuff, sizeof(infobuff)));
    }
 
+   _xioopen_connect_late(sfd, us, opts, pf);
+   return STAT_OK;
+}
+
+/* The part of _xioopen_connect() before the connect() call: creates the
+   socket in sfd->fd, applies options, and binds it.
+   Returns STAT_OK on success */
+int _xioopen_connect_socket(struct single *sfd,
+			    union sockaddr_union *us, size_t uslen,
+			    struct opt *opts, int pf, int socktype,
+			    int protocol, bool alt, int level) {
+#if WITH_UNIX
+   if (pf == PF_UNIX && us != NULL) {
+      applyopts_named(us->un.sun_path, opts, PH_EARLY);
+   }
+#endif
+
+   if ((sfd->fd = xiosocket(opts, pf, socktype, protocol, level)) < 0) {
+      return STAT_RETRYLATER;
+   }
+
+   applyopts_offset(sfd, opts);
+   applyopts(sfd, -1, opts, PH_PASTSOCKET);
+   applyopts(sfd, -1, opts, PH_FD);
+
+   applyopts_cloexec(sfd->fd, opts);
+
+   if (xiobind(sfd, us, uslen, opts, pf, alt, level) < 0) {
+      return -1;
+   }
+
+   applyopts(sfd, -1, opts, PH_CONNECT);
+   return STAT_OK;
+}
+
+/* The part of _xioopen_connect() after the socket has been connected */
+void _xioopen_connect_late(struct single *sfd, union sockaddr_union *us,
+			   struct opt *opts, int pf) {
    applyopts_fchown(sfd->fd, opts);	/* OPT_USER, OPT_GROUP */
    applyopts(sfd, -1, opts, PH_CONNECTED);
 #if WITH_UNIX
@@ -940,8 +986,6 @@ int _xioopen_connect(struct single *sfd, union sockaddr_union *us, size_t uslen,
    }
 #endif
    applyopts(sfd, -1, opts, PH_LATE);
-
-   return STAT_OK;
 }
 
 
@@ -1146,6 +1190,7 @@ int _xioopen_dgram_recvfrom(struct single *sfd, int xioflags,
    char infobuff[256];
    char lisname[256];
    bool drop = false;	/* true if current packet must be dropped */
+   int dosession;
    int result;
 
    retropt_bool(opts, OPT_FORK, &dofork);
@@ -1160,10 +1205,28 @@ int _xioopen_dgram_recvfrom(struct single *sfd, int xioflags,
 
    if (applyopts_single(sfd, opts, PH_INIT) < 0)  return STAT_NORETRY;
 
+   if ((dosession = xiosession_retropt(sfd, opts, xioflags, dofork)) < 0) {
+      return STAT_NORETRY;
+   }
+   if (dosession && (sfd->dtype & XIOREAD_RECV_SKIPIP)) {
+      Error("option session-table not supported with this address type");
+      return STAT_NORETRY;
+   }
+
    if ((sfd->fd = xiosocket(opts, pf, socktype, proto, level)) < 0) {
       return STAT_RETRYLATER;
    }
 
+   /* per session sockets bind to the same address */
+   if (dosession && sfd->para.socket.session.connected) {
+      int one = 1;
+      if (Setsockopt(sfd->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one))
+	  < 0) {
+	 Warn2("setsockopt(%d, SOL_SOCKET, SO_REUSEADDR, {1}, ...): %s",
+	       sfd->fd, strerror(errno));
+      }
+   }
+
    applyopts(sfd, -1, opts, PH_PASTSOCKET);
    /*! applyopts(sfd, -1, opts, PH_FD); */
 
@@ -1214,6 +1277,12 @@ int _xioopen_dgram_recvfrom(struct single *sfd, int xioflags,
       sfd->para.socket.dorange = true;
    }
 
+#if WITH_TCP || WITH_UDP
+   if (xio_retropt_rangefile(sfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
 #if (WITH_TCP || WITH_UDP) && WITH_LIBWRAP
    xio_retropt_tcpwrap(sfd, opts);
 #endif /* && (WITH_TCP || WITH_UDP) && WITH_LIBWRAP */
@@ -1225,6 +1294,17 @@ int _xioopen_dgram_recvfrom(struct single *sfd, int xioflags,
       Info("starting recvfrom loop");
    }
 
+   if (dosession) {
+      /* no packet is consumed here, socat demultiplexes them */
+      if (xiosession_prepare(sfd, proto) < 0) {
+	 return STAT_NORETRY;
+      }
+      sfd->dtype &= ~XIOREAD_RECV_ONESHOT;
+      if ((result = _xio_openlate(sfd, opts)) != 0)
+	 return STAT_NORETRY;
+      return STAT_OK;
+   }
+
    if (dofork) {
       xiosetchilddied();
    }
@@ -1435,6 +1515,12 @@ int _xioopen_dgram_recv(struct single *sfd, int xioflags,
       sfd->para.socket.dorange = true;
    }
 
+#if WITH_TCP || WITH_UDP
+   if (xio_retropt_rangefile(sfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
 #if (WITH_TCP || WITH_UDP) && WITH_LIBWRAP
    xio_retropt_tcpwrap(sfd, opts);
 #endif /* && (WITH_TCP || WITH_UDP) && WITH_LIBWRAP */
@@ -1667,6 +1753,20 @@ int xiocheckpeer(xiosingle_t *sfd,
    }
 #endif /* WITH_IP4 */
 
+#if WITH_TCP || WITH_UDP
+   result = xio_rangefile_check(sfd, pa);
+   if (result < 0) {
+      Warn1("refusing connection from %s due to range-file option",
+	    pa ? sockaddr_info(&pa->soa, 0, infobuff, sizeof(infobuff)) :
+	    "NULL");
+      return -1;
+   } else if (result > 0) {
+      Info1("permitting connection from %s due to range-file option",
+	    sockaddr_info(&pa->soa, 0,
+			  infobuff, sizeof(infobuff)));
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
 #if WITH_TCP || WITH_UDP
    if (sfd->para.socket.ip.dosourceport) {
       if (pa == NULL)  { return -1; }
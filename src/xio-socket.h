@@ -103,6 +103,13 @@ extern int _xioopen_connect(struct single *fd,
 			    struct opt *opts,
 			    int pf, int socktype, int protocol,
 			    bool alt, int level);
+extern int _xioopen_connect_socket(struct single *sfd,
+			    union sockaddr_union *us, size_t uslen,
+			    struct opt *opts, int pf, int socktype,
+			    int protocol, bool alt, int level);
+extern void _xioopen_connect_late(struct single *sfd,
+			    union sockaddr_union *us, struct opt *opts,
+			    int pf);
 
 /* common to xioopen_udp_sendto, ..unix_sendto, ..rawip */
 extern
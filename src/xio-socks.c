@@ -101,7 +101,7 @@ static int xioopen_socks4_connect(
       result =
 	 _xioopen_ipapp_prepare(opts, &opts0, sockdname, socksport,
 				&pf, ipproto,
-				sfd->para.socket.ip.ai_flags,
+				&sfd->para.socket.ip,
 				&themarr, us, &uslen,
 				&needbind, &lowport, socktype);
 
@@ -141,10 +141,10 @@ static int xioopen_socks4_connect(
 
       /* this cannot fork because we retrieved fork option above */
 	 result =
-	    _xioopen_connect(sfd,
+	    _xioopen_ipapp_connect(sfd,
 			     needbind?us:NULL, uslen,
-			     themp->ai_addr, themp->ai_addrlen,
-			     opts, pf?pf:themp->ai_family, socktype, IPPROTO_TCP, lowport, level);
+			     themarr, &i,
+			     opts, pf, socktype, IPPROTO_TCP, lowport, level);
 	 if (result == STAT_OK)
 	    break;
 	   themp = themarr[i++];
@@ -517,6 +517,7 @@ static int xioopen_socks5(
 	bool needbind = false;
 	bool lowport = false;
 	char infobuff[256];
+	int i;
 
 	if (!xioparms.experimental) {
 		Error1("%s: use option --experimental to acknowledge unmature state", argv[0]);
@@ -551,7 +552,7 @@ static int xioopen_socks5(
 
 	result = _xioopen_ipapp_prepare(opts, &opts0, socks_server, socks_port,
 					&pf, ipproto,
-					sfd->para.socket.ip.ai_flags,
+					&sfd->para.socket.ip,
 					&themarr, us, &uslen,
 					&needbind, &lowport, socktype);
 
@@ -568,18 +569,19 @@ static int xioopen_socks5(
 #endif
 
 		/* loop over themarr */
-		themp = themarr[0];
+		i = 0;
+		themp = themarr[i++];
 		while (themp != NULL) {
 			Notice1("opening connection to %s",
 				sockaddr_info(themp->ai_addr, themp->ai_addrlen,
 					      infobuff, sizeof(infobuff)));
-			result = _xioopen_connect(sfd, needbind?us:NULL, sizeof(*us),
-						  themp->ai_addr, themp->ai_addrlen,
-						  opts, pf?pf:themp->ai_family, socktype,
+			result = _xioopen_ipapp_connect(sfd, needbind?us:NULL, sizeof(*us),
+						  themarr, &i,
+						  opts, pf, socktype,
 						  IPPROTO_TCP, lowport, level);
 			if (result == STAT_OK)
 				break;
-			themp = themp->ai_next;
+			themp = themarr[i++];
 			if (themp == NULL)
 				result = STAT_RETRYLATER;
 
@@ -9,6 +9,7 @@
 
 #include "xio-fdnum.h"
 #include "xio-stdio.h"
+#include "xio-cache.h"
 
 
 #if WITH_STDIO
@@ -99,6 +100,12 @@ int xioopen_stdio_bi(xiofile_t *sock) {
       return result;
 
    /* apply options to first FD */
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+   if ((result = _xioopen_cache(sock->dual.stream[0], XIO_RDONLY,
+				sock->dual.stream[0]->opts)) < 0) {
+      return result;
+   }
+#endif
    if ((result =
 	applyopts(sock->dual.stream[0], -1,
 		  sock->dual.stream[0]->opts, PH_ALL))
@@ -115,6 +122,12 @@ int xioopen_stdio_bi(xiofile_t *sock) {
 #endif
 
    /* apply options to second FD */
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+   if ((result = _xioopen_cache(sock->dual.stream[1], XIO_WRONLY,
+				sock->dual.stream[1]->opts)) < 0) {
+      return result;
+   }
+#endif
    if ((result = applyopts(sock->dual.stream[1], -1,
 			   sock->dual.stream[1]->opts, PH_ALL)) < 0) {
       return result;
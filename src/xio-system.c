@@ -32,14 +32,25 @@ static int xioopen_system(
    int duptostderr;
    int result;
    const char *string = argv[1];
+   char *spawnargv[4];
+   struct xiospawn spawn;
 
    if (argc != 2) {
       xio_syntax(argv[0], 1, argc-1, addrdesc->syntax);
       return STAT_NORETRY;
    }
 
+   /* what system() does */
+   spawnargv[0] = "sh";
+   spawnargv[1] = "-c";
+   spawnargv[2] = (char *)string;
+   spawnargv[3] = NULL;
+   spawn.file   = "/bin/sh";
+   spawn.argv   = spawnargv;
+   spawn.search = false;
    status =
-      _xioopen_foxec(xioflags, sfd, addrdesc->groups, &opts, &duptostderr);
+      _xioopen_foxec(xioflags, sfd, addrdesc->groups, &opts, &duptostderr,
+		     &spawn);
    if (status < 0)
       return status;
    if (status == 0) {	/* child */
@@ -76,6 +76,12 @@ const struct optdesc opt_tcp_defer_accept={"tcp-defer-accept","defer-accept",OPT
 #ifdef TCP_WINDOW_CLAMP
 const struct optdesc opt_tcp_window_clamp={"tcp-window-clamp","window-clamp",OPT_TCP_WINDOW_CLAMP,GROUP_IP_TCP,PH_PASTSOCKET,TYPE_INT,OFUNC_SOCKOPT,SOL_TCP,TCP_WINDOW_CLAMP };
 #endif
+#ifdef TCP_FASTOPEN
+const struct optdesc opt_tcp_fastopen={"tcp-fastopen","fastopen",OPT_TCP_FASTOPEN,GROUP_IP_TCP,PH_PASTSOCKET,TYPE_INT,OFUNC_SOCKOPT,SOL_TCP,TCP_FASTOPEN };
+#endif
+#ifdef TCP_FASTOPEN_CONNECT
+const struct optdesc opt_tcp_fastopen_connect={"tcp-fastopen-connect","fastopen-connect",OPT_TCP_FASTOPEN_CONNECT,GROUP_IP_TCP,PH_PASTSOCKET,TYPE_INT,OFUNC_SOCKOPT,SOL_TCP,TCP_FASTOPEN_CONNECT };
+#endif
 #ifdef TCP_INFO
 const struct optdesc opt_tcp_info   = { "tcp-info",     "info", OPT_TCP_INFO,    GROUP_IP_TCP, PH_PASTSOCKET, TYPE_INT, OFUNC_SOCKOPT, SOL_TCP, TCP_INFO };
 #endif
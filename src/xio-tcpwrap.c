@@ -17,6 +17,7 @@
 #if (WITH_TCP || WITH_UDP) && WITH_LIBWRAP
 
 const struct optdesc opt_tcpwrappers = { "tcpwrappers", "tcpwrap", OPT_TCPWRAPPERS, GROUP_RANGE,  PH_ACCEPT, TYPE_STRING_NULL, OFUNC_SPEC };
+const struct optdesc opt_tcpwrap_cache = { "tcpwrap-cache", NULL, OPT_TCPWRAP_CACHE, GROUP_RANGE, PH_ACCEPT, TYPE_BOOL, OFUNC_SPEC };
 const struct optdesc opt_tcpwrap_etc               = { "tcpwrap-etc",               "tcpwrap-dir", OPT_TCPWRAP_ETC,               GROUP_RANGE, PH_ACCEPT, TYPE_FILENAME, OFUNC_SPEC };
 #if defined(HAVE_HOSTS_ALLOW_TABLE)
 const struct optdesc opt_tcpwrap_hosts_allow_table = { "tcpwrap-hosts-allow-table", "allow-table", OPT_TCPWRAP_HOSTS_ALLOW_TABLE, GROUP_RANGE, PH_ACCEPT, TYPE_FILENAME, OFUNC_SPEC };
@@ -42,6 +43,8 @@ int xio_retropt_tcpwrap(
    dolibwrap =
       retropt_string(opts, OPT_TCPWRAPPERS,
 		     &sfd->para.socket.ip.libwrapname) >= 0 || dolibwrap;
+   retropt_bool(opts, OPT_TCPWRAP_CACHE, &sfd->para.socket.ip.tcpwrap_cache);
+   dolibwrap = sfd->para.socket.ip.tcpwrap_cache || dolibwrap;
    dolibwrap =
       retropt_string(opts, OPT_TCPWRAP_ETC,
 		     &sfd->para.socket.ip.tcpwrap_etc) >= 0 || dolibwrap;
@@ -82,6 +85,435 @@ int xio_retropt_tcpwrap(
 }
 
 
+/* Compiled hosts.allow/hosts.deny tables for option tcpwrap-cache.
+   A table is parsed once and parsed again only when the file changes. Only
+   the address based subset of hosts_access(5) is compiled: daemon names,
+   ALL, EXCEPT, n.n.n.n, n.n.n. (prefix), n.n.n.n/m.m.m.m, [ipv6], and
+   [ipv6]/len. When a table contains anything else (host names, LOCAL,
+   wildcards, user@host, shell commands or options...) the table is marked
+   so and the check is left to libwrap. */
+
+enum xio_tcpwrap_toktype {
+   XIO_TCPWRAP_EXCEPT,
+   XIO_TCPWRAP_ALL,
+   XIO_TCPWRAP_NAME,	/* daemon name */
+   XIO_TCPWRAP_STRING,	/* exact client address string */
+   XIO_TCPWRAP_PREFIX,	/* client address string prefix, e.g. "10.1." */
+   XIO_TCPWRAP_NET4,
+   XIO_TCPWRAP_NET6,
+} ;
+
+struct xio_tcpwrap_tok {
+   enum xio_tcpwrap_toktype type;
+   char *str;
+   unsigned int bits;	/* NET6 */
+   union {
+      struct { struct in_addr net, mask; } ip4;
+#if WITH_IP6
+      struct in6_addr ip6;
+#endif
+   } u;
+} ;
+
+struct xio_tcpwrap_rule {
+   unsigned int daemons, ndaemons;	/* index and number of tokens */
+   unsigned int clients, nclients;
+} ;
+
+struct xio_tcpwrap_tab {
+   char *filename;
+   bool exists;
+   struct stat st;	/* of the file when it was parsed */
+   bool unsupported;	/* contains patterns we do not evaluate */
+   struct xio_tcpwrap_tok *toks;
+   unsigned int ntoks, maxtoks;
+   struct xio_tcpwrap_rule *rules;
+   unsigned int nrules, maxrules;
+} ;
+
+static void xio_tcpwrap_tab_clear(struct xio_tcpwrap_tab *tab) {
+   unsigned int i;
+
+   for (i = 0; i < tab->ntoks; ++i) {
+      free(tab->toks[i].str);
+   }
+   tab->ntoks = 0;
+   tab->nrules = 0;
+   tab->unsupported = false;
+   tab->exists = false;
+}
+
+static struct xio_tcpwrap_tok *xio_tcpwrap_newtok(struct xio_tcpwrap_tab *tab) {
+   if (tab->ntoks == tab->maxtoks) {
+      struct xio_tcpwrap_tok *toks;
+      unsigned int maxtoks = tab->maxtoks ? 2*tab->maxtoks : 32;
+
+      if ((toks = Realloc(tab->toks, maxtoks*sizeof(*toks))) == NULL)
+	 return NULL;
+      tab->toks = toks;  tab->maxtoks = maxtoks;
+   }
+   memset(&tab->toks[tab->ntoks], 0, sizeof(struct xio_tcpwrap_tok));
+   return &tab->toks[tab->ntoks++];
+}
+
+/* splits at the first sep character outside of [] like libwrap does, returns
+   the remainder or NULL */
+static char *xio_tcpwrap_split(char *string, int sep) {
+   int inbracket = 0;
+
+   for (; *string; ++string) {
+      if (*string == '[')  inbracket = 1;
+      else if (*string == ']')  inbracket = 0;
+      else if (*string == sep && !inbracket) {
+	 *string = '\0';
+	 return string+1;
+      }
+   }
+   return NULL;
+}
+
+/* returns true if tok consists of digits and dots only */
+static bool xio_tcpwrap_isdotted(const char *tok) {
+   return *tok && strspn(tok, "0123456789.") == strlen(tok);
+}
+
+/* compiles one client list token; returns false for unsupported patterns */
+static bool xio_tcpwrap_clienttok(struct xio_tcpwrap_tok *t, char *tok) {
+   char *slash;
+
+   if (!strcasecmp(tok, "EXCEPT")) {
+      t->type = XIO_TCPWRAP_EXCEPT;  return true;
+   }
+   if (!strcasecmp(tok, "ALL")) {
+      t->type = XIO_TCPWRAP_ALL;  return true;
+   }
+   if (tok[0] == '[') {
+#if WITH_IP6
+      char *end = strchr(tok, ']');
+      char *endp;
+
+      if (end == NULL)
+	 return false;
+      *end = '\0';
+      if (inet_pton(AF_INET6, tok+1, &t->u.ip6) != 1)
+	 return false;
+      t->type = XIO_TCPWRAP_NET6;
+      t->bits = 128;
+      if (end[1] == '/') {
+	 t->bits = strtoul(end+2, &endp, 10);
+	 if (end[2] == '\0' || *endp != '\0' || t->bits > 128)
+	    return false;
+      } else if (end[1] != '\0') {
+	 return false;
+      }
+      return true;
+#else
+      return false;
+#endif
+   }
+   if ((slash = strchr(tok, '/')) != NULL) {
+      *slash = '\0';
+      if (!xio_tcpwrap_isdotted(tok) || !xio_tcpwrap_isdotted(slash+1) ||
+	  inet_pton(AF_INET, tok, &t->u.ip4.net) != 1 ||
+	  inet_pton(AF_INET, slash+1, &t->u.ip4.mask) != 1)
+	 return false;
+      t->type = XIO_TCPWRAP_NET4;
+      return true;
+   }
+   if (!xio_tcpwrap_isdotted(tok))
+      return false;		/* host name, LOCAL, KNOWN, wildcards... */
+   if (tok[strlen(tok)-1] == '.') {
+      t->type = XIO_TCPWRAP_PREFIX;
+   } else {
+      struct in_addr a;
+      if (inet_pton(AF_INET, tok, &a) != 1)
+	 return false;
+      t->type = XIO_TCPWRAP_STRING;
+   }
+   t->str = strdup(tok);
+   return t->str != NULL;
+}
+
+static bool xio_tcpwrap_daemontok(struct xio_tcpwrap_tok *t, char *tok) {
+   if (!strcasecmp(tok, "EXCEPT")) {
+      t->type = XIO_TCPWRAP_EXCEPT;  return true;
+   }
+   if (!strcasecmp(tok, "ALL")) {
+      t->type = XIO_TCPWRAP_ALL;  return true;
+   }
+   if (strpbrk(tok, "@*?/") != NULL)
+      return false;
+   t->type = XIO_TCPWRAP_NAME;
+   t->str = strdup(tok);
+   return t->str != NULL;
+}
+
+/* compiles a token list into tab->toks; returns the number of tokens, or -1
+   when unsupported */
+static int xio_tcpwrap_compilelist(struct xio_tcpwrap_tab *tab, char *list,
+				   bool client) {
+   static const char sep[] = ", \t\r\n";
+   struct xio_tcpwrap_tok *t;
+   char *tok, *save;
+   int n = 0;
+
+   for (tok = strtok_r(list, sep, &save); tok != NULL;
+	tok = strtok_r(NULL, sep, &save)) {
+      if ((t = xio_tcpwrap_newtok(tab)) == NULL)
+	 return -1;
+      if (!(client ?
+	    xio_tcpwrap_clienttok(t, tok) : xio_tcpwrap_daemontok(t, tok))) {
+	 Info3("%s: tcpwrap-cache does not handle pattern \"%s\"%s",
+	       tab->filename, tok, ", leaving table to libwrap");
+	 --tab->ntoks;
+	 return -1;
+      }
+      ++n;
+   }
+   return n;
+}
+
+static int xio_tcpwrap_tab_parse(struct xio_tcpwrap_tab *tab, FILE *fp) {
+   char line[BUFSIZ];
+   size_t len = 0;
+
+   while (fgets(line+len, sizeof(line)-len, fp) != NULL) {
+      struct xio_tcpwrap_rule rule;
+      char *daemons, *clients, *options;
+      int n;
+
+      len += strlen(line+len);
+      if (len > 0 && line[len-1] != '\n' && !feof(fp)) {
+	 /* too long for us */
+	 tab->unsupported = true;
+	 return 0;
+      }
+      if (len > 1 && line[len-2] == '\\') {
+	 len -= 2;	/* continuation line */
+	 continue;
+      }
+      len = 0;
+      if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0')
+	 continue;
+      daemons = line;
+      if ((clients = xio_tcpwrap_split(daemons, ':')) == NULL) {
+	 tab->unsupported = true;	/* let libwrap report it */
+	 return 0;
+      }
+      if ((options = xio_tcpwrap_split(clients, ':')) != NULL &&
+	  options[strspn(options, " \t\r\n")] != '\0') {
+	 Info1("%s: tcpwrap-cache does not handle shell commands or options, leaving table to libwrap",
+	       tab->filename);
+	 tab->unsupported = true;
+	 return 0;
+      }
+      rule.daemons = tab->ntoks;
+      if ((n = xio_tcpwrap_compilelist(tab, daemons, false)) < 0) {
+	 tab->unsupported = true;
+	 return 0;
+      }
+      rule.ndaemons = n;
+      rule.clients = tab->ntoks;
+      if ((n = xio_tcpwrap_compilelist(tab, clients, true)) < 0) {
+	 tab->unsupported = true;
+	 return 0;
+      }
+      rule.nclients = n;
+      if (tab->nrules == tab->maxrules) {
+	 struct xio_tcpwrap_rule *rules;
+	 unsigned int maxrules = tab->maxrules ? 2*tab->maxrules : 16;
+
+	 if ((rules = Realloc(tab->rules, maxrules*sizeof(*rules))) == NULL)
+	    return -1;
+	 tab->rules = rules;  tab->maxrules = maxrules;
+      }
+      tab->rules[tab->nrules++] = rule;
+   }
+   return 0;
+}
+
+/* makes sure the table reflects the current file contents.
+   returns 0 on success, or -1 when the table cannot be used */
+static int xio_tcpwrap_tab_update(struct xio_tcpwrap_tab *tab) {
+   struct stat st;
+   FILE *fp;
+
+   if (Stat(tab->filename, &st) < 0) {
+      if (errno != ENOENT)
+	 return -1;
+      if (tab->exists || tab->unsupported || tab->st.st_ino == 0) {
+	 xio_tcpwrap_tab_clear(tab);
+	 tab->st.st_ino = 1;	/* mark as "known to be absent" */
+	 Info1("tcpwrap-cache: \"%s\" does not exist", tab->filename);
+      }
+      return 0;
+   }
+   if (tab->exists &&
+       st.st_ino   == tab->st.st_ino   && st.st_dev   == tab->st.st_dev &&
+       st.st_size  == tab->st.st_size  && st.st_mtime == tab->st.st_mtime &&
+       st.st_ctime == tab->st.st_ctime) {
+      return 0;
+   }
+   xio_tcpwrap_tab_clear(tab);
+   if ((fp = fopen(tab->filename, "r")) == NULL) {
+      Info2("fopen(\"%s\", \"r\"): %s", tab->filename, strerror(errno));
+      return -1;
+   }
+   if (xio_tcpwrap_tab_parse(tab, fp) < 0) {
+      fclose(fp);
+      xio_tcpwrap_tab_clear(tab);
+      return -1;
+   }
+   fclose(fp);
+   tab->exists = true;
+   tab->st = st;
+   Info3("tcpwrap-cache: compiled \"%s\": %u rules%s", tab->filename,
+	 tab->nrules, tab->unsupported ? " (not all supported)" : "");
+   return 0;
+}
+
+static bool xio_tcpwrap_tokmatch(const struct xio_tcpwrap_tok *t,
+				 const char *daemon,
+				 const union sockaddr_union *them,
+				 const char *clientaddr) {
+   switch (t->type) {
+   case XIO_TCPWRAP_ALL:
+      return true;
+   case XIO_TCPWRAP_NAME:
+      return daemon != NULL && !strcasecmp(t->str, daemon);
+   case XIO_TCPWRAP_STRING:
+      return !strcasecmp(t->str, clientaddr);
+   case XIO_TCPWRAP_PREFIX:
+      return !strncasecmp(t->str, clientaddr, strlen(t->str));
+   case XIO_TCPWRAP_NET4:
+      return them->soa.sa_family == AF_INET &&
+	 (them->ip4.sin_addr.s_addr & t->u.ip4.mask.s_addr) ==
+	 t->u.ip4.net.s_addr;
+#if WITH_IP6
+   case XIO_TCPWRAP_NET6: {
+      const unsigned char *a = them->ip6.sin6_addr.s6_addr;
+      const unsigned char *n = t->u.ip6.s6_addr;
+      unsigned int bits = t->bits;
+
+      if (them->soa.sa_family != AF_INET6)
+	 return false;
+      if (memcmp(a, n, bits/8) != 0)
+	 return false;
+      if (bits%8 == 0)
+	 return true;
+      return ((a[bits/8] ^ n[bits/8]) & (0xff << (8-bits%8))) == 0;
+   }
+#endif
+   default:
+      return false;
+   }
+}
+
+/* like libwrap list_match(): true if a token before EXCEPT matches and
+   the list after EXCEPT does not */
+static bool xio_tcpwrap_listmatch(const struct xio_tcpwrap_tok *toks,
+				  unsigned int ntoks, const char *daemon,
+				  const union sockaddr_union *them,
+				  const char *clientaddr) {
+   unsigned int i;
+
+   for (i = 0; i < ntoks; ++i) {
+      if (toks[i].type == XIO_TCPWRAP_EXCEPT)
+	 return false;
+      if (xio_tcpwrap_tokmatch(&toks[i], daemon, them, clientaddr)) {
+	 while (++i < ntoks) {
+	    if (toks[i].type == XIO_TCPWRAP_EXCEPT) {
+	       return !xio_tcpwrap_listmatch(&toks[i+1], ntoks-i-1, daemon,
+					     them, clientaddr);
+	    }
+	 }
+	 return true;
+      }
+   }
+   return false;
+}
+
+static bool xio_tcpwrap_tabmatch(const struct xio_tcpwrap_tab *tab,
+				 const char *daemon,
+				 const union sockaddr_union *them,
+				 const char *clientaddr) {
+   unsigned int i;
+
+   for (i = 0; i < tab->nrules; ++i) {
+      const struct xio_tcpwrap_rule *r = &tab->rules[i];
+      if (xio_tcpwrap_listmatch(&tab->toks[r->daemons], r->ndaemons,
+				daemon, them, clientaddr) &&
+	  xio_tcpwrap_listmatch(&tab->toks[r->clients], r->nclients,
+				NULL, them, clientaddr)) {
+	 return true;
+      }
+   }
+   return false;
+}
+
+/* evaluates the compiled tables.
+   returns -1 if forbidden, 1 if allowed, or 0 if libwrap must decide */
+static int xio_tcpwrap_cached(struct single *sfd, union sockaddr_union *them) {
+   struct xio_tcpwrap_tab **tabs = sfd->para.socket.ip.tcpwrap_tabs;
+   const char *filenames[2];
+   const char *daemon;
+#if WITH_IP6
+   char clientaddr[INET6_ADDRSTRLEN];
+#else
+   char clientaddr[INET_ADDRSTRLEN];
+#endif
+   int i;
+
+   /* libwrap compares patterns with the textual address */
+   if (inet_ntop(them->soa.sa_family,
+#if WITH_IP6
+		 them->soa.sa_family==PF_INET6 ?
+		 (void *)&them->ip6.sin6_addr :
+#endif
+		 (void *)&them->ip4.sin_addr,
+		 clientaddr, sizeof(clientaddr)) == NULL) {
+      return 0;
+   }
+
+#if defined(HAVE_HOSTS_ALLOW_TABLE)
+   filenames[0] = sfd->para.socket.ip.hosts_allow_table ?
+      sfd->para.socket.ip.hosts_allow_table : hosts_allow_table;
+#else
+   filenames[0] = "/etc/hosts.allow";
+#endif
+#if defined(HAVE_HOSTS_DENY_TABLE)
+   filenames[1] = sfd->para.socket.ip.hosts_deny_table ?
+      sfd->para.socket.ip.hosts_deny_table : hosts_deny_table;
+#else
+   filenames[1] = "/etc/hosts.deny";
+#endif
+   for (i = 0; i < 2; ++i) {
+      if (tabs[i] == NULL) {
+	 if ((tabs[i] = Calloc(1, sizeof(struct xio_tcpwrap_tab))) == NULL)
+	    return 0;
+	 if ((tabs[i]->filename = strdup(filenames[i])) == NULL) {
+	    free(tabs[i]);  tabs[i] = NULL;
+	    return 0;
+	 }
+      }
+      if (xio_tcpwrap_tab_update(tabs[i]) < 0 || tabs[i]->unsupported)
+	 return 0;
+   }
+
+   daemon = sfd->para.socket.ip.libwrapname ?
+      sfd->para.socket.ip.libwrapname : diag_get_string('p');
+   if (xio_tcpwrap_tabmatch(tabs[0], daemon, them, clientaddr)) {
+      Debug1("tcpwrap-cache: \"%s\" matches", tabs[0]->filename);
+      return 1;
+   }
+   if (xio_tcpwrap_tabmatch(tabs[1], daemon, them, clientaddr)) {
+      Debug1("tcpwrap-cache: \"%s\" matches", tabs[1]->filename);
+      return -1;
+   }
+   return 1;
+}
+
+
 /* returns -1 if forbidden, 0 if no tcpwrap check, or 1 if explicitely allowed
    */
 int xio_tcpwrap_check(
@@ -102,6 +534,11 @@ int xio_tcpwrap_check(
    }
    if (us == NULL || them == NULL)  { return -1; }
 
+   if (sfd->para.socket.ip.tcpwrap_cache &&
+       (allow = xio_tcpwrap_cached(sfd, them)) != 0) {
+      return allow;
+   }
+
 #if defined(HAVE_HOSTS_ALLOW_TABLE)
    save_hosts_allow_table = hosts_allow_table;
    if (sfd->para.socket.ip.hosts_allow_table) {
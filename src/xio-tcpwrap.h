@@ -8,6 +8,7 @@
 #if (WITH_TCP || WITH_UDP) && WITH_LIBWRAP
 
 extern const struct optdesc opt_tcpwrappers;
+extern const struct optdesc opt_tcpwrap_cache;
 extern const struct optdesc opt_tcpwrap_etc;
 extern const struct optdesc opt_tcpwrap_hosts_allow_table;
 extern const struct optdesc opt_tcpwrap_hosts_deny_table;
@@ -0,0 +1,439 @@
+/* source: xio-tlscache.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the TLS session cache of the OPENSSL addresses (option
+   openssl-session-cache): sessions are stored DER encoded in a table that is
+   moved to shared memory (xioshm.c) before the first fork(), so that the
+   children of a forking socat process resume the sessions the others have
+   negotiated. Clients look up sessions by target host:port, servers by
+   session id; each role has its own entries, so a socat process that is
+   TLS server and client does not evict one role's sessions with the
+   other's.
+   It also manages the session ticket keys of servers (option
+   openssl-ticket-key-file) */
+
+#include "xiosysincludes.h"
+
+#if WITH_OPENSSL
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
+
+#include "xioopen.h"
+
+#include "xio-tlscache.h"
+#include "xioshm.h"
+
+
+#define XIOTLSCACHE_ENTRIES	32	/* per role */
+#define XIOTLSCACHE_KEYLEN	256	/* client: "host:port", server: id */
+#define XIOTLSCACHE_DERMAX	8192	/* larger sessions are not cached */
+
+#define XIOTLSCACHE_CLIENT	0
+#define XIOTLSCACHE_SERVER	1
+
+struct xiotlscache_entry {
+   bool used;
+   unsigned int keylen;
+   unsigned char key[XIOTLSCACHE_KEYLEN];
+   time_t expires;		/* from session time and timeout */
+   int derlen;
+   unsigned char der[XIOTLSCACHE_DERMAX];
+} ;
+
+struct xiotlscache_tab {
+   /* indexed by XIOTLSCACHE_CLIENT or _SERVER */
+   struct xiotlscache_entry entries[2][XIOTLSCACHE_ENTRIES];
+} ;
+
+static struct xiotlscache_tab xiotlscache_local;
+static struct xiotlscache_tab *xiotlscache = &xiotlscache_local;
+static struct xioshm xiotlscache_shm =
+   XIOSHM_INIT("TLS session cache", &xiotlscache_local);
+static bool xiotlscache_used;	/* local table has entries */
+
+/* the key of the connection this process is establishing */
+static unsigned char xiotlscache_clientkey[XIOTLSCACHE_KEYLEN];
+static unsigned int xiotlscache_clientkeylen;
+
+
+/* Moves the session cache to shared memory so that processes forked from now
+   on share it with this one. Called before fork() */
+void xiotlscache_share(void) {
+   if (xioshm_share(&xiotlscache_shm, xiotlscache_used) == 0)
+      xiotlscache = xiotlscache_shm.addr;
+}
+
+/* Returns the entry with role and key, or NULL; call with lock held */
+static struct xiotlscache_entry *
+   xiotlscache_find(int role, const unsigned char *key, unsigned int keylen) {
+   int i;
+
+   for (i = 0; i < XIOTLSCACHE_ENTRIES; ++i) {
+      struct xiotlscache_entry *e = &xiotlscache->entries[role][i];
+      if (e->used && e->keylen == keylen && !memcmp(e->key, key, keylen))
+	 return e;
+   }
+   return NULL;
+}
+
+/* Stores sess under key, replacing an older session of the same key, an
+   expired one, or the one that expires first */
+static void xiotlscache_put(int role,
+			    const unsigned char *key, unsigned int keylen,
+			    SSL_SESSION *sess) {
+   struct xiotlscache_entry *e, *victim = NULL;
+   unsigned char *p;
+   time_t now = time(NULL);
+   int derlen;
+   int i;
+
+   if (keylen > XIOTLSCACHE_KEYLEN)
+      return;
+   derlen = i2d_SSL_SESSION(sess, NULL);
+   if (derlen <= 0 || derlen > XIOTLSCACHE_DERMAX) {
+      Info1("TLS session cache: session of "F_Zu" bytes not cached",
+	    (size_t)derlen);
+      return;
+   }
+   xioshm_lock(&xiotlscache_shm);
+   if ((victim = xiotlscache_find(role, key, keylen)) == NULL) {
+      for (i = 0; i < XIOTLSCACHE_ENTRIES; ++i) {
+	 e = &xiotlscache->entries[role][i];
+	 if (!e->used || e->expires <= now) {
+	    victim = e;
+	    break;
+	 }
+	 if (victim == NULL || e->expires < victim->expires)
+	    victim = e;
+      }
+   }
+   victim->used = true;
+   victim->keylen = keylen;
+   memcpy(victim->key, key, keylen);
+   victim->expires = SSL_SESSION_get_time(sess) + SSL_SESSION_get_timeout(sess);
+   p = victim->der;
+   victim->derlen = i2d_SSL_SESSION(sess, &p);
+   xioshm_unlock(&xiotlscache_shm);
+   xiotlscache_used = true;
+}
+
+/* Returns a new session object for key, or NULL when there is no valid
+   session in the cache */
+static SSL_SESSION *xiotlscache_get(int role, const unsigned char *key,
+				    unsigned int keylen) {
+   struct xiotlscache_entry *e;
+   unsigned char der[XIOTLSCACHE_DERMAX];
+   const unsigned char *p = der;
+   int derlen = 0;
+
+   xioshm_lock(&xiotlscache_shm);
+   if ((e = xiotlscache_find(role, key, keylen)) != NULL) {
+      if (e->expires <= time(NULL)) {
+	 e->used = false;
+      } else {
+	 derlen = e->derlen;
+	 memcpy(der, e->der, derlen);
+      }
+   }
+   xioshm_unlock(&xiotlscache_shm);
+   if (derlen == 0)
+      return NULL;
+   return d2i_SSL_SESSION(NULL, &p, derlen);
+}
+
+static void xiotlscache_remove(int role, const unsigned char *key,
+			       unsigned int keylen) {
+   struct xiotlscache_entry *e;
+
+   xioshm_lock(&xiotlscache_shm);
+   if ((e = xiotlscache_find(role, key, keylen)) != NULL)
+      e->used = false;
+   xioshm_unlock(&xiotlscache_shm);
+}
+
+/* Client side: OpenSSL reports each new session, with TLS 1.3 also the
+   tickets that arrive after the handshake */
+static int xiotlscache_client_new(SSL *ssl, SSL_SESSION *sess) {
+   if (xiotlscache_clientkeylen == 0)
+      return 0;
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L && !defined(LIBRESSL_VERSION_NUMBER)
+   if (!SSL_SESSION_is_resumable(sess))
+      return 0;
+#endif
+   xiotlscache_put(XIOTLSCACHE_CLIENT,
+		   xiotlscache_clientkey, xiotlscache_clientkeylen, sess);
+   Info1("TLS session cache: stored session for \"%s\"",
+	 (char *)xiotlscache_clientkey);
+   return 0;	/* we did not keep a reference */
+}
+
+/* Prepares the client context for the session cache */
+void xiotlscache_client_setup(SSL_CTX *ctx) {
+   SSL_CTX_set_session_cache_mode(ctx,
+				  SSL_SESS_CACHE_CLIENT|SSL_SESS_CACHE_NO_INTERNAL_STORE);
+   SSL_CTX_sess_set_new_cb(ctx, xiotlscache_client_new);
+}
+
+/* Sets the target of the connections of this process */
+void xiotlscache_client_target(const char *host, const char *port) {
+   int n;
+
+   n = snprintf((char *)xiotlscache_clientkey, sizeof(xiotlscache_clientkey),
+		"%s:%s", host, port);
+   if (n < 0 || n >= sizeof(xiotlscache_clientkey)) {
+      xiotlscache_clientkeylen = 0;
+      return;
+   }
+   xiotlscache_clientkeylen = n+1;
+}
+
+/* Offers the cached session of the target to the server */
+void xiotlscache_client_offer(SSL *ssl) {
+   SSL_SESSION *sess;
+
+   if (xiotlscache_clientkeylen == 0)
+      return;
+   if ((sess = xiotlscache_get(XIOTLSCACHE_CLIENT, xiotlscache_clientkey,
+			       xiotlscache_clientkeylen)) == NULL) {
+      Info1("TLS session cache: no session for \"%s\"",
+	    (char *)xiotlscache_clientkey);
+      return;
+   }
+   if (SSL_set_session(ssl, sess) != 1) {
+      Info1("TLS session cache: SSL_set_session() failed for \"%s\"",
+	    (char *)xiotlscache_clientkey);
+   } else {
+      Info1("TLS session cache: offering session for \"%s\"",
+	    (char *)xiotlscache_clientkey);
+   }
+   SSL_SESSION_free(sess);
+}
+
+/* Server side: sessions are stored under their id; OpenSSL calls these
+   functions instead of using its internal store */
+static int xiotlscache_server_new(SSL *ssl, SSL_SESSION *sess) {
+   const unsigned char *id;
+   unsigned int idlen;
+
+   id = SSL_SESSION_get_id(sess, &idlen);
+   if (idlen == 0)
+      return 0;
+   xiotlscache_put(XIOTLSCACHE_SERVER, id, idlen, sess);
+   Info("TLS session cache: stored server session");
+   return 0;	/* we did not keep a reference */
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+static SSL_SESSION *xiotlscache_server_get(SSL *ssl, const unsigned char *id,
+					   int idlen, int *copy) {
+#else
+static SSL_SESSION *xiotlscache_server_get(SSL *ssl, unsigned char *id,
+					   int idlen, int *copy) {
+#endif
+   SSL_SESSION *sess;
+
+   *copy = 0;	/* caller gets our reference */
+   sess = xiotlscache_get(XIOTLSCACHE_SERVER, id, idlen);
+   Info1("TLS session cache: session %s", sess?"found":"not found");
+   return sess;
+}
+
+static void xiotlscache_server_remove(SSL_CTX *ctx, SSL_SESSION *sess) {
+   const unsigned char *id;
+   unsigned int idlen;
+
+   id = SSL_SESSION_get_id(sess, &idlen);
+   xiotlscache_remove(XIOTLSCACHE_SERVER, id, idlen);
+}
+
+/* Prepares the server context for the session cache. Session tickets are
+   turned off unless keep_tickets is set, so clients resume by session id
+   from the shared cache */
+int xiotlscache_server_setup(SSL_CTX *ctx, bool keep_tickets) {
+   static const unsigned char sid_ctx[] = "socat";
+
+   if (SSL_CTX_set_session_id_context(ctx, sid_ctx, sizeof(sid_ctx)-1) != 1) {
+      Error("SSL_CTX_set_session_id_context() failed");
+      return STAT_NORETRY;
+   }
+   SSL_CTX_set_session_cache_mode(ctx,
+				  SSL_SESS_CACHE_SERVER|SSL_SESS_CACHE_NO_INTERNAL);
+   SSL_CTX_sess_set_new_cb(ctx, xiotlscache_server_new);
+   SSL_CTX_sess_set_get_cb(ctx, xiotlscache_server_get);
+   SSL_CTX_sess_set_remove_cb(ctx, xiotlscache_server_remove);
+   if (!keep_tickets)
+      SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+   return STAT_OK;
+}
+
+
+/* Session ticket keys: the file contains one or more keys of 80 bytes each
+   (16 bytes name, 32 bytes HMAC secret, 32 bytes AES key). The first key
+   encrypts new tickets, all keys decrypt. The file is checked every
+   XIOTLSCACHE_KEYCHECK seconds and read again when it has changed
+   (modification time, size, or inode), so keys can be rotated by prepending
+   a new key without restarting socat */
+
+#define XIOTLSCACHE_TICKETKEYS	8
+#define XIOTLSCACHE_KEYCHECK	10	/* seconds */
+
+struct xiotlscache_ticketkey {
+   unsigned char name[16];
+   unsigned char hmac[32];
+   unsigned char aes[32];
+} ;
+
+static const char *xiotlscache_keyfile;
+static time_t xiotlscache_keymtime;
+static off_t xiotlscache_keysize;
+static ino_t xiotlscache_keyino;
+static time_t xiotlscache_keychecked;	/* time of last stat() */
+static struct xiotlscache_ticketkey xiotlscache_keys[XIOTLSCACHE_TICKETKEYS];
+static int xiotlscache_numkeys;
+
+/* Reads the ticket key file; on error the previous keys are kept.
+   Returns 0 on success, or -1 */
+static int xiotlscache_load_keys(int level) {
+   struct xiotlscache_ticketkey keys[XIOTLSCACHE_TICKETKEYS];
+   struct stat buf;
+   ssize_t bytes;
+   int fd;
+
+   if ((fd = Open(xiotlscache_keyfile, O_RDONLY, 0)) < 0) {
+      Msg2(level, "open(\"%s\", O_RDONLY): %s",
+	   xiotlscache_keyfile, strerror(errno));
+      return -1;
+   }
+   if (Fstat(fd, &buf) < 0) {
+      Msg3(level, "fstat(%d (\"%s\")): %s",
+	   fd, xiotlscache_keyfile, strerror(errno));
+      Close(fd);
+      return -1;
+   }
+   bytes = Read(fd, keys, sizeof(keys));
+   Close(fd);
+   if (bytes < 0) {
+      Msg2(level, "read(\"%s\"): %s", xiotlscache_keyfile, strerror(errno));
+      return -1;
+   }
+   if (bytes == 0 || bytes % sizeof(struct xiotlscache_ticketkey) != 0) {
+      Msg3(level, "%s: size "F_Zd" is not a multiple of "F_Zu" bytes",
+	   xiotlscache_keyfile, bytes, sizeof(struct xiotlscache_ticketkey));
+      return -1;
+   }
+   if (buf.st_size > (off_t)sizeof(keys)) {
+      Warn2("%s: using only the first %d ticket keys",
+	    xiotlscache_keyfile, XIOTLSCACHE_TICKETKEYS);
+   }
+   memcpy(xiotlscache_keys, keys, bytes);
+   xiotlscache_numkeys = bytes / sizeof(struct xiotlscache_ticketkey);
+   xiotlscache_keymtime = buf.st_mtime;
+   xiotlscache_keysize  = buf.st_size;
+   xiotlscache_keyino   = buf.st_ino;
+   xiotlscache_keychecked = time(NULL);
+   memset(keys, 0, sizeof(keys));
+   Info2("TLS ticket keys: loaded %d key(s) from \"%s\"",
+	 xiotlscache_numkeys, xiotlscache_keyfile);
+   return 0;
+}
+
+/* Reloads the key file when it has been modified; looks at it at most every
+   XIOTLSCACHE_KEYCHECK seconds, not on each handshake */
+static void xiotlscache_check_keys(void) {
+   struct stat buf;
+   time_t now = time(NULL);
+
+   if (now >= xiotlscache_keychecked &&
+       now < xiotlscache_keychecked + XIOTLSCACHE_KEYCHECK)
+      return;
+   xiotlscache_keychecked = now;
+   if (Stat(xiotlscache_keyfile, &buf) < 0) {
+      Warn2("stat(\"%s\"): %s", xiotlscache_keyfile, strerror(errno));
+      return;
+   }
+   if (buf.st_mtime != xiotlscache_keymtime ||
+       buf.st_size != xiotlscache_keysize || buf.st_ino != xiotlscache_keyino)
+      xiotlscache_load_keys(E_WARN);
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+static int xiotlscache_ticket_cb(SSL *ssl, unsigned char *name,
+				 unsigned char *iv, EVP_CIPHER_CTX *ectx,
+				 EVP_MAC_CTX *hctx, int enc)
+#else
+static int xiotlscache_ticket_cb(SSL *ssl, unsigned char *name,
+				 unsigned char *iv, EVP_CIPHER_CTX *ectx,
+				 HMAC_CTX *hctx, int enc)
+#endif
+{
+   struct xiotlscache_ticketkey *key = NULL;
+   int i;
+
+   xiotlscache_check_keys();
+   if (enc) {
+      key = &xiotlscache_keys[0];
+      memcpy(name, key->name, sizeof(key->name));
+      if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1)
+	 return -1;
+      if (EVP_EncryptInit_ex(ectx, EVP_aes_256_cbc(), NULL, key->aes, iv) != 1)
+	 return -1;
+      i = 1;
+   } else {
+      for (i = 0; i < xiotlscache_numkeys; ++i) {
+	 if (!memcmp(name, xiotlscache_keys[i].name, sizeof(key->name))) {
+	    key = &xiotlscache_keys[i];
+	    break;
+	 }
+      }
+      if (key == NULL) {
+	 Info("TLS ticket keys: ticket with unknown key name");
+	 return 0;
+      }
+      if (EVP_DecryptInit_ex(ectx, EVP_aes_256_cbc(), NULL, key->aes, iv) != 1)
+	 return -1;
+      /* tickets of older keys are renewed */
+      i = (key == &xiotlscache_keys[0]) ? 1 : 2;
+   }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   {
+      OSSL_PARAM params[3];
+
+      params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY,
+						    key->hmac, sizeof(key->hmac));
+      params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+						   "sha256", 0);
+      params[2] = OSSL_PARAM_construct_end();
+      if (EVP_MAC_CTX_set_params(hctx, params) != 1)
+	 return -1;
+   }
+#else
+   if (HMAC_Init_ex(hctx, key->hmac, sizeof(key->hmac), EVP_sha256(), NULL)
+       != 1)
+      return -1;
+#endif
+   return i;
+}
+
+/* Loads the ticket keys from file and installs them in the server context.
+   Called in the listening process, so the children inherit the keys */
+int xiotlscache_ticket_keys(SSL_CTX *ctx, const char *filename) {
+   xiotlscache_keyfile = filename;
+   if (xiotlscache_load_keys(E_ERROR) < 0)
+      return STAT_NORETRY;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+   if (SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, xiotlscache_ticket_cb) != 1) {
+#else
+   if (SSL_CTX_set_tlsext_ticket_key_cb(ctx, xiotlscache_ticket_cb) != 1) {
+#endif
+      Error("SSL_CTX_set_tlsext_ticket_key_cb() failed");
+      return STAT_NORETRY;
+   }
+   return STAT_OK;
+}
+
+#endif /* WITH_OPENSSL */
@@ -0,0 +1,19 @@
+/* source: xio-tlscache.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xio_tlscache_h_included
+#define __xio_tlscache_h_included 1
+
+#if WITH_OPENSSL
+
+extern void xiotlscache_share(void);
+extern void xiotlscache_client_setup(SSL_CTX *ctx);
+extern void xiotlscache_client_target(const char *host, const char *port);
+extern void xiotlscache_client_offer(SSL *ssl);
+extern int xiotlscache_server_setup(SSL_CTX *ctx, bool keep_tickets);
+extern int xiotlscache_ticket_keys(SSL_CTX *ctx, const char *filename);
+
+#endif /* WITH_OPENSSL */
+
+#endif /* !defined(__xio_tlscache_h_included) */
@@ -15,6 +15,8 @@
 #include "xio-ip.h"
 #include "xio-ipapp.h"
 #include "xio-tcpwrap.h"
+#include "xio-range.h"
+#include "xio-session.h"
 
 #include "xio-udp.h"
 
@@ -67,6 +69,7 @@ int _xioopen_ipdgram_listen(struct single *sfd,
    char infobuff[256];
    unsigned char buff1[1];
    socklen_t themlen;
+   int dosession;
    int result;
 
    retropt_bool(opts, OPT_FORK, &dofork);
@@ -78,6 +81,10 @@ int _xioopen_ipdgram_listen(struct single *sfd,
       }
    }
 
+   if ((dosession = xiosession_retropt(sfd, opts, xioflags, dofork)) < 0) {
+      return STAT_NORETRY;
+   }
+
    retropt_int(opts, OPT_MAX_CHILDREN, &maxchildren);
 
    if (! dofork && maxchildren) {
@@ -98,6 +105,12 @@ int _xioopen_ipdgram_listen(struct single *sfd,
    }
 #endif
 
+#if WITH_TCP || WITH_UDP
+   if (xio_retropt_rangefile(sfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
 #if WITH_LIBWRAP
    xio_retropt_tcpwrap(sfd, opts);
 #endif /* WITH_LIBWRAP */
@@ -117,12 +130,13 @@ int _xioopen_ipdgram_listen(struct single *sfd,
 	 address, connect there, and return */
       union integral notnull;
       union integral reuseaddr;
-      int doreuseaddr = (dofork != 0);
+      int doreuseaddr =
+	 (dofork || dosession && sfd->para.socket.session.connected);
       char infobuff[256];
       union sockaddr_union _sockname;
       union sockaddr_union *la = &_sockname;	/* local address */
 
-      reuseaddr.u_int = dofork;
+      reuseaddr.u_int = doreuseaddr;
 
       if ((sfd->fd = xiosocket(opts, pf, socktype, ipproto, E_ERROR)) < 0) {
 	 return STAT_RETRYLATER;
@@ -166,6 +180,20 @@ int _xioopen_ipdgram_listen(struct single *sfd,
 		 sockaddr_info(&us->soa, uslen, infobuff, sizeof(infobuff)));
       }
 
+      if (dosession) {
+	 /* socat receives the packets and demultiplexes them by peer */
+	 if (xiosession_prepare(sfd, ipproto) < 0) {
+	    return STAT_NORETRY;
+	 }
+	 sfd->dtype = XIODATA_RECVFROM;
+	 xiosetsockaddrenv("SOCK", us, uslen, ipproto);
+	 if (sfd->howtoend == END_UNSPEC)
+	    sfd->howtoend = END_CLOSE;
+	 applyopts_fchown(sfd->fd, opts);
+	 applyopts(sfd, -1, opts, PH_LATE);
+	 return _xio_openlate(sfd, opts);
+      }
+
       readfd.fd = sfd->fd;
       readfd.events = POLLIN|POLLERR;
       while (xiopoll(&readfd, 1, NULL) < 0) {
@@ -491,6 +519,15 @@ int xioopen_udp_datagram(
       free(rangename);
    }
 
+#if WITH_TCP || WITH_UDP
+   if (xio_retropt_rangefile(sfd, opts) < 0) {
+      return STAT_NORETRY;
+   }
+   if (sfd->para.socket.ip.rangetab != NULL) {
+      sfd->dtype |= XIOREAD_RECV_CHECKRANGE;
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
 #if WITH_LIBWRAP
    xio_retropt_tcpwrap(sfd, opts);
 #endif /* WITH_LIBWRAP */
@@ -658,6 +695,12 @@ int xioopen_udp_recv(
    }
 #endif
 
+#if WITH_TCP || WITH_UDP
+   if (xio_retropt_rangefile(&xfd->stream, opts) < 0) {
+      return STAT_NORETRY;
+   }
+#endif /* WITH_TCP || WITH_UDP */
+
 #if WITH_LIBWRAP
    xio_retropt_tcpwrap(&xfd->stream, opts);
 #endif /* WITH_LIBWRAP */
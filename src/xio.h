@@ -32,12 +32,18 @@ struct opt;
 #define XIO_MAYEXEC    16 /* address is allowed to exec a prog (exec+nofork) */
 #define XIO_MAYCONVERT 32 /* address is allowed to perform modifications on the
 			     stream data, e.g. SSL, REALDINE; CRLF */
+#define XIO_MAYSESSION 64 /* address is allowed to demultiplex datagrams into
+			     sessions (session-table) */
+#define XIO_MAYPASS   128 /* address is allowed to pass the fds of the first
+			     address to its child process (inetd) */
 
 /* the status flags of xiofile_t */
 #define XIO_DOESFORK    XIO_MAYFORK
 #define XIO_DOESCHILD   XIO_MAYCHILD
 #define XIO_DOESEXEC    XIO_MAYEXEC
 #define XIO_DOESCONVERT XIO_MAYCONVERT
+#define XIO_DOESSESSION XIO_MAYSESSION
+#define XIO_DOESPASS    XIO_MAYPASS
 
 
 /* methods for reading and writing, and for related checks */
@@ -48,6 +54,9 @@ struct opt;
 #define XIOREAD_POSIXMQ		0x5000	/* POSIX MQ */
 #define XIOREAD_READLINE	0x6000	/* ... */
 #define XIOREAD_OPENSSL		0x7000	/* SSL_read() */
+#define XIOREAD_MMAP		0x8000	/* from memory mapped file */
+#define XIOREAD_AIO		0x9000	/* aio_read() ahead */
+#define XIOREAD_SHMRING		0xa000	/* from shared memory ring */
 #define XIODATA_WRITEMASK	0x0f00	/* mask for basic r/w method */
 #define XIOWRITE_STREAM		0x0100	/* write() (default) */
 #define XIOWRITE_SENDTO		0x0200	/* sendto() */
@@ -56,6 +65,7 @@ struct opt;
 #define XIOWRITE_POSIXMQ	0x0500  /* POSIX MQ */
 #define XIOWRITE_READLINE	0x0600	/* check for prompt */
 #define XIOWRITE_OPENSSL	0x0700	/* SSL_write() */
+#define XIOWRITE_SHMRING	0x0800	/* to shared memory ring */
 /* modifiers to XIODATA_READ_RECV */
 #define XIOREAD_RECV_CHECKPORT	0x0001	/* recv, check peer port */
 #define XIOREAD_RECV_CHECKADDR	0x0002	/* recv, check peer address */
@@ -77,6 +87,7 @@ struct opt;
 #define XIODATA_PIPE		(XIOREAD_STREAM|XIOWRITE_PIPE)
 #define XIODATA_2PIPE		(XIOREAD_STREAM|XIOWRITE_2PIPE)
 #define XIODATA_POSIXMQ		(XIOREAD_POSIXMQ|XIOWRITE_POSIXMQ)
+#define XIODATA_SHMRING		(XIOREAD_SHMRING|XIOWRITE_SHMRING)
 #define XIODATA_PTY		(XIOREAD_PTY|XIOWRITE_STREAM)
 #define XIODATA_READLINE	(XIOREAD_READLINE|XIOWRITE_STREAM)
 #define XIODATA_OPENSSL		(XIOREAD_OPENSSL|XIOWRITE_OPENSSL)
@@ -159,12 +170,24 @@ struct para_ip {
 	bool     dosourceport; 	/* check the source port of incoming connection or packets */
 	uint16_t sourceport;		/* host byte order */
 	bool     lowport;
+	bool     happy_eyeballs;	/* race connects to all addresses */
+	struct timeval happy_eyeballs_delay;	/* between attempts */
+	struct timeval resolve_ttl;	/* keep addresses in resolver cache */
+	struct timeval resolve_negative_ttl;	/* keep failed lookups */
+	struct timeval resolve_timeout;	/* deadline for name resolution */
+	int      pool;		/* number of connections kept established */
+	struct timeval pool_max_idle;	/* close pool connections after */
 #if (WITH_TCP || WITH_UDP) && WITH_LIBWRAP
 	bool   dolibwrap;
 	char    *libwrapname;
 	char    *tcpwrap_etc;
 	char    *hosts_allow_table;
 	char    *hosts_deny_table;
+	bool     tcpwrap_cache;
+	struct xio_tcpwrap_tab *tcpwrap_tabs[2];	/* allow, deny */
+#endif
+#if WITH_TCP || WITH_UDP
+	struct xiorangetab *rangetab;	/* option range-file */
 #endif
 } ;
 #endif /* _WITH_IP4 || _WITH_IP6 */
@@ -231,6 +254,31 @@ typedef struct single {
    int escape;			/* escape character; -1 for no escape */
    bool actescape;		/* escape character found in input data */
    int 	shutup; 		/* children-shutup option */
+   bool   sparse;		/* option sparse: skip holes of input file */
+   bool   sparse_stream;	/* option sparse-stream: data and hole records */
+#if HAVE_SYS_INOTIFY_H
+   struct {
+      bool  active;	/* option follow */
+      int   fd;		/* inotify instance */
+      int   filewd;	/* watch of the file, -1 after it was removed */
+      int   dirwd;	/* watch of its directory, for the new file */
+      char *path;	/* for reopening after rotation */
+      bool  rotated;	/* file has been moved away or removed */
+   } follow;
+#endif /* HAVE_SYS_INOTIFY_H */
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+   struct {
+      size_t window;	/* option sync-range: bytes per step */
+      bool   rdrop;	/* option drop-cache on read side */
+      bool   wdrop;	/* option drop-cache on write side */
+      bool   wsync;	/* incremental writeback */
+      size_t rcount;	/* bytes read since last step */
+      off_t  rdone;	/* read data dropped up to here, -1 initially */
+      size_t wcount;	/* bytes written since last step */
+      off_t  wsub;	/* writeback started up to here, -1 initially */
+      off_t  wdone;	/* writeback finished up to here */
+   } cache;
+#endif /* HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE */
    union {
       struct {
 	 int fdout;		/* use fd for output */
@@ -265,6 +313,12 @@ typedef struct single {
 	    bool     tight;
 	 } un;
 #endif /* WITH_UNIX */
+	 struct {
+	    bool     connected;	/* per flow connected sockets */
+	    int      max;	/* max number of sessions, 0: unlimited */
+	    struct timeval timeout;	/* idle timeout */
+	    struct xiosessiontab *tab;
+	 } session;		/* option session-table */
       } socket;
 #endif /* _WITH_SOCKET */
 #if WITH_POSIXMQ
@@ -273,6 +327,21 @@ typedef struct single {
 	 unsigned int prio; 		/* POSIX message queue */
       } posixmq;
 #endif /* WITH_POSIXMQ */
+#if WITH_SHMRING
+      struct {
+	 char   *name;		/* file with the rings, for unlink-close */
+	 struct xioshmring *shm;	/* shared memory mapping */
+	 size_t  mapsize;
+	 int     side;		/* 0: created the file, 1: attached */
+	 int     bellfd;	/* doorbell of the peer */
+	 int     rdbellfd;	/* own doorbell; fd polls it for reading */
+	 int     wrbellfd;	/* space doorbell of the own ring, polled for
+				   writing; full while the ring is full */
+	 int     wrbellrdfd;	/* its read end until the peer attached */
+	 int     spacebellfd;	/* space doorbell of the peer, read end */
+	 int     pidfd;		/* peer process in fd; -1 not yet, -2 never */
+      } shmring;
+#endif /* WITH_SHMRING */
       struct {
 	 int fdout;		/* use fd for output if two pipes */
 	 pid_t pid;		/* child PID, with EXEC: */
@@ -314,8 +383,42 @@ typedef struct single {
 #if HAVE_SSL_CTX_set_max_proto_version || defined(SSL_CTX_set_max_proto_version)
 	 char *max_proto_version;
 #endif
+	 bool session_cache;	/* option openssl-session-cache */
+	 bool ktls_send;	/* kernel encrypts, write() plain data */
+	 bool ktls_recv;	/* kernel decrypts */
+	 bool read_ahead;	/* option openssl-read-ahead */
+	 bool readagain;	/* EOF or error pending after draining */
+	 bool dynrecords;	/* option openssl-dynamic-records */
+	 size_t dynrec_sent;	/* bytes sent since start or idle */
+	 struct timeval dynrec_last;	/* time of last write */
       } openssl;
 #endif /* WITH_OPENSSL */
+#if HAVE_SYS_MMAN_H
+      struct {
+	 size_t window;		/* option mmap-window */
+	 void  *map;		/* current window, NULL before first read */
+	 size_t maplen;
+	 off_t  mapoff;		/* file offset of window */
+	 off_t  pos;		/* next byte to pass; -1 before first read */
+      } mmap;
+#endif /* HAVE_SYS_MMAN_H */
+#if HAVE_AIO_READ
+      struct {
+	 int     nbufs;		/* option aio-buffers */
+	 size_t  bufsiz;	/* size of each buffer, page aligned */
+	 unsigned char *bufs;	/* nbufs aligned buffers */
+	 struct aiocb *cbs;	/* one control block per buffer */
+	 bool   *busy;		/* request submitted, not yet reaped */
+	 int     head;		/* buffer to pass data from */
+	 size_t  headpos;	/* bytes of head already passed */
+	 ssize_t headlen;	/* bytes in head, -1 while in flight */
+	 off_t   next;		/* file offset of next request */
+	 size_t  skip;		/* bytes at next already passed */
+	 bool    started;	/* requests are in flight */
+	 bool    draining;	/* head hit EOF, discard the others */
+	 pid_t   owner;		/* process that submitted the requests */
+      } aio;
+#endif /* HAVE_AIO_READ */
 #if _WITH_INTERFACE
       struct {
 	 char name[IFNAMSIZ];	/* name of interface */
@@ -393,7 +496,14 @@ struct addrdesc {
 #define XIO_RDSTREAM(s) (((s)->tag==XIO_TAG_DUAL)?(s)->dual.stream[0]:&(s)->stream)
 #define XIO_WRSTREAM(s) (((s)->tag==XIO_TAG_DUAL)?(s)->dual.stream[1]:&(s)->stream)
 #define XIO_GETRDFD(s) (((s)->tag==XIO_TAG_DUAL)?(s)->dual.stream[0]->fd:(s)->stream.fd)
-#define XIO_GETWRFD(s) (((s)->tag==XIO_TAG_DUAL)?(s)->dual.stream[1]->fd:(((s)->stream.dtype&XIODATA_WRITEMASK)==XIOWRITE_2PIPE)?(s)->stream.para.exec.fdout:(((s)->stream.dtype&XIODATA_WRITEMASK)==XIOWRITE_PIPE)?(s)->stream.para.bipipe.fdout:(s)->stream.fd)
+#if WITH_SHMRING
+/* a shared memory ring is polled for reading via an epoll fd, and for
+   writing via its space doorbell, which is full while the ring is full */
+#define XIO_SFDWRFD(sfd) ((((sfd)->dtype&XIODATA_WRITEMASK)==XIOWRITE_SHMRING)?(sfd)->para.shmring.wrbellfd:(sfd)->fd)
+#else
+#define XIO_SFDWRFD(sfd) ((sfd)->fd)
+#endif
+#define XIO_GETWRFD(s) (((s)->tag==XIO_TAG_DUAL)?XIO_SFDWRFD((s)->dual.stream[1]):(((s)->stream.dtype&XIODATA_WRITEMASK)==XIOWRITE_2PIPE)?(s)->stream.para.exec.fdout:(((s)->stream.dtype&XIODATA_WRITEMASK)==XIOWRITE_PIPE)?(s)->stream.para.bipipe.fdout:XIO_SFDWRFD(&(s)->stream))
 #define XIO_EOF(s) (XIO_RDSTREAM(s)->eof && !XIO_RDSTREAM(s)->ignoreeof)
 
 typedef unsigned long flags_t;
@@ -514,8 +624,10 @@ extern int xio_opt_signal(pid_t pid, int signum);
 extern void childdied(int signum);
 
 extern ssize_t xioread(xiofile_t *sock1, void *buff, size_t bufsiz);
+extern ssize_t xioreadptr(xiofile_t *file, void *buff, size_t bufsiz, const void **data);
 extern ssize_t xiopending(xiofile_t *sock1);
 extern ssize_t xiowrite(xiofile_t *sock1, const void *buff, size_t bufsiz);
+extern ssize_t xiowritespace(xiofile_t *file, size_t bytes);
 extern int xioshutdown(xiofile_t *sock, int how);
 
 extern int xioclose(xiofile_t *sock);
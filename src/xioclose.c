@@ -12,6 +12,11 @@
 #include "xio-termios.h"
 #include "xio-interface.h"
 #include "xio-posixmq.h"
+#include "xio-shmring.h"
+#include "xio-mmap.h"
+#include "xio-aio.h"
+#include "xio-cache.h"
+#include "xio-follow.h"
 
 
 /* close the xio fd; must be valid and "simple" (not dual) */
@@ -72,6 +77,27 @@ int xioclose1(struct single *pipe) {
       xioclose_posixmq(pipe);
    }
 #endif /* WITH_POSIXMQ */
+#if WITH_SHMRING
+   if ((pipe->dtype & XIODATA_MASK) == XIODATA_SHMRING) {
+      xioclose_shmring(pipe);
+   }
+#endif /* WITH_SHMRING */
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+   xiocache_close(pipe);
+#endif
+#if HAVE_SYS_INOTIFY_H
+   xioclose_follow(pipe);
+#endif
+#if HAVE_SYS_MMAN_H
+   if ((pipe->dtype & XIODATA_READMASK) == XIOREAD_MMAP) {
+      xioclose_mmap(pipe);
+   }
+#endif /* HAVE_SYS_MMAN_H */
+#if HAVE_AIO_READ
+   if ((pipe->dtype & XIODATA_READMASK) == XIOREAD_AIO) {
+      xioclose_aio(pipe);
+   }
+#endif /* HAVE_AIO_READ */
    if (pipe->fd >= 0) {
       switch (pipe->howtoend) {
       case END_KILL: case END_SHUTDOWN_KILL: case END_CLOSE_KILL:
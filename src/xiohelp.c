@@ -41,7 +41,7 @@ static const char *optiontypenames[] = {
 /* keep consistent with xioopts.h:#define GROUP_* ! */
 static const char *addressgroupnames[] = {
 	"FD",		"FIFO",		"CHR",		"BLK",
-	"REG",		"SOCKET",	"READLINE",	"undef",
+	"REG",		"SOCKET",	"READLINE",	"SHMRING",
 	"NAMED",	"OPEN",		"EXEC",		"FORK",
 	"LISTEN",	"SHELL",	"CHILD",	"RETRY",
 	"TERMIOS",	"RANGE",	"PTY",		"PARENT",
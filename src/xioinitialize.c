@@ -10,6 +10,11 @@
 #include "xiolockfile.h"
 
 #include "xio-openssl.h"	/* xio_reset_fips_mode() */
+#include "xio-range.h"	/* xio_rangefile_sigrestore() */
+#include "xio-ip.h"	/* xioip_rescache_share() */
+#include "xio-balance.h"	/* xiobalance_share() */
+#include "xio-tlscache.h"	/* xiotlscache_share() */
+#include "xio-aio.h"	/* xioaio_prefork() */
 
 static int xioinitialized;
 xiofile_t *sock[XIO_MAXSOCK];
@@ -188,6 +193,9 @@ int xio_forked_inchild(void) {
    }
    num_child = 0;
    xiodroplocks();
+#if WITH_TCP || WITH_UDP
+   xio_rangefile_sigrestore();
+#endif
 #if WITH_FIPS
    if (xio_reset_fips_mode() != 0) {
       result = 1;
@@ -222,6 +230,28 @@ pid_t xio_fork(bool subchild,
    const char *forkwaitstring;
    int forkwaitsecs = 0;
 
+#if _WITH_IP4 || _WITH_IP6
+   if (!subchild) {
+      /* children and parent shall use the same resolver cache */
+      xioip_rescache_share();
+   }
+#endif
+#if WITH_TCP
+   if (!subchild) {
+      /* and the same backend states */
+      xiobalance_share();
+   }
+#endif
+#if WITH_OPENSSL
+   if (!subchild) {
+      /* and the same TLS sessions */
+      xiotlscache_share();
+   }
+#endif
+#if HAVE_AIO_READ
+   /* the helper threads of POSIX AIO do not survive fork() */
+   xioaio_prefork();
+#endif
    if ((pid = Fork()) < 0) {
       Msg1(level, "fork(): %s", strerror(errno));
       return pid;
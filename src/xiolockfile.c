@@ -76,16 +76,79 @@ int xiounlock(const char *lockfile) {
 }
 
 
+#if HAVE_SYS_INOTIFY_H
+/* creates an inotify instance that reports when entries of the lockfile's
+   directory are removed or renamed.
+   returns its fd, or -1 when the waiter must fall back to polling */
+static int xiowaitlock_watch(const char *lockfile) {
+   char *dir, *slash;
+   int ifd;
+
+   if ((dir = strdup(lockfile)) == NULL) {
+      return -1;
+   }
+   if ((slash = strrchr(dir, '/')) == NULL) {
+      strcpy(dir, ".");
+   } else if (slash == dir) {
+      dir[1] = '\0';
+   } else {
+      *slash = '\0';
+   }
+   if ((ifd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC)) < 0) {
+      Info1("inotify_init1(): %s, polling for lock", strerror(errno));
+      free(dir);
+      return -1;
+   }
+   if (inotify_add_watch(ifd, dir, IN_DELETE|IN_MOVED_FROM) < 0) {
+      Info2("inotify_add_watch(\"%s\", ...): %s, polling for lock",
+	    dir, strerror(errno));
+      Close(ifd);
+      free(dir);
+      return -1;
+   }
+   free(dir);
+   return ifd;
+}
+
+/* waits until an entry of the watched directory is removed, at most
+   intervall (lock files on network file systems may vanish without event) */
+static void xiowaitlock_wait(int ifd, const struct timespec *intervall) {
+   struct pollfd pfd;
+   char buff[1024];
+
+   pfd.fd = ifd;
+   pfd.events = POLLIN;
+   if (Poll(&pfd, 1, intervall->tv_sec*1000 + intervall->tv_nsec/1000000)
+       > 0) {
+      while (Read(ifd, buff, sizeof(buff)) > 0) ;
+   }
+}
+#endif /* HAVE_SYS_INOTIFY_H */
+
 /* returns 0 when it could create lock, or -1 on error */
 int xiowaitlock(const char *lockfile, struct timespec *intervall) {
    int rc;
    int level = E_NOTICE;	/* first print a notice */
+   int ifd = -1;
 
+#if HAVE_SYS_INOTIFY_H
+   /* watch before the first try so a release right after it is not missed */
+   ifd = xiowaitlock_watch(lockfile);
+#endif
    while ((rc = xiogetlock(lockfile)) == 1) {
       Msg1(level, "waiting for lock \"%s\"", lockfile);
       level = E_INFO;		/* afterwards only make info */
+#if HAVE_SYS_INOTIFY_H
+      if (ifd >= 0) {
+	 xiowaitlock_wait(ifd, intervall);
+	 continue;
+      }
+#endif
       Nanosleep(intervall, NULL);
    }
+   if (ifd >= 0) {
+      Close(ifd);
+   }
    return rc;
 }
 
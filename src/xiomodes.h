@@ -40,6 +40,7 @@
 #endif /* _WITH_SOCKET */
 #include "xio-namespaces.h"
 #include "xio-posixmq.h"
+#include "xio-shmring.h"
 #include "xio-progcall.h"
 #include "xio-exec.h"
 #include "xio-system.h"
@@ -49,7 +50,17 @@
 #include "xio-pty.h"
 #include "xio-openssl.h"
 #include "xio-tcpwrap.h"
+#include "xio-range.h"
+#include "xio-handover.h"
+#include "xio-pool.h"
+#include "xio-balance.h"
+#include "xio-tlscache.h"
+#include "xio-session.h"
 #include "xio-fs.h"
+#include "xio-mmap.h"
+#include "xio-aio.h"
+#include "xio-cache.h"
+#include "xio-follow.h"
 #include "xio-tun.h"
 #include "xio-streams.h"
 
@@ -223,6 +223,9 @@ const struct addrname addressnames[] = {
 #if WITH_SHELL
    { "SHELL",			&xioaddr_shell },
 #endif
+#if WITH_SHMRING
+   { "SHM-RING",		&xioaddr_shmring },
+#endif
 #if WITH_GENERICSOCKET
    { "SOCKET-CONNECT",		&xioaddr_socket_connect },
    { "SOCKET-DATAGRAM",		&xioaddr_socket_datagram },
@@ -552,13 +555,13 @@ static int xioopen_dual(xiofile_t *xfd, int xioflags) {
 	 Warn("unidirectional open of dual address");
       }
       if (((xioflags&XIO_ACCMODE)+1) & (XIO_RDONLY+1)) {
-	 if (xioopen_single((xiofile_t *)xfd->dual.stream[0], XIO_RDONLY|(xioflags&~XIO_ACCMODE&~XIO_MAYEXEC))
+	 if (xioopen_single((xiofile_t *)xfd->dual.stream[0], XIO_RDONLY|(xioflags&~XIO_ACCMODE&~XIO_MAYEXEC&~XIO_MAYSESSION&~XIO_MAYPASS))
 	     < 0) {
 	    return -1;
 	 }
       }
       if (((xioflags&XIO_ACCMODE)+1) & (XIO_WRONLY+1)) {
-	 if (xioopen_single((xiofile_t *)xfd->dual.stream[1], XIO_WRONLY|(xioflags&~XIO_ACCMODE&~XIO_MAYEXEC))
+	 if (xioopen_single((xiofile_t *)xfd->dual.stream[1], XIO_WRONLY|(xioflags&~XIO_ACCMODE&~XIO_MAYEXEC&~XIO_MAYSESSION&~XIO_MAYPASS))
 	     < 0) {
 	    xioclose((xiofile_t *)xfd->dual.stream[0]);
 	    return -1;
@@ -207,6 +207,10 @@ const struct optname optionnames[] = {
 #endif
 #if defined(AI_V4MAPPED)
 	IF_IP	  ("ai-v4mapped", 		&opt_ai_v4mapped)
+#endif
+#if HAVE_AIO_READ
+	IF_ANY    ("aio",	&opt_aio_buffers)
+	IF_ANY    ("aio-buffers",	&opt_aio_buffers)
 #endif
 	IF_INTERFACE("allmulti",	&opt_iff_allmulti)
 #if WITH_LIBWRAP && defined(HAVE_HOSTS_ALLOW_TABLE)
@@ -301,7 +305,10 @@ const struct optname optionnames[] = {
 #endif
 	IF_TERMIOS("b9600",	&opt_b9600)
 #endif /* defined(CBAUD) */
+	IF_TCP    ("backend-down-time",	&opt_backend_down_time)
+	IF_TCP    ("backends",	&opt_backends)
 	IF_LISTEN ("backlog",	&opt_backlog)
+	IF_TCP    ("balance",	&opt_balance)
 #ifdef O_BINARY
 	IF_OPEN   ("bin",		&opt_o_binary)
 	IF_OPEN   ("binary",		&opt_o_binary)
@@ -464,6 +471,9 @@ const struct optname optionnames[] = {
 	IF_SOCKET ("dontlinger",	&opt_so_dontlinger)
 #endif
 	IF_SOCKET ("dontroute",	&opt_so_dontroute)
+#if HAVE_POSIX_FADVISE
+	IF_ANY    ("drop-cache",	&opt_drop_cache)
+#endif
 #ifdef IPV6_DSTOPTS
 	IF_IP6    ("dstopts",	&opt_ipv6_dstopts)
 #endif
@@ -473,6 +483,7 @@ const struct optname optionnames[] = {
 #ifdef O_DSYNC
 	IF_OPEN   ("dsync",	&opt_o_dsync)
 #endif
+	IF_OPENSSL("dynamic-records",	&opt_openssl_dynamic_records)
 	IF_TERMIOS("echo",	&opt_echo)
 	IF_TERMIOS("echoctl",	&opt_echoctl)
 	IF_TERMIOS("echoe",	&opt_echoe)
@@ -571,6 +582,15 @@ const struct optname optionnames[] = {
 	IF_ANY 	  ("f-setlkw-wr",	&opt_f_setlkw_wr)
 #if WITH_PIPE && defined(F_SETPIPE_SZ)
 	IF_ANY    ("f-setpipe-sz",	&opt_f_setpipe_sz)
+#endif
+#if HAVE_POSIX_FADVISE
+	IF_ANY    ("fadvise",	&opt_fadvise)
+#endif
+#ifdef TCP_FASTOPEN	/* Linux 3.7 */
+	IF_TCP    ("fastopen",	&opt_tcp_fastopen)
+#endif
+#ifdef TCP_FASTOPEN_CONNECT	/* Linux 4.11 */
+	IF_TCP    ("fastopen-connect",	&opt_tcp_fastopen_connect)
 #endif
 	IF_EXEC   ("fdin",	&opt_fdin)
 	IF_EXEC   ("fdout",	&opt_fdout)
@@ -601,6 +621,9 @@ const struct optname optionnames[] = {
 	IF_IP6    ("flowinfo",	&opt_ipv6_flowinfo)
 #endif
 	IF_TERMIOS("flusho",	&opt_flusho)
+#if HAVE_SYS_INOTIFY_H
+	IF_ANY    ("follow",	&opt_follow)
+#endif
 	IF_RETRY  ("forever",	&opt_forever)
 	IF_LISTEN ("fork",	&opt_fork)
 #ifdef IP_FREEBIND
@@ -657,9 +680,13 @@ const struct optname optionnames[] = {
 	IF_ANY    ("group",	&opt_group)
 	IF_NAMED  ("group-early",	&opt_group_early)
 	IF_ANY    ("group-late",	&opt_group_late)
+	IF_LISTEN ("handover",	&opt_handover)
+	IF_TCP    ("happy-eyeballs",	&opt_happy_eyeballs)
+	IF_TCP    ("happy-eyeballs-delay",	&opt_happy_eyeballs_delay)
 #ifdef IP_HDRINCL
 	IF_IP     ("hdrincl",	&opt_ip_hdrincl)
 #endif
+	IF_TCP    ("health-check",	&opt_health_check)
 	IF_READLINE("history",	&opt_history_file)
 	IF_READLINE("history-file",	&opt_history_file)
 #ifdef IPV6_HOPLIMIT
@@ -728,6 +755,7 @@ const struct optname optionnames[] = {
 #if WITH_FS && defined(FS_IMMUTABLE_FL)
 	IF_ANY    ("immutable",	&opt_fs_immutable)
 #endif
+	IF_EXEC   ("inetd",	&opt_inetd)
 #ifdef TCP_INFO	/* Linux 2.4.0 */
 	IF_TCP    ("info",	&opt_tcp_info)
 #endif
@@ -957,6 +985,9 @@ const struct optname optionnames[] = {
 #endif /* SO_KERNACCEPT */
 	IF_OPENSSL("key",	&opt_openssl_key)
 	IF_TERMIOS("kill",	&opt_vkill)
+#ifdef SSL_OP_ENABLE_KTLS
+	IF_OPENSSL("ktls",	&opt_openssl_ktls)
+#endif
 #ifdef O_LARGEFILE
 	IF_OPEN   ("largefile",	&opt_o_largefile)
 #endif
@@ -1029,6 +1060,10 @@ const struct optname optionnames[] = {
 	IF_TERMIOS("min",	&opt_vmin)
 #if HAVE_SSL_set_min_proto_version || defined(SSL_set_min_proto_version)
 	IF_OPENSSL("min-version",	&opt_openssl_min_proto_version)
+#endif
+#if HAVE_SYS_MMAN_H
+	IF_ANY    ("mmap",	&opt_mmap)
+	IF_ANY    ("mmap-window",	&opt_mmap_window)
 #endif
 	IF_ANY    ("mode",	&opt_perm)
 #if WITH_POSIXMQ
@@ -1271,11 +1306,15 @@ const struct optname optionnames[] = {
 #endif
 	IF_OPENSSL("openssl-dhparam",	&opt_openssl_dhparam)
 	IF_OPENSSL("openssl-dhparams",	&opt_openssl_dhparam)
+	IF_OPENSSL("openssl-dynamic-records",	&opt_openssl_dynamic_records)
 	IF_OPENSSL("openssl-egd",	&opt_openssl_egd)
 #if WITH_FIPS
 	IF_OPENSSL("openssl-fips",	&opt_openssl_fips)
 #endif
 	IF_OPENSSL("openssl-key",	&opt_openssl_key)
+#ifdef SSL_OP_ENABLE_KTLS
+	IF_OPENSSL("openssl-ktls",	&opt_openssl_ktls)
+#endif
 #if HAVE_SSL_set_max_proto_version || defined(SSL_set_max_proto_version)
 	IF_OPENSSL("openssl-max-proto-version",	&opt_openssl_max_proto_version)
 #endif
@@ -1295,9 +1334,12 @@ const struct optname optionnames[] = {
 	IF_OPENSSL("openssl-no-sni",	&opt_openssl_no_sni)
 #endif
 	IF_OPENSSL("openssl-pseudo",	&opt_openssl_pseudo)
+	IF_OPENSSL("openssl-read-ahead",	&opt_openssl_read_ahead)
+	IF_OPENSSL("openssl-session-cache",	&opt_openssl_session_cache)
 #if defined(HAVE_SSL_set_tlsext_host_name) || defined(SSL_set_tlsext_host_name)
 	IF_OPENSSL("openssl-snihost",   &opt_openssl_snihost)
 #endif
+	IF_OPENSSL("openssl-ticket-key-file",	&opt_openssl_ticket_key_file)
 	IF_OPENSSL("openssl-verify",	&opt_openssl_verify)
 	IF_TERMIOS("opost",	&opt_opost)
 #if HAVE_TERMIOS_OSPEED
@@ -1340,6 +1382,8 @@ const struct optname optionnames[] = {
 	IF_IP     ("pktopts",	&opt_ip_pktoptions)
 #endif
 	IF_INTERFACE("pointopoint",	&opt_iff_pointopoint)
+	IF_TCP    ("pool",	&opt_pool)
+	IF_TCP    ("pool-max-idle",	&opt_pool_max_idle)
 #ifdef I_POP
 	IF_ANY    ("pop-all",	&opt_streams_i_pop_all)
 #endif
@@ -1398,6 +1442,7 @@ const struct optname optionnames[] = {
 #endif
 	IF_TERMIOS("quit",	&opt_vquit)
 	IF_RANGE  ("range",	&opt_range)
+	IF_RANGE  ("range-file",	&opt_range_file)
 	IF_TERMIOS("raw",	&opt_raw)
 	IF_TERMIOS("rawer",	&opt_termios_rawer)
 	IF_SOCKET ("rcvbuf",	&opt_so_rcvbuf)
@@ -1410,6 +1455,7 @@ const struct optname optionnames[] = {
 #endif
 	IF_OPEN   ("rdonly",	&opt_o_rdonly)
 	IF_OPEN   ("rdwr",	&opt_o_rdwr)
+	IF_OPENSSL("read-ahead",	&opt_openssl_read_ahead)
 	IF_ANY    ("readbytes", &opt_readbytes)
 #if HAVE_RESOLV_H
 	IF_RESOLVE("recurse",		&opt_res_recurse)
@@ -1483,6 +1529,9 @@ const struct optname optionnames[] = {
 #endif /* HAVE_RESOLV_H */
 	IF_PROXY  ("resolv",	&opt_proxy_resolve)
 	IF_PROXY  ("resolve",	&opt_proxy_resolve)
+	IF_IP     ("resolve-negative-ttl",	&opt_resolve_negative_ttl)
+	IF_IP     ("resolve-timeout",	&opt_resolve_timeout)
+	IF_IP     ("resolve-ttl",	&opt_resolve_ttl)
 #ifdef IP_RETOPTS
 	IF_IP     ("retopts",	&opt_ip_retopts)
 #endif
@@ -1562,6 +1611,11 @@ const struct optname optionnames[] = {
 	IF_ANY    ("seek-end",		&opt_lseek32_end)
 	IF_ANY    ("seek-set",		&opt_lseek32_set)
 #endif
+	IF_OPENSSL("session-cache",	&opt_openssl_session_cache)
+	IF_SOCKET ("session-connected",	&opt_session_connected)
+	IF_SOCKET ("session-max",	&opt_session_max)
+	IF_SOCKET ("session-table",	&opt_session_table)
+	IF_SOCKET ("session-timeout",	&opt_session_timeout)
 	IF_ANY    ("setgid",	&opt_setgid)
 	IF_ANY    ("setgid-early",	&opt_setgid_early)
 	IF_ANY 	  ("setlk",	&opt_f_setlk_wr)
@@ -1583,6 +1637,9 @@ const struct optname optionnames[] = {
 	IF_ANY    ("setuid-early",	&opt_setuid_early)
 #if WITH_SHELL
 	IF_ANY	  ("shell", 		&opt_shell)
+#endif
+#if WITH_SHMRING
+	IF_ANY    ("shm-size",	&opt_shmring_size)
 #endif
 	IF_ANY    ("shut-close",	&opt_shut_close)
 	IF_ANY    ("shut-down",	&opt_shut_down)
@@ -1723,6 +1780,11 @@ const struct optname optionnames[] = {
 #endif
 	IF_IPAPP  ("sourceport",	&opt_sourceport)
 	IF_IPAPP  ("sp",	&opt_sourceport)
+	IF_ANY    ("sparse",	&opt_sparse)
+	IF_ANY    ("sparse-stream",	&opt_sparse_stream)
+#if HAVE_POSIX_SPAWN
+	IF_EXEC   ("spawn",	&opt_spawn)
+#endif
 	IF_TERMIOS("start",	&opt_vstart)
 #if HAVE_RESOLV_H
 	IF_RESOLVE("stayopen",		&opt_res_stayopen)
@@ -1759,6 +1821,9 @@ const struct optname optionnames[] = {
 #elif FS_SYNC_FL
 	IF_ANY    ("sync",	&opt_fs_sync)
 #endif
+#if HAVE_SYNC_FILE_RANGE
+	IF_ANY    ("sync-range",	&opt_sync_range)
+#endif
 #ifdef TCP_SYNCNT
 	IF_TCP    ("syncnt",	&opt_tcp_syncnt)
 #endif
@@ -1792,6 +1857,12 @@ const struct optname optionnames[] = {
 #ifdef TCP_DEFER_ACCEPT	/* Linux 2.4.0 */
 	IF_TCP    ("tcp-defer-accept",	&opt_tcp_defer_accept)
 #endif
+#ifdef TCP_FASTOPEN	/* Linux 3.7 */
+	IF_TCP    ("tcp-fastopen",	&opt_tcp_fastopen)
+#endif
+#ifdef TCP_FASTOPEN_CONNECT	/* Linux 4.11 */
+	IF_TCP    ("tcp-fastopen-connect",	&opt_tcp_fastopen_connect)
+#endif
 #ifdef TCP_INFO	/* Linux 2.4.0 */
 	IF_TCP    ("tcp-info",	&opt_tcp_info)
 #endif
@@ -1858,6 +1929,7 @@ const struct optname optionnames[] = {
 #endif
 #if WITH_LIBWRAP
 	IF_IPAPP  ("tcpwrap",		&opt_tcpwrappers)
+	IF_IPAPP  ("tcpwrap-cache",	&opt_tcpwrap_cache)
 	IF_IPAPP  ("tcpwrap-dir",	&opt_tcpwrap_etc)
 	IF_IPAPP  ("tcpwrap-etc",	&opt_tcpwrap_etc)
 #if WITH_LIBWRAP && defined(HAVE_HOSTS_ALLOW_TABLE)
@@ -1874,6 +1946,7 @@ const struct optname optionnames[] = {
 #ifdef O_TEXT
 	IF_ANY    ("text",	&opt_o_text)
 #endif
+	IF_OPENSSL("ticket-key-file",	&opt_openssl_ticket_key_file)
 	IF_UNIX   ("tightsocklen",	&xioopt_unix_tightsocklen)
 	IF_TERMIOS("time",	&opt_vtime)
 #ifdef SO_TIMESTAMP
@@ -3184,6 +3257,23 @@ int retropt_ulong(struct opt *opts, int optcode, unsigned long *result) {
    return -1;
 }
 
+/* get the value of a SIZE_T typed option and mark the option as consumed.
+   return 0 if option was found, or -1 if option was not in opts */
+int retropt_size_t(struct opt *opts, int optcode, size_t *result) {
+   struct opt *opt = opts;
+
+   while (opt->desc != ODESC_END) {
+      if (opt->desc != ODESC_DONE && opt->desc != ODESC_ERROR &&
+	  opt->desc->optcode == optcode) {
+	 *result = opt->value.u_sizet;
+	 opt->desc = ODESC_DONE;
+	 return 0;
+      }
+      ++opt;
+   }
+   return -1;
+}
+
 #if 0	/* currently not used */
 /* get the value of a FLAG typed option, and apply it to the appropriate
    bit position. Mark the option as consumed (done). return 0 if options was found and successfully applied,
@@ -158,6 +158,7 @@ enum e_func {
 #define GROUP_FILE GROUP_REG
 #define GROUP_SOCKET	0x00000020
 #define GROUP_READLINE	0x00000040
+#define GROUP_SHMRING	0x00000080
 
 #define GROUP_NAMED	0x00000100	/* file system entry */
 #define GROUP_OPEN	0x00000200	/* flags for open() */
@@ -215,6 +216,7 @@ enum e_func {
 /* optcode's */
 enum e_optcode {
    OPT_ADDRESS_FAMILY = 1,
+   OPT_AIO_BUFFERS,
    OPT_AI_ADDRCONFIG, 	/* getaddrinfo() */
    OPT_AI_ALL, 		/* getaddrinfo() */
    OPT_AI_PASSIVE, 	/* getaddrinfo() */
@@ -254,7 +256,10 @@ enum e_optcode {
    OPT_B3000000,	/* termios.c_cflag */
    OPT_B3500000,	/* termios.c_cflag */
    OPT_B4000000,	/* termios.c_cflag */
+   OPT_BACKEND_DOWN_TIME,
+   OPT_BACKENDS,
    OPT_BACKLOG,
+   OPT_BALANCE,
    OPT_BIND,	/* a socket address as character string */
    OPT_BRKINT,		/* termios.c_iflag */
 #ifdef BSDLY
@@ -304,6 +309,7 @@ enum e_optcode {
    OPT_CSTOPB,		/* termios.c_cflag */
    OPT_DASH,		/* exec() */
    OPT_DCCP_SET_CCID,
+   OPT_DROP_CACHE,
    OPT_ECHO,		/* termios.c_lflag */
    OPT_ECHOCTL,		/* termios.c_lflag */
    OPT_ECHOE,		/* termios.c_lflag */
@@ -317,6 +323,7 @@ enum e_optcode {
    OPT_ESCAPE,
    OPT_FDIN,
    OPT_FDOUT,
+   OPT_FADVISE,
 #ifdef FFDLY
 #  ifdef FF0
    OPT_FF0,		/* termios.c_oflag */
@@ -335,6 +342,7 @@ enum e_optcode {
    OPT_FLOCK_SH_NB,	/* flock(fd, LOCK_SH|LOCK_NB) */
    OPT_FLUSHO,		/* termios.c_lflag */
    /*0 OPT_FORCE,*/
+   OPT_FOLLOW,
    OPT_FOREVER,
    OPT_FORK,
    OPT_FS_APPEND,
@@ -359,6 +367,10 @@ enum e_optcode {
    OPT_GROUP,
    OPT_GROUP_EARLY,
    OPT_GROUP_LATE,
+   OPT_HANDOVER,	/* pass listening socket to new process */
+   OPT_HAPPY_EYEBALLS,
+   OPT_HAPPY_EYEBALLS_DELAY,
+   OPT_HEALTH_CHECK,
    OPT_HISTORY_FILE,	/* readline history file */
    OPT_HTTP_VERSION,
    OPT_HUPCL,		/* termios.c_cflag */
@@ -388,6 +400,7 @@ enum e_optcode {
    OPT_IGNOREEOF,	/* customized */
    OPT_IGNPAR,		/* termios.c_iflag */
    OPT_IMAXBEL,		/* termios.c_iflag */
+   OPT_INETD,		/* with exec, system */
    OPT_INLCR,		/* termios.c_iflag */
    OPT_INPCK,		/* termios.c_iflag */
    OPT_INTERVALL,
@@ -481,6 +494,8 @@ enum e_optcode {
    OPT_LOCKFILE,
    OPT_LOWPORT,
    OPT_MAX_CHILDREN,
+   OPT_MMAP,
+   OPT_MMAP_WINDOW,
 #if WITH_POSIXMQ
    OPT_POSIXMQ_PRIORITY,
 #endif
@@ -529,9 +544,11 @@ enum e_optcode {
    OPT_OPENSSL_COMPRESS,
 #endif
    OPT_OPENSSL_DHPARAM,
+   OPT_OPENSSL_DYNAMIC_RECORDS,
    OPT_OPENSSL_EGD,
    OPT_OPENSSL_FIPS,
    OPT_OPENSSL_KEY,
+   OPT_OPENSSL_KTLS,
 #if HAVE_SSL_CTX_set_tlsext_max_fragment_length || defined(SSL_CTX_set_tlsext_max_fragment_length)
    OPT_OPENSSL_MAXFRAGLEN,
 #endif
@@ -543,7 +560,10 @@ enum e_optcode {
    OPT_OPENSSL_MIN_PROTO_VERSION,
    OPT_OPENSSL_NO_SNI,
    OPT_OPENSSL_PSEUDO,
+   OPT_OPENSSL_READ_AHEAD,
+   OPT_OPENSSL_SESSION_CACHE,
    OPT_OPENSSL_SNIHOST,
+   OPT_OPENSSL_TICKET_KEY_FILE,
    OPT_OPENSSL_VERIFY,
    OPT_OPOST,		/* termios.c_oflag */
    OPT_OSPEED,		/* termios.c_ospeed */
@@ -613,6 +633,8 @@ enum e_optcode {
    OPT_PERM_EARLY,
    OPT_PERM_LATE,
    OPT_PIPES,
+   OPT_POOL,
+   OPT_POOL_MAX_IDLE,
    /*OPT_PORT,*/
    OPT_PROMPT,		/* readline */
    OPT_PROTOCOL,	/* 6=TCP, 17=UDP */
@@ -628,6 +650,7 @@ enum e_optcode {
    OPT_PTY_INTERVALL,
    OPT_PTY_WAIT_SLAVE,
    OPT_RANGE,		/* restrict client socket address */
+   OPT_RANGE_FILE,	/* table of permitted/denied client networks */
    OPT_RAW,		/* termios */
    OPT_READBYTES,
    OPT_RESET_NETNS, 	/* reset net namespace - not an option, just op! */
@@ -643,6 +666,9 @@ enum e_optcode {
    OPT_RES_RETRY,	/* undocumented */
    OPT_RES_STAYOPEN,	/* resolver(3) */
    OPT_RES_USEVC,	/* resolver(3) */
+   OPT_RESOLVE_NEGATIVE_TTL,
+   OPT_RESOLVE_TIMEOUT,
+   OPT_RESOLVE_TTL,
    OPT_RETRIEVE_VLAN, 	/* Linux: get VLAN info on raw sockets per auxdata */
    OPT_RETRY,
    OPT_SANE,		/* termios */
@@ -655,6 +681,10 @@ enum e_optcode {
    OPT_SEEK64_CUR,
    OPT_SEEK64_END,
    OPT_SEEK64_SET,
+   OPT_SESSION_CONNECTED,
+   OPT_SESSION_MAX,
+   OPT_SESSION_TABLE,
+   OPT_SESSION_TIMEOUT,
    OPT_SETGID,
    OPT_SETGID_EARLY,
    OPT_SETPGID,
@@ -667,6 +697,7 @@ enum e_optcode {
    OPT_SETUID_EARLY,
    OPT_SET_NETNS, 	/* set net namespace */
    OPT_SHELL,
+   OPT_SHM_SIZE,		/* shm-ring */
    OPT_SHUT_CLOSE,
    OPT_SHUT_DOWN,
    OPT_SHUT_NONE,
@@ -773,6 +804,9 @@ enum e_optcode {
    OPT_SOCKSUSER,
 #endif
    OPT_SOURCEPORT,
+   OPT_SPARSE,
+   OPT_SPARSE_STREAM,
+   OPT_SPAWN,		/* with exec, system */
    OPT_STDERR,		/* with exec, system */
 #  define ENABLE_OPTCODE
 #  include "xio-streams.h"
@@ -783,6 +817,7 @@ enum e_optcode {
    OPT_SUBSTUSER_DELAYED,
 #endif
    OPT_SYMBOLIC_LINK,	/* with pty */
+   OPT_SYNC_RANGE,
 #ifdef TABDLY
 #  ifdef TAB0
    OPT_TAB0,		/* termios.c_oflag */
@@ -799,6 +834,7 @@ enum e_optcode {
    OPT_TABDLY,		/* termios.c_oflag */
 #endif
    OPT_TCPWRAPPERS,	/* libwrap */
+   OPT_TCPWRAP_CACHE,	/* libwrap */
    OPT_TCPWRAP_ETC,	/* libwrap */
    OPT_TCPWRAP_HOSTS_ALLOW_TABLE,	/* libwrap */
    OPT_TCPWRAP_HOSTS_DENY_TABLE,	/* libwrap */
@@ -810,6 +846,12 @@ enum e_optcode {
 #ifdef TCP_DEFER_ACCEPT
    OPT_TCP_DEFER_ACCEPT,	/* Linux 2.4.0 */
 #endif
+#ifdef TCP_FASTOPEN
+   OPT_TCP_FASTOPEN,	/* Linux 3.7 */
+#endif
+#ifdef TCP_FASTOPEN_CONNECT
+   OPT_TCP_FASTOPEN_CONNECT,	/* Linux 4.11 */
+#endif
 #ifdef TCP_INFO
    OPT_TCP_INFO,	/* Linux 2.4.0 */
 #endif
@@ -997,6 +1039,7 @@ extern int retropt_2integrals(struct opt *opts, int optcode, union integral *val
 extern int retropt_uint(struct opt *opts, int optcode, unsigned int *result);
 extern int retropt_long(struct opt *opts, int optcode, long *result);
 extern int retropt_ulong(struct opt *opts, int optcode, unsigned long *result);
+extern int retropt_size_t(struct opt *opts, int optcode, size_t *result);
 extern int retropt_flag(struct opt *opts, int optcode, flags_t *result);
 extern int retropt_string(struct opt *opts, int optcode, char **result);
 extern int retropt_timespec(struct opt *opts, int optcode, struct timespec *result);
@@ -10,8 +10,12 @@
 #include "xio-termios.h"
 #include "xio-socket.h"
 #include "xio-posixmq.h"
+#include "xio-shmring.h"
 #include "xio-readline.h"
 #include "xio-openssl.h"
+#include "xio-mmap.h"
+#include "xio-aio.h"
+#include "xio-cache.h"
 
 
 /* xioread() performs read() or recvfrom()
@@ -127,6 +131,14 @@ ssize_t xioread(xiofile_t *file, void *buff, size_t bufsiz) {
       break;
 #endif /* WITH_POSIXMQ */
 
+#if WITH_SHMRING
+   case XIOREAD_SHMRING:
+      if ((bytes = xioread_shmring(pipe, buff, bufsiz)) < 0) {
+	 return -1;
+      }
+      break;
+#endif /* WITH_SHMRING */
+
 #if WITH_READLINE
    case XIOREAD_READLINE:
       if ((bytes = xioread_readline(pipe, buff, bufsiz)) < 0) {
@@ -548,10 +560,97 @@ ssize_t xioread(xiofile_t *file, void *buff, size_t bufsiz) {
      break;
 #endif /* _WITH_SOCKET */
 
+#if HAVE_SYS_MMAN_H
+   case XIOREAD_MMAP:
+   {
+      if ((bytes = xioread_mmap(pipe, buff, bufsiz, NULL)) < 0) {
+	 return -1;
+      }
+   }
+   break;
+#endif /* HAVE_SYS_MMAN_H */
+
+#if HAVE_AIO_READ
+   case XIOREAD_AIO:
+   {
+      const void *data;
+      if ((bytes = xioread_aio(pipe, &data, bufsiz)) < 0) {
+	 return -1;
+      }
+      memcpy(buff, data, bytes);
+   }
+   break;
+#endif /* HAVE_AIO_READ */
+
    default:
       Error("internal: undefined read operation");
       errno = EINVAL;  return -1;
    }
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+   if (pipe->cache.rdrop && bytes > 0)
+      xiocache_read(pipe, bytes);
+#endif
+   pipe->actbytes -= bytes;
+   return bytes;
+}
+
+
+/* like xioread(), but addresses that hold their input in memory (options
+   mmap, aio-buffers) do not copy it to buff; instead *data points to the bytes
+   read, valid until the next call. For all other addresses the data is read
+   into buff and *data is set to buff. */
+ssize_t xioreadptr(xiofile_t *file, void *buff, size_t bufsiz,
+		   const void **data) {
+   struct single *pipe;
+   ssize_t bytes;
+
+   if (file->tag == XIO_TAG_INVALID || file->tag & XIO_TAG_CLOSED) {
+      return xioread(file, buff, bufsiz);
+   }
+   pipe = XIO_RDSTREAM(file);
+   switch (pipe->dtype & XIODATA_READMASK) {
+#if HAVE_SYS_MMAN_H
+   case XIOREAD_MMAP:
+#endif
+#if HAVE_AIO_READ
+   case XIOREAD_AIO:
+#endif
+      break;
+   default:
+      *data = buff;
+      return xioread(file, buff, bufsiz);
+   }
+
+   if (pipe->readbytes) {
+      if (pipe->actbytes == 0) {
+	 Info1("xioread(%d, ...): readbytes consumed, inserting EOF", pipe->fd);
+	 return 0;	/* EOF by count */
+      }
+      if (pipe->actbytes < bufsiz) {
+	 bufsiz = pipe->actbytes;
+      }
+   }
+   switch (pipe->dtype & XIODATA_READMASK) {
+#if HAVE_SYS_MMAN_H
+   case XIOREAD_MMAP:
+      bytes = xioread_mmap(pipe, buff, bufsiz, data);
+      break;
+#endif
+#if HAVE_AIO_READ
+   case XIOREAD_AIO:
+      bytes = xioread_aio(pipe, data, bufsiz);
+      break;
+#endif
+   default:
+      bytes = -1;	/* not reached */
+   }
+   if (bytes < 0) {
+      return -1;
+   }
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+   if (pipe->cache.rdrop && bytes > 0)
+      xiocache_read(pipe, bytes);
+#endif
    pipe->actbytes -= bytes;
    return bytes;
 }
@@ -0,0 +1,121 @@
+/* source: xioshm.c */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+/* this file contains the tables that the processes of a forking socat share
+   in anonymous memory (resolver cache, backend states, TLS sessions).
+   Access is serialized by a fcntl() record lock on one byte per table of an
+   unlinked file. The kernel releases the lock when its holder terminates, so
+   a process killed while holding it does not block the others */
+
+#include "xiosysincludes.h"
+#include "xioopen.h"
+
+#include "xioshm.h"
+
+
+#if HAVE_SYS_MMAN_H && defined(MAP_ANONYMOUS)
+#  define XIOSHM_SHARED 1
+#else
+#  define XIOSHM_SHARED 0
+#endif
+
+#if XIOSHM_SHARED
+static int xioshm_lockfd = -1;	/* common to all tables */
+static off_t xioshm_slots;	/* lock bytes assigned */
+
+/* Creates the lock file. Returns 0 on success, -1 on error */
+static int xioshm_lockfile(void) {
+   const char *tmpdir;
+   char *s;
+
+   if (xioshm_lockfd >= 0)
+      return 0;
+#if HAVE_MEMFD_CREATE
+   if ((xioshm_lockfd = memfd_create("socat-shm", MFD_CLOEXEC)) >= 0)
+      return 0;
+   Info1("memfd_create(\"socat-shm\", MFD_CLOEXEC): %s", strerror(errno));
+#endif
+   if ((tmpdir = getenv("TMPDIR")) == NULL || tmpdir[0] == '\0')
+      tmpdir = "/tmp";
+   if ((s = Malloc(strlen(tmpdir)+sizeof("/socat-shm.XXXXXX"))) == NULL)
+      return -1;
+   sprintf(s, "%s/socat-shm.XXXXXX", tmpdir);
+   if ((xioshm_lockfd = Mkstemp(s)) < 0) {
+      Info2("mkstemp(\"%s\"): %s", s, strerror(errno));
+      free(s);
+      return -1;
+   }
+   Unlink(s);
+   free(s);
+   if (Fcntl_l(xioshm_lockfd, F_SETFD, FD_CLOEXEC) < 0) {
+      Warn2("fcntl(%d, F_SETFD, FD_CLOEXEC): %s",
+	    xioshm_lockfd, strerror(errno));
+   }
+   return 0;
+}
+#endif /* XIOSHM_SHARED */
+
+/* Moves the table to shared memory, with its current contents when copy is
+   true, otherwise zeroed. Called before fork(); the table stays local when
+   sharing is not possible.
+   Returns 0 when the table is shared, -1 when not */
+int xioshm_share(struct xioshm *shm, bool copy) {
+#if XIOSHM_SHARED
+   void *addr;
+
+   if (shm->slot >= 0)
+      return 0;
+   if (xioshm_lockfile() < 0) {
+      Info1("%s: no lock file, not shared", shm->name);
+      return -1;
+   }
+   addr = Mmap(NULL, shm->size, PROT_READ|PROT_WRITE,
+	       MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+   if (addr == MAP_FAILED) {
+      Info2("%s: mmap(): %s, not shared", shm->name, strerror(errno));
+      return -1;
+   }
+   if (copy)
+      memcpy(addr, shm->addr, shm->size);
+   shm->addr = addr;
+   shm->slot = xioshm_slots++;
+   return 0;
+#else
+   return -1;
+#endif /* !XIOSHM_SHARED */
+}
+
+bool xioshm_shared(const struct xioshm *shm) {
+   return shm->slot >= 0;
+}
+
+static void xioshm_setlk(struct xioshm *shm, short type) {
+#if XIOSHM_SHARED
+   struct flock l;
+
+   if (shm->slot < 0)
+      return;
+   memset(&l, 0, sizeof(l));
+   l.l_type   = type;
+   l.l_whence = SEEK_SET;
+   l.l_start  = shm->slot;
+   l.l_len    = 1;
+   while (Fcntl_lock(xioshm_lockfd, F_SETLKW, &l) < 0) {
+      if (errno == EINTR || errno == EDEADLK)
+	 continue;
+      Warn3("%s: fcntl(%d, F_SETLKW, ...): %s",
+	    shm->name, xioshm_lockfd, strerror(errno));
+      break;
+   }
+#endif /* XIOSHM_SHARED */
+}
+
+/* The lock is only held while entries are copied */
+void xioshm_lock(struct xioshm *shm) {
+   xioshm_setlk(shm, F_WRLCK);
+}
+
+void xioshm_unlock(struct xioshm *shm) {
+   xioshm_setlk(shm, F_UNLCK);
+}
@@ -0,0 +1,24 @@
+/* source: xioshm.h */
+/* Copyright Gerhard Rieger and contributors (see file CHANGES) */
+/* Published under the GNU General Public License V.2, see file COPYING */
+
+#ifndef __xioshm_h_included
+#define __xioshm_h_included 1
+
+/* a table that starts process local and is moved to anonymous shared memory
+   by xioshm_share(), so that processes forked from then on share it */
+struct xioshm {
+   const char *name;	/* for messages */
+   void *addr;		/* the table, local or shared */
+   size_t size;
+   off_t slot;		/* locked byte in the lock file, -1 while local */
+} ;
+
+#define XIOSHM_INIT(name, local) { (name), (local), sizeof(*(local)), -1 }
+
+extern int xioshm_share(struct xioshm *shm, bool copy);
+extern bool xioshm_shared(const struct xioshm *shm);
+extern void xioshm_lock(struct xioshm *shm);
+extern void xioshm_unlock(struct xioshm *shm);
+
+#endif /* !defined(__xioshm_h_included) */
@@ -9,6 +9,7 @@
 #include "xioopen.h"
 
 #include "xio-openssl.h"
+#include "xio-shmring.h"
 
 static pid_t socat_kill_pid;	/* here we pass the pid to be killed in sighandler */
 
@@ -87,6 +88,10 @@ int xioshutdown(xiofile_t *sock, int how) {
    } else if ((sock->stream.dtype & XIODATA_MASK) == XIODATA_OPENSSL) {
       xioshutdown_openssl(&sock->stream, how);
 #endif /* WITH_OPENSSL */
+#if WITH_SHMRING
+   } else if ((sock->stream.dtype & XIODATA_MASK) == XIODATA_SHMRING) {
+      xioshutdown_shmring(&sock->stream, how);
+#endif /* WITH_SHMRING */
 
    } else if ((sock->stream.dtype & XIODATA_MASK) == XIODATA_PIPE) {
       if ((how+1)&1) {
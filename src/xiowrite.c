@@ -9,8 +9,10 @@
 #include "xioopen.h"
 
 #include "xio-posixmq.h"
+#include "xio-shmring.h"
 #include "xio-readline.h"
 #include "xio-openssl.h"
+#include "xio-cache.h"
 
 
 /* ...
@@ -69,6 +71,10 @@ ssize_t xiowrite(xiofile_t *file, const void *buff, size_t bytes) {
 	 errno = _errno;
 	 return -1;
       }
+#if HAVE_POSIX_FADVISE || HAVE_SYNC_FILE_RANGE
+      if (pipe->cache.wsync)
+	 xiocache_write(pipe, writt);
+#endif
       break;
 
 #if _WITH_SOCKET
@@ -147,6 +153,14 @@ ssize_t xiowrite(xiofile_t *file, const void *buff, size_t bytes) {
       break;
 #endif /* WITH_POSIXMQ */
 
+#if WITH_SHMRING
+   case XIOWRITE_SHMRING:
+      if ((writt = xiowrite_shmring(pipe, buff, bytes)) < 0) {
+	 return -1;
+      }
+      break;
+#endif /* WITH_SHMRING */
+
 #if WITH_OPENSSL
    case XIOWRITE_OPENSSL:
       /* this function prints its own error messages */
@@ -160,3 +174,31 @@ ssize_t xiowrite(xiofile_t *file, const void *buff, size_t bytes) {
    }
    return writt;
 }
+
+/* Returns how many of bytes can be written to file without waiting, for
+   addresses that cannot accept a part of a block and keep the rest; 0 means
+   poll() will report when there is room. Returns bytes for all other
+   addresses, or -1 on error */
+ssize_t xiowritespace(xiofile_t *file, size_t bytes) {
+   struct single *pipe;
+   ssize_t space;
+
+   if (file->tag == XIO_TAG_INVALID || file->tag & XIO_TAG_CLOSED) {
+      Error1("xiowritespace(): invalid xiofile descriptor %p", file);
+      errno = EINVAL;
+      return -1;
+   }
+   pipe = XIO_WRSTREAM(file);
+
+   switch (pipe->dtype & XIODATA_WRITEMASK) {
+#if WITH_SHMRING
+   case XIOWRITE_SHMRING:
+      if ((space = xiospace_shmring(pipe)) < 0) {
+	 return -1;
+      }
+      return Min((size_t)space, bytes);
+#endif /* WITH_SHMRING */
+   default:
+      return bytes;
+   }
+}